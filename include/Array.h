@@ -35,6 +35,7 @@
 
 #include "Logger.h"
 #include "Streamable.h"
+#include "DataIO.h"
 #include <iostream> //also has size_t
 
 /**
@@ -79,6 +80,12 @@ class Array : public Streamable
     //! allocated memory
     inline void resize(size_t new_size);
 
+    //! Uses the external buffer data (capacity elements in device
+    //! memory) as storage without copying or owning it. The current
+    //! storage is freed and the size set to zero; later resizes within
+    //! capacity keep the buffer. NULL detaches the array.
+    inline void wrap(T *data, size_t capacity);
+
     inline iterator begin();
     inline const_iterator begin() const;
 
@@ -94,6 +101,7 @@ class Array : public Streamable
     size_t size_;
     size_t capacity_;
     T* data_;
+    bool own_data_;
 
     //! private copy constructory to limit pass by value
     Array(Array const& rhs);
@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @author Rahimian, Abtin <arahimian@acm.org>
+ * @revision $Revision$
+ * @tags $Tags$
+ * @date $Date$
+ *
+ * @brief Background writer for checkpoint and visualization files
+ */
+
+/*
+ * Copyright (c) 2014, Abtin Rahimian
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _ASYNCWRITER_H_
+#define _ASYNCWRITER_H_
+
+#include "Error.h"
+#include "Logger.h"
+
+#include <deque>
+#include <string>
+#include <pthread.h>
+
+/**
+ * Writes files on a background thread so that the time stepping does
+ * not wait for the file system. The caller snapshots its data into a
+ * buffer and queues it with push(); the writer thread owns the
+ * buffer from then on. The queue is bounded: push() blocks while
+ * max_jobs buffers are pending (with the default of two, one
+ * snapshot is written while the next one is taken). flush() waits
+ * until all queued files are written.
+ *
+ * The writer thread only does file IO (no MPI), so the usual MPI
+ * threading level is sufficient.
+ */
+class AsyncWriter
+{
+  public:
+    explicit AsyncWriter(size_t max_jobs = 2);
+    //! flushes the queue and joins the writer thread
+    ~AsyncWriter();
+
+    /**
+     * Queue data to be written to fname. The content of data is
+     * moved to the queue (data is empty on return). When offset is
+     * negative the file is truncated, otherwise data is written at
+     * offset into the existing file.
+     */
+    Error_t push(const std::string &fname, std::string &data, long long offset = -1);
+
+    //! blocks until the queue is empty and the last write is done
+    Error_t flush();
+
+    //! number of queued or in-progress writes
+    size_t pending() const;
+
+    //! synchronous write with the same semantics as push
+    static Error_t Write(const std::string &fname, const std::string &data,
+        long long offset = -1);
+
+  private:
+    struct Job{
+        std::string fname;
+        std::string data;
+        long long offset;
+    };
+
+    AsyncWriter(const AsyncWriter&);
+    AsyncWriter& operator=(const AsyncWriter&);
+
+    static void* run(void *self);
+    void loop();
+
+    std::deque<Job> queue_;
+    size_t max_jobs_;
+    size_t busy_;
+    bool stop_;
+    Error_t status_;
+
+    mutable pthread_mutex_t lock_;
+    pthread_cond_t has_job_;
+    pthread_cond_t has_room_;
+    pthread_cond_t idle_;
+    pthread_t thread_;
+};
+
+#endif //_ASYNCWRITER_H_
@@ -0,0 +1,31 @@
+#ifndef _BDF2_H_
+#define _BDF2_H_
+
+/**
+ * Coefficients of the variable step BDF2 used by EvolveSurface
+ * (time_order=2). With w=dt/dt1 (dt1 the previous step and dt0 the
+ * one before) and d1, d2 the displacements of the last two steps,
+ *
+ *   x_{n+1} = x_start + step v(x_{n+1}),  x_start = x_n + start d1,
+ *
+ * with the operator linearized about x_n + extrap d1. The local error
+ * is Milne's estimate, err_scale |x_{n+1} - x_pred| for the quadratic
+ * extrapolation x_pred = x_n + pred1 d1 + pred2 d2.
+ */
+template<typename T>
+struct BDF2Coeffs
+{
+    //! dt0 is only used by the predictor and the error estimate
+    BDF2Coeffs(T dt, T dt1, T dt0 = 0);
+
+    T start;
+    T extrap;
+    T step;
+    T pred1;
+    T pred2;
+    T err_scale;
+};
+
+#include "BDF2.cc"
+
+#endif //_BDF2_H_
@@ -22,6 +22,8 @@
 #include "Error.h"
 #include "ves3d_common.h"
 
+class AsyncWriter;
+
 /**
  * A simple data I/O class tailored for this project. It reads data
  * from and writes data to file.
@@ -62,6 +64,80 @@ class DataIO
     static Error_t SlurpFile(const char* fname, std::ostream &content);
     static Error_t DumpFile(const char* fname, std::ostream &content);
 
+    /**
+     * Block files hold one binary block per process (e.g. the packed
+     * state of its vesicles) behind a short ASCII header that is
+     * written by rank 0:
+     *
+     *   BLOCKFILE
+     *   version: <VERSION>
+     *   nblocks: <P>
+     *   count: <items in block 0> ... <items in block P-1>
+     *   size: <bytes of block 0> ...
+     *   checksum: <Adler-32 of block 0> ...
+     *   preamble: <L>
+     *   <L bytes common to all blocks>
+     *   /BLOCKFILE
+     *   <block 0><block 1>...
+     *
+     * With MPI all processes write to the same file (with MPI-IO)
+     * and the name of rank 0 is used. When a writer is given, only
+     * the header metadata is exchanged here and the data is written
+     * in the background.
+     */
+    struct BlockHeader{
+        std::string version; /* as written, e.g. "123+" for a modified tree */
+        std::vector<size_t> count;
+        std::vector<size_t> size;
+        std::vector<unsigned long> checksum;
+        std::vector<size_t> offset;
+        std::string preamble;
+    };
+
+    //! collective, writes this process's block and its item count
+    static Error_t DumpBlocks(const char* fname, const std::string &preamble,
+        const std::string &block, size_t count, AsyncWriter *writer = NULL);
+    static bool IsBlockFile(const char* fname);
+    static Error_t ReadBlockHeader(const char* fname, BlockHeader &hdr);
+    //! reads block i, checks its checksum, and appends it to content
+    static Error_t ReadBlock(const char* fname, const BlockHeader &hdr,
+        int i, std::ostream &content);
+
+    //! Adler-32 checksum of buf, sum is the running checksum
+    static unsigned long Checksum(const char* buf, size_t len, unsigned long sum = 1);
+
+    /**
+     * Table files hold rows of a fixed number of fields (e.g. the
+     * vesicle geometry or properties) as raw doubles, row after row,
+     * behind a short ASCII header:
+     *
+     *   TABLEFILE
+     *   version: <VERSION>
+     *   rows: <N>
+     *   fields: <F>
+     *   /TABLEFILE
+     *   <N*F doubles>
+     *
+     * so that a process can read its rows without parsing the rest of
+     * the file (utils/table2bin.py converts the text tables).
+     */
+    static bool IsTableFile(const char* fname);
+    static Error_t WriteTable(const char* fname, size_t fields,
+        const std::vector<double> &rows);
+
+    //! Reads nrows rows of a text or table file into rows. When
+    //! distributed (collective) each process gets the rows following
+    //! those of the lower ranks: table files are read in slices with
+    //! MPI-IO and text files are parsed on rank 0 and scattered. When
+    //! not distributed every process reads the first nrows rows.
+    static Error_t ReadRows(const char* fname, size_t fields, size_t nrows,
+        std::vector<double> &rows, bool distributed = true);
+
+    //! Writes the rows of all processes (collective when distributed)
+    //! to a table file, in the order of ranks.
+    static Error_t WriteRows(const char* fname, size_t fields,
+        const std::vector<double> &rows, bool distributed = true);
+
   private:
     // Basic type IO
     // IOFormat default is differnet from public methods b/c of legacy
@@ -36,6 +36,8 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <limits>
 #include <omp.h>
 #include "VesBlas.h"
 #include "Logger.h"
@@ -101,6 +103,10 @@ class Device
     //! Memory allocation.
     void* Malloc(size_t length) const;
 
+    //! Number of calls to Malloc on this device type so far, to check
+    //! that a code path does not allocate
+    static size_t MallocCount() {return malloc_count_;}
+
     //! Freeing memory.
     void Free(void* ptr) const;
 
@@ -177,11 +183,36 @@ class Device
     T* xvpw(const T* x_in, const T*  v_in, const T*  w_in,
         size_t stride, size_t n_vecs, T*  xvpw_out) const;
 
+    //! First fundamental quantities from the derivatives u and v of
+    //! the position, in one pass: E, F, and G scaled by 1/W^2, the area
+    //! element W, the gradient coefficients cu=G*u-F*v and cv=E*v-F*u,
+    //! and the unit normal (u x v)/W. normal_out may alias v_in.
+    template<typename T>
+    void FirstForms(const T* u_in, const T* v_in, size_t stride,
+        size_t n_vecs, T* E_out, T* F_out, T* G_out, T* W_out,
+        T* cu_out, T* cv_out, T* normal_out) const;
+
+    //! Mean and Gaussian curvature from the second derivatives uu, uv,
+    //! and vv of the position and the output of FirstForms, in one
+    //! pass: H=(E*N+G*L)/2-F*M and K=(L*N-M^2)/W^2, with L=uu.n,
+    //! M=uv.n and N=vv.n.
+    template<typename T>
+    void SecondForms(const T* uu_in, const T* uv_in, const T* vv_in,
+        const T* normal_in, const T* E_in, const T* F_in, const T* G_in,
+        const T* W_in, size_t stride, size_t n_vecs, T* H_out, T* K_out) const;
+
     //! Smooth integral (reduction) for multidimensional fields.
     template<typename T>
     T* Reduce(const T *x_in, const int x_dim, const T *w_in, const T *quad_w_in,
         const size_t stride, const size_t ns, T *x_dw) const;
 
+    //! Area and volume of each surface in one pass: the integrals of
+    //! w and of x.n/3 times w, with the quadrature weights quad_w.
+    template<typename T>
+    void AreaVolume(const T *x_in, const T *normal_in, const T *w_in,
+        const T *quad_w_in, size_t stride, size_t n_surfs, T *area_out,
+        T *vol_out) const;
+
     //! General matrix-matrix multiplication.
     //!  From DGEMM documentation
     //!
@@ -250,8 +281,40 @@ class Device
      * functions. There will be no implementation for this method.
      */
     Device<DT>& operator=(const Device<DT> &device_in);
+
+    //! Folds items [0,length) into the Reducer::size accumulators acc
+    //! (CPU). The reducer provides init(acc), fold(begin, end, acc)
+    //! for a range of items, and join(part, acc) for the partial
+    //! result of a thread; see DeviceCPU.cc.
+    template<typename T, typename Reducer>
+    void Reduction(const Reducer &red, size_t length, T *acc) const;
+
+    //! Reductions of fewer items run serially (no parallel region)
+    static const size_t serial_reduction_length_ = 8192;
+
+    //! The partials of at most this many threads are kept (on the
+    //! stack of the caller)
+    static const int max_reduction_threads_ = 256;
+
+    //! Work buffer of the composed (GPU) kernels, grown on demand and
+    //! kept until the device is destroyed. Only one kernel may use it
+    //! at a time (the device is driven from one host thread).
+    void* Scratch(size_t length) const;
+    mutable void *scratch_;
+    mutable size_t scratch_length_;
+
+    static size_t malloc_count_;
 };
 
+template<enum DeviceType DT>
+size_t Device<DT>::malloc_count_(0);
+
+template<enum DeviceType DT>
+const size_t Device<DT>::serial_reduction_length_;
+
+template<enum DeviceType DT>
+const int Device<DT>::max_reduction_threads_;
+
 //! Overloaded insertion operator for DeviceType
 std::ostream& operator<<(
     std::ostream& output,
@@ -62,6 +62,7 @@ enum SolverScheme {JacobiBlockExplicit,     /* Jacobi iteration + only block ten
 ///The linear solver scheme for the vesicle evolution equation
 enum PrecondScheme {DiagonalSpectral,       /* Only the self preconditioner; diagonal in SH basis */
                     NoPrecond,              /* No preconditioner at all                           */
+                    BlockJacobiSelf,        /* LU of each vesicle's self-interaction block        */
                     UnknownPrecond};        /* Used to signal parsing errors                      */
 
 ///The types of background flow that are supported
@@ -83,6 +84,36 @@ enum ReparamType {BoxReparam,             /* Linear box filter */
                   PolyKReparam,           /* Linear filter with n^k attenuation coefficents */
                   UnknownReparam};
 
+///The longitudinal transform in SHTrans
+enum DFTType {GemmDFT,                    /* Dense DFT matrix multiply       */
+              FFTDFT,                     /* Real FFT                        */
+              UnknownDFT};                /* Used to signal parsing errors   */
+
+///Vector instruction set used by the direct Stokes kernels
+enum KernelISA {ScalarISA,                /* No vectorization                */
+                SSE3ISA,                  /* 128-bit                         */
+                AVXISA,                   /* 256-bit                         */
+                AVX512ISA,                /* 512-bit                         */
+                UnknownISA};              /* Used to signal parsing errors   */
+
+///Storage of the singular self-interaction operator in StokesVelocity
+enum SelfOpStorage {FullSelfOp,           /* Dense matrices in working precision */
+                    SingleSelfOp,         /* Dense matrices in single precision  */
+                    MatFreeSelfOp,        /* Rebuilt blockwise on each apply     */
+                    UnknownSelfOp};       /* Used to signal parsing errors       */
+
+///Loading of the precomputed operators in OperatorsMats
+enum MatsIO {TextMatsIO,                  /* Every process parses the text files   */
+             CacheMatsIO,                 /* Every process reads the binary cache  */
+             BcastMatsIO,                 /* Rank 0 reads the cache and broadcasts */
+             UnknownMatsIO};              /* Used to signal parsing errors         */
+
+///Initial guess of the globally implicit solve
+enum SolverGuess {ZeroGuess,              /* Zero vector                             */
+                  PreviousGuess,          /* Solution of the previous solve          */
+                  ExtrapolateGuess,       /* Linear extrapolation of the last two    */
+                  UnknownGuess};          /* Used to signal parsing errors           */
+
 ///String to enums functions
 enum CoordinateOrder EnumifyCoordinateOrder(const char * co);
 enum SolverScheme EnumifyScheme(const char * name);
@@ -90,6 +121,11 @@ enum PrecondScheme EnumifyPrecond(const char * name);
 enum BgFlowType EnumifyBgFlow(const char * name);
 enum SingularStokesRot EnumifyStokesRot(const char * name);
 enum ReparamType EnumifyReparam(const char * name);
+enum DFTType EnumifyDFT(const char * name);
+enum KernelISA EnumifyKernelISA(const char * name);
+enum SelfOpStorage EnumifySelfOp(const char * name);
+enum MatsIO EnumifyMatsIO(const char * name);
+enum SolverGuess EnumifySolverGuess(const char * name);
 
 std::ostream& operator<<(
     std::ostream& output,
@@ -115,4 +151,24 @@ std::ostream& operator<<(
     std::ostream& output,
     const enum ReparamType &RT);
 
+std::ostream& operator<<(
+    std::ostream& output,
+    const enum DFTType &DT);
+
+std::ostream& operator<<(
+    std::ostream& output,
+    const enum KernelISA &ISA);
+
+std::ostream& operator<<(
+    std::ostream& output,
+    const enum SelfOpStorage &SO);
+
+std::ostream& operator<<(
+    std::ostream& output,
+    const enum MatsIO &MI);
+
+std::ostream& operator<<(
+    std::ostream& output,
+    const enum SolverGuess &SG);
+
 #endif //_ENUMS_H_
@@ -21,10 +21,12 @@
 #include "Repartition.h"
 #include "Monitor.h"
 #include "Streamable.h"
+#include "BDF2.h"
 
 /**
  * EvolveSurface uses a simple Euler time stepping (explicit,
- * implicit) method to update the surface. Major components of
+ * implicit) method, or the second order BDF2 (time_order=2, for the
+ * globally implicit scheme), to update the surface. Major components of
  * simulation (BgFlow, Interaction, Repartition, etc.) are arguments
  * to this.
  *
@@ -81,9 +83,32 @@ class EvolveSurface : public Streamable
     Error_t pack(std::ostream &os, Streamable::Format format) const;
     Error_t unpack(std::istream &is, Streamable::Format format);
 
+    //! Packs ves_props and S in the format of pack, without an
+    //! instance (e.g. to write a checkpoint block of a subset)
+    static Error_t packState(std::ostream &os, Streamable::Format format,
+        const VProp_t &ves_props, const Sur_t &S, const std::string &name);
+
+    //! Unpacks the vesicle properties and the surface written by pack
+    //! into ves_props and S (e.g. to read checkpoint blocks without
+    //! building the solver); name is set to the packed name
+    static Error_t unpackState(std::istream &is, Streamable::Format format,
+        Params_t &params, VProp_t &ves_props, Sur_t &S, std::string &name);
+
     Error_t ReinitInterfacialVelocity();
     Error_t Evolve();
 
+    /**
+     * Balance the vesicles between processes by their cost (see
+     * InterfacialVelocity::VesicleCost). The vesicle properties, the
+     * tension and the reference area and volume move with the
+     * vesicles. The interfacial velocity is rebuilt for the new
+     * partition, which drops the extrapolated initial guess and the
+     * recycled Krylov subspace; <tt>reset</tt> is set when that
+     * happens, since any step history of the caller (BDF2) is then
+     * in the old partition too.
+     */
+    Error_t RepartitionVesicles(Sca_t& area, Sca_t& vol, bool &reset);
+
     Error_t getSurfaceUp(const Sur_t *&) const;
     Params_t *params_;
     VProp_t *ves_props_;
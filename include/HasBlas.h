@@ -4,6 +4,10 @@
 #define dgemm dgemm_
 #define ssteqr ssteqr_
 #define dsteqr dsteqr_
+#define sgetrf sgetrf_
+#define dgetrf dgetrf_
+#define sgetrs sgetrs_
+#define dgetrs dgetrs_
 
 #ifdef __cplusplus
 extern "C"{
@@ -29,6 +33,20 @@ extern "C"{
     void dsteqr_(char *compz, const int *n, double *d, double *e,
         double *z, const int *ldz, double *work, const int *info);
 
+    void sgetrf_(const int *m, const int *n, float *a, const int *lda,
+        int *ipiv, int *info);
+
+    void dgetrf_(const int *m, const int *n, double *a, const int *lda,
+        int *ipiv, int *info);
+
+    void sgetrs_(const char *trans, const int *n, const int *nrhs,
+        const float *a, const int *lda, const int *ipiv, float *b,
+        const int *ldb, int *info);
+
+    void dgetrs_(const char *trans, const int *n, const int *nrhs,
+        const double *a, const int *lda, const int *ipiv, double *b,
+        const int *ldb, int *info);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,6 +55,21 @@ template<typename ScalarContainer, typename VectorContainer>
 inline void uyInv(const VectorContainer &u_in,
     const ScalarContainer &y_in, VectorContainer &uyInv_out);
 
+template<typename ScalarContainer, typename VectorContainer>
+inline void FirstForms(const VectorContainer &u_in,
+    const VectorContainer &v_in, ScalarContainer &E_out,
+    ScalarContainer &F_out, ScalarContainer &G_out, ScalarContainer &W_out,
+    VectorContainer &cu_out, VectorContainer &cv_out,
+    VectorContainer &normal_out);
+
+template<typename ScalarContainer, typename VectorContainer>
+inline void SecondForms(const VectorContainer &uu_in,
+    const VectorContainer &uv_in, const VectorContainer &vv_in,
+    const VectorContainer &normal_in, const ScalarContainer &E_in,
+    const ScalarContainer &F_in, const ScalarContainer &G_in,
+    const ScalarContainer &W_in, ScalarContainer &H_out,
+    ScalarContainer &K_out);
+
 template<typename ScalarContainer, typename VectorContainer>
 inline void avpw(const ScalarContainer &a_in,
     const VectorContainer &v_in, const VectorContainer &w_in,
@@ -84,6 +99,14 @@ template<typename Container>
 inline void Reduce(const Container &w_in, const Container &quad_w_in,
     Container &dw);
 
+//! area and volume of the surfaces of position x, normal, and area
+//! element w, in one pass
+template<typename ScalarContainer, typename VectorContainer>
+inline void AreaVolume(const VectorContainer &x_in,
+    const VectorContainer &normal_in, const ScalarContainer &w_in,
+    const ScalarContainer &quad_w_in, ScalarContainer &area_out,
+    ScalarContainer &vol_out);
+
 template<typename VectorContainer>
 inline void ShufflePoints(const VectorContainer &x_in,
     VectorContainer &x_out);
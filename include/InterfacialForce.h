@@ -30,6 +30,15 @@ class InterfacialForce
     mutable Vec_t v1, ftmp;
     mutable SurfContainer* S_up;
 
+    // S_up is the upsampled surface at position version S_up_version;
+    // its geometry is computed on first use and reused by all the
+    // matvecs of a time step. The upsampled work containers are kept
+    // so the matvec does not allocate.
+    mutable size_t S_up_version;
+    mutable Vec_t x_up, F_up, vwrk[2];
+    mutable Sca_t tension_up, swrk[2];
+    void upsample(const SurfContainer &S) const;
+
   public:
     InterfacialForce(const Parameters<value_type> &params,
         const VProp_t &ves_porps,
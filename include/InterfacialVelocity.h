@@ -11,6 +11,7 @@
 #include "Device.h"
 #include <queue>
 #include <memory>
+#include <vector>
 #include "Enums.h"
 #include "BgFlowBase.h"
 #include "OperatorsMats.h"
@@ -49,7 +50,10 @@ class InterfacialVelocity
     Error_t AssembleRhsVel(PVec_t *rhs, const value_type &dt, const SolverScheme &scheme) const;
     Error_t AssembleRhsPos(PVec_t *rhs, const value_type &dt, const SolverScheme &scheme) const;
     Error_t AssembleInitial(PVec_t *u0, const value_type &dt, const SolverScheme &scheme) const;
-    Error_t ImplicitMatvecPhysical(Vec_t &vox, Sca_t &ten) const;
+    Error_t ImplicitMatvecPhysical(Vec_t &vox, Sca_t &ten, bool self_only=false) const;
+    // the output may alias the input
+    Error_t ImplicitMatvecPhysical(const Vec_t &vox, const Sca_t &ten,
+        Vec_t &vox_out, Sca_t &ten_out, bool self_only=false) const;
 
     Error_t Solve(const PVec_t *rhs, PVec_t *u0, const value_type &dt, const SolverScheme &scheme) const;
     Error_t ConfigureSolver(const SolverScheme &scheme) const;
@@ -61,6 +65,13 @@ class InterfacialVelocity
     Error_t updateJacobiImplicit   (const SurfContainer& S_, const value_type &dt, Vec_t& dx);
     Error_t updateImplicit         (const SurfContainer& S_, const value_type &dt, Vec_t& dx);
 
+    //! The implicit step from x_start (instead of the position of
+    //! S_), with the operator still linearized about S_; dx is
+    //! relative to the position of S_. Used by the multistep (BDF2)
+    //! stepping.
+    Error_t updateImplicit         (const SurfContainer& S_, const value_type &dt, Vec_t& dx,
+        const Vec_t &x_start);
+
     Error_t reparam();
 
     Error_t getTension(const Vec_t &vel_in, Sca_t &tension) const;
@@ -76,6 +87,30 @@ class InterfacialVelocity
 
     value_type StokesError(const Vec_t &x) const;
 
+    //! The scheme in use, params.time_precond unless the block-Jacobi
+    //! blocks did not fit (see ConfigurePrecond).
+    PrecondScheme ActivePrecond() const {return(precond_);}
+
+    //! Relative error of the block-Jacobi preconditioner applied to the
+    //! self-interaction operator, which it should invert (for testing).
+    value_type BlockPrecondError() const;
+
+    //! Number of iterations of the last global solve.
+    size_t SolveIterations() const {return(solve_iter_);}
+
+    //! Number of iterations of the last reparam().
+    size_t ReparamIterations() const {return(rep_iter_);}
+
+    //! The energy <x,x>_A summed over the vesicles, before (initial)
+    //! or after the last reparam().
+    value_type ReparamEnergy(bool initial = false) const {return(initial ? rep_energy0_ : rep_energy_);}
+
+    /**
+     * Estimated cost of each local vesicle for load balancing: the
+     * number of points plus near-singular targets.
+     */
+    Error_t VesicleCost(std::vector<value_type> &cost) const;
+
     Sca_t& tension(){ return tension_;}
 
   private:
@@ -84,6 +119,7 @@ class InterfacialVelocity
     const BgFlowBase<Vec_t> &bg_flow_;
     const Parameters<value_type> &params_;
     const VProp_t &ves_props_;
+    const Mats_t &mats_;
 
     InterfacialForce<SurfContainer> Intfcl_force_;
     BiCGStab<Sca_t, InterfacialVelocity> linear_solver_;
@@ -93,17 +129,65 @@ class InterfacialVelocity
     PSolver_t *parallel_solver_;
     mutable bool psolver_configured_;
     mutable bool precond_configured_;
+    mutable PrecondScheme precond_; /* params_.time_precond, unless the blocks do not fit */
     mutable POp_t *parallel_matvec_;
 
     mutable PVec_t *parallel_rhs_;
     mutable PVec_t *parallel_u_;
+    mutable size_t solve_iter_;
+    mutable size_t solve_iter_total_;
+    mutable size_t solve_count_;
+    // matvecs of all solves, with those of the recycled-subspace
+    // projection (to compare runs with and without recycling)
+    mutable size_t solve_matvec_total_;
+
+    // the last two solutions (in the layout of parallel_u_) and their
+    // time steps, for the extrapolated initial guess
+    std::vector<value_type> guess_hist_[2];
+    value_type guess_dt_[2];
+    Error_t RecordSolution(const PVec_t *u0);
+
+    // inexact Krylov: the far-field accuracy of the matvec is relaxed
+    // as the residual of the running solve decreases; matvec count and
+    // time per accuracy level of stokes_
+    mutable bool inexact_solve_;
+    mutable std::vector<size_t> matvec_count_;
+    mutable std::vector<double> matvec_time_;
 
     static Error_t ImplicitApply(const POp_t *o, const value_type *x, value_type *y);
     static Error_t ImplicitPrecond(const PSolver_t *ksp, const value_type *x, value_type *y);
+    Error_t ParallelMatvec(const value_type *x, value_type *y, bool self_only) const;
+
+    // views (no copy) of the velocity and tension blocks of a parallel
+    // vector array in the pseudospectral layout; bytes copied between
+    // the parallel vectors and the containers in the current solve
+    void ViewParallelArray(value_type *x, Vec_t &vox, Sca_t &ten) const;
+    mutable size_t copied_bytes_;
+
+    // device allocations in the matvecs of the current solve, after
+    // the first one (which may fill the caches and work pools)
+    mutable size_t solve_matvecs_, matvec_mallocs_;
+
+    // block-Jacobi preconditioner: the LU factors of each vesicle's
+    // self-interaction block, in the layout of the parallel vector.
+    // The block of nb unknowns takes nb self-only matvecs to probe and
+    // nb^2 words to store, so it is only used up to the sizes below
+    // (falling back to DiagonalSpectral).
+    static const size_t max_block_bytes_ = 32<<20;  /* per vesicle */
+    static const size_t max_blocks_bytes_ = 1<<30;  /* per process */
+    mutable std::vector<value_type> block_lu_;
+    mutable std::vector<int> block_piv_;
+    mutable std::vector<size_t> block_idx_;
+    mutable size_t block_size_;
+    size_t blockPrecondSize() const;
+    bool blockPrecondFits(long nv) const;
+    Error_t AssembleBlockPrecond() const;
+    Error_t ApplyBlockPrecond(const value_type *x, value_type *y) const;
     size_t stokesBlockSize() const;
     size_t tensionBlockSize() const;
 
     value_type dt_;
+    const Vec_t *x_start_;
 
     Error_t EvalFarInter_Imp(const Vec_t &src, const Vec_t &fi, Vec_t &vel) const;
     Error_t EvalFarInter_ImpUpsample(const Vec_t &src, const Vec_t &fi, Vec_t &vel) const;
@@ -118,6 +202,15 @@ class InterfacialVelocity
     SHtrans_t sht_upsample_;
 
     mutable Stokes_t stokes_;
+
+    // mixed precision: the Stokes potentials of the Krylov matvec are
+    // evaluated in float and the solve is refined with double residuals
+    mutable StokesVelocity<float> *stokes_sp_;
+    mutable pvfmm::Vector<float> sp_buffer_;
+    mutable bool mixed_solve_;
+    void CastToSinglePrecision(const Vec_t &x, pvfmm::Vector<float> &y) const;
+    void StokesSinglePrecision(const Vec_t &fs, const Vec_t *fd, Vec_t &vel) const;
+    Error_t RefineSolution(size_t &iter) const;
     mutable Vec_t pos_vel_;
     mutable Sca_t tension_;
     mutable Sca_t position_precond;
@@ -125,6 +218,10 @@ class InterfacialVelocity
 
     //Workspace
     mutable SurfContainer* S_up_;
+    // the active (unconverged) vesicles of reparam
+    mutable SurfContainer* S_rep_;
+    size_t rep_iter_;
+    value_type rep_energy0_, rep_energy_;
     mutable std::queue<Sca_t*> scalar_work_q_;
     std::auto_ptr<Sca_t> checkoutSca() const;
     void recycle(std::auto_ptr<Sca_t> scp) const;
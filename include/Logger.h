@@ -39,17 +39,23 @@
 #include <iomanip>  //for setpercision
 #include <map>
 #include <omp.h>
-#include <stack>
+#include <stdint.h> //int64_t
 #include <string>
+#include <vector>
 #include <cassert>
 #include <ctime>
 
-//! A log event recorded by the Logger class.
+//! A log event recorded by the Logger class. When reported, the
+//! events are aggregated over threads and MPI ranks; time is the
+//! maximum over ranks and time_min/time_avg are the other two
+//! statistics.
 struct LogEvent
 {
     std::string       fun_name;
     unsigned long int num_calls;
     double            time;
+    double            time_min;
+    double            time_avg;
     double            flop;
     double            flop_rate;
 };
@@ -63,30 +69,60 @@ void PrintLogEvent(const std::pair<T, LogEvent>& ev);
 enum ReportFormat {SortFunName, SortNumCalls, SortTime,
                    SortFlop, SortFlopRate};
 
+//! Per-thread profiling state (Tic stack, accumulators and trace
+//! buffer), defined in Logger.cc.
+struct ThreadProfile;
+
 //! A singleton class handling the logging.
+//!
+//! The profiler keeps one state per thread so that Tic(), Toc() and
+//! Record() neither lock nor share a stack; profiled names are
+//! interned once per call site (see PROFILEEND) and the timers have
+//! nanosecond resolution. The per-thread data is only merged by
+//! Report(), WriteTrace() and PurgeProfileHistory(), which must be
+//! called outside of parallel regions.
 class Logger
 {
   public:
     //! Returns the current wall-time.
     static double Now();
 
-    //! Gets the current wall-time, saves it in a stack and also
-    //! returns it as output.
+    //! Returns a monotonic time stamp in nanoseconds.
+    static int64_t NowNs();
+
+    //! Gets the current wall-time, saves it in the calling thread's
+    //! stack and also returns it as output.
     static double Tic();
 
     //! Gets the current wall-time, pops the corresponding Tic() value
-    //! form the stack, i.e. the last Tic(), and returns the difference.
+    //! form the calling thread's stack, i.e. the last Tic(), and
+    //! returns the difference.
     static double Toc();
 
-    //! Records accumulative log events corresponding to functions
-    //! calling this method.
-    static void Record(std::string fun_name, std::string prefix, double time,
-        double flop);
+    //! Returns the key for the event name prefix+fun_name, registering
+    //! the name the first time it is seen.
+    static int Intern(const char *fun_name, const char *prefix);
+
+    //! Pops the last Tic() of the calling thread and records its
+    //! duration and flop (plus the flops recorded by nested events)
+    //! under the interned key.
+    static void Record(int key, double flop);
 
     //! Reports all accumulative data corresponding to all the calls to
-    //! the Record() function.
+    //! the Record() function, aggregated over threads and ranks.
     static void Report(enum ReportFormat rf);
 
+    //! Turns on/off the recording of individual events for WriteTrace().
+    static void SetTrace(bool enable);
+
+    //! Writes the recorded events in the Chrome trace (JSON) format,
+    //! one file per rank (with the rank appended to the name when
+    //! running on more than one rank). Returns false if a file could
+    //! not be written. The PROFILESTART/PROFILEEND(NAME) events are
+    //! traced, which include the pvfmm::Profile phases of
+    //! StokesVelocity (as pvfmm::<phase>).
+    static bool WriteTrace(std::string file_name);
+
     //! The setter function of the log file.
     static void SetLogFile(std::string file_name);
 
@@ -100,6 +136,8 @@ class Logger
     //! Clears the slate of profiler
     static void PurgeProfileHistory();
 
+    //! Flops accumulated by the calling thread in the current event
+    //! (or in total when no event is open).
     static double GetFlops();
 
   private:
@@ -108,14 +146,17 @@ class Logger
     //! object.
     Logger();
 
-    //! The map holding the data corresponding the Record() method.
-    static std::map<std::string, LogEvent> PrflMap;
+    //! The calling thread's profiling state, created on first use.
+    static ThreadProfile* Thread();
+
+    //! The interned event names, indexed by key.
+    static std::vector<std::string> PrflKeys;
 
-    //! The stack used by Tic() and Toc().
-    static std::stack<double> TicStack;
+    //! The states of all threads that have used the profiler.
+    static std::vector<ThreadProfile*> PrflThreads;
 
-    //! The stack to have cumulative
-    static std::stack<double> FlopStack;
+    //! Whether individual events are kept for WriteTrace().
+    static bool trace_on;
 
     //! The file name for the logger.
     static std::string log_file;
@@ -126,16 +167,25 @@ class Logger
  */
 #ifdef PROFILING
 #define PROFILESTART() (Logger::Tic())
-#define PROFILEEND(str,flps) (                                  \
-        Logger::Record(__FUNCTION__, str, Logger::Toc(), flps))
+#define PROFILEEND(str,flps) do{                                        \
+        static const int _prfl_key(Logger::Intern(__FUNCTION__, str));  \
+        Logger::Record(_prfl_key, flps);                                \
+    } while(0)
+#define PROFILEENDNAME(name,flps) do{                                   \
+        static const int _prfl_key(Logger::Intern(name, ""));           \
+        Logger::Record(_prfl_key, flps);                                \
+    } while(0)
 #define PROFILECLEAR() (Logger::PurgeProfileHistory())
 #define PROFILEREPORT(format) (Logger::Report(format))
+#define PROFILETRACE(file_name) (Logger::WriteTrace(file_name))
 #define PROFILEING_EXPR(expr) (expr)
 #else
 #define PROFILESTART()
 #define PROFILEEND(str,flps)
+#define PROFILEENDNAME(name,flps)
 #define PROFILECLEAR()
 #define PROFILEREPORT(format)
+#define PROFILETRACE(file_name)
 #define PROFILEING_EXPR(expr)
 #endif //PROFILING
 
@@ -4,16 +4,26 @@
 #include "Logger.h"
 #include "Spharm.h"
 #include "Enums.h"
+#include "AsyncWriter.h"
 
 template<typename EvolveSurface>
 class MonitorBase{
   private:
     typedef typename EvolveSurface::value_type value_type;
+    typedef typename EvolveSurface::Sca_t Sca_t;
 
   public:
     virtual ~MonitorBase();
     virtual Error_t operator()(const EvolveSurface *state, const value_type &t,
         value_type &dt) = 0;
+
+    //! waits for the pending output to be written
+    virtual Error_t flush();
+
+    //! The per vesicle state of the monitor (one value per vesicle
+    //! in each container), moved with the vesicles when they are
+    //! repartitioned; none by default
+    virtual void vesicleData(std::vector<Sca_t*> &data);
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -34,12 +44,23 @@ class Monitor : public MonitorBase<EvolveSurface>
     DictString_t d_;
     const Parameters<value_type> *params_;
 
+    //! owned by the monitor (created when params->async_io is set)
+    //! and deleted after the pending files are flushed
+    AsyncWriter *writer_;
+
+    Monitor(const Monitor &);
+    Monitor& operator=(const Monitor &);
+
   public:
     Monitor(const Parameters<value_type> *params);
     ~Monitor();
 
     virtual Error_t operator()(const EvolveSurface *state, const value_type &t,
         value_type &dt);
+    virtual Error_t flush();
+
+    //! the reference area and volume, once they are set
+    virtual void vesicleData(std::vector<typename EvolveSurface::Sca_t*> &data);
 };
 
 #include "Monitor.cc"
@@ -2,6 +2,8 @@
 #define _NEAR_SINGULAR_H_
 
 #include <mpi.h>
+#include <map>
+#include <string>
 #include <vector.hpp>
 #include <matrix.hpp>
 
@@ -27,12 +29,40 @@ class NearSingular{
     const PVFMMVec_t& ForceRepul();
     bool CheckCollision();
 
+    // Number of near targets of each local source vesicle (from the last setup)
+    const pvfmm::Vector<size_t>& NearTargetCount() const{return coord_setup.near_trg_cnt;}
+
+    /**
+     * Reuse the near pairs between position updates. The pairs are
+     * searched within (1+skin)*r_near and only the projections are
+     * recomputed while the points have moved less than the margin
+     * (skin=0 rebuilds the pairs on every update).
+     */
+    void SetNearSkin(Real_t skin);
+
+    // Fraction of the setups that reused the near pairs
+    Real_t SetupReuseRatio() const;
+
+    // Busy time of the slowest thread over the mean busy time in a
+    // threaded phase ("Proj", "SubtractDirect" or "VelocInterp"),
+    // summed over all calls; 0 if the phase has not run
+    double ThreadImbalance(const char* name) const;
+
   private:
 
     NearSingular(const NearSingular &);
     NearSingular& operator=(const NearSingular &);
 
     void SetupCoordData();
+    void SetupNearPair();
+    bool ReuseNearPair();
+    void SetupProjection();
+    Real_t MaxVesicleRadius();
+
+    // Thread tid gets the near pairs [a,b) (equal share of all pairs),
+    // starting in vesicle ves
+    void PairPartition(size_t tid, size_t omp_p, size_t& a, size_t& b, size_t& ves) const;
+    void ThreadLoad(const char* name, const pvfmm::Vector<double>& t_thread) const;
 
     void VelocityScatter(PVFMMVec_t& trg_vel);
 
@@ -59,6 +89,7 @@ class NearSingular{
 
     struct{
       Real_t r_near;
+      Real_t r_list;  // radius for the near pair search (>= r_near)
       Real_t bbox[4]; // {s,x,y,z} : scale, shift
 
       PVFMMVec_t            near_trg_coord;
@@ -71,10 +102,14 @@ class NearSingular{
 
       pvfmm::Vector<char>   is_surf_pt;       // If a target point is a surface point
       pvfmm::Vector<char>   is_extr_pt;       // If a target point is an exterior point
+      pvfmm::Vector<char>   is_near_pt;       // If a target point is within r_near
 
       PVFMMVec_t            proj_patch_param; // Projection patch parameter coordinates
       PVFMMVec_t            proj_coord;       // Projection coordinates (x,y,z)
       PVFMMVec_t            repl_force;       // Repulsive force (x,y,z)
+
+      PVFMMVec_t            src_coord0;       // Source coordinates at the last pair search
+      PVFMMVec_t            trg_coord0;       // Target coordinates at the last pair search
     } coord_setup;
 
     const PVFMMVec_t* S;
@@ -84,6 +119,10 @@ class NearSingular{
     const PVFMMVec_t* S_vel;
     Real_t repul_dist_;
     Real_t box_size_;
+    Real_t near_skin_;
+    size_t setup_cnt_;
+    size_t setup_reuse_cnt_;
+    mutable std::map<std::string, std::pair<double,double> > thread_load_; // (max, mean) busy time per phase
     MPI_Comm comm;
 
     int sh_order_;
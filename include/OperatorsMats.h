@@ -7,6 +7,11 @@
 #include "Parameters.h"
 #include "Error.h"
 
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <unistd.h> //getpid, gethostname
+
 template <typename Container>
 struct OperatorsMats
 {
@@ -40,6 +45,18 @@ struct OperatorsMats
     const SHMats_t& getShMats(int order) const;
 
   private:
+    //! length of the fixed header of the binary cache file
+    static const size_t CACHE_HEADER_LEN = 256;
+
+    Error_t readText();
+    Error_t readCache();
+    Error_t writeCache() const;
+#ifdef HAS_MPI
+    Error_t broadcast();
+#endif
+    std::string precisionName() const;
+    std::string cacheFileName() const;
+
     OperatorsMats(const OperatorsMats& mat_in);
     OperatorsMats& operator=(const OperatorsMats& vec_in);
 };
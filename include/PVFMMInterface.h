@@ -5,8 +5,28 @@
 #include <kernel.hpp>
 #include <mpi_tree.hpp>
 
+#include "Enums.h"
+
 ///////////////////////// Kernel Function Declarations ////////////////////////
 
+/**
+ * The direct Stokes kernels are compiled for every vector width (SSE3, AVX,
+ * AVX-512) whatever the compiler flags, and the width is selected at
+ * runtime. StokesHostISA() is the widest width supported by the CPU (scalar
+ * on hosts and compilers without the x86 variants). StokesSetISA() clamps
+ * its argument to it and returns the instruction set actually used.
+ */
+inline KernelISA StokesHostISA();
+inline KernelISA StokesGetISA();
+inline KernelISA StokesSetISA(KernelISA isa);
+
+/**
+ * Number of Newton iterations on the approximate reciprocal square root so
+ * that the kernels are accurate to the relative tolerance tol.
+ */
+template <class Real_t>
+int StokesNewtonIter(Real_t tol, KernelISA isa=StokesGetISA());
+
 template <class T>
 void stokes_sl_m2l(T* r_src, int src_cnt, T* v_src, int dof, T* r_trg, int trg_cnt, T* k_out, pvfmm::mem::MemoryManager* mem_mgr);
 
@@ -25,7 +45,15 @@ void stokes_vol_poten(const T* coord, int n, T* out);
 
 template <class Real_t>
 struct StokesKernel{
+  /// Kernel with two Newton iterations (full double precision).
   inline static const pvfmm::Kernel<Real_t>& Kernel();
+
+  /// Cheapest kernel with relative accuracy tol on the active ISA.
+  inline static const pvfmm::Kernel<Real_t>& Kernel(Real_t tol);
+
+  private:
+  template <int newton_iter>
+  inline static const pvfmm::Kernel<Real_t>& Kernel_();
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -54,12 +82,16 @@ void PVFMMEval(const T* src_pos, const T* sl_den, const T* dl_den, size_t n_src,
 
 /**
  * Repartition nv vesicles by the MortonId of their center-of-mass between
- * processors in MPI_COMM_WORLD.
+ * processors in MPI_COMM_WORLD. The Morton-ordered sequence is split
+ * into pieces of equal total weight (equal count when weight is
+ * NULL) and the per vesicle data (data_dof values) moves with the
+ * vesicles. Matches Repartition<T>::GlobalRepart_t.
  */
 template<typename T>
 void PVFMM_GlobalRepart(size_t nv, size_t stride,
-    const T* x, const T* tension, size_t* nvr, T** xr,
-    T** tensionr, void* user_ptr);
+    const T* x, const T* tension, const T* weight,
+    size_t data_dof, const T* data, size_t* nvr, T** xr,
+    T** tensionr, T** datar, void** context);
 
 /**
  * Determine bounding box.
@@ -174,6 +174,13 @@ class ParallelLinSolver{
     virtual Error_t Configure() = 0;
     virtual Error_t InitialGuessNonzero(bool flg) const = 0;
 
+    /**
+     * Keep the last k solutions and, before each solve, replace the
+     * initial guess by the minimal residual combination of them (and
+     * the given guess). The space is reset when the operator is set.
+     */
+    virtual Error_t SetRecycleSize(size_t k) = 0;
+
     // factories
     virtual Error_t VecFactory(vec_type **newvec) const = 0;
     virtual Error_t LinOpFactory(matvec_type **newop) const = 0;
@@ -184,6 +191,13 @@ class ParallelLinSolver{
 
     // utility
     virtual Error_t IterationNumber(size_t &niter) const = 0;
+    /**
+     * Residual norm of the current iterate (rnorm) and of the initial
+     * guess (rnorm0) of the running solve; both are zero before the
+     * initial residual is known. The operator may use them to relax
+     * its accuracy as the iteration converges (inexact Krylov).
+     */
+    virtual Error_t ResidualNorm(value_type &rnorm, value_type &rnorm0) const = 0;
     virtual Error_t ViewReport() const = 0;
     virtual Error_t OperatorResidual(const vec_type *rhs, const vec_type *x, value_type &res) const = 0;
     virtual const comm_t* MPIComm() const = 0;
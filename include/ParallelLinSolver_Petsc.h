@@ -39,6 +39,9 @@
 #include "ves3d_common.h"
 #include "petscksp.h"
 #include "Logger.h"
+#include <algorithm> //max
+#include <cmath>
+#include <vector>
 
 template<typename T>
 class ParallelVecPetsc : public ParallelVec<T>
@@ -151,7 +154,7 @@ template<typename T>
 PetscErrorCode PetscPrecondWrapper(PC A, Vec x, Vec y);
 
 template<typename T>
-PetscErrorCode PetscKSPMonitor(KSP K,PetscInt n, PetscReal rnorm, void *dummy);
+PetscErrorCode PetscKSPMonitor(KSP K,PetscInt n, PetscReal rnorm, void *ctx);
 
 template<typename T>
 class ParallelLinSolverPetsc : public ParallelLinSolver<T>
@@ -180,6 +183,7 @@ class ParallelLinSolverPetsc : public ParallelLinSolver<T>
 
     Error_t Configure();
     Error_t InitialGuessNonzero(bool flg) const;
+    Error_t SetRecycleSize(size_t k);
 
     // factories
     Error_t VecFactory(vec_type **newvec) const;
@@ -191,6 +195,7 @@ class ParallelLinSolverPetsc : public ParallelLinSolver<T>
 
     // utility
     Error_t IterationNumber(size_t &niter) const;
+    Error_t ResidualNorm(value_type &rnorm, value_type &rnorm0) const;
     Error_t ViewReport() const;
     Error_t OperatorResidual(const vec_type *rhs, const vec_type *x, value_type &res) const;
     const MPI_Comm* MPIComm() const;
@@ -209,8 +214,16 @@ class ParallelLinSolverPetsc : public ParallelLinSolver<T>
     petsc_matvec_type      *mv_;
     const void             *precond_ctx_;
     precond_type            precond_;
+    size_t                  recycle_size_;
+    mutable std::vector<Vec> recycle_;
+    mutable value_type      rnorm_, rnorm0_;
+
+    Error_t ProjectGuess(const Vec &b, Vec &x, bool nonzero) const;
+    Error_t UpdateRecycle(const Vec &x) const;
+    Error_t ClearRecycle() const;
 
     friend PetscErrorCode PetscPrecondWrapper<T>(PC A, Vec x, Vec y);
+    friend PetscErrorCode PetscKSPMonitor<T>(KSP K,PetscInt n, PetscReal rnorm, void *ctx);
 };
 
 #include "ParallelLinSolver_Petsc.cc"
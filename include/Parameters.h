@@ -32,6 +32,8 @@ class Parameters : public Streamable
     int sh_order;
     int filter_freq;
     int upsample_freq;
+    enum DFTType sht_dft;
+    enum MatsIO mats_io;
 
     T bending_modulus;
     T viscosity_contrast;
@@ -43,13 +45,20 @@ class Parameters : public Streamable
     T time_tol;
     int time_iter_max;
     bool time_adaptive;
+    int time_order;
     bool solve_for_velocity;
     bool pseudospectral;
+    bool inexact_krylov;
+    bool mixed_precision;
+    bool fmm_overlap;
 
     enum SolverScheme scheme;
     enum PrecondScheme time_precond;
+    enum SolverGuess solver_guess;
+    int solver_recycle;
     enum BgFlowType bg_flow;
     enum SingularStokesRot singular_stokes;
+    enum SelfOpStorage self_op;
 
     //Reparametrization
     enum ReparamType rep_type;
@@ -63,6 +72,9 @@ class Parameters : public Streamable
     //Repulsion
     T    repul_dist;
 
+    //Near-singular setup reuse
+    T    near_skin;
+
     //Background flow
     T bg_flow_param;
     bool interaction_upsample;
@@ -72,14 +84,21 @@ class Parameters : public Streamable
     //Startup and Monitoring
     bool checkpoint;
     T checkpoint_stride;
+    Format checkpoint_format;
+    bool async_io;
     std::string write_vtk;
     std::string shape_gallery_file;
     std::string vesicle_props_file;
     std::string vesicle_geometry_file;
+    T init_volume_fraction;
+    T init_min_sep;
+    int init_seed;
+    std::string init_geometry_out;
     std::string checkpoint_file_name;
     std::string load_checkpoint;
     T error_factor;
     int num_threads;
+    int repartition_stride;
 
     //parsing
     Error_t parseInput(int argc, char** argv, const DictString_t *dict=NULL);
@@ -0,0 +1,69 @@
+#ifndef _REALFFT_H_
+#define _REALFFT_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Batched real FFT of even length n, used by SHTrans for the
+ * longitudinal (Fourier) part of the transform. The coefficients
+ * have the same ordering and scaling as the DFT matrices in SHTMats,
+ *
+ *   [a_0 a_1 b_1 a_2 b_2 ... a_{n/2-1} b_{n/2-1} a_{n/2}],
+ *
+ * with the synthesis
+ *
+ *   f_j = a_0 + sum_k (a_k cos(2 pi jk/n) + b_k sin(2 pi jk/n)) + a_{n/2} cos(pi j).
+ *
+ * The real input is packed into a complex sequence of length n/2,
+ * which is transformed with a mixed-radix Cooley-Tukey FFT. The
+ * input and output are <code>howmany</code> contiguous rings of n
+ * points, and rings are distributed between the OpenMP threads.
+ *
+ * The implementation is compiled in the library for float and
+ * double. An object only holds the factorization and the twiddle
+ * factors; the scratch comes from the caller, at least work_size()
+ * values for each thread that should run (forward and backward use
+ * as many threads as the scratch holds), so that one object can be
+ * used by several threads at the same time. The input and output may
+ * be the same array.
+ */
+template<typename T>
+class RealFFT
+{
+  public:
+    explicit RealFFT(int n = 0);
+
+    void init(int n);
+    int size() const {return(n_);}
+
+    /// Scratch needed by one thread
+    size_t work_size() const {return(2*(m_+max_radix_));}
+
+    /// Analysis, equivalent to multiplying each ring by SHTMats::dft_
+    void forward(const T *in, int howmany, T *out, T *work,
+        size_t work_len) const;
+
+    /**
+     * Synthesis, equivalent to multiplying each ring by
+     * SHTMats::dft_inv_ (deriv=0), dft_inv_d1_ (deriv=1), or
+     * dft_inv_d2_ (deriv=2).
+     */
+    void backward(const T *in, int howmany, T *out, int deriv, T *work,
+        size_t work_len) const;
+
+  private:
+    int n_;
+    int m_;
+    int max_radix_;
+    std::vector<int> factors_; /* pairs of (radix, remaining length) */
+
+    // complex arrays stored as interleaved (re, im) pairs
+    std::vector<T> tw_fwd_;    /* exp(-2 pi i k/m) */
+    std::vector<T> tw_bwd_;    /* exp(+2 pi i k/m) */
+    std::vector<T> tw_half_;   /* exp(-2 pi i k/n), k=0..m */
+
+    int num_threads(int howmany, size_t work_len) const;
+};
+
+#endif //_REALFFT_H_
@@ -3,6 +3,7 @@
 
 #include <omp.h>
 #include <cassert>
+#include <vector>
 #include "Error.h"
 
 /**
@@ -16,10 +17,17 @@ template<typename T>
 class Repartition
 {
   public:
-    ///The function pointer type for the external repartitioning function.
+    /**
+     * The function pointer type for the external repartitioning
+     * function. <tt>weight</tt> is the cost of each vesicle (uniform
+     * when <tt>NULL</tt>) and <tt>data</tt> holds <tt>data_dof</tt>
+     * values per vesicle that move with the vesicle (returned in
+     * <tt>datar</tt> when <tt>data_dof>0</tt>).
+     */
     typedef void(*GlobalRepart_t)(size_t nv, size_t stride,
-        const T* x, const T* tension, size_t* nvr, T** xr,
-        T** tensionr, void** context);
+        const T* x, const T* tension, const T* weight,
+        size_t data_dof, const T* data, size_t* nvr, T** xr,
+        T** tensionr, T** datar, void** context);
 
     //Deallocator for the context
     typedef void(*Dealloc_t)(void**);
@@ -38,11 +46,16 @@ class Repartition
      * The function called from each thread.
      * @param coord The Cartesian coordinate of the points
      * @param tension The tension associated with each point.
-     * @param user_ptr the user-defined pointer that may be needed
-     * depending on the external repartitioning function.
+     * @param weight The cost of each vesicle (host), optional.
+     * @param ves_data Per vesicle data (host, <tt>data_dof</tt>
+     * values per vesicle) that is migrated with the vesicles,
+     * optional. The weight and data are only supported when called
+     * from a single thread.
      */
     template<typename VecContainer, typename ScaContainer>
-    Error_t operator()(VecContainer &coord, ScaContainer &tension) const;
+    Error_t operator()(VecContainer &coord, ScaContainer &tension,
+        const std::vector<T> *weight = NULL,
+        std::vector<T> *ves_data = NULL, size_t data_dof = 0) const;
 
   private:
     GlobalRepart_t g_repart_handle_;
@@ -60,6 +73,7 @@ class Repartition
 
     mutable T* posr_;
     mutable T* tensionr_;
+    mutable T* datar_;
     mutable size_t nvr_;
     mutable void* context_;
 
@@ -14,6 +14,7 @@ class SHTMats{
     T *data_;
     int dft_size;
     const Device &device_;
+    DFTType dft_type_;
 
     void gen_dft_forward();
     void gen_dft_backward();
@@ -23,7 +24,8 @@ class SHTMats{
   public:
     SHTMats(const Device &dev, int sh_order,
         T *data, bool genrateMats = false,
-        std::pair<int, int> gird_dim = EMPTY_GRID);
+        std::pair<int, int> gird_dim = EMPTY_GRID,
+        DFTType dft_type = GemmDFT);
     ~SHTMats();
 
     inline int getShOrder() const;
@@ -37,6 +39,9 @@ class SHTMats{
     inline T* getData();
     inline const Device& getDevice() const;
 
+    /// longitudinal transform of the SHTrans objects built on these matrices
+    DFTType getDFTType() const {return(dft_type_);}
+
     T *dft_;
     T *dft_inv_;
     T *dft_inv_d1_;
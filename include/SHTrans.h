@@ -1,6 +1,9 @@
 #ifndef _SHTRANS_H_
 #define _SHTRANS_H_
 
+#include "Enums.h"
+#include "RealFFT.h"
+
 /**
  * Spherical Harmonics Transform (SHT) class. The template parameter
  * <code>Container</code> is assumed to have a static method <code>
@@ -12,6 +15,11 @@
  * Analysis and Synthesis matrices of discrete Fourier transform,
  * discrete Legendre transform, and first and second derivatives of
  * latitude(Legendre) variable. See SHTMats for more information.
+ *
+ * The longitudinal transform is either a dense DFT matrix multiply
+ * (<code>GemmDFT</code>) or a batched real FFT (<code>FFTDFT</code>,
+ * host devices only). Unless given to the constructor, it is taken
+ * from <code>mats.getDFTType()</code>.
  */
 template<typename Container, typename Mats>
 class SHTrans
@@ -21,12 +29,14 @@ class SHTrans
 
   public:
     SHTrans(int sh_order_in, const Mats &mats, int filter_freq = -1,
-            value_type filter_exponent=4.0);
+            value_type filter_exponent=4.0,
+            DFTType dft_type=UnknownDFT);
     ~SHTrans();
 
     int getShOrder() const {return(p);}
     int getShFilterFreq() const {return(filter_freq_);}
     value_type getShFilterExponent() const {return(filter_exponent_);}
+    DFTType getDFTType() const {return(dft_type_);}
 
     /**
      * The Synthesis method. The input is in real space and the output
@@ -75,6 +85,8 @@ class SHTrans
     int dft_size;
     int filter_freq_;
     value_type filter_exponent_;
+    DFTType dft_type_;
+    RealFFT<value_type> fft_;
 
     /**
      * The forward and inverse Legendre transform. The case of forward
@@ -98,10 +110,11 @@ class SHTrans
         value_type *outputs, int m, int n , int k, int mf,
         int nf, int kf) const;
 
-    ///The inverse transform.
+    ///The inverse transform. dft_deriv is the order of the
+    ///longitudinal derivative in dft (used by the FFT).
     void back(const value_type *inputs, value_type *work_arr,
         int n_funs, value_type *outputs, value_type *trans,
-        value_type *dft) const;
+        value_type *dft, int dft_deriv) const;
 
     value_type* filter_coeff_;
     value_type* filter_coeff_poly_;
@@ -2,18 +2,77 @@
 #define _SPHERICAL_HARMONICS_H_
 
 #include <matrix.hpp>
+#include <vector>
 #define SHMAXDEG 256
 
+/**
+ * Scratch storage for the spherical harmonic transforms. Buffers are
+ * handed out in stack order by Frame and keep their capacity between
+ * calls, so repeated transforms of the same size do not allocate. A
+ * workspace must not be used by two calls at the same time; concurrent
+ * tasks each need their own.
+ */
+template <class Real>
+class SHWorkspace{
+
+  public:
+
+    SHWorkspace();
+
+    ~SHWorkspace();
+
+    // Buffers of one call, returned to the workspace on destruction. A
+    // NULL workspace gives a temporary one owned by the frame.
+    class Frame{
+      public:
+        Frame(SHWorkspace* ws);
+        ~Frame();
+
+        pvfmm::Vector<Real>& Get();
+
+        // For nested calls, which push their buffers above ours
+        SHWorkspace* Workspace(){return ws_;}
+
+      private:
+        Frame(const Frame &);
+        Frame& operator=(const Frame &);
+
+        SHWorkspace* own_;
+        SHWorkspace* ws_;
+        size_t top0_;
+    };
+
+    // Bytes held by the buffers
+    size_t Bytes() const;
+
+    // Largest number of bytes in use at once
+    size_t HighWaterMark() const{return high_water_;}
+
+    // Release the buffers (not while a frame is open)
+    void Clear();
+
+  private:
+
+    friend class Frame;
+
+    SHWorkspace(const SHWorkspace &);
+    SHWorkspace& operator=(const SHWorkspace &);
+
+    std::vector<pvfmm::Vector<Real>*> buf_;
+    size_t top_;
+    size_t high_water_;
+};
+
 template <class Real>
 class SphericalHarmonics{
 
   public:
 
-    static void SHC2Grid(const pvfmm::Vector<Real>& S, long p0, long p1, pvfmm::Vector<Real>& X, pvfmm::Vector<Real>* X_theta=NULL, pvfmm::Vector<Real>* X_phi=NULL);
+    static void SHC2Grid(const pvfmm::Vector<Real>& S, long p0, long p1, pvfmm::Vector<Real>& X, pvfmm::Vector<Real>* X_theta=NULL, pvfmm::Vector<Real>* X_phi=NULL, SHWorkspace<Real>* ws=NULL);
 
-    static void Grid2SHC(const pvfmm::Vector<Real>& X, long p0, long p1, pvfmm::Vector<Real>& S);
+    static void Grid2SHC(const pvfmm::Vector<Real>& X, long p0, long p1, pvfmm::Vector<Real>& S, SHWorkspace<Real>* ws=NULL);
 
-    static void SHC2GridTranspose(const pvfmm::Vector<Real>& X, long p0, long p1, pvfmm::Vector<Real>& S);
+    static void SHC2GridTranspose(const pvfmm::Vector<Real>& X, long p0, long p1, pvfmm::Vector<Real>& S, SHWorkspace<Real>* ws=NULL);
 
     static void SHC2Pole(const pvfmm::Vector<Real>& S, long p0, pvfmm::Vector<Real>& P);
 
@@ -41,7 +100,7 @@ class SphericalHarmonics{
 
     static std::vector<pvfmm::Matrix<Real> >& MatRotate(long p0);
 
-    static void StokesSingularInteg(const pvfmm::Vector<Real>& S, long p0, long p1, pvfmm::Vector<Real>* SLMatrix=NULL, pvfmm::Vector<Real>* DLMatrix=NULL);
+    static void StokesSingularInteg(const pvfmm::Vector<Real>& S, long p0, long p1, pvfmm::Vector<Real>* SLMatrix=NULL, pvfmm::Vector<Real>* DLMatrix=NULL, SHWorkspace<Real>* ws=NULL);
 
   private:
 
@@ -60,7 +119,18 @@ class SphericalHarmonics{
     static void LegPolyDeriv(Real* poly_val, const Real* X, long N, long degree);
 
     template <bool SLayer, bool DLayer>
-    static void StokesSingularInteg_(const pvfmm::Vector<Real>& X0, long p0, long p1, pvfmm::Vector<Real>& SL, pvfmm::Vector<Real>& DL);
+    static void StokesSingularInteg_(const pvfmm::Vector<Real>& X0, long p0, long p1, pvfmm::Vector<Real>& SL, pvfmm::Vector<Real>& DL, SHWorkspace<Real>* ws);
+
+    // The operators below are built on first use. Each entry is built
+    // once under a critical section named after its cache (the builders
+    // call each other) and published by an atomic flag in done_, so
+    // concurrent callers only wait for the entry they need.
+    enum CacheId {QxCache, QwCache, SwCache, MfCache, MdfCache, MlCache,
+      MdlCache, MrCache, MfinvCache, MlinvCache, NumCaches};
+
+    static bool CacheReady(int cache, long idx);
+
+    static void CacheSetReady(int cache, long idx);
 
     static struct MatrixStorage{
       MatrixStorage(int size){
@@ -74,6 +144,7 @@ class SphericalHarmonics{
         Mr_ .resize(size);
         Mfinv_ .resize(size*size);
         Mlinv_ .resize(size*size);
+        done_  .resize(NumCaches*size*size, 0);
       }
       std::vector<pvfmm::Vector<Real> > Qx_;
       std::vector<pvfmm::Vector<Real> > Qw_;
@@ -85,6 +156,7 @@ class SphericalHarmonics{
       std::vector<std::vector<pvfmm::Matrix<Real> > > Mr_;
       std::vector<pvfmm::Matrix<Real> > Mfinv_ ;
       std::vector<std::vector<pvfmm::Matrix<Real> > > Mlinv_ ;
+      std::vector<int> done_;
     } matrix;
 
 };
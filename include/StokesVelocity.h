@@ -4,7 +4,11 @@
 #include <mpi.h>
 #include "PVFMMInterface.h"
 #include "NearSingular.h"
+#include "SphericalHarmonics.h"
+#include "Enums.h"
+#include "AsyncWriter.h"
 #include <matrix.hpp>
+#include <vector>
 
 template <class Real>
 class StokesVelocity{
@@ -13,7 +17,7 @@ class StokesVelocity{
 
   public:
 
-    StokesVelocity(int sh_order, int sh_order_up, Real box_size=-1, Real repul_dist=1e-3, MPI_Comm c=MPI_COMM_WORLD);
+    StokesVelocity(int sh_order, int sh_order_up, Real box_size=-1, Real repul_dist=1e-3, MPI_Comm c=MPI_COMM_WORLD, SelfOpStorage self_op=FullSelfOp);
 
     ~StokesVelocity();
 
@@ -22,6 +26,14 @@ class StokesVelocity{
     template<class Vec>
     void SetSrcCoord(const Vec& S, int sh_order_up_self_=-1, int sh_order_up_=-1);
 
+    // A density may hold k densities on the current geometry one after
+    // the other; the velocities are then returned in the same order. The
+    // setup transforms and the self interaction (one GEMM over all k
+    // densities) are shared; the far and near interactions still run
+    // once per density, reusing the FMM tree and the near setup.
+    // Single- and double-layer densities must agree in number and
+    // repulsion is only added for k=1. No solver evaluates more than one
+    // density yet; NearSingularTest times the pass against k.
     void SetDensitySL(const PVFMMVec* force_single=NULL, bool add_repul=false);
 
     template<class Vec>
@@ -39,8 +51,48 @@ class StokesVelocity{
     template<class Vec>
     void operator()(Vec& vel);
 
+    // Velocity of the self interaction only (no near or far field),
+    // used to assemble the block-Jacobi preconditioner
+    template<class Vec>
+    void SelfVelocity(Vec& vel);
+
     Real MonitorError(Real tol=1e-5);
 
+    // Far-field accuracy of the following evaluations (inexact
+    // Krylov). Level 0 is the default FMM context, higher levels use a
+    // lower multipole order and a cheaper kernel with one context
+    // cached per level. Selects the cheapest level with nominal error
+    // at most tol (tol<=0 gives level 0) and returns it.
+    int SetAccuracy(Real tol);
+    static int AccuracyLevels();
+    static Real AccuracyTol(int level);
+
+    // Bytes per vesicle held by the self-interaction operator
+    size_t SelfOpBytes() const;
+
+    // Peak scratch memory of the spherical harmonic transforms
+    size_t WorkspaceBytes() const{return sh_ws.HighWaterMark();}
+
+    // Number of near-singular targets of each local vesicle
+    const pvfmm::Vector<size_t>& NearTargetCount() const{return near_singular0.NearTargetCount();}
+
+    // Reuse the near-singular setup while points move less than skin*r_near
+    void SetNearSkin(Real skin);
+
+    // Evaluate the far field on its own thread team while the other
+    // threads compute the self interaction (and the near interaction
+    // if MPI provides MPI_THREAD_MULTIPLE)
+    void SetOverlap(bool overlap);
+
+    // Fraction of the shorter of the far and local evaluations hidden
+    // behind the other, over all the overlapped evaluations
+    Real OverlapRatio() const;
+
+    // Fraction of the surface-to-surface near setups that were reused
+    Real NearSetupReuseRatio() const{return near_singular0.SetupReuseRatio();}
+    // Slowest over mean thread busy time of a surface-to-surface near phase
+    double NearThreadImbalance(const char* phase) const{return near_singular0.ThreadImbalance(phase);}
+
     static void Test();
 
   private:
@@ -53,7 +105,11 @@ class StokesVelocity{
     int sh_order_up;
     Real box_size;
     MPI_Comm comm;
+    MPI_Comm near_comm; // duplicate of comm, the near interaction may overlap the far field
+    static MPI_Comm DupComm(MPI_Comm c);
 
+    // Scratch of the transforms and self-interaction of this instance
+    SHWorkspace<Real> sh_ws;
 
     PVFMMVec scoord;
     PVFMMVec scoord_far;
@@ -76,9 +132,16 @@ class StokesVelocity{
 
 
     // Self
+    SelfOpStorage self_op;
     PVFMMVec SLMatrix, DLMatrix;
+    pvfmm::Vector<float> SLMatrix_sp, DLMatrix_sp; // self_op==SingleSelfOp
     PVFMMVec S_vel, S_vel_up;
 
+    void SelfInteraction();
+    void SetupSelfMatrix(bool sl, bool dl);
+    void SelfMatVec(const PVFMMVec* Fs, const PVFMMVec* Fd, PVFMMVec& SL_vel, PVFMMVec& DL_vel);
+    void ClearSelfMatrix();
+
 
     // Near
     NearSingular<Real> near_singular0; // Surface-to-Surface interaction
@@ -88,7 +151,26 @@ class StokesVelocity{
     // Far
     bool fmm_setup;
     void* pvfmm_ctx;
+    int fmm_level;
+    std::vector<void*> pvfmm_ctx_lvl; // created on first use, level 0 unused
+    std::vector<char> fmm_stale;      // context tree needs setup
     PVFMMVec fmm_vel;
+    void FarInteraction(PVFMMVec& trg_coord, const PVFMMVec& qs, const PVFMMVec& qd, PVFMMVec& vel);
+
+
+    // Several densities on the same geometry, stacked one after the other
+    long DensityCount() const;
+    PVFMMVec qforce_single_r, qforce_double_r, uforce_double_r, S_vel_up_r; // views of one density
+    PVFMMVec near_vel_batch;
+    void BatchedInteraction(NearSingular<Real>& near_singular, PVFMMVec& trg_coord, long n_rhs);
+
+
+    // Overlap of far with self and near
+    bool fmm_overlap;
+    Real fmm_share;        // fraction of the threads given to the far field
+    double overlap_hidden; // seconds hidden by the overlap
+    double overlap_total;  // seconds that could have been hidden
+    void PipelinedInteraction(NearSingular<Real>& near_singular, PVFMMVec& trg_coord);
 
 };
 
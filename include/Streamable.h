@@ -93,7 +93,8 @@ class Streamable{
     // utility function
     // ------------------------------------------------------------------------
 
-    //! pack an array of type T and size n to the stream.
+    //! pack an array of type T and size n to the stream. In BIN
+    //! format, the raw bytes are written and sep is ignored.
     template<typename T>
     Error_t pack_array(std::ostream &os, Format format, const T* arr, size_t n, const char *sep=" ") const;
 
@@ -114,6 +115,10 @@ class Streamable{
 //! function.
 std::ostream& operator<<(std::ostream& os, const Streamable *o);
 
+//! ASCII or BIN, anything else is treated as ASCII
+Streamable::Format EnumifyFormat(const char * name);
+std::ostream& operator<<(std::ostream& output, const Streamable::Format &F);
+
 #include "Streamable.cc"
 
 #endif //_STREAMABLE_H_
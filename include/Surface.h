@@ -49,6 +49,11 @@ class Surface : public Streamable
     Vec_t& getPositionModifiable();
     const Vec_t& getPosition() const;
 
+    //! Renewed whenever the position may change (setPosition,
+    //! getPositionModifiable, unpack) and unique among all surfaces;
+    //! keys caches of data derived from the position
+    size_t getPositionVersion() const { return position_version_; }
+
     const Vec_t& getNormal() const;
     const Sca_t& getAreaElement() const;
     const Sca_t& getMeanCurv() const;
@@ -59,6 +64,8 @@ class Surface : public Streamable
 
     void area(Sca_t &area) const;
     void volume(Sca_t &vol) const;
+    //! area and volume in one pass over the surface
+    void areaVolume(Sca_t &area, Sca_t &vol) const;
     void getCenters(Vec_t &centers) const;
 
     void getSmoothedShapePosition(Vec_t &smthd_pos) const;
@@ -111,6 +118,8 @@ class Surface : public Streamable
     mutable bool containers_are_stale_;
     mutable bool first_forms_are_stale_;
     mutable bool second_forms_are_stale_;
+    size_t position_version_;
+    static size_t newVersion() { static size_t v(0); return ++v; }
 
     void updateFirstForms() const;
     void updateAll() const;
@@ -0,0 +1,132 @@
+/**
+ * @file   SuspensionGenerator.h
+ *
+ * @brief  Parallel generator of dense initial suspensions.
+ */
+
+/*
+ * Copyright (c) 2014, Abtin Rahimian
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _SUSPENSIONGENERATOR_H_
+#define _SUSPENSIONGENERATOR_H_
+
+#include <map>
+#include <vector>
+#include "Error.h"
+#include "Logger.h"
+#include "HelperFuns.h"
+
+/**
+ * Places vesicles from the shape gallery in a box (or the periodic
+ * domain) at a target volume fraction, with random shape and
+ * orientation, and returns their geometry in the same 8 fields per
+ * vesicle as the vesicle geometry file: shape_idx scale center_x
+ * center_y center_z rot_z rot_y rot_z.
+ *
+ * The box is split between the MPI processes on a Cartesian grid and
+ * each process fills its own cell by random sequential addition. The
+ * cells are colored so that neighbors never place at the same time;
+ * after each color the placed vesicles near the cell faces are sent
+ * to the neighbors. The overlap check looks up the vesicles of the
+ * neighboring bins of a spatial hash (local and neighbor vesicles
+ * only), compares the bounding spheres and then the distance between
+ * the surface points, which assumes vesicles of comparable size (one
+ * cannot fit inside another).
+ */
+template<typename T>
+class SuspensionGenerator
+{
+  public:
+    /**
+     * @param shapes The shape gallery, DIM*stride values per shape
+     * (as in the shape gallery file).
+     * @param stride The number of points of each shape.
+     * @param volumes The enclosed volume of each shape.
+     */
+    SuspensionGenerator(const std::vector<T> &shapes, int stride,
+        const std::vector<T> &volumes);
+
+    /**
+     * Collective, fills geo_spec with the geometry of nves vesicles
+     * of this process.
+     *
+     * @param volume_fraction The target volume fraction.
+     * @param periodic_length When positive, the vesicles are placed
+     * in the periodic domain [0,periodic_length)^3 and scaled to match
+     * the volume fraction; otherwise the shapes keep their size and
+     * the side of the box [0,L]^3 of the centers is set by the volume
+     * fraction (the vesicles near the faces stick out of the box).
+     * @param min_sep The minimum distance between vesicles.
+     * @param seed The seed of the random numbers (the result depends
+     * on the seed and the number of processes).
+     */
+    Error_t operator()(int nves, T volume_fraction, T periodic_length,
+        T min_sep, int seed, std::vector<T> &geo_spec);
+
+    //! The side of the box of the last call
+    T BoxSize() const { return box_; }
+
+    //! The scale of the vesicles of the last call
+    T Scale() const { return scale_; }
+
+  private:
+    //! A placed vesicle, with its points relative to its center
+    struct Vesicle{
+        T geo[8];
+        T radius;
+        T spacing;
+        std::vector<T> pts;
+    };
+
+    typedef std::map<long, std::vector<int> > Hash_t;
+
+    void transform(Vesicle &ves) const;
+    T uniform();
+    long bin(const T *c, int *ijk = NULL) const;
+    void insert(Hash_t &hash, const Vesicle &ves, int idx) const;
+    bool overlaps(const Vesicle &ves, const Hash_t &hash) const;
+    bool overlaps(const Vesicle &a, const Vesicle &b) const;
+
+    int stride_;
+    int nshapes_;
+    std::vector<T> shapes_;
+    std::vector<T> volumes_;
+    std::vector<T> radius_;   //bounding radius of each shape
+    std::vector<T> spacing_;  //largest distance to the nearest point
+
+    T box_;
+    T scale_;
+    T min_sep_;
+    bool periodic_;
+    int nbins_;
+    T bin_size_;
+    unsigned short rng_[3];
+
+    std::vector<Vesicle> local_;
+    std::vector<Vesicle> halo_;
+};
+
+#include "SuspensionGenerator.cc"
+
+#endif //_SUSPENSIONGENERATOR_H_
@@ -40,6 +40,28 @@ void Steqr(char *compz, int &n, double *d, double *e, double *z,
     dsteqr(compz, &n, d, e, z, &ldz, work, &info);
 }
 
+void Getrf(int &m, int &n, float *a, int &lda, int *ipiv, int &info)
+{
+    sgetrf(&m, &n, a, &lda, ipiv, &info);
+}
+
+void Getrf(int &m, int &n, double *a, int &lda, int *ipiv, int &info)
+{
+    dgetrf(&m, &n, a, &lda, ipiv, &info);
+}
+
+void Getrs(const char *trans, int &n, int &nrhs, const float *a, int &lda,
+    const int *ipiv, float *b, int &ldb, int &info)
+{
+    sgetrs(trans, &n, &nrhs, a, &lda, ipiv, b, &ldb, &info);
+}
+
+void Getrs(const char *trans, int &n, int &nrhs, const double *a, int &lda,
+    const int *ipiv, double *b, int &ldb, int &info)
+{
+    dgetrs(trans, &n, &nrhs, a, &lda, ipiv, b, &ldb, &info);
+}
+
 #ifdef GPU_ACTIVE
 #include "cublas.h"
 
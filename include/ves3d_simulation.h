@@ -41,6 +41,7 @@
 #include "ves3d_common.h"
 #include "Logger.h"
 #include "DataIO.h"
+#include "SuspensionGenerator.h"
 
 #include <fstream>
 #include <sstream>
@@ -59,10 +60,12 @@ class Simulation{
     typedef EvolveSurface<real_t, DT, DEVICE> Evolve_t;
     typedef typename Evolve_t::Params_t Param_t;
     typedef typename Evolve_t::VProp_t VProp_t;
+    typedef typename Evolve_t::Sur_t Sur_t;
     typedef typename Evolve_t::Arr_t Arr_t;
     typedef typename Evolve_t::Vec_t Vec_t;
     typedef typename Evolve_t::value_type value_type;
     typedef typename Evolve_t::Interaction_t Inter_t;
+    typedef typename Evolve_t::Repartition_t Repart_t;
     typedef typename Evolve_t::Mats_t Mats_t;
     typedef BgFlowBase<Vec_t> Flow_t;
     typedef ParallelLinSolver<real_t> LinSol_t;
@@ -80,6 +83,7 @@ class Simulation{
     Error_t setup_basics();
     Error_t setup_from_options();
     Error_t setup_from_checkpoint();
+    Error_t redistribute_checkpoint();
     Error_t cleanup_run();
     Error_t prepare_run_params(const Param_t &ip);
     Error_t prepare_run_params(int argc, char **argv, const DictString_t *dict);
@@ -87,6 +91,8 @@ class Simulation{
   private:
     Param_t run_params_;
     std::stringstream checkpoint_data_;
+    std::string checkpoint_file_;
+    DataIO::BlockHeader checkpoint_header_;
 
     bool load_checkpoint_;
     VProp_t *ves_props_;
@@ -94,6 +100,7 @@ class Simulation{
     Flow_t *vInf_;
     LinSol_t *ksp_;
     Inter_t *interaction_;
+    Repart_t *repartition_;
     Evolve_t *timestepper_;
 };
 
@@ -2,7 +2,8 @@ template<typename T, typename DT, const DT &DEVICE>
 Array<T, DT, DEVICE>::Array(size_t size) :
     size_(size),
     capacity_(size_),
-    data_((capacity_ > 0) ? (T*) DEVICE.Malloc(capacity_ * sizeof(T)) : NULL)
+    data_((capacity_ > 0) ? (T*) DEVICE.Malloc(capacity_ * sizeof(T)) : NULL),
+    own_data_(true)
 {
     //to count the number of calls
     PROFILESTART();
@@ -11,7 +12,7 @@ Array<T, DT, DEVICE>::Array(size_t size) :
 
 template<typename T, typename DT, const DT &DEVICE>
 Array<T, DT, DEVICE>::Array(std::istream &is, Format format) :
-    size_(0), capacity_(0), data_(NULL)
+    size_(0), capacity_(0), data_(NULL), own_data_(true)
 {
     //to count the number of calls
     PROFILESTART();
@@ -24,7 +25,7 @@ Array<T, DT, DEVICE>::~Array()
 {
     //mostly for counting the # of calls
     PROFILESTART();
-    DEVICE.Free(this->data_);
+    if (own_data_) DEVICE.Free(this->data_);
     PROFILEEND("",0);
 }
 
@@ -63,22 +64,36 @@ void Array<T, DT, DEVICE>::resize(size_t new_size)
                 this->mem_size(),
                 DT::MemcpyDeviceToDevice);
 
-            DEVICE.Free(data_);
+            if (own_data_) DEVICE.Free(data_);
         }
         data_ = data_new;
         capacity_ = new_size;
+        own_data_ = true;
     }
     else if ( new_size == 0 && data_ != NULL )
     {
-        DEVICE.Free(data_);
+        if (own_data_) DEVICE.Free(data_);
         data_ = NULL;
         capacity_ = 0;
+        own_data_ = true;
     }
 
     size_ = new_size;
     PROFILEEND("",0);
 }
 
+template<typename T, typename DT, const DT &DEVICE>
+void Array<T, DT, DEVICE>::wrap(T *data, size_t capacity)
+{
+    if ( own_data_ && data_ != NULL )
+        DEVICE.Free(data_);
+
+    data_      = data;
+    capacity_  = (data == NULL) ? 0 : capacity;
+    size_      = 0;
+    own_data_  = (data == NULL);
+}
+
 template<typename T, typename DT, const DT &DEVICE>
 typename Array<T, DT, DEVICE>::iterator Array<T, DT, DEVICE>::begin()
 {
@@ -106,11 +121,9 @@ typename Array<T, DT, DEVICE>::const_iterator Array<T, DT, DEVICE>::end() const
 template<typename T, typename DT, const DT &DEVICE>
 Error_t Array<T, DT, DEVICE>::pack(std::ostream &os, Format format) const
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
-
     const T *buffer(begin());
 
-    if (DT::IsHost()){
+    if (!DT::IsHost()){
 	T* bb = new T[size()];
 	buffer = bb;
 	DEVICE.Memcpy(
@@ -124,8 +137,15 @@ Error_t Array<T, DT, DEVICE>::pack(std::ostream &os, Format format) const
     os<<"version: "<<VERSION<<"\n";
     os<<"name: "<<Streamable::name_<<"\n";
     os<<"size: "<<size()<<"\n";
-    os<<"data: ";
-    pack_array(os, format, buffer, size());
+    if (format==Streamable::BIN){
+        os<<"word: "<<sizeof(T)<<"\n";
+        os<<"data:\n";
+        pack_array(os, format, buffer, size());
+        os<<"\nchecksum: "<<DataIO::Checksum(reinterpret_cast<const char*>(buffer), mem_size());
+    } else {
+        os<<"data: ";
+        pack_array(os, format, buffer, size());
+    }
     os<<"\n/ARRAY\n";
 
     if (!DT::IsHost())
@@ -137,7 +157,6 @@ Error_t Array<T, DT, DEVICE>::pack(std::ostream &os, Format format) const
 template<typename T, typename DT, const DT &DEVICE>
 Error_t Array<T, DT, DEVICE>::unpack(std::istream &is, Format format)
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
     std::string s, key;
     int version(0);
     is>>s;
@@ -156,8 +175,24 @@ Error_t Array<T, DT, DEVICE>::unpack(std::istream &is, Format format)
     ASSERT(key=="size:", "bad key");
     resize(sz);
     is>>key;
+    if (format==Streamable::BIN){
+        size_t word(0);
+        is>>word;
+        ASSERT(key=="word:", "bad key");
+        ASSERT(word==sizeof(T), "incompatible data (word size "<<word<<"), cannot unpack");
+        is>>key;
+        is.get(); // newline before the data
+    }
     ASSERT(key=="data:", "bad key");
-    unpack_array(is, format, begin(), sz);
+    Error_t ierr(unpack_array(is, format, begin(), sz));
+    ASSERT(ierr==ErrorEvent::Success, "Truncated data for "<<Streamable::name_<<" ("<<sz<<" entries read)");
+    if (format==Streamable::BIN){
+        unsigned long cs(0);
+        is>>key>>cs;
+        ASSERT(key=="checksum:", "bad key");
+        ASSERT(cs==DataIO::Checksum(reinterpret_cast<const char*>(begin()), mem_size()),
+            "Checksum mismatch for "<<Streamable::name_);
+    }
     is>>s;
     ASSERT(s=="/ARRAY", "Bad input string (missing footer).");
 
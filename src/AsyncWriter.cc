@@ -0,0 +1,135 @@
+#include "AsyncWriter.h"
+#include <fstream>
+
+AsyncWriter::AsyncWriter(size_t max_jobs) :
+    max_jobs_(max_jobs>0 ? max_jobs : 1),
+    busy_(0),
+    stop_(false),
+    status_(ErrorEvent::Success)
+{
+    pthread_mutex_init(&lock_, NULL);
+    pthread_cond_init(&has_job_, NULL);
+    pthread_cond_init(&has_room_, NULL);
+    pthread_cond_init(&idle_, NULL);
+    pthread_create(&thread_, NULL, &AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    flush();
+
+    pthread_mutex_lock(&lock_);
+    stop_ = true;
+    pthread_cond_signal(&has_job_);
+    pthread_mutex_unlock(&lock_);
+    pthread_join(thread_, NULL);
+
+    pthread_cond_destroy(&idle_);
+    pthread_cond_destroy(&has_room_);
+    pthread_cond_destroy(&has_job_);
+    pthread_mutex_destroy(&lock_);
+}
+
+Error_t AsyncWriter::push(const std::string &fname, std::string &data, long long offset)
+{
+    pthread_mutex_lock(&lock_);
+    if (busy_>=max_jobs_){
+        // back-pressure, the file system is behind
+        double t0(omp_get_wtime());
+        while (busy_>=max_jobs_)
+            pthread_cond_wait(&has_room_, &lock_);
+        WARN("Waited "<<omp_get_wtime()-t0<<"s for the IO queue before writing "<<fname);
+    }
+
+    queue_.push_back(Job());
+    Job &job(queue_.back());
+    job.fname  = fname;
+    job.offset = offset;
+    job.data.swap(data);
+    ++busy_;
+
+    Error_t ierr(status_);
+    status_ = ErrorEvent::Success;
+    pthread_cond_signal(&has_job_);
+    pthread_mutex_unlock(&lock_);
+
+    return ierr;
+}
+
+Error_t AsyncWriter::flush()
+{
+    pthread_mutex_lock(&lock_);
+    while (busy_>0)
+        pthread_cond_wait(&idle_, &lock_);
+
+    Error_t ierr(status_);
+    status_ = ErrorEvent::Success;
+    pthread_mutex_unlock(&lock_);
+
+    return ierr;
+}
+
+size_t AsyncWriter::pending() const
+{
+    pthread_mutex_lock(&lock_);
+    size_t n(busy_);
+    pthread_mutex_unlock(&lock_);
+    return n;
+}
+
+Error_t AsyncWriter::Write(const std::string &fname, const std::string &data,
+    long long offset)
+{
+    std::ios_base::openmode mode(std::ios::binary | std::ios::out);
+    if (offset>=0) mode |= std::ios::in;
+
+    std::fstream fh(fname.c_str(), mode);
+    if(!fh){
+        CERR_LOC("Cannot open file for writing: "<<fname, "", NULL);
+        return ErrorEvent::IOError;
+    }
+
+    if (offset>0) fh.seekp(offset);
+    fh.write(data.data(), data.size());
+    fh.close();
+
+    if(fh.fail()){
+        CERR_LOC("Failed writing "<<data.size()<<" bytes to "<<fname, "", NULL);
+        return ErrorEvent::IOError;
+    }
+
+    return ErrorEvent::Success;
+}
+
+void* AsyncWriter::run(void *self)
+{
+    static_cast<AsyncWriter*>(self)->loop();
+    return NULL;
+}
+
+void AsyncWriter::loop()
+{
+    Job job;
+    pthread_mutex_lock(&lock_);
+    while (true){
+        while (queue_.empty() && !stop_)
+            pthread_cond_wait(&has_job_, &lock_);
+        if (queue_.empty()) break;
+
+        job.fname.swap(queue_.front().fname);
+        job.data.swap(queue_.front().data);
+        job.offset = queue_.front().offset;
+        queue_.pop_front();
+        pthread_mutex_unlock(&lock_);
+
+        Error_t ierr(Write(job.fname, job.data, job.offset));
+        std::string().swap(job.data);
+
+        pthread_mutex_lock(&lock_);
+        if (ierr) status_ = ierr;
+        --busy_;
+        pthread_cond_signal(&has_room_);
+        if (busy_==0) pthread_cond_broadcast(&idle_);
+    }
+    pthread_mutex_unlock(&lock_);
+}
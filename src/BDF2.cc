@@ -0,0 +1,25 @@
+template<typename T>
+BDF2Coeffs<T>::BDF2Coeffs(T dt, T dt1, T dt0) :
+    start(0),
+    extrap(0),
+    step(dt),
+    pred1(0),
+    pred2(0),
+    err_scale(0)
+{
+    T w(dt/dt1);
+    start  = w*w/(1+2*w);
+    extrap = w;
+    step   = dt*(1+w)/(1+2*w);
+
+    if (dt0>0){
+        pred1 = dt/dt1 + dt*(dt+dt1)/(dt1*(dt1+dt0));
+        pred2 = -dt*(dt+dt1)/(dt0*(dt1+dt0));
+
+        // the local errors of BDF2 and of the predictor are -C dt^3
+        // x''' and P dt^3 x'''
+        T C((1+w)*(1+w)/(6*w*(1+2*w)));
+        T P((1+1/w)*(1+1/w+dt0/dt)/6);
+        err_scale = C/(P+C);
+    }
+}
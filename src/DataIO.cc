@@ -1,4 +1,7 @@
 #include "DataIO.h"
+#include "AsyncWriter.h"
+#include <algorithm>
+#include <sstream>
 
 DataIO::DataIO(std::string file_name, IOFormat frmt,
     size_t buffer_size, int resize_factor) :
@@ -100,6 +103,455 @@ Error_t DataIO::DumpFile(const char* fname, std::ostream &content)
     return ErrorEvent::Success;
 }
 
+unsigned long DataIO::Checksum(const char* buf, size_t len, unsigned long sum)
+{
+    const unsigned long mod(65521);
+    unsigned long a(sum & 0xffff), b((sum >> 16) & 0xffff);
+
+    // 5552 is the largest run that does not overflow 32 bits
+    while (len > 0){
+        size_t n(len < 5552 ? len : 5552);
+        len -= n;
+        for (;n>0;--n,++buf){
+            a += (unsigned char) *buf;
+            b += a;
+        }
+        a %= mod;
+        b %= mod;
+    }
+
+    return (b << 16) | a;
+}
+
+Error_t DataIO::DumpBlocks(const char* fname, const std::string &preamble,
+    const std::string &block, size_t count, AsyncWriter *writer)
+{
+    int nproc(1), rank(0);
+#ifdef HAS_MPI
+    MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
+
+    unsigned long long loc[3], *all(NULL);
+    loc[0] = count;
+    loc[1] = block.size();
+    loc[2] = Checksum(block.data(), block.size());
+
+    if (rank==0) all = new unsigned long long[3*nproc];
+#ifdef HAS_MPI
+    MPI_Gather(loc, 3, MPI_UNSIGNED_LONG_LONG, all, 3, MPI_UNSIGNED_LONG_LONG,
+        0, VES3D_COMM_WORLD);
+#else
+    all[0] = loc[0]; all[1] = loc[1]; all[2] = loc[2];
+#endif
+
+    std::string header;
+    if (rank==0){
+        std::stringstream hs;
+        hs<<"BLOCKFILE\n";
+        hs<<"version: "<<VERSION<<"\n";
+        hs<<"nblocks: "<<nproc<<"\n";
+        for (int k(0); k<3; ++k){
+            hs<<(k==0 ? "count:" : (k==1 ? "size:" : "checksum:"));
+            for (int i(0); i<nproc; ++i) hs<<" "<<all[3*i+k];
+            hs<<"\n";
+        }
+        hs<<"preamble: "<<preamble.size()<<"\n"<<preamble<<"\n/BLOCKFILE\n";
+        header = hs.str();
+        delete[] all;
+    }
+
+#ifdef HAS_MPI
+    std::string name(rank==0 ? fname : "");
+    unsigned long long lens[2] = {header.size(), name.size()};
+    MPI_Bcast(lens, 2, MPI_UNSIGNED_LONG_LONG, 0, VES3D_COMM_WORLD);
+    name.resize(lens[1]);
+    MPI_Bcast(&name[0], lens[1], MPI_CHAR, 0, VES3D_COMM_WORLD);
+
+    unsigned long long offset(0);
+    MPI_Exscan(&loc[1], &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, VES3D_COMM_WORLD);
+    if (rank==0) offset = 0;
+    offset += lens[0];
+
+    if (writer){
+        // a pending write of an earlier dump to the same file
+        // should not land after the truncation below
+        CHK(writer->flush());
+        if (rank==0) CHK(AsyncWriter::Write(name, std::string()));
+        MPI_Barrier(VES3D_COMM_WORLD);
+
+        std::string data(block);
+        if (rank==0) CHK(writer->push(name, header, 0));
+        CHK(writer->push(name, data, offset));
+        return ErrorEvent::Success;
+    }
+
+    MPI_File fh;
+    if (MPI_File_open(VES3D_COMM_WORLD, &name[0], MPI_MODE_CREATE | MPI_MODE_WRONLY,
+            MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        CERR_LOC("Cannot open file for writing: "<<name, "", exit(1));
+    MPI_File_set_size(fh, 0);
+
+    MPI_Status status;
+    if (rank==0)
+        MPI_File_write_at(fh, 0, &header[0], header.size(), MPI_CHAR, &status);
+
+    // MPI counts are int, large blocks are written in chunks
+    const unsigned long long chunk(1<<30);
+    unsigned long long nchunk((loc[1]+chunk-1)/chunk), maxchunk(0);
+    MPI_Allreduce(&nchunk, &maxchunk, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, VES3D_COMM_WORLD);
+    for (unsigned long long c(0); c<maxchunk; ++c){
+        unsigned long long b(std::min(c*chunk, loc[1]));
+        unsigned long long e(std::min(b+chunk, loc[1]));
+        MPI_File_write_at_all(fh, offset+b, const_cast<char*>(block.data()+b),
+            e-b, MPI_CHAR, &status);
+    }
+    MPI_File_close(&fh);
+#else
+    header += block;
+    if (writer)
+        CHK(writer->push(fname, header));
+    else
+        CHK(AsyncWriter::Write(fname, header));
+#endif
+
+    return ErrorEvent::Success;
+}
+
+bool DataIO::IsBlockFile(const char* fname)
+{
+    std::ifstream fh(fname, std::ios::binary | std::ios::in);
+    std::string s;
+    fh>>s;
+    return (s=="BLOCKFILE");
+}
+
+Error_t DataIO::ReadBlockHeader(const char* fname, BlockHeader &hdr)
+{
+    std::ifstream fh(fname, std::ios::binary | std::ios::in);
+    if(!fh)
+        CERR_LOC("Cannot open file for reading: "<<fname, "", exit(1));
+
+    std::string s, key;
+    int nblocks(0);
+    size_t len(0);
+
+    fh>>s;
+    ASSERT(s=="BLOCKFILE", "Bad input string (missing header).");
+    fh>>key>>hdr.version;
+    ASSERT(key=="version:", "bad key version");
+    fh>>key>>nblocks;
+    ASSERT(key=="nblocks:", "bad key nblocks");
+
+    hdr.count.resize(nblocks);
+    hdr.size.resize(nblocks);
+    hdr.checksum.resize(nblocks);
+    hdr.offset.resize(nblocks);
+
+    fh>>key;
+    ASSERT(key=="count:", "bad key count");
+    for (int i(0); i<nblocks; ++i) fh>>hdr.count[i];
+    fh>>key;
+    ASSERT(key=="size:", "bad key size");
+    for (int i(0); i<nblocks; ++i) fh>>hdr.size[i];
+    fh>>key;
+    ASSERT(key=="checksum:", "bad key checksum");
+    for (int i(0); i<nblocks; ++i) fh>>hdr.checksum[i];
+
+    fh>>key>>len;
+    ASSERT(key=="preamble:", "bad key preamble");
+    fh.get();
+    hdr.preamble.resize(len);
+    if (len) fh.read(&hdr.preamble[0], len);
+    fh>>s;
+    ASSERT(s=="/BLOCKFILE", "Bad input string (missing footer).");
+    fh.get();
+    ASSERT(fh.good(), "Truncated block file header: "<<fname);
+
+    size_t offset(fh.tellg());
+    for (int i(0); i<nblocks; ++i){
+        hdr.offset[i] = offset;
+        offset += hdr.size[i];
+    }
+
+    fh.seekg(0, std::ios::end);
+    if ((size_t) fh.tellg() < offset){
+        CERR_LOC("Truncated block file: "<<fname<<" ("<<fh.tellg()
+            <<" bytes, expected "<<offset<<")", "", NULL);
+        return ErrorEvent::IOError;
+    }
+
+    COUTDEBUG("Read the header of "<<fname<<" with "<<nblocks<<" blocks (version "<<hdr.version<<")");
+    return ErrorEvent::Success;
+}
+
+Error_t DataIO::ReadBlock(const char* fname, const BlockHeader &hdr,
+    int i, std::ostream &content)
+{
+    ASSERT(i>=0 && i<(int) hdr.size.size(), "Block index out of bound");
+
+    std::ifstream fh(fname, std::ios::binary | std::ios::in);
+    if(!fh)
+        CERR_LOC("Cannot open file for reading: "<<fname, "", exit(1));
+
+    std::string buf(hdr.size[i], '\0');
+    fh.seekg(hdr.offset[i]);
+    if (buf.size()) fh.read(&buf[0], buf.size());
+    if ((size_t) fh.gcount() != buf.size()){
+        CERR_LOC("Truncated block "<<i<<" in file "<<fname, "", NULL);
+        return ErrorEvent::IOError;
+    }
+
+    if (Checksum(buf.data(), buf.size()) != hdr.checksum[i]){
+        CERR_LOC("Checksum mismatch for block "<<i<<" in file "<<fname, "", NULL);
+        return ErrorEvent::IOError;
+    }
+
+    content.write(buf.data(), buf.size());
+    return ErrorEvent::Success;
+}
+
+bool DataIO::IsTableFile(const char* fname)
+{
+    std::ifstream fh(fname, std::ios::binary | std::ios::in);
+    std::string s;
+    fh>>s;
+    return (s=="TABLEFILE");
+}
+
+Error_t DataIO::WriteTable(const char* fname, size_t fields,
+    const std::vector<double> &rows)
+{
+    ASSERT(fields>0 && rows.size()%fields==0, "Rows should hold whole rows");
+
+    std::ofstream fh(fname, std::ios::binary | std::ios::out);
+    if(!fh)
+        CERR_LOC("Cannot open file for writing: "<<fname, "", exit(1));
+
+    fh<<"TABLEFILE\n";
+    fh<<"version: "<<VERSION<<"\n";
+    fh<<"rows: "<<rows.size()/fields<<"\n";
+    fh<<"fields: "<<fields<<"\n";
+    fh<<"/TABLEFILE\n";
+    if (rows.size())
+        fh.write(reinterpret_cast<const char*>(&rows[0]), rows.size()*sizeof(double));
+
+    return fh.good() ? ErrorEvent::Success : ErrorEvent::IOError;
+}
+
+Error_t DataIO::WriteRows(const char* fname, size_t fields,
+    const std::vector<double> &rows, bool distributed)
+{
+    int nproc(1), rank(0);
+#ifdef HAS_MPI
+    if (distributed){
+        MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+        MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+    }
+#endif
+    if (nproc==1) return WriteTable(fname, fields, rows);
+
+#ifdef HAS_MPI
+    ASSERT(fields>0 && rows.size()%fields==0, "Rows should hold whole rows");
+    unsigned long long loc(rows.size()/fields), nrows(0), row0(0);
+    MPI_Allreduce(&loc, &nrows, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, VES3D_COMM_WORLD);
+    MPI_Exscan(&loc, &row0, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, VES3D_COMM_WORLD);
+    if (rank==0) row0 = 0;
+
+    std::stringstream hs;
+    hs<<"TABLEFILE\n";
+    hs<<"version: "<<VERSION<<"\n";
+    hs<<"rows: "<<nrows<<"\n";
+    hs<<"fields: "<<fields<<"\n";
+    hs<<"/TABLEFILE\n";
+    std::string header(hs.str());
+
+    MPI_File fh;
+    if (MPI_File_open(VES3D_COMM_WORLD, const_cast<char*>(fname),
+            MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        CERR_LOC("Cannot open file for writing: "<<fname, "", exit(1));
+    MPI_File_set_size(fh, 0);
+
+    MPI_Status status;
+    if (rank==0)
+        MPI_File_write_at(fh, 0, &header[0], header.size(), MPI_CHAR, &status);
+
+    // MPI counts are int, large slices are written in chunks
+    unsigned long long offset(header.size() + row0*fields*sizeof(double));
+    unsigned long long bytes(rows.size()*sizeof(double));
+    const char *buf(reinterpret_cast<const char*>(rows.empty() ? NULL : &rows[0]));
+    const unsigned long long chunk(1<<30);
+    unsigned long long nchunk((bytes+chunk-1)/chunk), maxchunk(0);
+    MPI_Allreduce(&nchunk, &maxchunk, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, VES3D_COMM_WORLD);
+    for (unsigned long long c(0); c<maxchunk; ++c){
+        unsigned long long b(std::min(c*chunk, bytes));
+        unsigned long long e(std::min(b+chunk, bytes));
+        MPI_File_write_at_all(fh, offset+b, const_cast<char*>(buf+b),
+            e-b, MPI_CHAR, &status);
+    }
+    MPI_File_close(&fh);
+#endif
+
+    return ErrorEvent::Success;
+}
+
+//! reads the header of a table file, offset is where the data starts
+static Error_t ReadTableHeader(const char* fname, size_t &nrows,
+    size_t &fields, size_t &offset)
+{
+    std::ifstream fh(fname, std::ios::binary | std::ios::in);
+    if(!fh)
+        CERR_LOC("Cannot open file for reading: "<<fname, "", exit(1));
+
+    std::string s, key, version;
+    fh>>s;
+    ASSERT(s=="TABLEFILE", "Bad input string (missing header).");
+    fh>>key>>version;
+    ASSERT(key=="version:", "bad key version");
+    fh>>key>>nrows;
+    ASSERT(key=="rows:", "bad key rows");
+    fh>>key>>fields;
+    ASSERT(key=="fields:", "bad key fields");
+    fh>>s;
+    ASSERT(s=="/TABLEFILE", "Bad input string (missing footer).");
+    fh.get();
+    if (!fh.good()){
+        CERR_LOC("Truncated table file header: "<<fname, "", NULL);
+        return ErrorEvent::IOError;
+    }
+    offset = fh.tellg();
+
+    fh.seekg(0, std::ios::end);
+    if ((size_t) fh.tellg() < offset + nrows*fields*sizeof(double)){
+        CERR_LOC("Truncated table file: "<<fname<<" ("<<fh.tellg()
+            <<" bytes, expected "<<offset + nrows*fields*sizeof(double)<<")", "", NULL);
+        return ErrorEvent::IOError;
+    }
+
+    return ErrorEvent::Success;
+}
+
+Error_t DataIO::ReadRows(const char* fname, size_t fields, size_t nrows,
+    std::vector<double> &rows, bool distributed)
+{
+    int nproc(1), rank(0);
+    unsigned long long loc(nrows), row0(0);
+#ifdef HAS_MPI
+    if (distributed){
+        MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+        MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+        MPI_Exscan(&loc, &row0, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, VES3D_COMM_WORLD);
+        if (rank==0) row0 = 0;
+    }
+#endif
+    distributed &= (nproc>1);
+    rows.resize(nrows*fields);
+    int bad(0);
+
+    // the header is read by rank 0 only and broadcast
+    bool is_table(false);
+    size_t file_rows(0), file_fields(0), offset(0);
+    if (rank==0){
+        is_table = IsTableFile(fname);
+        if (is_table && ReadTableHeader(fname, file_rows, file_fields, offset) != ErrorEvent::Success)
+            bad = 1;
+    }
+#ifdef HAS_MPI
+    if (distributed){
+        unsigned long long hdr[5] = {is_table, (unsigned long long) bad, file_rows, file_fields, offset};
+        MPI_Bcast(hdr, 5, MPI_UNSIGNED_LONG_LONG, 0, VES3D_COMM_WORLD);
+        is_table = hdr[0];
+        bad = hdr[1];
+        file_rows = hdr[2];
+        file_fields = hdr[3];
+        offset = hdr[4];
+    }
+#endif
+
+    if (is_table){
+        if (!bad && (file_fields != fields || row0+nrows > file_rows)){
+            CERR_LOC("Table file "<<fname<<" has "<<file_rows<<" rows of "<<file_fields
+                <<" fields, rows "<<row0<<" to "<<row0+nrows<<" of "<<fields
+                <<" fields are requested", "", NULL);
+            bad = 1;
+        }
+        offset += row0*fields*sizeof(double);
+        unsigned long long bytes(rows.size()*sizeof(double));
+        char *buf(reinterpret_cast<char*>(rows.empty() ? NULL : &rows[0]));
+
+#ifdef HAS_MPI
+        if (distributed){
+            int any_bad(0);
+            MPI_Allreduce(&bad, &any_bad, 1, MPI_INT, MPI_MAX, VES3D_COMM_WORLD);
+            if (any_bad) return ErrorEvent::IOError;
+
+            MPI_File fh;
+            if (MPI_File_open(VES3D_COMM_WORLD, const_cast<char*>(fname), MPI_MODE_RDONLY,
+                    MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+                CERR_LOC("Cannot open file for reading: "<<fname, "", exit(1));
+
+            // MPI counts are int, large slices are read in chunks
+            MPI_Status status;
+            const unsigned long long chunk(1<<30);
+            unsigned long long nchunk((bytes+chunk-1)/chunk), maxchunk(0);
+            MPI_Allreduce(&nchunk, &maxchunk, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, VES3D_COMM_WORLD);
+            for (unsigned long long c(0); c<maxchunk; ++c){
+                unsigned long long b(std::min(c*chunk, bytes));
+                unsigned long long e(std::min(b+chunk, bytes));
+                MPI_File_read_at_all(fh, offset+b, buf+b, e-b, MPI_CHAR, &status);
+            }
+            MPI_File_close(&fh);
+            return ErrorEvent::Success;
+        }
+#endif
+        if (bad) return ErrorEvent::IOError;
+
+        std::ifstream fh(fname, std::ios::binary | std::ios::in);
+        fh.seekg(offset);
+        if (bytes) fh.read(buf, bytes);
+        if ((unsigned long long) fh.gcount() != bytes){
+            CERR_LOC("Truncated table file "<<fname, "", NULL);
+            return ErrorEvent::IOError;
+        }
+        return ErrorEvent::Success;
+    }
+
+    // text tables are only parsed once
+    DataIO io;
+    std::vector<double> all;
+    if (rank==0) io.ReadDataStl(fname, all, ASCII);
+
+#ifdef HAS_MPI
+    if (distributed){
+        int cnt(rows.size());
+        std::vector<int> counts(nproc), displs(nproc+1, 0);
+        MPI_Gather(&cnt, 1, MPI_INT, &counts[0], 1, MPI_INT, 0, VES3D_COMM_WORLD);
+        if (rank==0){
+            for (int i(0); i<nproc; ++i) displs[i+1] = displs[i] + counts[i];
+            if (all.size() < (size_t) displs[nproc]){
+                CERR_LOC("The file "<<fname<<" has "<<all.size()<<" values, "
+                    <<displs[nproc]<<" are requested", "", NULL);
+                bad = 1;
+            }
+        }
+        MPI_Bcast(&bad, 1, MPI_INT, 0, VES3D_COMM_WORLD);
+        if (bad) return ErrorEvent::IOError;
+
+        MPI_Scatterv(all.empty() ? NULL : &all[0], &counts[0], &displs[0], MPI_DOUBLE,
+            rows.empty() ? NULL : &rows[0], cnt, MPI_DOUBLE, 0, VES3D_COMM_WORLD);
+        return ErrorEvent::Success;
+    }
+#endif
+
+    if (all.size() < rows.size()){
+        CERR_LOC("The file "<<fname<<" has "<<all.size()<<" values, "
+            <<rows.size()<<" are requested", "", NULL);
+        return ErrorEvent::IOError;
+    }
+    std::copy(all.begin(), all.begin()+rows.size(), rows.begin());
+    return ErrorEvent::Success;
+}
+
 std::string FullPath(const std::string fname){
     std::string base(VES3D_PATH);
     base += "/" + fname;
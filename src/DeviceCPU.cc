@@ -7,7 +7,9 @@
  */
 
 template<enum DeviceType DT>
-Device<DT>::Device(int device_id, Error_t *err)
+Device<DT>::Device(int device_id, Error_t *err) :
+    scratch_(NULL),
+    scratch_length_(0)
 {
     if(err!=0) *err = ErrorEvent::Success;
 }
@@ -16,11 +18,24 @@ template<enum DeviceType DT>
 Device<DT>::~Device()
 {}
 
+template<enum DeviceType DT>
+void* Device<DT>::Scratch(size_t length) const
+{
+    if (length > scratch_length_){
+        if (scratch_) Free(scratch_);
+        scratch_ = Malloc(length);
+        scratch_length_ = length;
+    }
+    return(scratch_);
+}
+
 template<>
 void* Device<CPU>::Malloc(size_t length) const
 {
     PROFILESTART();
     void* ptr = ::malloc(length);
+#pragma omp atomic
+    ++malloc_count_;
     PROFILEEND("CPU",0);
     return(ptr);
 }
@@ -34,6 +49,12 @@ void Device<CPU>::Free(void* ptr) const
     PROFILEEND("CPU",0);
 }
 
+template<>
+Device<CPU>::~Device()
+{
+    if (scratch_) Free(scratch_);
+}
+
 template<>
 void* Device<CPU>::Calloc(size_t num, size_t size) const
 {
@@ -439,6 +460,112 @@ T*  Device<CPU>::xvpw(const T* x_in, const T*  v_in, const T*  w_in, size_t stri
     return xvpw_out;
 }
 
+// Points per block of the fused geometry kernels; a block of all the
+// inputs and outputs stays in L1 and its loop vectorizes
+#define VES3D_GEO_BLOCK 64
+
+template<>
+template<typename T>
+void Device<CPU>::FirstForms(const T* u_in, const T* v_in, size_t stride,
+    size_t n_vecs, T* E_out, T* F_out, T* G_out, T* W_out,
+    T* cu_out, T* cv_out, T* normal_out) const
+{
+    PROFILESTART();
+    long n_blk((stride + VES3D_GEO_BLOCK - 1) / VES3D_GEO_BLOCK);
+    long n_tot(n_vecs * n_blk);
+
+#pragma omp parallel for
+    for (long ib = 0; ib < n_tot; ++ib)
+    {
+        size_t vv(ib / n_blk);
+        size_t s0((ib % n_blk) * VES3D_GEO_BLOCK);
+        size_t s1(std::min(s0 + VES3D_GEO_BLOCK, stride));
+        const T *u(u_in + vv * DIM * stride), *v(v_in + vv * DIM * stride);
+        T *cu(cu_out + vv * DIM * stride), *cv(cv_out + vv * DIM * stride);
+        T *nor(normal_out + vv * DIM * stride);
+        size_t sbase(vv * stride);
+
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+        for (size_t s = s0; s < s1; ++s)
+        {
+            T ux(u[s]), uy(u[s + stride]), uz(u[s + 2 * stride]);
+            T vx(v[s]), vy(v[s + stride]), vz(v[s + 2 * stride]);
+
+            T E(ux * ux + uy * uy + uz * uz);
+            T F(ux * vx + uy * vy + uz * vz);
+            T G(vx * vx + vy * vy + vz * vz);
+            T W2(E * G - F * F);
+            T iW2(1 / W2);
+            T W(::sqrt(W2));
+            T iW(1 / W);
+            E *= iW2;
+            F *= iW2;
+            G *= iW2;
+
+            E_out[sbase + s] = E;
+            F_out[sbase + s] = F;
+            G_out[sbase + s] = G;
+            W_out[sbase + s] = W;
+
+            cu[s             ] = G * ux - F * vx;
+            cu[s +     stride] = G * uy - F * vy;
+            cu[s + 2 * stride] = G * uz - F * vz;
+
+            cv[s             ] = E * vx - F * ux;
+            cv[s +     stride] = E * vy - F * uy;
+            cv[s + 2 * stride] = E * vz - F * uz;
+
+            nor[s             ] = (uy * vz - uz * vy) * iW;
+            nor[s +     stride] = (uz * vx - ux * vz) * iW;
+            nor[s + 2 * stride] = (ux * vy - uy * vx) * iW;
+        }
+    }
+
+    PROFILEEND("CPU", 50 * n_vecs * stride);
+}
+
+template<>
+template<typename T>
+void Device<CPU>::SecondForms(const T* uu_in, const T* uv_in, const T* vv_in,
+    const T* normal_in, const T* E_in, const T* F_in, const T* G_in,
+    const T* W_in, size_t stride, size_t n_vecs, T* H_out, T* K_out) const
+{
+    PROFILESTART();
+    long n_blk((stride + VES3D_GEO_BLOCK - 1) / VES3D_GEO_BLOCK);
+    long n_tot(n_vecs * n_blk);
+
+#pragma omp parallel for
+    for (long ib = 0; ib < n_tot; ++ib)
+    {
+        size_t vv(ib / n_blk);
+        size_t s0((ib % n_blk) * VES3D_GEO_BLOCK);
+        size_t s1(std::min(s0 + VES3D_GEO_BLOCK, stride));
+        size_t vbase(vv * DIM * stride), sbase(vv * stride);
+        const T *uu(uu_in + vbase), *uv(uv_in + vbase), *vv_(vv_in + vbase);
+        const T *nor(normal_in + vbase);
+
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+        for (size_t s = s0; s < s1; ++s)
+        {
+            T nx(nor[s]), ny(nor[s + stride]), nz(nor[s + 2 * stride]);
+            T L(uu [s] * nx + uu [s + stride] * ny + uu [s + 2 * stride] * nz);
+            T M(uv [s] * nx + uv [s + stride] * ny + uv [s + 2 * stride] * nz);
+            T N(vv_[s] * nx + vv_[s + stride] * ny + vv_[s + 2 * stride] * nz);
+            T W(W_in[sbase + s]);
+
+            H_out[sbase + s] = (E_in[sbase + s] * N + G_in[sbase + s] * L) / 2
+                - F_in[sbase + s] * M;
+            K_out[sbase + s] = (L * N - M * M) / (W * W);
+        }
+    }
+
+    PROFILEEND("CPU", 25 * n_vecs * stride);
+}
+
 template<>
 template<typename T>
 T*  Device<CPU>::Reduce(const T *x_in, const int x_dim, const T *w_in,
@@ -450,9 +577,10 @@ T*  Device<CPU>::Reduce(const T *x_in, const int x_dim, const T *w_in,
     register T val;
     T sum;
 
+    bool parallel(ns * stride * (x_dim + 1) >= serial_reduction_length_);
     if(x_in != NULL)
     {
-#pragma omp parallel for private(val,sum)
+#pragma omp parallel for private(val,sum) if(parallel)
         for (size_t ii = 0; ii < ns; ++ii)
         {
             int wbase = ii * stride;
@@ -476,7 +604,7 @@ T*  Device<CPU>::Reduce(const T *x_in, const int x_dim, const T *w_in,
     }
     else
     {
-#pragma omp parallel for private(val,sum)
+#pragma omp parallel for private(val,sum) if(parallel)
         for (size_t ii = 0; ii < ns; ++ii)
         {
             sum = 0;
@@ -496,6 +624,36 @@ T*  Device<CPU>::Reduce(const T *x_in, const int x_dim, const T *w_in,
     return x_dw;
 }
 
+template<>
+template<typename T>
+void Device<CPU>::AreaVolume(const T *x_in, const T *normal_in, const T *w_in,
+    const T *quad_w_in, size_t stride, size_t n_surfs, T *area_out,
+    T *vol_out) const
+{
+    PROFILESTART();
+    bool parallel(n_surfs * stride >= serial_reduction_length_);
+
+#pragma omp parallel for if(parallel)
+    for (size_t ii = 0; ii < n_surfs; ++ii)
+    {
+        const T *x(x_in + ii * DIM * stride), *n(normal_in + ii * DIM * stride);
+        const T *w(w_in + ii * stride);
+        T area(0), vol(0), wq;
+
+        for (size_t jj = 0; jj < stride; ++jj)
+        {
+            wq = w[jj] * quad_w_in[jj];
+            area += wq;
+            vol  += wq * (x[jj] * n[jj] + x[jj + stride] * n[jj + stride]
+                + x[jj + 2 * stride] * n[jj + 2 * stride]);
+        }
+        area_out[ii] = area;
+        vol_out[ii]  = vol / 3;
+    }
+
+    PROFILEEND("CPU", 9 * n_surfs * stride);
+}
+
 template<>
 template<typename T>
 T* Device<CPU>::gemm(const char *transA, const char *transB,
@@ -554,40 +712,106 @@ void Device<CPU>::DirectStokesDoubleLayer(const T *src, const T *norm, const T *
     PROFILEEND("CPU",((qw == NULL) ? 32 : 35) * n_surfs * src_stride * (trg_idx_tail - trg_idx_head));
 }
 
-template<>
+/*
+ * The reducers of Device<CPU>::Reduction. The partial result of each
+ * thread lives in its own slot of a buffer on the stack of the caller,
+ * so that reductions do not allocate and can run in nested teams.
+ */
 template<typename T>
-T Device<CPU>::MaxAbs(const T *x_in, size_t length) const
+struct MaxAbsReducer
 {
-    PROFILESTART();
-    T *max_arr;
-    int n_threads;
+    enum {size = 1};
+    const T *x;
 
-    if (length == 0)
-        return 0;
+    explicit MaxAbsReducer(const T *x_in) : x(x_in) {}
+    void init(T *acc) const { acc[0] = 0; }
+    void fold(size_t begin, size_t end, T *acc) const
+    {
+        T max_loc(acc[0]);
+        for(size_t idx = begin; idx < end; ++idx)
+            max_loc = (max_loc > std::abs(x[idx])) ? max_loc : std::abs(x[idx]);
+        acc[0] = max_loc;
+    }
+    void join(const T *part, T *acc) const
+    {
+        acc[0] = (acc[0] > part[0]) ? acc[0] : part[0];
+    }
+};
 
-#pragma omp parallel
+template<typename T>
+struct DotReducer
+{
+    enum {size = 1};
+    const T *x, *y;
+
+    DotReducer(const T *x_in, const T *y_in) : x(x_in), y(y_in) {}
+    void init(T *acc) const { acc[0] = 0; }
+    void fold(size_t begin, size_t end, T *acc) const
     {
-        if(omp_get_thread_num() == 0)
-            max_arr= (T*) this->Malloc(omp_get_num_threads() * sizeof(T));
+        T dot(acc[0]);
+        for(size_t idx = begin; idx < end; ++idx)
+            dot += x[idx] * y[idx];
+        acc[0] = dot;
+    }
+    void join(const T *part, T *acc) const { acc[0] += part[0]; }
+};
 
-        T max_loc = std::abs(*x_in);
-#pragma omp for
-        for(size_t idx = 0;idx<length;idx++)
-            max_loc = (max_loc > std::abs(x_in[idx])) ?
-                max_loc : std::abs(x_in[idx]);
+//! counts the nan and inf entries (neither compares <= max)
+template<typename T>
+struct NonFiniteReducer
+{
+    enum {size = 1};
+    const T *x;
 
-        max_arr[omp_get_thread_num()] =  max_loc;
+    explicit NonFiniteReducer(const T *x_in) : x(x_in) {}
+    void init(T *acc) const { acc[0] = 0; }
+    void fold(size_t begin, size_t end, T *acc) const
+    {
+        const T max(std::numeric_limits<T>::max());
+        T cnt(acc[0]);
+        for(size_t idx = begin; idx < end; ++idx)
+            cnt += !(std::abs(x[idx]) <= max);
+        acc[0] = cnt;
+    }
+    void join(const T *part, T *acc) const { acc[0] += part[0]; }
+};
 
-        if(omp_get_thread_num() == 0)
-            n_threads = omp_get_num_threads();
+template<>
+template<typename T, typename Reducer>
+void Device<CPU>::Reduction(const Reducer &red, size_t length, T *acc) const
+{
+    red.init(acc);
+    int n_threads(std::min(omp_get_max_threads(), max_reduction_threads_));
+    if (length < serial_reduction_length_ || n_threads < 2){
+        red.fold(0, length, acc);
+        return;
     }
 
-    T max=max_arr[0];
-    for(size_t idx = 0;idx<n_threads;idx++)
-        max = (max > max_arr[idx]) ? max : max_arr[idx];
+    // a cache line (or more) per thread
+    enum {slot = (Reducer::size * sizeof(T) + 63) / 64 * 64 / sizeof(T)};
+    T part[max_reduction_threads_ * slot];
+    int n_run(1);
 
-    Free(max_arr);
+#pragma omp parallel num_threads(n_threads)
+    {
+        int tid(omp_get_thread_num()), nt(omp_get_num_threads());
+        T *p(part + tid * slot);
+        red.init(p);
+        red.fold(length * tid / nt, length * (tid + 1) / nt, p);
+        if (tid == 0) n_run = nt;
+    }
 
+    for(int tid = 0; tid < n_run; ++tid)
+        red.join(part + tid * slot, acc);
+}
+
+template<>
+template<typename T>
+T Device<CPU>::MaxAbs(const T *x_in, size_t length) const
+{
+    PROFILESTART();
+    T max(0);
+    Reduction(MaxAbsReducer<T>(x_in), length, &max);
     PROFILEEND("CPU",0);
     return(max);
 }
@@ -615,11 +839,7 @@ T Device<CPU>::AlgebraicDot(const T* x, const T* y, size_t length) const
 {
     T dot(0.0);
     PROFILESTART();
-
-#pragma omp parallel for reduction(+:dot)
-    for(size_t idx=0;idx<length; ++idx)
-        dot = dot + (x[idx] * y[idx]);
-
+    Reduction(DotReducer<T>(x, y), length, &dot);
     PROFILEEND("CPU", length);
     return(dot);
 }
@@ -629,16 +849,10 @@ template<typename T>
 bool Device<CPU>::isNumeric(const T* x, size_t length) const
 {
     PROFILESTART();
-    bool is_nan(false);
-
-#pragma omp parallel for reduction(&&:is_nan)
-    for(size_t idx=0;idx<length; ++idx){
-        is_nan = is_nan && std::isnan(x[idx]);
-        is_nan = is_nan && std::isinf(x[idx]);
-    }
-
+    T non_finite(0);
+    Reduction(NonFiniteReducer<T>(x), length, &non_finite);
     PROFILEEND("CPU", 0);
-    return !is_nan;
+    return(non_finite == 0);
 }
 
 template<>
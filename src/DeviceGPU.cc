@@ -1,5 +1,7 @@
 template<>
-Device<GPU>::Device(int device_id, Error_t *err)
+Device<GPU>::Device(int device_id, Error_t *err) :
+    scratch_(NULL),
+    scratch_length_(0)
 {
     if(err != NULL)
         switch ( cudaSetDevice(device_id) )
@@ -26,6 +28,8 @@ void* Device<GPU>::Malloc(size_t length) const
     PROFILESTART();
     void* ptr = 0;
     cudaMalloc(&ptr, length);
+#pragma omp atomic
+    ++malloc_count_;
     PROFILEEND("GPU",0);
     return(ptr);
 }
@@ -217,6 +221,76 @@ T*  Device<GPU>::xvpw(const T* x_in, const T*  v_in, const T*  w_in,
     return xvpw_out;
 }
 
+// The fused geometry kernels are composed of the elementwise GPU
+// kernels; the GPU streams each field once per kernel launch anyway
+
+template<>
+template<typename T>
+void Device<GPU>::FirstForms(const T* u_in, const T* v_in, size_t stride,
+    size_t n_vecs, T* E_out, T* F_out, T* G_out, T* W_out,
+    T* cu_out, T* cv_out, T* normal_out) const
+{
+    PROFILESTART();
+    size_t length(stride * n_vecs);
+
+    DotProduct(u_in, u_in, stride, n_vecs, E_out);
+    DotProduct(u_in, v_in, stride, n_vecs, F_out);
+    DotProduct(v_in, v_in, stride, n_vecs, G_out);
+
+    // cv_out is free until the gradient coefficients
+    xy(E_out, G_out, length, W_out);
+    xy(F_out, F_out, length, cv_out);
+    axpy((T) -1, cv_out, W_out, length, W_out);
+
+    xyInv(E_out, W_out, length, E_out);
+    xyInv(F_out, W_out, length, F_out);
+    xyInv(G_out, W_out, length, G_out);
+    Sqrt(W_out, length, W_out);
+
+    xvpw(F_out, v_in, (T*) NULL, stride, n_vecs, cu_out);
+    axpy((T) -1, cu_out, (T*) NULL, DIM * length, cu_out);
+    xvpw(G_out, u_in, cu_out, stride, n_vecs, cu_out);
+
+    xvpw(F_out, u_in, (T*) NULL, stride, n_vecs, cv_out);
+    axpy((T) -1, cv_out, (T*) NULL, DIM * length, cv_out);
+    xvpw(E_out, v_in, cv_out, stride, n_vecs, cv_out);
+
+    CrossProduct(u_in, v_in, stride, n_vecs, normal_out);
+    uyInv(normal_out, W_out, stride, n_vecs, normal_out);
+    PROFILEEND("GPU", 0);
+}
+
+template<>
+template<typename T>
+void Device<GPU>::SecondForms(const T* uu_in, const T* uv_in, const T* vv_in,
+    const T* normal_in, const T* E_in, const T* F_in, const T* G_in,
+    const T* W_in, size_t stride, size_t n_vecs, T* H_out, T* K_out) const
+{
+    PROFILESTART();
+    size_t length(stride * n_vecs);
+    T *L = (T*) Scratch(3 * length * sizeof(T));
+    T *M(L + length), *N(M + length);
+
+    DotProduct(uu_in, normal_in, stride, n_vecs, L);
+    DotProduct(uv_in, normal_in, stride, n_vecs, M);
+    DotProduct(vv_in, normal_in, stride, n_vecs, N);
+
+    xy(E_in, N, length, H_out);
+    xy(G_in, L, length, K_out);
+    axpy((T) 1, K_out, H_out, length, H_out);
+    axpy((T) .5, H_out, (T*) NULL, length, H_out);
+    xy(F_in, M, length, K_out);
+    axpy((T) -1, K_out, H_out, length, H_out);
+
+    xy(L, N, length, K_out);
+    xy(M, M, length, M);
+    axpy((T) -1, M, K_out, length, K_out);
+    xyInv(K_out, W_in, length, K_out);
+    xyInv(K_out, W_in, length, K_out);
+
+    PROFILEEND("GPU", 0);
+}
+
 template<>
 template<typename T>
 T*  Device<GPU>::Reduce(const T *x_in, const int x_dim, const T *w_in,
@@ -228,6 +302,23 @@ T*  Device<GPU>::Reduce(const T *x_in, const int x_dim, const T *w_in,
     return int_x_dw;
 }
 
+template<>
+template<typename T>
+void Device<GPU>::AreaVolume(const T *x_in, const T *normal_in, const T *w_in,
+    const T *quad_w_in, size_t stride, size_t n_surfs, T *area_out,
+    T *vol_out) const
+{
+    PROFILESTART();
+    T *xn = (T*) Scratch(stride * n_surfs * sizeof(T));
+
+    DotProduct(x_in, normal_in, stride, n_surfs, xn);
+    Reduce((T*) NULL, 0, w_in, quad_w_in, stride, n_surfs, area_out);
+    Reduce(xn, 1, w_in, quad_w_in, stride, n_surfs, vol_out);
+    axpy((T) 1 / 3, vol_out, (T*) NULL, n_surfs, vol_out);
+
+    PROFILEEND("GPU", 0);
+}
+
 template<>
 template<typename T>
 T* Device<GPU>::gemm(const char *transA, const char *transB,
@@ -305,6 +396,7 @@ T Device<GPU>::AlgebraicDot(const T* x, const T* y, size_t length) const
 template<>
 Device<GPU>::~Device()
 {
+    if (scratch_) Free(scratch_);
     cublasShutdown();
     CudaApiGlobals::ClearAll();
 }
@@ -34,6 +34,8 @@ enum PrecondScheme EnumifyPrecond(const char * name)
 
   if      ( ns.compare(0,8,"Diagonal") == 0 )
       return DiagonalSpectral;
+  else if ( ns.compare(0,10,"BlockJacob") == 0 )
+      return BlockJacobiSelf;
   else if ( ns.compare(0,9,"NoPrecond") == 0 )
       return NoPrecond;
   else
@@ -84,6 +86,32 @@ enum ReparamType EnumifyReparam(const char * name)
     return UnknownReparam;
 }
 
+enum DFTType EnumifyDFT(const char * name)
+{
+  std::string ns(name);
+  if ( ns.compare(0,4,"Gemm") == 0 )
+    return GemmDFT;
+  else if ( ns.compare(0,3,"FFT") == 0 )
+    return FFTDFT;
+  else
+    return UnknownDFT;
+}
+
+enum KernelISA EnumifyKernelISA(const char * name)
+{
+  std::string ns(name);
+  if ( ns.compare(0,6,"Scalar") == 0 )
+    return ScalarISA;
+  else if ( ns.compare(0,4,"SSE3") == 0 )
+    return SSE3ISA;
+  else if ( ns.compare(0,6,"AVX512") == 0 )
+    return AVX512ISA;
+  else if ( ns.compare(0,3,"AVX") == 0 )
+    return AVXISA;
+  else
+    return UnknownISA;
+}
+
 std::ostream& operator<<(std::ostream& output,
     const enum CoordinateOrder &O)
 {
@@ -134,6 +162,9 @@ std::ostream& operator<<(std::ostream& output, const enum PrecondScheme &PS)
 	case DiagonalSpectral:
             output<<"DiagonalSpectral";
             break;
+	case BlockJacobiSelf:
+            output<<"BlockJacobiSelf";
+            break;
 	case NoPrecond:
             output<<"NoPrecond";
             break;
@@ -211,3 +242,142 @@ std::ostream& operator<<(std::ostream& output, const enum ReparamType &RT)
 
     return output;
 }
+
+enum SelfOpStorage EnumifySelfOp(const char * name)
+{
+  std::string ns(name);
+  if ( ns.compare(0,4,"Full") == 0 )
+    return FullSelfOp;
+  else if ( ns.compare(0,6,"Single") == 0 )
+    return SingleSelfOp;
+  else if ( ns.compare(0,7,"MatFree") == 0 )
+    return MatFreeSelfOp;
+  else
+    return UnknownSelfOp;
+}
+
+enum MatsIO EnumifyMatsIO(const char * name)
+{
+  std::string ns(name);
+  if ( ns.compare(0,4,"Text") == 0 )
+    return TextMatsIO;
+  else if ( ns.compare(0,5,"Cache") == 0 )
+    return CacheMatsIO;
+  else if ( ns.compare(0,5,"Bcast") == 0 )
+    return BcastMatsIO;
+  else
+    return UnknownMatsIO;
+}
+
+enum SolverGuess EnumifySolverGuess(const char * name)
+{
+  std::string ns(name);
+  if ( ns.compare(0,4,"Zero") == 0 )
+    return ZeroGuess;
+  else if ( ns.compare(0,8,"Previous") == 0 )
+    return PreviousGuess;
+  else if ( ns.compare(0,11,"Extrapolate") == 0 )
+    return ExtrapolateGuess;
+  else
+    return UnknownGuess;
+}
+
+std::ostream& operator<<(std::ostream& output, const enum DFTType &DT)
+{
+    switch (DT)
+    {
+        case GemmDFT:
+            output<<"GemmDFT";
+            break;
+        case FFTDFT:
+            output<<"FFTDFT";
+            break;
+        default:
+            output<<"UnknownDFT";
+    }
+
+    return output;
+}
+
+std::ostream& operator<<(std::ostream& output, const enum KernelISA &ISA)
+{
+    switch (ISA)
+    {
+        case ScalarISA:
+            output<<"ScalarISA";
+            break;
+        case SSE3ISA:
+            output<<"SSE3ISA";
+            break;
+        case AVXISA:
+            output<<"AVXISA";
+            break;
+        case AVX512ISA:
+            output<<"AVX512ISA";
+            break;
+        default:
+            output<<"UnknownISA";
+    }
+
+    return output;
+}
+
+std::ostream& operator<<(std::ostream& output, const enum SelfOpStorage &SO)
+{
+    switch (SO)
+    {
+        case FullSelfOp:
+            output<<"FullSelfOp";
+            break;
+        case SingleSelfOp:
+            output<<"SingleSelfOp";
+            break;
+        case MatFreeSelfOp:
+            output<<"MatFreeSelfOp";
+            break;
+        default:
+            output<<"UnknownSelfOp";
+    }
+
+    return output;
+}
+
+std::ostream& operator<<(std::ostream& output, const enum MatsIO &MI)
+{
+    switch (MI)
+    {
+        case TextMatsIO:
+            output<<"TextMatsIO";
+            break;
+        case CacheMatsIO:
+            output<<"CacheMatsIO";
+            break;
+        case BcastMatsIO:
+            output<<"BcastMatsIO";
+            break;
+        default:
+            output<<"UnknownMatsIO";
+    }
+
+    return output;
+}
+
+std::ostream& operator<<(std::ostream& output, const enum SolverGuess &SG)
+{
+    switch (SG)
+    {
+        case ZeroGuess:
+            output<<"ZeroGuess";
+            break;
+        case PreviousGuess:
+            output<<"PreviousGuess";
+            break;
+        case ExtrapolateGuess:
+            output<<"ExtrapolateGuess";
+            break;
+        default:
+            output<<"UnknownGuess";
+    }
+
+    return output;
+}
@@ -116,12 +116,18 @@ Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::Evolve()
     };
     TimeAdaptive time_adap=(params_->time_adaptive?TimeAdapErr:TimeAdapNone);
 
+    if(params_->time_order==2 && params_->scheme!=GloballyImplicit){
+        CERR("Second order time stepping is only implemented for the "<<GloballyImplicit
+            <<" scheme");
+        return ErrorEvent::InvalidParameterError;
+    }
+
     Sca_t area, vol;
     { // Compute area, vol
         S_->resample(params_->upsample_freq, &S_up_); // up-sample
         int N_ves=S_up_->getNumberOfSurfaces();
-        area.resize(N_ves,1); S_up_->area  (area);
-        vol .resize(N_ves,1); S_up_->volume( vol);
+        area.resize(N_ves,1);
+        vol .resize(N_ves,1); S_up_->areaVolume(area, vol);
         //@bug downsample seems unnecessary
         //S_up_->resample(params_->sh_order, &S_); // down-sample
     }
@@ -155,16 +161,109 @@ Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::Evolve()
     }
 
     Vec_t dx, x0, x_dt, x_2dt;
+
+    // BDF2: the displacements of the last two steps (by the solves,
+    // without the reparametrization and area/volume correction)
+    Vec_t d_hist[2], x_start, x_pred;
+    value_type dt_hist[2] = {0, 0};
+    int n_hist(0);
     CHK( (*monitor_)( this, 0, dt) );
     INFO("Stepping with "<<params_->scheme);
 
     MPI_Comm comm=MPI_COMM_WORLD;
+    int step(0);
     pvfmm::Profile::Enable(true);
     while ( ERRORSTATUS() && t < time_horizon && dt>1e-10 )
     {
         pvfmm::Profile::Tic("TimeStep",&comm,true);
 
-        if(time_adap==TimeAdapErr){ // Adaptive using 2*dt time-step for error
+        if(params_->time_order==2){ // BDF2, adaptive using the extrapolated history for error
+            dt=std::min(time_horizon-t, dt);
+            Error_t err=ErrorEvent::Success;
+
+            // Copy S_->getPosition
+            x0.replicate(S_->getPosition());
+            axpy(static_cast<value_type>(0.0), S_->getPosition(), S_->getPosition(), x0);
+
+            pvfmm::Profile::Tic("GMRES",&comm,true);
+            if(n_hist==0){ // no history, Euler step
+                err=(F_->*updater)(*S_, dt, dx);
+            }else{
+                // with w=dt/dt_prev, x_{n+1} = x_start + dt(1+w)/(1+2w) v(x_{n+1}) for
+                // x_start = x_n + w^2/(1+2w) (x_n-x_{n-1}), with the operator linearized
+                // about the extrapolation x_n + w (x_n-x_{n-1})
+                BDF2Coeffs<value_type> bdf(dt, dt_hist[0]);
+                x_start.replicate(x0);
+                axpy(bdf.start, d_hist[0], x0, x_start);
+                axpy(bdf.extrap, d_hist[0], x0, S_->getPositionModifiable());
+                err=F_->updateImplicit(*S_, bdf.step, dx, x_start);
+            }
+            axpy(static_cast<value_type>(1.0), dx, S_->getPosition(), S_->getPositionModifiable());
+            pvfmm::Profile::Toc();
+            if(time_adap==TimeAdapNone) CHK(err);
+
+            int accept=1;
+            value_type dt_new=dt;
+            if(time_adap!=TimeAdapNone && (n_hist==2 || err!=ErrorEvent::Success)){ // Compute dt_new
+                value_type error(0);
+                if(n_hist==2){ // Compare with the quadratic through x_{n-2}, x_{n-1}, x_n
+                    BDF2Coeffs<value_type> bdf(dt, dt_hist[0], dt_hist[1]);
+                    x_pred.replicate(x0);
+                    axpy(bdf.pred1, d_hist[0], x0, x_pred);
+                    axpy(bdf.pred2, d_hist[1], x_pred, x_pred);
+                    axpy(static_cast<value_type>(-1.0), x_pred, S_->getPosition(), x_pred);
+                    error=MaxAbs(x_pred);
+                    { // error = MPI_MAX(error)
+                      assert(typeid(T)==typeid(double)); // @bug this only works for T==double
+                      value_type error_loc=error;
+                      MPI_Allreduce(&error_loc, &error, 1, MPI_DOUBLE, MPI_MAX, VES3D_COMM_WORLD);
+                    }
+
+                    // Milne's device (see BDF2Coeffs)
+                    error*=bdf.err_scale;
+                }
+
+                value_type stokes_error=F_->StokesError(S_->getPosition());
+                { // stokes_error = MPI_MAX(stokes_error)
+                  assert(typeid(T)==typeid(double)); // @bug this only works for T==double
+                  value_type error_loc=stokes_error;
+                  MPI_Allreduce(&error_loc, &stokes_error, 1, MPI_DOUBLE, MPI_MAX, VES3D_COMM_WORLD);
+                }
+
+                value_type timestep_order=2;
+                value_type time_horizon=params_->time_horizon;
+
+                value_type beta;
+                beta = (1.0/error) * (dt/time_horizon) * params_->error_factor;
+                beta = std::pow(beta, 1/timestep_order);
+                if(err!=ErrorEvent::Success) beta=0.5;
+                if(stokes_error*dt>params_->time_tol) beta=params_->time_tol/(stokes_error*dt); // This is required for GMRES to converge
+
+                beta=std::min(beta,1.5);
+                beta=std::max(beta,0.5);
+
+                value_type beta_scale=std::pow(0.9,1/timestep_order) * beta;
+                accept=(beta_scale<0.5?0:1);
+                dt_new=beta_scale * dt;
+
+                INFO("Time-adaptive: error/dt = "<<error/dt<<", error/dt^3 = "<<error/dt/dt/dt<<", dt_new = "<<dt_new);
+            }
+            if(accept){ // Increment t, shift the history
+                if(n_hist>0){
+                    d_hist[1].replicate(x0);
+                    axpy(static_cast<value_type>(0.0), d_hist[0], d_hist[0], d_hist[1]);
+                }
+                d_hist[0].replicate(x0);
+                axpy(static_cast<value_type>(-1.0), x0, S_->getPosition(), d_hist[0]);
+                dt_hist[1]=dt_hist[0];
+                dt_hist[0]=dt;
+                n_hist=std::min(n_hist+1,2);
+                t += dt;
+            }else{ // Restore original S_
+                axpy(static_cast<value_type>(0.0), x0, x0, S_->getPositionModifiable());
+            }
+            dt=dt_new;
+        }else if(time_adap==TimeAdapErr){ // Adaptive using 2*dt time-step for error
             dt=std::min((time_horizon-t)/2, dt);
             Error_t err=ErrorEvent::Success;
 
@@ -254,8 +353,8 @@ Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::Evolve()
             static Sca_t area0, vol0;
             size_t N_ves=S_->getPosition().getNumSubs();
             S_->resample(params_->upsample_freq, &S_up_); // up-sample
-            area0.replicate(S_up_->getPosition()); S_up_->area  (area0);
-            vol0 .replicate(S_up_->getPosition()); S_up_->volume( vol0);
+            area0.replicate(S_up_->getPosition());
+            vol0 .replicate(S_up_->getPosition()); S_up_->areaVolume(area0, vol0);
             A0=Sca_t::getDevice().MaxAbs(area0.begin(), N_ves);
             V0=Sca_t::getDevice().MaxAbs( vol0.begin(), N_ves);
 
@@ -269,8 +368,8 @@ Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::Evolve()
             value_type A_err, V_err;
             static Sca_t area_err, vol_err;
             S_->resample(params_->upsample_freq, &S_up_); // up-sample
-            area_err.replicate(S_up_->getPosition()); S_up_->area  (area_err);
-            vol_err .replicate(S_up_->getPosition()); S_up_->volume( vol_err);
+            area_err.replicate(S_up_->getPosition());
+            vol_err .replicate(S_up_->getPosition()); S_up_->areaVolume(area_err, vol_err);
             axpy(static_cast<value_type>(-1.0), area0, area_err, area_err);
             axpy(static_cast<value_type>(-1.0),  vol0,  vol_err,  vol_err);
             A_err=Sca_t::getDevice().MaxAbs(area_err.begin(), N_ves);
@@ -333,9 +432,17 @@ Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::Evolve()
         pvfmm::Profile::Tic("AreaVolume",&comm,true);
         AreaVolumeCorrection(area, vol);
         pvfmm::Profile::Toc();
-        pvfmm::Profile::Tic("Repartition",&comm,true);
-        (*repartition_)(S_->getPositionModifiable(), F_->tension());
-        pvfmm::Profile::Toc();
+        ++step;
+        if (params_->repartition_stride>0 && step%params_->repartition_stride==0){
+            pvfmm::Profile::Tic("Repartition",&comm,true);
+            bool reset(false);
+            CHK( RepartitionVesicles(area, vol, reset) );
+            if (reset && n_hist){
+                INFO("Restarting BDF2 with an Euler step, its history is in the old partition");
+                n_hist=0;
+            }
+            pvfmm::Profile::Toc();
+        }
         pvfmm::Profile::Tic("Monitor",&comm,true);
         CHK( (*monitor_)( this, t, dt) );
         pvfmm::Profile::Toc();
@@ -343,6 +450,78 @@ Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::Evolve()
         pvfmm::Profile::Toc();
         pvfmm::Profile::print(&comm);
     }
+    CHK( monitor_->flush() );
+    PROFILEEND("",0);
+    return ErrorEvent::Success;
+}
+
+template<typename T, typename DT, const DT &DEVICE,
+         typename Interact, typename Repart>
+Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::RepartitionVesicles(Sca_t& area, Sca_t& vol, bool &reset)
+{
+    PROFILESTART();
+    reset = false;
+    size_t nv(S_->getPosition().getNumSubs());
+
+    std::vector<value_type> cost;
+    CHK(F_->VesicleCost(cost));
+
+    // per vesicle data: the properties, followed by area and volume
+    // and the state of the monitor (its reference area and volume)
+    std::vector<Sca_t*> cols;
+    cols.push_back(&area);
+    cols.push_back(&vol);
+    std::vector<Sca_t*> mon_cols;
+    monitor_->vesicleData(mon_cols);
+    cols.insert(cols.end(), mon_cols.begin(), mon_cols.end());
+
+    const int ndof(VProp_t::n_props+cols.size());
+    std::vector<value_type> data(nv*ndof);
+    std::vector<value_type> buffer(nv);
+    for (int iP(0); iP<ndof; ++iP){
+        const value_type *src(iP<VProp_t::n_props ? ves_props_->getPropIdx(iP)->begin() :
+            cols[iP-VProp_t::n_props]->begin());
+        if (nv) Sca_t::getDevice().Memcpy(&buffer[0], src, nv*sizeof(value_type),
+            device_type::MemcpyDeviceToHost);
+        for (size_t i(0); i<nv; ++i) data[i*ndof+iP] = buffer[i];
+    }
+
+    Sca_t &tension(F_->tension());
+    Error_t ierr((*repartition_)(S_->getPositionModifiable(), tension,
+            &cost, &data, ndof));
+    if (ierr==ErrorEvent::ReferenceError) return ErrorEvent::Success; // no handle
+    CHK(ierr);
+
+    nv = S_->getPosition().getNumSubs();
+    ASSERT(data.size()==nv*ndof, "Vesicle data does not match the new partition");
+    buffer.resize(nv);
+    for (int iP(0); iP<ndof; ++iP){
+        value_type *dst;
+        if (iP<VProp_t::n_props){
+            ves_props_->getPropIdx(iP)->resize(nv);
+            dst = ves_props_->getPropIdx(iP)->begin();
+        } else {
+            cols[iP-VProp_t::n_props]->resize(nv,1);
+            dst = cols[iP-VProp_t::n_props]->begin();
+        }
+        for (size_t i(0); i<nv; ++i) buffer[i] = data[i*ndof+iP];
+        if (nv) Sca_t::getDevice().Memcpy(dst, &buffer[0], nv*sizeof(value_type),
+            device_type::MemcpyHostToDevice);
+    }
+    CHK(ves_props_->update());
+
+    // the interfacial velocity (and the parallel solver) are set up
+    // for the old partition; its solver history is not migrated
+    INFO("Rebuilding the interfacial velocity for the new partition, "
+        "the initial guess history and the recycled subspace are reset");
+    Sca_t ten;
+    ten.replicate(tension);
+    axpy(static_cast<value_type>(0.0), tension, tension, ten);
+    delete S_up_; S_up_ = NULL;
+    CHK(ReinitInterfacialVelocity());
+    axpy(static_cast<value_type>(0.0), ten, ten, F_->tension());
+    reset = true;
+
     PROFILEEND("",0);
     return ErrorEvent::Success;
 }
@@ -381,8 +560,8 @@ Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::AreaVolumeCorrection(con
         { // Set dX, dY
             Sca_t area_err, vol_err;
             { // compute error
-                area_err.resize(N_ves,1); S_up_->area  (area_err);
-                vol_err .resize(N_ves,1); S_up_->volume( vol_err);
+                area_err.resize(N_ves,1);
+                vol_err .resize(N_ves,1); S_up_->areaVolume(area_err, vol_err);
                 device.axpy(-1.0, area_err.begin(), area.begin(), N_ves, area_err.begin());
                 device.axpy(-1.0,  vol_err.begin(),  vol.begin(), N_ves,  vol_err.begin());
 
@@ -477,13 +656,20 @@ template<typename T, typename DT, const DT &DEVICE,
 Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::pack(
     std::ostream &os, Streamable::Format format) const{
 
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
+    return packState(os, format, *ves_props_, *S_, Streamable::name_);
+}
+
+template<typename T, typename DT, const DT &DEVICE,
+         typename Interact, typename Repart>
+Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::packState(
+    std::ostream &os, Streamable::Format format, const VProp_t &ves_props,
+    const Sur_t &S, const std::string &name){
 
     os<<"EVOLVE\n";
     os<<"version: "<<VERSION<<"\n";
-    os<<"name: "<<Streamable::name_<<"\n";
-    ves_props_->pack(os,format);
-    S_->pack(os,format);
+    os<<"name: "<<name<<"\n";
+    ves_props.pack(os,format);
+    S.pack(os,format);
     os<<"/EVOLVE\n";
 
     return ErrorEvent::Success;
@@ -494,7 +680,15 @@ template<typename T, typename DT, const DT &DEVICE,
 Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::unpack(
     std::istream &is, Streamable::Format format){
 
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
+    return unpackState(is, format, *params_, *ves_props_, *S_, Streamable::name_);
+}
+
+template<typename T, typename DT, const DT &DEVICE,
+         typename Interact, typename Repart>
+Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::unpackState(
+    std::istream &is, Streamable::Format format, Params_t &params,
+    VProp_t &ves_props, Sur_t &S, std::string &name){
+
     std::string s,key;
     int version;
 
@@ -506,19 +700,19 @@ Error_t EvolveSurface<T, DT, DEVICE, Interact, Repart>::unpack(
 
     is>>key;
     if (key=="+") {++version;is>>key;}
-    is>>Streamable::name_;
+    is>>name;
     ASSERT(key=="name:", "bad key name");
 
     if (version>590){
-        ves_props_->unpack(is,format);
+        ves_props.unpack(is,format);
     } else {
-        ves_props_->setFromParams(*params_);
+        ves_props.setFromParams(params);
     }
-    S_->unpack(is,format);
+    S.unpack(is,format);
     is>>s;
     ASSERT(s=="/EVOLVE", "Bad input string (missing footer).");
 
-    INFO("Unpacked "<<Streamable::name_<<" data from version "<<version<<" (current version "<<VERSION<<")");
+    INFO("Unpacked "<<name<<" data from version "<<version<<" (current version "<<VERSION<<")");
     return ErrorEvent::Success;
 }
 
@@ -119,6 +119,23 @@ void Reduce(const Container &w_in, const Container &quad_w_in,
         w_in.getNumSubs(), dw.begin());
 }
 
+template<typename ScalarContainer, typename VectorContainer>
+void AreaVolume(const VectorContainer &x_in,
+    const VectorContainer &normal_in, const ScalarContainer &w_in,
+    const ScalarContainer &quad_w_in, ScalarContainer &area_out,
+    ScalarContainer &vol_out)
+{
+    ASSERT(AreCompatible(x_in,normal_in),"Incompatible containers");
+    ASSERT(AreCompatible(normal_in,w_in),"Incompatible containers");
+    ASSERT(quad_w_in.getStride() == w_in.getStride(),"Incompatible containers");
+    ASSERT(area_out.size() >= w_in.getNumSubs(),"Incompatible containers");
+    ASSERT(vol_out.size() >= w_in.getNumSubs(),"Incompatible containers");
+
+    x_in.getDevice().AreaVolume(x_in.begin(), normal_in.begin(),
+        w_in.begin(), quad_w_in.begin(), x_in.getStride(),
+        x_in.getNumSubs(), area_out.begin(), vol_out.begin());
+}
+
 template<typename ScalarContainer>
 typename ScalarContainer::value_type Max(const ScalarContainer &x_in)
 {
@@ -159,6 +176,52 @@ inline void GeometricCross(const VectorContainer &u_in,
         u_in.getStride(), u_in.getNumSubs(), w_out.begin());
 }
 
+template<typename ScalarContainer, typename VectorContainer>
+inline void FirstForms(const VectorContainer &u_in,
+    const VectorContainer &v_in, ScalarContainer &E_out,
+    ScalarContainer &F_out, ScalarContainer &G_out, ScalarContainer &W_out,
+    VectorContainer &cu_out, VectorContainer &cv_out,
+    VectorContainer &normal_out)
+{
+    ASSERT(AreCompatible(u_in,v_in),"Incompatible containers");
+    ASSERT(AreCompatible(v_in,E_out),"Incompatible containers");
+    ASSERT(AreCompatible(E_out,F_out),"Incompatible containers");
+    ASSERT(AreCompatible(F_out,G_out),"Incompatible containers");
+    ASSERT(AreCompatible(G_out,W_out),"Incompatible containers");
+    ASSERT(AreCompatible(v_in,cu_out),"Incompatible containers");
+    ASSERT(AreCompatible(v_in,cv_out),"Incompatible containers");
+    ASSERT(AreCompatible(v_in,normal_out),"Incompatible containers");
+
+    u_in.getDevice().FirstForms(u_in.begin(), v_in.begin(),
+        u_in.getStride(), u_in.getNumSubs(), E_out.begin(), F_out.begin(),
+        G_out.begin(), W_out.begin(), cu_out.begin(), cv_out.begin(),
+        normal_out.begin());
+}
+
+template<typename ScalarContainer, typename VectorContainer>
+inline void SecondForms(const VectorContainer &uu_in,
+    const VectorContainer &uv_in, const VectorContainer &vv_in,
+    const VectorContainer &normal_in, const ScalarContainer &E_in,
+    const ScalarContainer &F_in, const ScalarContainer &G_in,
+    const ScalarContainer &W_in, ScalarContainer &H_out,
+    ScalarContainer &K_out)
+{
+    ASSERT(AreCompatible(uu_in,uv_in),"Incompatible containers");
+    ASSERT(AreCompatible(uv_in,vv_in),"Incompatible containers");
+    ASSERT(AreCompatible(vv_in,normal_in),"Incompatible containers");
+    ASSERT(AreCompatible(normal_in,E_in),"Incompatible containers");
+    ASSERT(AreCompatible(E_in,F_in),"Incompatible containers");
+    ASSERT(AreCompatible(F_in,G_in),"Incompatible containers");
+    ASSERT(AreCompatible(G_in,W_in),"Incompatible containers");
+    ASSERT(AreCompatible(W_in,H_out),"Incompatible containers");
+    ASSERT(AreCompatible(H_out,K_out),"Incompatible containers");
+
+    uu_in.getDevice().SecondForms(uu_in.begin(), uv_in.begin(),
+        vv_in.begin(), normal_in.begin(), E_in.begin(), F_in.begin(),
+        G_in.begin(), W_in.begin(), uu_in.getStride(), uu_in.getNumSubs(),
+        H_out.begin(), K_out.begin());
+}
+
 template<typename ScalarContainer, typename VectorContainer>
 inline void uyInv(const VectorContainer &u_in,
     const ScalarContainer &y_in, VectorContainer &uyInv_out)
@@ -8,7 +8,8 @@ InterfacialForce<SurfContainer>::InterfacialForce(
     sht_   (mats.p_   , mats.mats_p_   ),
     sht_up_(mats.p_up_, mats.mats_p_up_),
     cen(1, 1, std::make_pair(1,1)),
-    S_up(NULL)
+    S_up(NULL),
+    S_up_version(0)
 {}
 
 template<typename SurfContainer>
@@ -17,13 +18,22 @@ InterfacialForce<SurfContainer>::~InterfacialForce()
   if(S_up) delete S_up;
 }
 
+template<typename SurfContainer>
+void InterfacialForce<SurfContainer>::upsample(const SurfContainer &S) const
+{
+    if (S_up && S_up_version==S.getPositionVersion()) return;
+
+    S.resample(params_.upsample_freq, &S_up);
+    S_up_version = S.getPositionVersion();
+}
+
 template<typename SurfContainer>
 void InterfacialForce<SurfContainer>::bendingForce(const SurfContainer &S,
     Vec_t &Fb) const
 {
-    S.resample(params_.upsample_freq, &S_up); // upsample
+    upsample(S);
 
-    Vec_t Fb_up;
+    Vec_t &Fb_up(F_up);
     Fb_up.replicate(S_up->getPosition());
     s1.replicate(S_up->getPosition());
     s2.replicate(S_up->getPosition());
@@ -41,11 +51,10 @@ void InterfacialForce<SurfContainer>::bendingForce(const SurfContainer &S,
     av(ves_props_.bending_coeff,Fb_up, Fb_up);
 
     { // downsample Fb
-      Vec_t wrk[2]; // TODO: Pre-allocate
-      wrk[0].resize(Fb_up.getNumSubs(), params_.upsample_freq);
-      wrk[1].resize(Fb_up.getNumSubs(), params_.upsample_freq);
+      vwrk[0].resize(Fb_up.getNumSubs(), params_.upsample_freq);
+      vwrk[1].resize(Fb_up.getNumSubs(), params_.upsample_freq);
       Fb.replicate(S.getPosition());
-      Resample(Fb_up, sht_up_, sht_, wrk[0], wrk[1], Fb);
+      Resample(Fb_up, sht_up_, sht_, vwrk[0], vwrk[1], Fb);
     }
 }
 
@@ -53,17 +62,16 @@ template<typename SurfContainer>
 void InterfacialForce<SurfContainer>::linearBendingForce(const SurfContainer &S,
     const Vec_t &x_new, Vec_t &Fb) const
 {
-    S.resample(params_.upsample_freq, &S_up); // upsample
-    Vec_t x_new_up;
+    upsample(S);
+    Vec_t &x_new_up(x_up);
     { // upsample x_new
-      Vec_t wrk[2]; // TODO: Pre-allocate
-      wrk[0]  .resize(x_new.getNumSubs(), params_.upsample_freq);
-      wrk[1]  .resize(x_new.getNumSubs(), params_.upsample_freq);
+      vwrk[0] .resize(x_new.getNumSubs(), params_.upsample_freq);
+      vwrk[1] .resize(x_new.getNumSubs(), params_.upsample_freq);
       x_new_up.resize(x_new.getNumSubs(), params_.upsample_freq);
-      Resample(x_new, sht_, sht_up_, wrk[0], wrk[1], x_new_up);
+      Resample(x_new, sht_, sht_up_, vwrk[0], vwrk[1], x_new_up);
     }
 
-    Vec_t Fb_up;
+    Vec_t &Fb_up(F_up);
     Fb_up.replicate(S_up->getPosition());
     s1.replicate(S_up->getPosition());
     s2.replicate(S_up->getPosition());
@@ -83,11 +91,10 @@ void InterfacialForce<SurfContainer>::linearBendingForce(const SurfContainer &S,
     av(ves_props_.bending_coeff, Fb_up, Fb_up);
 
     { // downsample Fb
-      Vec_t wrk[2]; // TODO: Pre-allocate
-      wrk[0].resize(Fb_up.getNumSubs(), params_.upsample_freq);
-      wrk[1].resize(Fb_up.getNumSubs(), params_.upsample_freq);
+      vwrk[0].resize(Fb_up.getNumSubs(), params_.upsample_freq);
+      vwrk[1].resize(Fb_up.getNumSubs(), params_.upsample_freq);
       Fb.replicate(S.getPosition());
-      Resample(Fb_up, sht_up_, sht_, wrk[0], wrk[1], Fb);
+      Resample(Fb_up, sht_up_, sht_, vwrk[0], vwrk[1], Fb);
     }
 }
 
@@ -95,17 +102,15 @@ template<typename SurfContainer>
 void InterfacialForce<SurfContainer>::tensileForce(const SurfContainer &S,
     const Sca_t &tension, Vec_t &Fs) const
 {
-    S.resample(params_.upsample_freq, &S_up); // upsample
-    Sca_t tension_up;
+    upsample(S);
     { // upsample tension
-      Sca_t wrk[2]; // TODO: Pre-allocate
-      wrk[0]    .resize(tension.getNumSubs(), params_.upsample_freq);
-      wrk[1]    .resize(tension.getNumSubs(), params_.upsample_freq);
+      swrk[0]   .resize(tension.getNumSubs(), params_.upsample_freq);
+      swrk[1]   .resize(tension.getNumSubs(), params_.upsample_freq);
       tension_up.resize(tension.getNumSubs(), params_.upsample_freq);
-      Resample(tension, sht_, sht_up_, wrk[0], wrk[1], tension_up);
+      Resample(tension, sht_, sht_up_, swrk[0], swrk[1], tension_up);
     }
 
-    Vec_t Fs_up;
+    Vec_t &Fs_up(F_up);
     Fs_up.replicate(S_up->getPosition());
     v1.replicate(S_up->getPosition());
 
@@ -115,11 +120,10 @@ void InterfacialForce<SurfContainer>::tensileForce(const SurfContainer &S,
     axpy(static_cast<typename SurfContainer::value_type>(2), Fs_up, v1, Fs_up);
 
     { // downsample Fs
-      Vec_t wrk[2]; // TODO: Pre-allocate
-      wrk[0].resize(Fs_up.getNumSubs(), params_.upsample_freq);
-      wrk[1].resize(Fs_up.getNumSubs(), params_.upsample_freq);
+      vwrk[0].resize(Fs_up.getNumSubs(), params_.upsample_freq);
+      vwrk[1].resize(Fs_up.getNumSubs(), params_.upsample_freq);
       Fs.replicate(S.getPosition());
-      Resample(Fs_up, sht_up_, sht_, wrk[0], wrk[1], Fs);
+      Resample(Fs_up, sht_up_, sht_, vwrk[0], vwrk[1], Fs);
     }
 }
 
@@ -9,23 +9,53 @@ InterfacialVelocity(SurfContainer &S_in, const Interaction &Inter,
     bg_flow_(bgFlow),
     params_(params),
     ves_props_(ves_props),
+    mats_(mats),
     Intfcl_force_(params,ves_props_,mats),
     //
     parallel_solver_(parallel_solver),
     psolver_configured_(false),
     precond_configured_(false),
+    precond_(params_.time_precond),
     parallel_matvec_(NULL),
     parallel_rhs_(NULL),
     parallel_u_(NULL),
+    solve_iter_(0),
+    solve_iter_total_(0),
+    solve_count_(0),
+    solve_matvec_total_(0),
+    inexact_solve_(false),
+    copied_bytes_(0),
+    solve_matvecs_(0),
+    matvec_mallocs_(0),
+    block_size_(0),
     //
     dt_(params_.ts),
+    x_start_(NULL),
     sht_(mats.p_, mats.mats_p_),
     sht_upsample_(mats.p_up_, mats.mats_p_up_),
     checked_out_work_sca_(0),
     checked_out_work_vec_(0),
-    stokes_(params_.sh_order,params_.upsample_freq,params_.periodic_length,params_.repul_dist),
-    S_up_(NULL)
+    stokes_(params_.sh_order,params_.upsample_freq,params_.periodic_length,params_.repul_dist,MPI_COMM_WORLD,params_.self_op),
+    stokes_sp_(NULL),
+    mixed_solve_(false),
+    S_up_(NULL),
+    S_rep_(NULL),
+    rep_iter_(0),
+    rep_energy0_(0),
+    rep_energy_(0)
 {
+    stokes_.SetNearSkin(params_.near_skin);
+    stokes_.SetOverlap(params_.fmm_overlap);
+    if (params_.mixed_precision){
+        INFO("Evaluating the Stokes potentials of the matvec in single precision");
+        stokes_sp_ = new StokesVelocity<float>(params_.sh_order,params_.upsample_freq,params_.periodic_length,params_.repul_dist,MPI_COMM_WORLD,params_.self_op);
+        stokes_sp_->SetNearSkin(params_.near_skin);
+        stokes_sp_->SetOverlap(params_.fmm_overlap);
+    }
+    guess_dt_[0] = guess_dt_[1] = 0;
+    matvec_count_.assign(Stokes_t::AccuracyLevels(), 0);
+    matvec_time_.assign(Stokes_t::AccuracyLevels(), 0);
+
     pos_vel_.replicate(S_.getPosition());
     tension_.replicate(S_.getPosition());
 
@@ -90,6 +120,8 @@ InterfacialVelocity<SurfContainer, Interaction>::
     delete parallel_u_;
 
     if(S_up_) delete S_up_;
+    delete S_rep_;
+    delete stokes_sp_;
 }
 
 // Performs the following computation:
@@ -174,6 +206,7 @@ updateJacobiGaussSeidel(const SurfContainer& S_, const value_type &dt, Vec_t& dx
 
     COUTDEBUG("Solving for position");
     solver_ret = linear_solver_vec_(*this, *u2, *u1, rsrt, iter, relres);
+    solve_iter_ = iter;
     if ( solver_ret  != BiCGSSuccess )
         ret_val = ErrorEvent::DivergenceError;
 
@@ -210,6 +243,9 @@ updateImplicit(const SurfContainer& S_, const value_type &dt, Vec_t& dx)
     INFO("Taking a time step using "<<scheme<<" scheme");
     CHK(Prepare(scheme));
 
+    if (precond_==BlockJacobiSelf)
+        CHK(AssembleBlockPrecond());
+
     if (params_.solve_for_velocity) {
         CHK(AssembleRhsVel(parallel_rhs_, dt_, scheme));
     } else {
@@ -220,6 +256,8 @@ updateImplicit(const SurfContainer& S_, const value_type &dt, Vec_t& dx)
     if(err==ErrorEvent::Success) err=AssembleInitial(parallel_u_, dt_, scheme);
     if(err==ErrorEvent::Success) err=Solve(parallel_rhs_, parallel_u_, dt_, scheme);
     if(err==ErrorEvent::Success) err=Update(parallel_u_);
+    if(err==ErrorEvent::Success && params_.solver_guess==ExtrapolateGuess)
+        err=RecordSolution(parallel_u_);
 
     if(0)
     if (params_.solve_for_velocity && !params_.pseudospectral){ // Save velocity field to VTK
@@ -551,6 +589,10 @@ updateImplicit(const SurfContainer& S_, const value_type &dt, Vec_t& dx)
     dx.replicate(S_.getPosition());
     if (params_.solve_for_velocity){
         axpy(dt, pos_vel_, dx);
+        if (x_start_){
+            axpy(static_cast<value_type>(1.0), *x_start_, dx, dx);
+            axpy(static_cast<value_type>(-1.0), S_.getPosition(), dx, dx);
+        }
     } else {
         axpy(-1.0, S_.getPosition(), pos_vel_, dx);
     }
@@ -559,6 +601,17 @@ updateImplicit(const SurfContainer& S_, const value_type &dt, Vec_t& dx)
     return err;
 }
 
+template<typename SurfContainer, typename Interaction>
+Error_t InterfacialVelocity<SurfContainer, Interaction>::
+updateImplicit(const SurfContainer& S_, const value_type &dt, Vec_t& dx,
+    const Vec_t &x_start)
+{
+    x_start_ = &x_start;
+    Error_t err(updateImplicit(S_, dt, dx));
+    x_start_ = NULL;
+    return err;
+}
+
 template<typename SurfContainer, typename Interaction>
 size_t InterfacialVelocity<SurfContainer, Interaction>::stokesBlockSize() const{
 
@@ -596,9 +649,13 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::Prepare(const SolverSch
 
     INFO("Setting interaction source and target");
     stokes_.SetSrcCoord(S_.getPosition());
+    if (stokes_sp_){
+        CastToSinglePrecision(S_.getPosition(), sp_buffer_);
+        stokes_sp_->SetSrcCoord(sp_buffer_);
+    }
 
-    if (!precond_configured_ && params_.time_precond!=NoPrecond)
-        ConfigurePrecond(params_.time_precond);
+    if (!precond_configured_ && precond_!=NoPrecond)
+        ConfigurePrecond(precond_);
 
     //!@bug doesn't support repartitioning
     if (!psolver_configured_ && scheme==GloballyImplicit){
@@ -642,6 +699,7 @@ ConfigureSolver(const SolverScheme &scheme) const
 
     // setting up the solver
     CHK(parallel_solver_->SetOperator(parallel_matvec_));
+    CHK(parallel_solver_->SetRecycleSize(params_.solver_recycle));
     CHK(parallel_solver_->SetTolerances(params_.time_tol,
             PSolver_t::PLS_DEFAULT,
             PSolver_t::PLS_DEFAULT,
@@ -666,10 +724,29 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::
 ConfigurePrecond(const PrecondScheme &precond) const{
 
     PROFILESTART();
+    if (precond==BlockJacobiSelf){
+        if (blockPrecondFits(S_.getPosition().getNumSubs())){
+            // assembled and factored at each step in AssembleBlockPrecond
+            precond_=BlockJacobiSelf;
+            precond_configured_=true;
+            PROFILEEND("",0);
+            return ErrorEvent::Success;
+        }
+        Error_t err(ConfigurePrecond(DiagonalSpectral));
+        PROFILEEND("",0);
+        return err;
+    }
+
     if (precond!=DiagonalSpectral)
         return ErrorEvent::NotImplementedError; /* Unsupported preconditioner scheme */
 
     INFO("Setting up the diagonal preceonditioner");
+    precond_=DiagonalSpectral;
+    int p(S_.getPosition().getShOrder());
+    if (position_precond.getShOrder()!=p){
+        position_precond.resize(1,p);
+        tension_precond.resize(1,p);
+    }
     value_type *buffer = new value_type[position_precond.size() * sizeof(value_type)];
 
     { //bending precond
@@ -730,6 +807,18 @@ AssembleRhsVel(PVec_t *rhs, const value_type &dt, const SolverScheme &scheme) co
     std::auto_ptr<Vec_t> f  = checkoutVec();
     std::auto_ptr<Vec_t> Sf = checkoutVec();
     Intfcl_force_.explicitTractionJump(S_, *f);
+    if (x_start_){
+        COUTDEBUG("Adding the linearized traction jump of the start position");
+        std::auto_ptr<Vec_t> xs = checkoutVec();
+        std::auto_ptr<Vec_t> fs = checkoutVec();
+        axpy(static_cast<value_type>(-1.0), S_.getPosition(), *x_start_, *xs);
+        Intfcl_force_.linearBendingForce(S_, *xs, *fs);
+        axpy(static_cast<value_type>(1.0), *fs, *f, *f);
+        Intfcl_force_.gravityForce(S_, *xs, *fs);
+        axpy(static_cast<value_type>(1.0), *fs, *f, *f);
+        recycle(xs);
+        recycle(fs);
+    }
     stokes_.SetDensitySL(f.get(),true);
     stokes_.SetDensityDL(NULL);
     stokes_(*Sf);
@@ -801,11 +890,14 @@ AssembleRhsPos(PVec_t *rhs, const value_type &dt, const SolverScheme &scheme) co
     pRhs2->replicate(S_.getPosition());
     CHK(BgFlow(*pRhs, dt));
 
+    // the position at the start of the step
+    const Vec_t &x0(x_start_ ? *x_start_ : S_.getPosition());
+
     if( ves_props_.has_contrast ){
         COUTDEBUG("Computing the rhs due to viscosity contrast");
         std::auto_ptr<Vec_t> x  = checkoutVec();
         std::auto_ptr<Vec_t> Dx = checkoutVec();
-        av(ves_props_.dl_coeff, S_.getPosition(), *x);
+        av(ves_props_.dl_coeff, x0, *x);
         stokes_.SetDensitySL(NULL, true);
         stokes_.SetDensityDL(x.get());
         stokes_(*Dx);
@@ -821,7 +913,7 @@ AssembleRhsPos(PVec_t *rhs, const value_type &dt, const SolverScheme &scheme) co
     std::auto_ptr<Sca_t> tRhs = checkoutSca();
     S_.div(*pRhs, *tRhs);
 
-    av(ves_props_.vel_coeff, S_.getPosition(), *pRhs2);
+    av(ves_props_.vel_coeff, x0, *pRhs2);
     axpy(static_cast<value_type>(1.0), *pRhs, *pRhs2, *pRhs);
 
     ASSERT( pRhs->getDevice().isNumeric(pRhs->begin(), pRhs->size()), "Non-numeric rhs");
@@ -875,7 +967,6 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::
 AssembleInitial(PVec_t *u0, const value_type &dt, const SolverScheme &scheme) const
 {
     PROFILESTART();
-    COUTDEBUG("Using current position/tension as initial guess");
     size_t vsz(stokesBlockSize()), tsz(tensionBlockSize());
     typename PVec_t::iterator i(NULL);
     typename PVec_t::size_type rsz;
@@ -886,12 +977,28 @@ AssembleInitial(PVec_t *u0, const value_type &dt, const SolverScheme &scheme) co
     CHK(parallel_u_->GetArray(i, rsz));
     ASSERT(rsz==vsz+tsz,"Bad sizes");
 
-    if (params_.pseudospectral){
+    // extrapolation is only valid for equal steps; the trial steps of
+    // the adaptive stepper (dt, 2dt, dt) fall back to the previous
+    // solution
+    bool extrapolate(params_.solver_guess==ExtrapolateGuess &&
+        guess_hist_[0].size()==rsz && guess_hist_[1].size()==rsz &&
+        guess_dt_[0]==dt && guess_dt_[1]==dt);
+
+    if (params_.solver_guess==ZeroGuess){
+        COUTDEBUG("Using zero initial guess");
+        for (size_t j(0); j<rsz; ++j) i[j] = 0;
+    } else if (extrapolate){
+        COUTDEBUG("Extrapolating the last two solutions as initial guess");
+        for (size_t j(0); j<rsz; ++j)
+            i[j] = 2*guess_hist_[0][j]-guess_hist_[1][j];
+    } else if (params_.pseudospectral){
+        COUTDEBUG("Using current position/tension as initial guess");
         COUTDEBUG("Copy initial guess to parallel solution array");
         pos_vel_.getDevice().Memcpy(i    , pos_vel_.begin(), vsz * sizeof(value_type), device_type::MemcpyDeviceToHost);
         tension_.getDevice().Memcpy(i+vsz, tension_.begin(), tsz * sizeof(value_type), device_type::MemcpyDeviceToHost);
     } else {  /* Galerkin */
-            COUTDEBUG("Project initial guess to spectral coefficient");
+        COUTDEBUG("Using current position/tension as initial guess");
+        COUTDEBUG("Project initial guess to spectral coefficient");
         std::auto_ptr<Vec_t> voxSh  = checkoutVec();
         std::auto_ptr<Sca_t> tSh    = checkoutSca();
         std::auto_ptr<Vec_t> wrk    = checkoutVec();
@@ -913,13 +1020,20 @@ AssembleInitial(PVec_t *u0, const value_type &dt, const SolverScheme &scheme) co
     }
 
     CHK(parallel_u_->RestoreArray(i));
-    CHK(parallel_solver_->InitialGuessNonzero(true));
+    CHK(parallel_solver_->InitialGuessNonzero(params_.solver_guess!=ZeroGuess));
     PROFILEEND("",0);
     return ErrorEvent::Success;
 }
 
 template<typename SurfContainer, typename Interaction>
-Error_t InterfacialVelocity<SurfContainer, Interaction>::ImplicitMatvecPhysical(Vec_t &vox, Sca_t &ten) const
+Error_t InterfacialVelocity<SurfContainer, Interaction>::ImplicitMatvecPhysical(Vec_t &vox, Sca_t &ten, bool self_only) const
+{
+    return ImplicitMatvecPhysical(vox, ten, vox, ten, self_only);
+}
+
+template<typename SurfContainer, typename Interaction>
+Error_t InterfacialVelocity<SurfContainer, Interaction>::ImplicitMatvecPhysical(const Vec_t &vox, const Sca_t &ten,
+    Vec_t &vox_out, Sca_t &ten_out, bool self_only) const
 {
     PROFILESTART();
 
@@ -940,18 +1054,22 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::ImplicitMatvecPhysical(
         Intfcl_force_.implicitTractionJump(S_, vox, ten, *f);
         axpy(dt_, *f, *f);
     }
-    stokes_.SetDensitySL(f.get());
-
     if( ves_props_.has_contrast ){
         COUTDEBUG("Setting the double-layer density");
         av(ves_props_.dl_coeff, vox, *Du);
-        stokes_.SetDensityDL(Du.get());
-    } else {
-        stokes_.SetDensityDL(NULL);
     }
 
     COUTDEBUG("Calling stokes");
-    stokes_(*Sf);
+    if (mixed_solve_ && !self_only){
+        StokesSinglePrecision(*f, ves_props_.has_contrast ? Du.get() : NULL, *Sf);
+    } else {
+        stokes_.SetDensitySL(f.get());
+        stokes_.SetDensityDL(ves_props_.has_contrast ? Du.get() : NULL);
+        if (self_only)
+            stokes_.SelfVelocity(*Sf);
+        else
+            stokes_(*Sf);
+    }
 
     COUTDEBUG("Computing the div term");
     //! @note For some reason, doing the linear algebraic manipulation
@@ -959,16 +1077,18 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::ImplicitMatvecPhysical(
     //! almost halves the number of gmres iterations. Also having the
     //! minus sign in the matvec is tangibly better (1-2
     //! iterations). Need to investigate why.
-    S_.div(*Sf, ten);
-    axpy((value_type) -1.0, ten, ten);
-
-    if( ves_props_.has_contrast )
-        av(ves_props_.vel_coeff, vox, vox);
+    S_.div(*Sf, ten_out);
+    axpy((value_type) -1.0, ten_out, ten_out);
 
-    axpy((value_type) -1.0, *Sf, vox, vox);
+    if( ves_props_.has_contrast ){
+        av(ves_props_.vel_coeff, vox, vox_out);
+        axpy((value_type) -1.0, *Sf, vox_out, vox_out);
+    } else {
+        axpy((value_type) -1.0, *Sf, vox, vox_out);
+    }
 
-    ASSERT(vox.getDevice().isNumeric(vox.begin(), vox.size()), "Non-numeric velocity");
-    ASSERT(ten.getDevice().isNumeric(ten.begin(), ten.size()), "Non-numeric divergence");
+    ASSERT(vox_out.getDevice().isNumeric(vox_out.begin(), vox_out.size()), "Non-numeric velocity");
+    ASSERT(ten_out.getDevice().isNumeric(ten_out.begin(), ten_out.size()), "Non-numeric divergence");
 
     recycle(f);
     recycle(Sf);
@@ -978,28 +1098,275 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::ImplicitMatvecPhysical(
     return ErrorEvent::Success;
 }
 
+template<typename SurfContainer, typename Interaction>
+size_t InterfacialVelocity<SurfContainer, Interaction>::
+blockPrecondSize() const
+{
+    int p(S_.getPosition().getShOrder());
+    size_t nc(0);
+    if (params_.pseudospectral)
+        nc = S_.getPosition().getStride();
+    else
+        for (int b(0); b<2*p; ++b)
+            nc += (b==0 ? p+1 : (b==2*p-1 ? 1 : p+1-(b+1)/2));
+
+    return 4*nc;
+}
+
+template<typename SurfContainer, typename Interaction>
+bool InterfacialVelocity<SurfContainer, Interaction>::
+blockPrecondFits(long nv) const
+{
+    size_t nb(blockPrecondSize());
+    size_t bytes(nb*nb*sizeof(value_type));
+    if (bytes<=max_block_bytes_ && nv*bytes<=max_blocks_bytes_)
+        return true;
+
+    WARN("The self-interaction blocks are too large for the block-Jacobi preconditioner ("
+        <<nb<<" unknowns, "<<nv<<" x "<<bytes/1024.0/1024.0<<" MB), using "<<DiagonalSpectral);
+    return false;
+}
+
+/*
+ * The self-interaction part of the implicit operator is block
+ * diagonal, with one block of the (velocity, tension) unknowns of
+ * each vesicle. The blocks of all vesicles are assembled together,
+ * one column at a time, by applying the self-only operator to the
+ * corresponding unit vector in every vesicle, and then factored
+ * independently.
+ */
 template<typename SurfContainer, typename Interaction>
 Error_t InterfacialVelocity<SurfContainer, Interaction>::
-ImplicitApply(const POp_t *o, const value_type *x, value_type *y)
+AssembleBlockPrecond() const
 {
     PROFILESTART();
+    double t0(GETSECONDS());
+    size_t vsz(stokesBlockSize()), tsz(tensionBlockSize());
+    long nv(S_.getPosition().getNumSubs());
+
+    // the number of vesicles may have grown since the configuration
+    if (!blockPrecondFits(nv)){
+        block_lu_.clear(); block_piv_.clear(); block_idx_.clear();
+        block_size_ = 0;
+        Error_t err(ConfigurePrecond(DiagonalSpectral));
+        PROFILEEND("",0);
+        return err;
+    }
+
+    int p(S_.getPosition().getShOrder());
+    size_t stride(S_.getPosition().getStride());
+
+    // offsets of the unknowns of one function; the SH coefficients
+    // are ordered by frequency (as in SHTrans::ScaleFreq) with the
+    // functions interleaved in each frequency block
+    std::vector<size_t> pre, len, off;
+    if (params_.pseudospectral){
+        for (size_t c(0); c<stride; ++c){
+            pre.push_back(c); len.push_back(0); off.push_back(0);
+        }
+    } else {
+        size_t sum(0);
+        for (int b(0); b<2*p; ++b){
+            int L(b==0 ? p+1 : (b==2*p-1 ? 1 : p+1-(b+1)/2));
+            for (int q(0); q<L; ++q){
+                pre.push_back(sum); len.push_back(L); off.push_back(q);
+            }
+            sum += L;
+        }
+    }
+    size_t nc(pre.size());
+    ASSERT(nc<=stride, "Inconsistent coefficient layout");
+
+    // index of coefficient c of function f out of nf functions
+    #define BLOCK_INDEX(nf, f, c) (params_.pseudospectral ?               \
+        (f)*stride + (c) : (nf)*pre[c] + (f)*len[c] + off[c])
+
+    size_t nb(4*nc);
+    ASSERT(nb==blockPrecondSize(), "Inconsistent block size");
+    block_size_ = nb;
+    block_idx_.resize(nv*nb);
+    for (long i(0); i<nv; ++i){
+        for (int k(0); k<DIM; ++k)
+            for (size_t c(0); c<nc; ++c)
+                block_idx_[i*nb+k*nc+c] = BLOCK_INDEX(DIM*nv, DIM*i+k, c);
+        for (size_t c(0); c<nc; ++c)
+            block_idx_[i*nb+DIM*nc+c] = vsz + BLOCK_INDEX(nv, i, c);
+    }
+    #undef BLOCK_INDEX
+
+    COUTDEBUG("Assembling "<<nv<<" self-interaction blocks of size "<<nb);
+    block_lu_.resize(nv*nb*nb);
+    block_piv_.resize(nv*nb);
+    std::vector<value_type> x(vsz+tsz, 0), y(vsz+tsz);
+    for (size_t c(0); c<nb; ++c){
+        for (long i(0); i<nv; ++i) x[block_idx_[i*nb+c]] = 1;
+        CHK(ParallelMatvec(&x[0], &y[0], true));
+        for (long i(0); i<nv; ++i) x[block_idx_[i*nb+c]] = 0;
+
+#pragma omp parallel for
+        for (long i=0; i<nv; ++i){
+            value_type *col(&block_lu_[(i*nb+c)*nb]);
+            const size_t *idx(&block_idx_[i*nb]);
+            for (size_t r(0); r<nb; ++r) col[r] = y[idx[r]];
+        }
+    }
+
+    COUTDEBUG("Factoring the self-interaction blocks");
+    int nsingular(0);
+#pragma omp parallel for reduction(+:nsingular)
+    for (long i=0; i<nv; ++i){
+        value_type *A(&block_lu_[i*nb*nb]);
+        int *piv(&block_piv_[i*nb]);
+        int n(nb), info(0);
+        Getrf(n, n, A, n, piv, info);
+
+        value_type dmin(0), dmax(0);
+        for (int r(0); r<n && info==0; ++r){
+            value_type d(fabs(A[r*nb+r]));
+            dmin = (r==0) ? d : std::min(dmin, d);
+            dmax = std::max(dmax, d);
+        }
+
+        if (info!=0 || dmin<=1e-12*dmax){ // singular; leave this block unpreconditioned
+            ++nsingular;
+            for (int c(0); c<n; ++c)
+                for (int r(0); r<n; ++r)
+                    A[c*nb+r] = (r==c);
+            for (int r(0); r<n; ++r) piv[r] = r+1;
+        }
+    }
+
+    if (nsingular)
+        WARN("The self-interaction block of "<<nsingular<<" vesicle(s) is singular (not preconditioned)");
+
+    INFO("Block-Jacobi preconditioner assembled and factored in "<<GETSECONDS()-t0
+        <<"s ("<<nb*nb*sizeof(value_type)/1024.0/1024.0<<" MB per vesicle)");
+    PROFILEEND("",0);
+    return ErrorEvent::Success;
+}
+
+template<typename SurfContainer, typename Interaction>
+typename InterfacialVelocity<SurfContainer, Interaction>::value_type
+InterfacialVelocity<SurfContainer, Interaction>::
+BlockPrecondError() const
+{
+    ASSERT(precond_==BlockJacobiSelf, "The block preconditioner is not in use");
+    if (!block_size_) CHK(AssembleBlockPrecond());
+
+    // a random vector on the block unknowns (the other slots are unused)
+    size_t sz(stokesBlockSize()+tensionBlockSize());
+    std::vector<value_type> x(sz, 0), y(sz), z(sz);
+    for (size_t i(0); i<block_idx_.size(); ++i)
+        x[block_idx_[i]] = drand48()-0.5;
+
+    CHK(ParallelMatvec(&x[0], &y[0], true));
+    CHK(ApplyBlockPrecond(&y[0], &z[0]));
+
+    value_type err(0), nrm(0);
+    for (size_t i(0); i<block_idx_.size(); ++i){
+        size_t j(block_idx_[i]);
+        err = std::max(err, (value_type) fabs(z[j]-x[j]));
+        nrm = std::max(nrm, (value_type) fabs(x[j]));
+    }
+    return(err/nrm);
+}
+
+template<typename SurfContainer, typename Interaction>
+Error_t InterfacialVelocity<SurfContainer, Interaction>::
+ApplyBlockPrecond(const value_type *x, value_type *y) const
+{
+    PROFILESTART();
+    size_t sz(stokesBlockSize()+tensionBlockSize());
+    size_t nb(block_size_);
+    long nv(nb ? block_idx_.size()/nb : 0);
+    ASSERT(block_lu_.size()==nv*nb*nb, "The block preconditioner is not assembled");
+
+    // the unused coefficient slots are passed through
+    if (x!=y) memcpy(y, x, sz*sizeof(value_type));
+
+#pragma omp parallel
+    {
+        std::vector<value_type> b(nb);
+#pragma omp for
+        for (long i=0; i<nv; ++i){
+            const size_t *idx(&block_idx_[i*nb]);
+            for (size_t r(0); r<nb; ++r) b[r] = y[idx[r]];
+
+            int n(nb), one(1), info(0);
+            Getrs("N", n, one, &block_lu_[i*nb*nb], n, &block_piv_[i*nb], &b[0], n, info);
+            for (size_t r(0); r<nb; ++r) y[idx[r]] = b[r];
+        }
+    }
+
+    PROFILEEND("",0);
+    return ErrorEvent::Success;
+}
+
+template<typename SurfContainer, typename Interaction>
+Error_t InterfacialVelocity<SurfContainer, Interaction>::
+ImplicitApply(const POp_t *o, const value_type *x, value_type *y)
+{
     const InterfacialVelocity *F(NULL);
     o->Context((const void**) &F);
-    size_t vsz(F->stokesBlockSize()), tsz(F->tensionBlockSize());
+    size_t nm(device_type::MallocCount());
+    if (!F->inexact_solve_){
+        Error_t err(F->ParallelMatvec(x, y, false));
+        if (F->solve_matvecs_++) F->matvec_mallocs_ += device_type::MallocCount()-nm;
+        return err;
+    }
 
-    std::auto_ptr<Vec_t> vox = F->checkoutVec();
-    std::auto_ptr<Sca_t> ten = F->checkoutSca();
-    vox->replicate(F->pos_vel_);
-    ten->replicate(F->tension_);
+    // The matvec error may grow like tol*|r0|/|r_k| without spoiling
+    // the final residual (inexact Krylov); the factor is a safety margin
+    value_type rnorm, rnorm0, tol(0);
+    CHK(F->parallel_solver_->ResidualNorm(rnorm, rnorm0));
+    if (rnorm>0) tol = 0.1 * F->params_.time_tol * rnorm0 / rnorm;
+    int level(F->stokes_.SetAccuracy(tol));
+    if (F->stokes_sp_) F->stokes_sp_->SetAccuracy(tol);
+
+    double ts(GETSECONDS());
+    Error_t err(F->ParallelMatvec(x, y, false));
+    F->matvec_time_[level] += GETSECONDS()-ts;
+    ++F->matvec_count_[level];
+    if (F->solve_matvecs_++) F->matvec_mallocs_ += device_type::MallocCount()-nm;
+
+    F->stokes_.SetAccuracy(0);
+    if (F->stokes_sp_) F->stokes_sp_->SetAccuracy(0);
+    return err;
+}
+
+template<typename SurfContainer, typename Interaction>
+Error_t InterfacialVelocity<SurfContainer, Interaction>::
+ParallelMatvec(const value_type *x, value_type *y, bool self_only) const
+{
+    PROFILESTART();
+    size_t vsz(stokesBlockSize()), tsz(tensionBlockSize());
+
+    if (params_.pseudospectral && device_type::IsHost()){
+        COUTDEBUG("Applying the matvec in place on the parallel vectors");
+        Vec_t vox, vox_out;
+        Sca_t ten, ten_out;
+        ViewParallelArray(const_cast<value_type*>(x), vox, ten); // only read
+        ViewParallelArray(y, vox_out, ten_out);
+
+        ImplicitMatvecPhysical(vox, ten, vox_out, ten_out, self_only);
+
+        PROFILEEND("",0);
+        return ErrorEvent::Success;
+    }
+
+    std::auto_ptr<Vec_t> vox = checkoutVec();
+    std::auto_ptr<Sca_t> ten = checkoutSca();
+    vox->replicate(pos_vel_);
+    ten->replicate(tension_);
 
     COUTDEBUG("Unpacking the input from parallel vector");
-    if (F->params_.pseudospectral){
+    if (params_.pseudospectral){
         vox->getDevice().Memcpy(vox->begin(), x    , vsz * sizeof(value_type), device_type::MemcpyHostToDevice);
         ten->getDevice().Memcpy(ten->begin(), x+vsz, tsz * sizeof(value_type), device_type::MemcpyHostToDevice);
     } else {  /* Galerkin */
-        std::auto_ptr<Vec_t> voxSh = F->checkoutVec();
-        std::auto_ptr<Sca_t> tSh   = F->checkoutSca();
-        std::auto_ptr<Vec_t> wrk   = F->checkoutVec();
+        std::auto_ptr<Vec_t> voxSh = checkoutVec();
+        std::auto_ptr<Sca_t> tSh   = checkoutSca();
+        std::auto_ptr<Vec_t> wrk   = checkoutVec();
 
         voxSh->replicate(*vox);
         tSh->replicate(*ten);
@@ -1008,49 +1375,63 @@ ImplicitApply(const POp_t *o, const value_type *x, value_type *y)
         tSh  ->getDevice().Memcpy(tSh->begin()  , x+vsz, tsz * sizeof(value_type), device_type::MemcpyHostToDevice);
 
         COUTDEBUG("Mapping the input to physical space");
-        F->sht_.backward(*voxSh, *wrk, *vox);
-        F->sht_.backward(*tSh  , *wrk, *ten);
+        sht_.backward(*voxSh, *wrk, *vox);
+        sht_.backward(*tSh  , *wrk, *ten);
 
-        F->recycle(voxSh);
-        F->recycle(tSh);
-        F->recycle(wrk);
+        recycle(voxSh);
+        recycle(tSh);
+        recycle(wrk);
     }
+    copied_bytes_ += (vsz+tsz) * sizeof(value_type);
 
-    F->ImplicitMatvecPhysical(*vox, *ten);
+    ImplicitMatvecPhysical(*vox, *ten, self_only);
 
-    if (F->params_.pseudospectral){
+    if (params_.pseudospectral){
         COUTDEBUG("Packing the matvec into parallel vector");
         vox->getDevice().Memcpy(y    , vox->begin(), vsz * sizeof(value_type), device_type::MemcpyDeviceToHost);
         ten->getDevice().Memcpy(y+vsz, ten->begin(), tsz * sizeof(value_type), device_type::MemcpyDeviceToHost);
     } else {  /* Galerkin */
         COUTDEBUG("Mapping the matvec to physical space");
-        std::auto_ptr<Vec_t> voxSh = F->checkoutVec();
-        std::auto_ptr<Sca_t> tSh   = F->checkoutSca();
-        std::auto_ptr<Vec_t> wrk   = F->checkoutVec();
+        std::auto_ptr<Vec_t> voxSh = checkoutVec();
+        std::auto_ptr<Sca_t> tSh   = checkoutSca();
+        std::auto_ptr<Vec_t> wrk   = checkoutVec();
 
         voxSh->replicate(*vox);
         tSh->replicate(*ten);
         wrk->replicate(*vox);
 
-        F->sht_.forward(*vox, *wrk, *voxSh);
-        F->sht_.forward(*ten, *wrk, *tSh);
+        sht_.forward(*vox, *wrk, *voxSh);
+        sht_.forward(*ten, *wrk, *tSh);
 
         COUTDEBUG("Packing the matvec into parallel vector");
         voxSh->getDevice().Memcpy(y    , voxSh->begin(), vsz * sizeof(value_type), device_type::MemcpyDeviceToHost);
         tSh  ->getDevice().Memcpy(y+vsz, tSh->begin()  , tsz * sizeof(value_type), device_type::MemcpyDeviceToHost);
 
-        F->recycle(voxSh);
-        F->recycle(tSh);
-        F->recycle(wrk);
+        recycle(voxSh);
+        recycle(tSh);
+        recycle(wrk);
     }
+    copied_bytes_ += (vsz+tsz) * sizeof(value_type);
 
-    F->recycle(vox);
-    F->recycle(ten);
+    recycle(vox);
+    recycle(ten);
 
     PROFILEEND("",0);
     return ErrorEvent::Success;
 }
 
+template<typename SurfContainer, typename Interaction>
+void InterfacialVelocity<SurfContainer, Interaction>::
+ViewParallelArray(value_type *x, Vec_t &vox, Sca_t &ten) const
+{
+    size_t vsz(stokesBlockSize()), tsz(tensionBlockSize());
+    vox.wrap(x, vsz);
+    ten.wrap(x+vsz, tsz);
+    vox.replicate(pos_vel_);
+    ten.replicate(tension_);
+    ASSERT(vox.begin()==x && ten.begin()==x+vsz, "The parallel vector layout doesn't match the containers");
+}
+
 template<typename SurfContainer, typename Interaction>
 Error_t InterfacialVelocity<SurfContainer, Interaction>::
 ImplicitPrecond(const PSolver_t *ksp, const value_type *x, value_type *y)
@@ -1059,8 +1440,43 @@ ImplicitPrecond(const PSolver_t *ksp, const value_type *x, value_type *y)
     const InterfacialVelocity *F(NULL);
     ksp->PrecondContext((const void**) &F);
 
+    if (F->precond_==BlockJacobiSelf){
+        Error_t ierr(F->ApplyBlockPrecond(x, y));
+        PROFILEEND("",0);
+        return ierr;
+    }
+
     size_t vsz(F->stokesBlockSize()), tsz(F->tensionBlockSize());
 
+    if (F->params_.pseudospectral && device_type::IsHost()){
+        COUTDEBUG("Applying diagonal preconditioner in place on the parallel vectors");
+        Vec_t vox, vox_out;
+        Sca_t ten, ten_out;
+        F->ViewParallelArray(const_cast<value_type*>(x), vox, ten); // only read
+        F->ViewParallelArray(y, vox_out, ten_out);
+
+        std::auto_ptr<Vec_t> vxs = F->checkoutVec();
+        std::auto_ptr<Vec_t> wrk = F->checkoutVec();
+        std::auto_ptr<Sca_t> tns = F->checkoutSca();
+        vxs->replicate(F->pos_vel_);
+        wrk->replicate(F->pos_vel_);
+        tns->replicate(F->tension_);
+
+        F->sht_.forward(vox, *wrk, *vxs);
+        F->sht_.forward(ten, *wrk, *tns);
+        F->sht_.ScaleFreq(vxs->begin(), vxs->getNumSubFuncs(), F->position_precond.begin(), vxs->begin());
+        F->sht_.ScaleFreq(tns->begin(), tns->getNumSubFuncs(), F->tension_precond.begin() , tns->begin());
+        F->sht_.backward(*vxs, *wrk, vox_out);
+        F->sht_.backward(*tns, *wrk, ten_out);
+
+        F->recycle(vxs);
+        F->recycle(wrk);
+        F->recycle(tns);
+
+        PROFILEEND("",0);
+        return ErrorEvent::Success;
+    }
+
     std::auto_ptr<Vec_t> vox = F->checkoutVec();
     std::auto_ptr<Vec_t> vxs = F->checkoutVec();
     std::auto_ptr<Vec_t> wrk = F->checkoutVec();
@@ -1083,6 +1499,7 @@ ImplicitPrecond(const PSolver_t *ksp, const value_type *x, value_type *y)
         vxs->getDevice().Memcpy(vxs->begin(), x    , vsz * sizeof(value_type), device_type::MemcpyHostToDevice);
         tns->getDevice().Memcpy(tns->begin(), x+vsz, tsz * sizeof(value_type), device_type::MemcpyHostToDevice);
     }
+    F->copied_bytes_ += (vsz+tsz) * sizeof(value_type);
 
     COUTDEBUG("Applying diagonal preconditioner");
     F->sht_.ScaleFreq(vxs->begin(), vxs->getNumSubFuncs(), F->position_precond.begin(), vxs->begin());
@@ -1097,6 +1514,7 @@ ImplicitPrecond(const PSolver_t *ksp, const value_type *x, value_type *y)
         vxs->getDevice().Memcpy(y    , vxs->begin(), vsz * sizeof(value_type), device_type::MemcpyDeviceToHost);
         tns->getDevice().Memcpy(y+vsz, tns->begin(), tsz * sizeof(value_type), device_type::MemcpyDeviceToHost);
     }
+    F->copied_bytes_ += (vsz+tsz) * sizeof(value_type);
 
     F->recycle(vox);
     F->recycle(vxs);
@@ -1115,17 +1533,139 @@ Solve(const PVec_t *rhs, PVec_t *u0, const value_type &dt, const SolverScheme &s
     PROFILESTART();
     INFO("Solving for position/velocity and tension using "<<scheme<<" scheme.");
 
+    copied_bytes_ = 0;
+    solve_matvecs_ = matvec_mallocs_ = 0;
+    inexact_solve_ = params_.inexact_krylov;
+    mixed_solve_ = (stokes_sp_!=NULL);
     Error_t err = parallel_solver_->Solve(parallel_rhs_, parallel_u_);
     typename PVec_t::size_type iter;
     CHK(parallel_solver_->IterationNumber(iter));
-
-    INFO("Parallel solver returned after "<<iter<<" iteration(s).");
+    if (mixed_solve_ && err==ErrorEvent::Success) err = RefineSolution(iter);
+    inexact_solve_ = mixed_solve_ = false;
+    solve_iter_ = iter;
+    solve_iter_total_ += iter;
+    solve_matvec_total_ += solve_matvecs_;
+    ++solve_count_;
+
+    INFO("Parallel solver returned after "<<iter<<" iteration(s) and "<<solve_matvecs_
+        <<" matvec(s) (average "<<(double) solve_iter_total_/solve_count_<<" iterations and "
+        <<(double) solve_matvec_total_/solve_count_<<" matvecs over "<<solve_count_<<" solves).");
+    INFO("Bytes copied between the parallel vectors and the containers per iteration: "
+        <<(iter ? copied_bytes_/iter : copied_bytes_));
+    INFO("Device allocations in the matvecs after the first: "<<matvec_mallocs_
+        <<" in "<<(solve_matvecs_ ? solve_matvecs_-1 : 0)<<" matvec(s)");
+    INFO("Peak spherical harmonic workspace of the Stokes evaluator: "
+        <<stokes_.WorkspaceBytes()/1024.0/1024.0<<" MB");
+    if (params_.fmm_overlap)
+        INFO("Share of the far field or self/near time hidden by the overlap: "
+            <<100*stokes_.OverlapRatio()<<"%");
     parallel_solver_->ViewReport();
 
+    if (params_.inexact_krylov){
+        for (int l(0); l<Stokes_t::AccuracyLevels(); ++l)
+            if (matvec_count_[l])
+                INFO("Total matvecs at accuracy level "<<l<<" (far-field tol "<<Stokes_t::AccuracyTol(l)<<"): "
+                    <<matvec_count_[l]<<", "<<matvec_time_[l]/matvec_count_[l]<<"s per matvec");
+
+        // true residual with the full accuracy operator
+        value_type res, nrm;
+        CHK(parallel_solver_->OperatorResidual(parallel_rhs_, parallel_u_, res));
+        CHK(parallel_rhs_->Norm(nrm));
+        INFO("True relative residual of the inexact solve: "<<SCI_PRINT_FRMT<<res/nrm);
+    }
+
+    PROFILEEND("",0);
+    return err;
+}
+
+/*
+ * Iterative refinement of the single precision solve: the residual is
+ * computed with the double precision operator and the correction is
+ * solved with the single precision one, until the residual is below
+ * the solver tolerance.
+ */
+template<typename SurfContainer, typename Interaction>
+Error_t InterfacialVelocity<SurfContainer, Interaction>::
+RefineSolution(size_t &iter) const
+{
+    PROFILESTART();
+    const int max_refine(3);
+    bool inexact(inexact_solve_);
+
+    PVec_t *r(NULL), *d(NULL);
+    CHK(parallel_rhs_->ReplicateTo(&r));
+    CHK(parallel_rhs_->ReplicateTo(&d));
+
+    value_type nrm, res;
+    CHK(parallel_rhs_->Norm(nrm));
+
+    Error_t err(ErrorEvent::Success);
+    for (int i(0); ; ++i){
+        // r = A*u-b in double precision with full accuracy
+        inexact_solve_ = mixed_solve_ = false;
+        CHK(parallel_matvec_->Apply(parallel_u_, r));
+        CHK(r->axpy(-1.0, parallel_rhs_));
+        CHK(r->Norm(res));
+        INFO("Mixed precision refinement "<<i<<", relative residual: "<<SCI_PRINT_FRMT<<res/nrm);
+        if (res<=params_.time_tol*nrm || i==max_refine) break;
+
+        // A*d = r with the single precision operator and u -= d
+        inexact_solve_ = inexact;
+        mixed_solve_ = true;
+        size_t niter;
+        CHK(parallel_solver_->InitialGuessNonzero(false));
+        err = parallel_solver_->Solve(r, d);
+        CHK(parallel_solver_->IterationNumber(niter));
+        iter += niter;
+        if (err!=ErrorEvent::Success) break;
+        CHK(parallel_u_->axpy(-1.0, d));
+    }
+    CHK(parallel_solver_->InitialGuessNonzero(params_.solver_guess!=ZeroGuess));
+    inexact_solve_ = inexact;
+    mixed_solve_ = true;
+
+    delete r;
+    delete d;
+
     PROFILEEND("",0);
     return err;
 }
 
+template<typename SurfContainer, typename Interaction>
+void InterfacialVelocity<SurfContainer, Interaction>::
+CastToSinglePrecision(const Vec_t &x, pvfmm::Vector<float> &y) const
+{
+    long sz(x.size());
+    const value_type *xp(x.begin());
+    y.ReInit(sz);
+#pragma omp parallel for
+    for (long i=0; i<sz; ++i)
+        y[i] = xp[i];
+}
+
+template<typename SurfContainer, typename Interaction>
+void InterfacialVelocity<SurfContainer, Interaction>::
+StokesSinglePrecision(const Vec_t &fs, const Vec_t *fd, Vec_t &vel) const
+{
+    // the densities are copied by SetDensity*, so one buffer is enough
+    CastToSinglePrecision(fs, sp_buffer_);
+    stokes_sp_->SetDensitySL(&sp_buffer_);
+    if (fd){
+        CastToSinglePrecision(*fd, sp_buffer_);
+        stokes_sp_->SetDensityDL(&sp_buffer_);
+    } else {
+        stokes_sp_->SetDensityDL(NULL);
+    }
+
+    const pvfmm::Vector<float> &v((*stokes_sp_)());
+    long sz(vel.size());
+    ASSERT(v.Dim()==sz, "Bad size of the single precision velocity");
+    value_type *vp(vel.begin());
+#pragma omp parallel for
+    for (long i=0; i<sz; ++i)
+        vp[i] = v[i];
+}
+
 template<typename SurfContainer, typename Interaction>
 Error_t InterfacialVelocity<SurfContainer, Interaction>::Update(PVec_t *u0)
 {
@@ -1171,6 +1711,22 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::Update(PVec_t *u0)
     return ErrorEvent::Success;
 }
 
+template<typename SurfContainer, typename Interaction>
+Error_t InterfacialVelocity<SurfContainer, Interaction>::RecordSolution(const PVec_t *u0)
+{
+    typename PVec_t::const_iterator i(NULL);
+    typename PVec_t::size_type rsz;
+
+    CHK(u0->GetArray(i, rsz));
+    guess_hist_[1].swap(guess_hist_[0]);
+    guess_hist_[0].assign(i, i+rsz);
+    guess_dt_[1] = guess_dt_[0];
+    guess_dt_[0] = dt_;
+    CHK(u0->RestoreArray(i));
+
+    return ErrorEvent::Success;
+}
+
 template<typename SurfContainer, typename Interaction>
 Error_t InterfacialVelocity<SurfContainer, Interaction>::
 BgFlow(Vec_t &bg, const value_type &dt) const{
@@ -1533,106 +2089,150 @@ StokesError(const Vec_t &x) const
     return stokes_error;
 }
 
-template <class Vec_t, class SHT>
-static std::vector<typename Vec_t::value_type> inner_prod(const Vec_t& v1, const Vec_t& v2, SHT* sh_trans, int rep_exp){
-  typedef typename Vec_t::value_type value_type;
+template<typename SurfContainer, typename Interaction>
+Error_t InterfacialVelocity<SurfContainer, Interaction>::
+VesicleCost(std::vector<value_type> &cost) const
+{
+    size_t nv(S_.getPosition().getNumSubs());
+    size_t np(S_.getPosition().getStride());
+    const pvfmm::Vector<size_t> &near_cnt(stokes_.NearTargetCount());
+    bool has_near(near_cnt.Dim() == nv);
 
-  static Vec_t w, v1_, v2_;
-  { // Set v1_
-    v1_.replicate(v1);
-    w  .replicate(v1);
-    sh_trans->forward(v1, w, v1_);
-  }
-  { // Set v2_
-    v2_.replicate(v2);
-    w  .replicate(v2);
-    sh_trans->forward(v2, w, v2_);
-  }
-  size_t p=v1.getShOrder();
-  int ns_x = v1.getNumSubFuncs();
+    cost.resize(nv);
+    for (size_t i=0; i<nv; ++i)
+        cost[i] = np + (has_near ? near_cnt[i] : 0);
 
+    return ErrorEvent::Success;
+}
+
+template <class T>
+static const std::vector<T>& reparam_weights(size_t p, int rep_exp){
   assert(p<256);
   assert(rep_exp<128);
-  static std::vector<value_type> A_[256*128];
-  std::vector<value_type>& A=A_[rep_exp*256+p];
+  static std::vector<T> A_[256*128];
+  std::vector<T>& A=A_[rep_exp*256+p];
   if(!A.size()){
     A.resize(p+1);
     long filter_freq_=(rep_exp?p/2:p/3);
     for(int ii=0; ii<= p; ++ii){
-      value_type a = 1.0 - (rep_exp?std::pow(ii*1.0/filter_freq_,rep_exp):0);
+      T a = 1.0 - (rep_exp?std::pow(ii*1.0/filter_freq_,rep_exp):0);
       a *= (ii > filter_freq_ ? 0.0 : 1.0 );
       A[ii] = 1.0 - a;
     }
   }
+  return A;
+}
 
-  std::vector<value_type> E(ns_x/COORD_DIM,0);
+// weighted inner products E[k] of each vesicle's SH coefficients u_
+// and v_[k], k<nv (at most 3), in one pass over u_
+template <class Vec_t>
+static void coeff_prods(const Vec_t& u_, const Vec_t* const* v_, int nv, int rep_exp,
+    std::vector<typename Vec_t::value_type>* E){
+  typedef typename Vec_t::value_type value_type;
+  ASSERT(nv>0 && nv<=3, "Unsupported number of products");
+
+  size_t p=u_.getShOrder();
+  int ns_x = u_.getNumSubFuncs();
+  const std::vector<value_type>& A=reparam_weights<value_type>(p, rep_exp);
+
+  for(int k=0; k<nv; ++k) E[k].assign(ns_x/COORD_DIM,0);
   for(int ii=0; ii<= p; ++ii){
-    value_type* inPtr_v1 = v1_.begin() + ii;
-    value_type* inPtr_v2 = v2_.begin() + ii;
+    const value_type* inPtr_u = u_.begin() + ii;
+    const value_type* inPtr_v[3];
+    for(int k=0; k<nv; ++k) inPtr_v[k] = v_[k]->begin() + ii;
     int len = 2*ii + 1 - (ii/p);
     for(int jj=0; jj< len; ++jj){
       int dist = (p + 1 - (jj + 1)/2);
       for(int ss=0; ss<ns_x; ++ss){
-        E[ss/COORD_DIM] += A[ii]*(*inPtr_v1)*(*inPtr_v2);
-        inPtr_v1 += dist;
-        inPtr_v2 += dist;
+        value_type Au(A[ii]*(*inPtr_u));
+        for(int k=0; k<nv; ++k){
+          E[k][ss/COORD_DIM] += Au*(*inPtr_v[k]);
+          inPtr_v[k] += dist;
+        }
+        inPtr_u += dist;
+      }
+      inPtr_u--;
+      inPtr_u += jj%2;
+      for(int k=0; k<nv; ++k){
+        inPtr_v[k]--;
+        inPtr_v[k] += jj%2;
       }
-      inPtr_v1--;
-      inPtr_v2--;
-      inPtr_v1 += jj%2;
-      inPtr_v2 += jj%2;
     }
   }
+}
 
+// weighted inner product of each vesicle's SH coefficients v1_ and v2_
+template <class Vec_t>
+static std::vector<typename Vec_t::value_type> coeff_prod(const Vec_t& v1_, const Vec_t& v2_, int rep_exp){
+  std::vector<typename Vec_t::value_type> E;
+  const Vec_t* v[1]={&v2_};
+  coeff_prods(v1_, v, 1, rep_exp, &E);
   return E;
 }
 
-template <class Vec_t, class SHT>
-static void sht_filter(const Vec_t& v1, Vec_t& v2, SHT* sh_trans, int rep_exp){
+// v_ = -A v_ for the SH coefficients v_
+template <class Vec_t>
+static void coeff_filter(Vec_t& v_, int rep_exp){
   typedef typename Vec_t::value_type value_type;
 
-  static Vec_t w, v1_;
-  { // Set v1_
-    v1_.replicate(v1);
-    w  .replicate(v1);
-    sh_trans->forward(v1, w, v1_);
-  }
-  size_t p=v1.getShOrder();
-  int ns_x = v1.getNumSubFuncs();
+  size_t p=v_.getShOrder();
+  int ns_x = v_.getNumSubFuncs();
+  const std::vector<value_type>& A=reparam_weights<value_type>(p, rep_exp);
 
-  assert(p<256);
-  assert(rep_exp<128);
-  static std::vector<value_type> A_[256*128];
-  std::vector<value_type>& A=A_[rep_exp*256+p];
-  if(!A.size()){
-    A.resize(p+1);
-    long filter_freq_=(rep_exp?p/2:p/3);
-    for(int ii=0; ii<= p; ++ii){
-      value_type a = 1.0 - (rep_exp?std::pow(ii*1.0/filter_freq_,rep_exp):0);
-      a *= (ii > filter_freq_ ? 0.0 : 1.0 );
-      A[ii] = 1.0 - a;
-    }
-  }
-
-  value_type E=0;
   for(int ii=0; ii<= p; ++ii){
-    value_type* inPtr_v1 = v1_.begin() + ii;
+    value_type* inPtr_v = v_.begin() + ii;
     int len = 2*ii + 1 - (ii/p);
     for(int jj=0; jj< len; ++jj){
       int dist = (p + 1 - (jj + 1)/2);
       for(int ss=0; ss<ns_x; ++ss){
-        inPtr_v1[0] *= -A[ii];
-        inPtr_v1 += dist;
+        inPtr_v[0] *= -A[ii];
+        inPtr_v += dist;
       }
-      inPtr_v1--;
-      inPtr_v1 += jj%2;
+      inPtr_v--;
+      inPtr_v += jj%2;
     }
   }
+}
 
-  { // Set v2
-    v2 .replicate(v1);
-    sh_trans->backward(v1_, w, v2);
+template <class Vec_t, class SHT>
+static std::vector<typename Vec_t::value_type> inner_prod(const Vec_t& v1, const Vec_t& v2, SHT* sh_trans, int rep_exp){
+  Vec_t w, v1_, v2_;
+  { // Set v1_
+    v1_.replicate(v1);
+    w  .replicate(v1);
+    sh_trans->forward(v1, w, v1_);
+  }
+  { // Set v2_
+    v2_.replicate(v2);
+    w  .replicate(v2);
+    sh_trans->forward(v2, w, v2_);
   }
+
+  return coeff_prod(v1_, v2_, rep_exp);
+}
+
+// out[k] = in[idx[k]] for the subs (vesicles) of the containers; out
+// may be in when idx is increasing
+template <class Container>
+static void gather_subs(const Container &in, const std::vector<long> &idx, Container &out){
+  if (&out != &in) out.replicate(in);
+  size_t sz(in.getTheDim()*in.getStride());
+  for (size_t k=0; k<idx.size(); ++k)
+    if (&out != &in || idx[k] != k)
+      out.getDevice().Memcpy(out.getSubN_begin(k), in.getSubN_begin(idx[k]),
+          sz * sizeof(typename Container::value_type),
+          Container::device_type::MemcpyDeviceToDevice);
+  out.resize(idx.size());
+}
+
+// out[idx[k]] = in[k]
+template <class Container>
+static void scatter_subs(const Container &in, const std::vector<long> &idx, Container &out){
+  size_t sz(in.getTheDim()*in.getStride());
+  for (size_t k=0; k<idx.size(); ++k)
+    out.getDevice().Memcpy(out.getSubN_begin(idx[k]), in.getSubN_begin(k),
+        sz * sizeof(typename Container::value_type),
+        Container::device_type::MemcpyDeviceToDevice);
 }
 
 template<typename SurfContainer, typename Interaction>
@@ -1663,13 +2263,11 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::reparam()
         sh_trans = &sht_;
     }
 
-    std::auto_ptr<Vec_t> u1 = checkoutVec();
-    std::auto_ptr<Vec_t> u2 = checkoutVec();
-    std::auto_ptr<Sca_t> wrk = checkoutSca();
-    u1 ->replicate(Surf->getPosition());
-    u2 ->replicate(Surf->getPosition());
-    wrk->replicate(Surf->getPosition());
-    long N_ves = u1->getNumSubs();
+    bool advect_tension(params_.scheme != GloballyImplicit);
+    if (advect_tension && params_.rep_upsample){
+        WARN("Reparametrizaition is not advecting the tension in the upsample mode (fix!)");
+        advect_tension = false;
+    }
 
     value_type E0=0;
     { // Compute energy E0
@@ -1677,95 +2275,201 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::reparam()
         for(long i=0;i<x2.size();i++) E0+=x2[i];
     }
 
+    /*
+     * The iteration runs on S_rep_, which holds only the active
+     * (unconverged) vesicles; converged vesicles are written back to
+     * Surf and dropped, so they no longer pay for the transforms and
+     * the geometry. The step is a Polak-Ribiere nonlinear conjugate
+     * gradient on the energy <x,x>_A, with the tangential filtered
+     * -Ax as the descent direction, an exact line search along the
+     * search direction, and the displacement capped by rep_ts.
+     */
+    long N_ves = Surf->getPosition().getNumSubs();
+    std::vector<long> active(N_ves);
+    for(long i=0;i<N_ves;i++) active[i]=i;
+
+    if (S_rep_ == NULL || S_rep_->getShOrder() != Surf->getShOrder()){
+        delete S_rep_;
+        S_rep_ = new SurfContainer(Surf->getShOrder(), mats_, &Surf->getPosition(),
+            Surf->diffFilterFreq(), Surf->reparamFilterFreq());
+    } else
+        S_rep_->setPosition(Surf->getPosition());
+    SurfContainer &Sa(*S_rep_);
+
+    std::auto_ptr<Vec_t> vbuf[8];
+    for(int i=0;i<8;i++) vbuf[i] = checkoutVec();
+    Vec_t *g(vbuf[0].get()), *gp(vbuf[1].get()), *d(vbuf[2].get()), *dp(vbuf[3].get());
+    Vec_t *xc(vbuf[4].get()), *gc(vbuf[5].get()), *gpc(vbuf[6].get()), *wrk(vbuf[7].get());
+    std::auto_ptr<Sca_t> ten = checkoutSca();
+    std::auto_ptr<Sca_t> swrk = checkoutSca();
+    if (advect_tension) gather_subs(tension_, active, *ten);
+
     int ii(0);
-    std::vector<value_type> E;
-    while ( ii < rep_maxit )
+    std::vector<value_type> gg_prev;
+    while ( ii < rep_maxit && active.size() )
     {
-        //Surf->getSmoothedShapePositionReparam(*u1);
-        //axpy(static_cast<value_type>(-1), Surf->getPosition(), *u1, *u1);
-        sht_filter(Surf->getPosition(), *u1, sh_trans, rep_exp);
-        Surf->mapToTangentSpace(*u1, false /* upsample */);
-        { // Filter u1
-            static Vec_t u_, w;
-            u_.replicate(*u1);
-            w .replicate(*u1);
-            sh_trans->forward(*u1, w, u_);
-            sh_trans->backward(u_, w, *u1);
+        long na(active.size());
+        const Vec_t &x(Sa.getPosition());
+        g  ->replicate(x);
+        d  ->replicate(x);
+        xc ->replicate(x);
+        gc ->replicate(x);
+        wrk->replicate(x);
+
+        // descent direction g, the filtered -Ax in the tangent space
+        sh_trans->forward(x, *wrk, *xc);
+        axpy(static_cast<value_type>(1), *xc, *gc);
+        coeff_filter(*gc, rep_exp);
+        sh_trans->backward(*gc, *wrk, *g);
+        for(int k=0;k<2;k++){
+            Sa.mapToTangentSpace(*g, false /* upsample */);
+            sh_trans->forward(*g, *wrk, *gc);
+            sh_trans->backward(*gc, *wrk, *g);
         }
-        Surf->mapToTangentSpace(*u1, false /* upsample */);
-        { // Filter u1
-            static Vec_t u_, w;
-            u_.replicate(*u1);
-            w .replicate(*u1);
-            sh_trans->forward(*u1, w, u_);
-            sh_trans->backward(u_, w, *u1);
+
+        // <g,x>, <g,g>, and <g,g_prev> in one pass over g
+        std::vector<value_type> g_dot[3];
+        const Vec_t* g_with[3]={xc, gc, gpc};
+        coeff_prods(*gc, g_with, gg_prev.size() ? 3 : 2, rep_exp, g_dot);
+        const std::vector<value_type> &x_dot_g(g_dot[0]), &g_dot_g(g_dot[1]), &g_dot_gp(g_dot[2]);
+        std::vector<value_type> beta(na, 0);
+        if (gg_prev.size()){
+            for(long i=0;i<na;i++)
+                if (gg_prev[i]>0) beta[i]=std::max(static_cast<value_type>(0), (g_dot_g[i]-g_dot_gp[i])/gg_prev[i]);
         }
 
-        { // normalize u1 for each vesicle
-            long N = u1->getNumSubFuncs();
-            long M=u1->size()/N;
-            value_type* u=u1->begin();
-            for(long i=0;i<N/COORD_DIM;i++){
-                value_type max_v=0;
-                for(long j=0;j<M;j++){
-                    value_type x=u[j+M*(0+i*COORD_DIM)];
-                    value_type y=u[j+M*(1+i*COORD_DIM)];
-                    value_type z=u[j+M*(2+i*COORD_DIM)];
-                    max_v=std::max(max_v, sqrt(x*x+y*y+z*z));
-                }
-                for(long j=0;j<M;j++){
-                    u[j+M*(0+i*COORD_DIM)]/=max_v;
-                    u[j+M*(1+i*COORD_DIM)]/=max_v;
-                    u[j+M*(2+i*COORD_DIM)]/=max_v;
+        // search direction d = g + beta*d_prev; restart with g when d
+        // is not a descent direction
+        axpy(static_cast<value_type>(1), *g, *d);
+        for(long i=0;i<na;i++)
+            if (beta[i]>0){
+                long N=d->getStride()*DIM;
+                value_type* d_=d->getSubN_begin(i);
+                const value_type* dp_=dp->getSubN_begin(i);
+                for(long j=0;j<N;j++) d_[j]+=beta[i]*dp_[j];
+            }
+        std::vector<value_type> x_dot_d(x_dot_g), d_dot_d(g_dot_g);
+        bool has_beta(false);
+        for(long i=0;i<na;i++) has_beta |= (beta[i]>0);
+        if (has_beta){
+            sh_trans->forward(*d, *wrk, *dp /* coefficients of d */);
+            std::vector<value_type> d_dot[2];
+            const Vec_t* d_with[2]={xc, dp};
+            coeff_prods(*dp, d_with, 2, rep_exp, d_dot);
+            const std::vector<value_type> &xd(d_dot[0]), &dd(d_dot[1]);
+            for(long i=0;i<na;i++){
+                if (beta[i]==0) continue;
+                if (xd[i]<0){
+                    x_dot_d[i]=xd[i];
+                    d_dot_d[i]=dd[i];
+                } else { // restart
+                    long N=d->getStride()*DIM;
+                    d->getDevice().Memcpy(d->getSubN_begin(i), g->getSubN_begin(i),
+                        N * sizeof(value_type), device_type::MemcpyDeviceToDevice);
                 }
             }
         }
 
-        std::vector<value_type>  x_dot_x =inner_prod(Surf->getPosition(), Surf->getPosition(), sh_trans, rep_exp);
-        std::vector<value_type>  x_dot_u1=inner_prod(Surf->getPosition(),                 *u1, sh_trans, rep_exp);
-        std::vector<value_type> u1_dot_u1=inner_prod(                *u1,                 *u1, sh_trans, rep_exp);
-
+        // line search, the displacement dt[i]*max|d_i| is capped by ts;
+        // wrk is the displacement
         value_type dt_max(0);
-        std::vector<value_type> dt(x_dot_u1.size(),0);
-        for(long i=0; i<N_ves; i++){
-            dt[i]=std::min(ts, -x_dot_u1[i]/u1_dot_u1[i]);
-            if( dt[i]<rep_tol || (E.size() && (E[i]==0 /*|| E[i]-x_dot_x[i]<rep_tol*rep_tol*E[i]*/ )) ){
-                x_dot_x[i]=0;
-                dt[i]=0;
+        std::vector<long> keep, done;
+        for(long i=0; i<na; i++){
+            long M=d->getStride();
+            const value_type* d_=d->getSubN_begin(i);
+            value_type max_d(0);
+            for(long j=0;j<M;j++)
+                max_d=std::max(max_d, sqrt(d_[j]*d_[j]+d_[j+M]*d_[j+M]+d_[j+2*M]*d_[j+2*M]));
+
+            value_type dt(0), disp(0);
+            if (max_d>0 && d_dot_d[i]>0){
+                dt=-x_dot_d[i]/d_dot_d[i];
+                disp=dt*max_d;
+                if (disp>ts){ dt=ts/max_d; disp=ts; }
             }
-            dt_max=std::max(dt_max,dt[i]);
-
-            long N=u1->getStride()*DIM;
-            value_type* u1_=u1->getSubN_begin(i);
-            for(long j=0;j<N;j++) u1_[j]*=dt[i];
+            if (disp<rep_tol || disp!=disp){
+                dt=0;
+                done.push_back(i);
+            } else
+                keep.push_back(i);
+            dt_max=std::max(dt_max,disp);
+
+            value_type* w_=wrk->getSubN_begin(i);
+            for(long j=0;j<DIM*M;j++) w_[j]=dt*d_[j];
         }
         if(dt_max==0) break;
-        E=x_dot_x;
 
         //Advecting tension (useless for implicit)
-        if (params_.scheme != GloballyImplicit){
-            if (params_.rep_upsample)
-                WARN("Reparametrizaition is not advecting the tension in the upsample mode (fix!)");
-            else {
-                Surf->grad(tension_, *u2);
-                GeometricDot(*u2, *u1, *wrk);
-                axpy(1.0, *wrk, tension_, tension_);
-            }
+        if (advect_tension){
+            std::auto_ptr<Vec_t> u2 = checkoutVec();
+            u2  ->replicate(x);
+            swrk->replicate(x);
+            Sa.grad(*ten, *u2);
+            GeometricDot(*u2, *wrk, *swrk);
+            axpy(static_cast<value_type>(1), *swrk, *ten, *ten);
+            recycle(u2);
         }
 
         //updating position
-        axpy(1.0, *u1, Surf->getPosition(), Surf->getPositionModifiable());
+        axpy(static_cast<value_type>(1), *wrk, Sa.getPosition(), Sa.getPositionModifiable());
+
+        // the previous direction and gradient for the next iteration
+        std::swap(d, dp);
+        std::swap(g, gp);
+        std::swap(gc, gpc);
+        gg_prev=g_dot_g;
+
+        if (done.size()){ // write back and compact the active set
+            std::vector<long> idx(done.size());
+            for(size_t k=0;k<done.size();k++) idx[k]=active[done[k]];
+            gather_subs(Sa.getPosition(), done, *wrk);
+            scatter_subs(*wrk, idx, Surf->getPositionModifiable());
+            if (advect_tension){
+                gather_subs(*ten, done, *swrk);
+                scatter_subs(*swrk, idx, tension_);
+                gather_subs(*ten, keep, *ten);
+            }
+
+            for(size_t k=0;k<keep.size();k++) active[k]=active[keep[k]];
+            active.resize(keep.size());
+            for(size_t k=0;k<keep.size();k++) gg_prev[k]=gg_prev[keep[k]];
+            gg_prev.resize(keep.size());
+
+            gather_subs(Sa.getPosition(), keep, Sa.getPositionModifiable());
+            gather_subs(*dp, keep, *dp);
+            gather_subs(*gp, keep, *gp);
+            gpc->replicate(*gp);
+            wrk->replicate(*gp);
+            sh_trans->forward(*gp, *wrk, *gpc);
+            COUTDEBUG("Iteration = "<<ii<<", active vesicles = "<<active.size());
+        }
 
         COUTDEBUG("Iteration = "<<ii<<", dt = "<<dt_max);
         ++ii;
     }
 
+    // the vesicles still active at the end
+    scatter_subs(Sa.getPosition(), active, Surf->getPositionModifiable());
+    if (advect_tension) scatter_subs(*ten, active, tension_);
+
+    for(int i=0;i<8;i++) recycle(vbuf[i]);
+    recycle(ten);
+    recycle(swrk);
+
+    std::auto_ptr<Vec_t> u1 = checkoutVec();
+    std::auto_ptr<Vec_t> u2 = checkoutVec();
+    u1 ->replicate(Surf->getPosition());
+    u2 ->replicate(Surf->getPosition());
+
     value_type E1=0;
     { // Compute energy E1
         std::vector<value_type>  x2=inner_prod(Surf->getPosition(), Surf->getPosition(), sh_trans, rep_exp);
         for(long i=0;i<x2.size();i++) E1+=x2[i];
     }
     INFO("Iterations = "<<ii<<", Energy = "<<E1<<", dE = "<<E1-E0);
+    rep_iter_ = ii;
+    rep_energy0_ = E0;
+    rep_energy_ = E1;
     { // print log(coeff)
       std::auto_ptr<Vec_t> x = checkoutVec();
       { // Set x
@@ -1812,7 +2516,6 @@ Error_t InterfacialVelocity<SurfContainer, Interaction>::reparam()
 
     recycle(u1);
     recycle(u2);
-    recycle(wrk);
     PROFILEEND("",0);
 
     return ErrorEvent::Success;
@@ -1,18 +1,58 @@
 #include "Logger.h"
 
 #include <algorithm> //to get for_each()
+#include <cstdio>    //snprintf
 #include <fstream>   //ofstream type
+#include <sstream>
 #include <unistd.h>  //to get sleep()
 
+//! One entry of the per-thread Tic stack
+struct TicFrame
+{
+    int64_t start;
+    double  flop;  //flops of the nested events
+};
 
-std::stack<double> Logger::TicStack;
-std::stack<double> Logger::FlopStack;
-std::map<std::string, LogEvent> Logger::PrflMap;
-std::string Logger::log_file;
+//! Accumulated data of one interned key on one thread
+struct ProfileAcc
+{
+    unsigned long int num_calls;
+    int64_t           time;
+    double            flop;
+};
 
-// //The variables for the timing macro.
-// struct timeval  tt;
-// struct timezone ttz;
+//! A recorded event, kept only when tracing is on
+struct TraceEvent
+{
+    int     key;
+    int64_t start;
+    int64_t dur;
+    double  flop;
+};
+
+struct ThreadProfile
+{
+    int                     id;
+    std::vector<TicFrame>   tics;
+    std::vector<ProfileAcc> acc;
+    std::vector<TraceEvent> trace;
+    unsigned long int       dropped;
+    double                  total_flop;
+};
+
+//! Cap on the trace events kept per thread (about 32MB)
+static const size_t MAX_TRACE_EVENTS(1<<20);
+
+//! The time origin of the trace time stamps
+static int64_t prfl_epoch(Logger::NowNs());
+
+static ThreadProfile *prfl_thread(NULL);
+#pragma omp threadprivate(prfl_thread)
+
+std::vector<std::string> Logger::PrflKeys;
+std::vector<ThreadProfile*> Logger::PrflThreads;
+bool Logger::trace_on(false);
+std::string Logger::log_file;
 
 template<typename T>
 void PrintLogEvent(const std::pair<T, LogEvent> &ev)
@@ -21,141 +61,346 @@ void PrintLogEvent(const std::pair<T, LogEvent> &ev)
     std::string printstr = ev.second.fun_name;
     printstr.resize(print_length,' ');
     printstr= "  " + printstr +
-        "%-8u \t %-4.3e \t %-4.3e \t %-4.3e \n";
+        "%-8lu \t %-4.3e \t %-4.3e \t %-4.3e \t %-4.3e \t %-4.3e \n";
 
-    printf(printstr.c_str(), ev.second.num_calls, ev.second.time,
-        ev.second.flop/1e9, ev.second.flop_rate);
+    printf(printstr.c_str(), ev.second.num_calls, ev.second.time_min,
+        ev.second.time_avg, ev.second.time, ev.second.flop/1e9,
+        ev.second.flop_rate);
 }
 
 double Logger::Now()
 {
-    return(GETSECONDS());
+    return(NowNs()*1e-9);
 }
 
-double Logger::Tic()
+int64_t Logger::NowNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((int64_t) ts.tv_sec*1000000000 + ts.tv_nsec);
+}
+
+ThreadProfile* Logger::Thread()
 {
-    double now = Logger::Now();
-    Logger::TicStack.push(now);
+    if (prfl_thread == NULL){
+        prfl_thread = new ThreadProfile;
+        prfl_thread->dropped    = 0;
+        prfl_thread->total_flop = 0;
 
-    if ( Logger::FlopStack.empty() )
-        Logger::FlopStack.push(0); //in order to have the total number of flops
+#pragma omp critical (loggerThread)
+        {
+            prfl_thread->id = PrflThreads.size();
+            PrflThreads.push_back(prfl_thread);
+        }
+    }
+    return(prfl_thread);
+}
+
+double Logger::Tic()
+{
+    TicFrame fr;
+    fr.start = NowNs();
+    fr.flop  = 0;
+    Thread()->tics.push_back(fr);
 
-    Logger::FlopStack.push(0);
-    return(now);
+    return(fr.start*1e-9);
 }
 
 double Logger::Toc()
 {
+    ThreadProfile *th(Thread());
     double toc;
-    if(Logger::TicStack.empty())
+    if(th->tics.empty())
         CERR_LOC("There is no matching Logger::Tic() call.","", toc=0);
     else
     {
-        toc = Logger::Now();
-        toc -= Logger::TicStack.top();
-        Logger::TicStack.pop();
+        const TicFrame &fr(th->tics.back());
+        toc = (NowNs() - fr.start)*1e-9;
+
+        //the flops of a bare Tic/Toc pair still belong to the parent
+        if (th->tics.size() > 1)
+            th->tics[th->tics.size()-2].flop += fr.flop;
+        else
+            th->total_flop += fr.flop;
+        th->tics.pop_back();
     }
     return(toc);
 }
 
-void Logger::Record(std::string fun_name, std::string prefix,
-    double time, double flop)
+int Logger::Intern(const char *fun_name, const char *prefix)
 {
-#pragma omp critical (loggerRecord)
+    std::string name(std::string(prefix)+fun_name);
+    int key;
+
+#pragma omp critical (loggerIntern)
     {
-        fun_name = prefix+fun_name;
-        flop += Logger::FlopStack.top();
-        Logger::FlopStack.pop();
-        if ( !Logger::FlopStack.empty() )
-            Logger::FlopStack.top() += flop;
+        key = std::find(PrflKeys.begin(), PrflKeys.end(), name) - PrflKeys.begin();
+        if ( key == (int) PrflKeys.size() )
+            PrflKeys.push_back(name);
+    }
+    return(key);
+}
 
-        if(Logger::PrflMap.count(fun_name))
-        {
-            Logger::PrflMap[fun_name].num_calls++;
-            Logger::PrflMap[fun_name].time +=time;
-            Logger::PrflMap[fun_name].flop +=flop;
-        }
-        else
-        {
-            LogEvent ev;
-            ev.fun_name  = fun_name;
-            ev.num_calls = 1;
-            ev.time      = time;
-            ev.flop      = flop;
-            Logger::PrflMap.insert(make_pair(fun_name, ev));
-        }
+void Logger::Record(int key, double flop)
+{
+    int64_t now(NowNs());
+    ThreadProfile *th(Thread());
+    if(th->tics.empty()){
+        CERR_LOC("There is no matching Logger::Tic() call for "
+            <<PrflKeys[key],"",sleep(0));
+        return;
+    }
+
+    TicFrame fr(th->tics.back());
+    th->tics.pop_back();
+    flop += fr.flop;
+    if (th->tics.empty())
+        th->total_flop += flop;
+    else
+        th->tics.back().flop += flop;
+
+    if (key >= (int) th->acc.size()){
+        ProfileAcc z = {0, 0, 0};
+        th->acc.resize(key+1, z);
+    }
+    ProfileAcc &acc(th->acc[key]);
+    ++acc.num_calls;
+    acc.time += now - fr.start;
+    acc.flop += flop;
+
+    if (trace_on){
+        if (th->trace.size() < MAX_TRACE_EVENTS){
+            TraceEvent ev = {key, fr.start, now - fr.start, flop};
+            th->trace.push_back(ev);
+        } else
+            ++th->dropped;
     }
 }
 
 void Logger::PurgeProfileHistory()
 {
-    Logger::PrflMap.clear();
-
-    while ( !Logger::TicStack.empty() )
-        Logger::TicStack.pop();
+    for (size_t i=0; i<PrflThreads.size(); ++i){
+        PrflThreads[i]->tics.clear();
+        PrflThreads[i]->acc.clear();
+        PrflThreads[i]->trace.clear();
+        PrflThreads[i]->dropped    = 0;
+        PrflThreads[i]->total_flop = 0;
+    }
+}
 
-    while ( !Logger::FlopStack.empty() )
-        Logger::FlopStack.pop();
+void Logger::SetTrace(bool enable)
+{
+    trace_on = enable;
 }
 
 void Logger::Report(enum ReportFormat rf)
 {
+    int rank(0), np(1);
+#ifdef HAS_MPI
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+    MPI_Comm_size(VES3D_COMM_WORLD, &np);
+#endif
+
+    //merge the threads of this rank
+    std::map<std::string, ProfileAcc> local;
+    bool unbalanced(false);
+    for (size_t i=0; i<PrflThreads.size(); ++i){
+        const ThreadProfile &th(*PrflThreads[i]);
+        unbalanced |= !th.tics.empty();
+        for (size_t key=0; key<th.acc.size(); ++key){
+            if (th.acc[key].num_calls == 0) continue;
+            ProfileAcc &a(local[PrflKeys[key]]);
+            a.num_calls += th.acc[key].num_calls;
+            a.time      += th.acc[key].time;
+            a.flop      += th.acc[key].flop;
+        }
+    }
+
+    //the union of names over the ranks, in the order of rank 0
+    std::vector<std::string> names;
+    for (std::map<std::string, ProfileAcc>::iterator it = local.begin();
+         it != local.end(); ++it)
+        names.push_back(it->first);
+
+#ifdef HAS_MPI
+    if (np > 1){
+        std::string packed;
+        for (size_t i=0; i<names.size(); ++i)
+            packed += names[i] + '\n';
+
+        int len(packed.size());
+        std::vector<int> lens(np), displ(np+1, 0);
+        MPI_Gather(&len, 1, MPI_INT, &lens[0], 1, MPI_INT, 0, VES3D_COMM_WORLD);
+        for (int i=0; i<np; ++i) displ[i+1] = displ[i] + lens[i];
+
+        std::vector<char> all(displ[np]+1, 0);
+        MPI_Gatherv(const_cast<char*>(packed.data()), len, MPI_CHAR, &all[0],
+            &lens[0], &displ[0], MPI_CHAR, 0, VES3D_COMM_WORLD);
+
+        std::string merged;
+        if (rank == 0){
+            std::map<std::string, int> uniq;
+            std::istringstream is(std::string(all.begin(), all.end()-1));
+            std::string line;
+            while (std::getline(is, line)) uniq[line];
+            for (std::map<std::string, int>::iterator it = uniq.begin();
+                 it != uniq.end(); ++it)
+                merged += it->first + '\n';
+        }
+
+        len = merged.size();
+        MPI_Bcast(&len, 1, MPI_INT, 0, VES3D_COMM_WORLD);
+        std::vector<char> buf(len+1, 0);
+        if (rank == 0) std::copy(merged.begin(), merged.end(), buf.begin());
+        MPI_Bcast(&buf[0], len, MPI_CHAR, 0, VES3D_COMM_WORLD);
+
+        names.clear();
+        std::istringstream is(std::string(buf.begin(), buf.end()-1));
+        std::string line;
+        while (std::getline(is, line)) names.push_back(line);
+    }
+#endif
+
+    size_t n(names.size());
+    std::vector<double> calls(n, 0), time(n, 0), flop(n, 0);
+    for (size_t i=0; i<n; ++i){
+        std::map<std::string, ProfileAcc>::iterator it(local.find(names[i]));
+        if (it == local.end()) continue;
+        calls[i] = it->second.num_calls;
+        time[i]  = it->second.time*1e-9;
+        flop[i]  = it->second.flop;
+    }
+
+    std::vector<double> calls_sum(calls), time_min(time), time_sum(time),
+        time_max(time), flop_sum(flop);
+#ifdef HAS_MPI
+    if (np > 1 && n > 0){
+        MPI_Reduce(&calls[0], &calls_sum[0], n, MPI_DOUBLE, MPI_SUM, 0, VES3D_COMM_WORLD);
+        MPI_Reduce(&time[0] , &time_min[0] , n, MPI_DOUBLE, MPI_MIN, 0, VES3D_COMM_WORLD);
+        MPI_Reduce(&time[0] , &time_sum[0] , n, MPI_DOUBLE, MPI_SUM, 0, VES3D_COMM_WORLD);
+        MPI_Reduce(&time[0] , &time_max[0] , n, MPI_DOUBLE, MPI_MAX, 0, VES3D_COMM_WORLD);
+        MPI_Reduce(&flop[0] , &flop_sum[0] , n, MPI_DOUBLE, MPI_SUM, 0, VES3D_COMM_WORLD);
+    }
+#endif
+
+    if (unbalanced)
+        CERR_LOC("There may be unbalanced Tic() and Toc() calls.","",sleep(0));
+
+    if (rank != 0) return;
+
+    std::map<std::string, LogEvent> PrflMap;
+    for (size_t i=0; i<n; ++i){
+        LogEvent ev;
+        ev.fun_name  = names[i];
+        ev.num_calls = (unsigned long int) calls_sum[i];
+        ev.time      = time_max[i];
+        ev.time_min  = time_min[i];
+        ev.time_avg  = time_sum[i]/np;
+        ev.flop      = flop_sum[i];
+        ev.flop_rate = (ev.time > 0) ? ev.flop/ev.time/1e9 : 0;
+        PrflMap.insert(std::make_pair(ev.fun_name, ev));
+    }
+
     std::multimap<double, LogEvent> ReportMap;
     std::map<std::string, LogEvent>::iterator it;
-
-    for (it = Logger::PrflMap.begin();it != Logger::PrflMap.end(); ++it)
-        it->second.flop_rate = it->second.flop/it->second.time/1e9;
+    std::string head;
 
     switch ( rf )
     {
         case SortFunName:
-            COUT("=====================================================================================\n"
-                <<" >Function name              Calls       Total time      GFlop           GFlop/sec\n"
-                <<"------------------------------------------------------------------------------------");
-            for_each(PrflMap.begin(), PrflMap.end(), &PrintLogEvent<std::string>);
+            head = " >Function name              Calls       Min time        Avg time        Max time        GFlop           GFlop/sec";
             break;
 
         case SortNumCalls:
-            COUT("=====================================================================================\n"
-                <<"  Function name             >Calls       Total time      GFlop           GFlop/sec\n"
-                <<"------------------------------------------------------------------------------------");
-            for (it = Logger::PrflMap.begin();it != Logger::PrflMap.end(); ++it)
+            head = "  Function name             >Calls       Min time        Avg time        Max time        GFlop           GFlop/sec";
+            for (it = PrflMap.begin();it != PrflMap.end(); ++it)
                 ReportMap.insert(std::make_pair(it->second.num_calls, it->second));
-            for_each(ReportMap.begin(), ReportMap.end(), &PrintLogEvent<double>);
             break;
 
         case SortTime:
-            COUT("=====================================================================================\n"
-                <<"  Function name              Calls      >Total time      GFlop           GFlop/sec\n"
-                <<"------------------------------------------------------------------------------------");
-            for (it = Logger::PrflMap.begin();it != Logger::PrflMap.end(); ++it)
+            head = "  Function name              Calls       Min time        Avg time       >Max time        GFlop           GFlop/sec";
+            for (it = PrflMap.begin();it != PrflMap.end(); ++it)
                 ReportMap.insert(std::make_pair(it->second.time, it->second));
-            for_each(ReportMap.begin(), ReportMap.end(), &PrintLogEvent<double>);
             break;
 
         case SortFlop:
-            COUT("=====================================================================================\n"
-                <<"  Function name              Calls       Total time     >GFlop           GFlop/sec\n"
-                <<"------------------------------------------------------------------------------------");
-            for (it = Logger::PrflMap.begin();it != Logger::PrflMap.end(); ++it)
+            head = "  Function name              Calls       Min time        Avg time        Max time       >GFlop           GFlop/sec";
+            for (it = PrflMap.begin();it != PrflMap.end(); ++it)
                 ReportMap.insert(std::make_pair(it->second.flop, it->second));
-            for_each(ReportMap.begin(), ReportMap.end(), &PrintLogEvent<double>);
             break;
 
         case SortFlopRate:
-            COUT("=====================================================================================\n"
-                <<"  Function name              Calls       Total time      GFlop          >GFlop/sec\n"
-                <<"------------------------------------------------------------------------------------");
-            for (it = Logger::PrflMap.begin();it != Logger::PrflMap.end(); ++it)
+            head = "  Function name              Calls       Min time        Avg time        Max time        GFlop          >GFlop/sec";
+            for (it = PrflMap.begin();it != PrflMap.end(); ++it)
                 ReportMap.insert(std::make_pair(it->second.flop_rate, it->second));
-            for_each(ReportMap.begin(), ReportMap.end(), &PrintLogEvent<double>);
             break;
+    }
+
+    std::string rule(head.size()+2, '=');
+    COUT(rule<<"\n"<<head<<"\n"<<std::string(head.size()+2, '-')
+        <<"\n  ("<<np<<" ranks, "<<PrflThreads.size()<<" threads; times in seconds)");
+    if ( rf == SortFunName )
+        for_each(PrflMap.begin(), PrflMap.end(), &PrintLogEvent<std::string>);
+    else
+        for_each(ReportMap.begin(), ReportMap.end(), &PrintLogEvent<double>);
+    fflush(stdout);
+    COUT(rule);
+}
 
+static std::string JsonEscape(const std::string &str)
+{
+    std::string out;
+    for (size_t i=0; i<str.size(); ++i){
+        if ( str[i] == '"' || str[i] == '\\' ) out += '\\';
+        out += str[i];
     }
-    COUT("=====================================================================================");
+    return(out);
+}
 
-    if(TicStack.size())
-        CERR_LOC("There may be unbalanced Tic() and Toc() calls.","",sleep(0));
+bool Logger::WriteTrace(std::string file_name)
+{
+    int rank(0), np(1);
+#ifdef HAS_MPI
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+    MPI_Comm_size(VES3D_COMM_WORLD, &np);
+#endif
+
+    if (np > 1){
+        std::stringstream ss;
+        ss<<file_name<<"."<<rank;
+        file_name = ss.str();
+    }
+
+    std::ofstream out(file_name.c_str());
+    if(!out){
+        CERR("Could not open the trace file '"<<file_name<<"'");
+        return(false);
+    }
+
+    unsigned long int dropped(0);
+    char buf[128];
+    out<<"{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first(true);
+    for (size_t i=0; i<PrflThreads.size(); ++i){
+        const ThreadProfile &th(*PrflThreads[i]);
+        dropped += th.dropped;
+        for (size_t j=0; j<th.trace.size(); ++j){
+            const TraceEvent &ev(th.trace[j]);
+            snprintf(buf, sizeof(buf),
+                "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,"
+                "\"args\":{\"flop\":%g}}",
+                (ev.start-prfl_epoch)*1e-3, ev.dur*1e-3, rank, th.id, ev.flop);
+            out<<(first ? "\n" : ",\n")<<"{\"name\":\""
+               <<JsonEscape(PrflKeys[ev.key])<<buf;
+            first = false;
+        }
+    }
+    out<<"\n]}"<<std::endl;
+
+    if (dropped)
+        WARN("The trace buffers were full, "<<dropped<<" events are not in "<<file_name);
+
+    return(out.good());
 }
 
 void Logger::SetLogFile(std::string file_name)
@@ -207,10 +452,11 @@ void Logger::Log(std::ostream &event)
 
 double Logger::GetFlops()
 {
-    if ( !Logger::FlopStack.empty() )
-        return(Logger::FlopStack.top());
+    ThreadProfile *th(Thread());
+    if ( !th->tics.empty() )
+        return(th->tics.back().flop);
     else
-        return(0);
+        return(th->total_flop);
 }
 
 std::ostream& alert(std::ostream& os)
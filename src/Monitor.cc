@@ -2,6 +2,18 @@ template<typename EvolveSurface>
 MonitorBase<EvolveSurface>::~MonitorBase()
 {}
 
+template<typename EvolveSurface>
+Error_t MonitorBase<EvolveSurface>::flush()
+{
+    return ErrorEvent::Success;
+}
+
+template<typename EvolveSurface>
+void MonitorBase<EvolveSurface>::vesicleData(std::vector<Sca_t*> &data)
+{
+    data.clear();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 ///@todo move the buffer size to the parameters
 template<typename EvolveSurface>
@@ -12,12 +24,32 @@ Monitor<EvolveSurface>::Monitor(const Parameters<value_type> *params) :
     V0_(-1),
     last_checkpoint_(-1),
     time_idx_(-1),
-    params_(params)
+    params_(params),
+    writer_(params->async_io ? new AsyncWriter(8) : NULL) // room for two snapshots with VTK
 {}
 
 template<typename EvolveSurface>
 Monitor<EvolveSurface>::~Monitor()
-{}
+{
+    delete writer_;
+}
+
+template<typename EvolveSurface>
+Error_t Monitor<EvolveSurface>::flush()
+{
+    if (writer_==NULL) return ErrorEvent::Success;
+    INFO("Waiting for "<<writer_->pending()<<" pending file(s)");
+    return writer_->flush();
+}
+
+template<typename EvolveSurface>
+void Monitor<EvolveSurface>::vesicleData(std::vector<typename EvolveSurface::Sca_t*> &data)
+{
+    data.clear();
+    if (A0_ < 0) return;
+    data.push_back(&area0_);
+    data.push_back(&vol0_);
+}
 
 template<typename EvolveSurface>
 Error_t Monitor<EvolveSurface>::operator()(const EvolveSurface *state,
@@ -28,8 +60,7 @@ Error_t Monitor<EvolveSurface>::operator()(const EvolveSurface *state,
 
     area_new.replicate(state->S_->getPosition());
     vol_new .replicate(state->S_->getPosition());
-    state->S_->area  (area_new);
-    state->S_->volume( vol_new);
+    state->S_->areaVolume(area_new, vol_new);
 
     if(A0_ < 0){ // Initialize area0_, vol0_
         area0_.replicate(state->S_->getPosition());
@@ -68,13 +99,31 @@ Error_t Monitor<EvolveSurface>::operator()(const EvolveSurface *state,
 
             //This order of packing is used when loading checkpoints
             //in ves3d_simulation file
-            std::stringstream ss;
-            ss<<std::scientific<<std::setprecision(16);
-            params_->pack(ss, Streamable::ASCII);
-            state->pack(ss, Streamable::ASCII);
+            if (params_->checkpoint_format==Streamable::BIN){
+                //parameters are common to all processes and go to
+                //the preamble, each process writes its own state block
+                std::stringstream pre, blk;
+                pre<<std::scientific<<std::setprecision(16);
+                blk<<std::scientific<<std::setprecision(16);
+                params_->pack(pre, Streamable::BIN);
+                state->pack(blk, Streamable::BIN);
 
-            INFO("Writing data to file "<<fname);
-            IO_.DumpFile(fname.c_str(), ss);
+                INFO("Writing binary data to file "<<fname);
+                CHK(DataIO::DumpBlocks(fname.c_str(), pre.str(), blk.str(), N_ves, writer_));
+            } else {
+                std::stringstream ss;
+                ss<<std::scientific<<std::setprecision(16);
+                params_->pack(ss, Streamable::ASCII);
+                state->pack(ss, Streamable::ASCII);
+
+                INFO("Writing data to file "<<fname);
+                if (writer_){
+                    std::string data(ss.str());
+                    CHK(writer_->push(fname, data));
+                } else {
+                    IO_.DumpFile(fname.c_str(), ss);
+                }
+            }
             ++last_checkpoint_;
 
 #if HAVE_PVFMM
@@ -82,7 +131,7 @@ Error_t Monitor<EvolveSurface>::operator()(const EvolveSurface *state,
                 std::string vtkfbase(params_->write_vtk);
                 vtkfbase += suffix;
                 INFO("Writing VTK file");
-                WriteVTK(*state->S_,vtkfbase.c_str(), MPI_COMM_WORLD, NULL, -1, params_->periodic_length);
+                CHK(WriteVTK(*state->S_,vtkfbase.c_str(), MPI_COMM_WORLD, NULL, -1, params_->periodic_length, writer_));
             }
 #endif // HAVE_PVFMM
         }
@@ -20,6 +20,9 @@ NearSingular<Real_t>::NearSingular(Real_t box_size, Real_t repul_dist, MPI_Comm
   qforce_double=NULL;
   force_double=NULL;
   S_vel=NULL;
+  near_skin_=0;
+  setup_cnt_=0;
+  setup_reuse_cnt_=0;
 
   update_setup =update_setup  | NearSingular::UpdateSrcCoord;
   update_setup =update_setup  | NearSingular::UpdateTrgCoord;
@@ -77,20 +80,245 @@ void NearSingular<Real_t>::SetTrgCoord(Real_t* trg_coord, size_t N, bool trg_is_
   T.ReInit(N*COORD_DIM,trg_coord);
 }
 
+template<typename Real_t>
+void NearSingular<Real_t>::SetNearSkin(Real_t skin){
+  assert(skin>=0);
+  near_skin_=skin;
+  coord_setup.src_coord0.ReInit(0);
+  coord_setup.trg_coord0.ReInit(0);
+}
+
+template<typename Real_t>
+Real_t NearSingular<Real_t>::SetupReuseRatio() const{
+  return (setup_cnt_?setup_reuse_cnt_/(Real_t)setup_cnt_:0);
+}
+
+template<typename Real_t>
+double NearSingular<Real_t>::ThreadImbalance(const char* name) const{
+  typename std::map<std::string, std::pair<double,double> >::const_iterator it=thread_load_.find(name);
+  if(it==thread_load_.end() || it->second.second<=0) return 0;
+  return it->second.first/it->second.second;
+}
+
+template<typename Real_t>
+void NearSingular<Real_t>::PairPartition(size_t tid, size_t omp_p, size_t& a, size_t& b, size_t& ves) const{
+  const pvfmm::Vector<size_t>& trg_dsp=coord_setup.near_trg_dsp;
+  size_t N_pair=coord_setup.near_trg_coord.Dim()/COORD_DIM;
+  a=((tid+0)*N_pair)/omp_p;
+  b=((tid+1)*N_pair)/omp_p;
+  ves=0;
+  if(a<b) ves=std::upper_bound(&trg_dsp[0], &trg_dsp[0]+trg_dsp.Dim(), a)-&trg_dsp[0]-1;
+}
+
+template<typename Real_t>
+void NearSingular<Real_t>::ThreadLoad(const char* name, const pvfmm::Vector<double>& t_thread) const{
+  double t_max=0, t_sum=0;
+  for(size_t tid=0;tid<t_thread.Dim();tid++){
+    t_max=std::max(t_max,t_thread[tid]);
+    t_sum+=t_thread[tid];
+  }
+  if(t_sum<=0) return;
+  std::pair<double,double>& load=thread_load_[name];
+  load.first +=t_max;
+  load.second+=t_sum/t_thread.Dim();
+  COUTDEBUG(name<<" thread load: max="<<t_max<<"s, mean="<<t_sum/t_thread.Dim()<<"s, imbalance="<<t_max*t_thread.Dim()/t_sum);
+}
+
 template<typename Real_t>
 void NearSingular<Real_t>::SetupCoordData(){
   assert(S);
-  Real_t near=2.0/sqrt((Real_t)sh_order_); // TODO: some function of sh_order and accuracy
   if(!(update_setup & (NearSingular::UpdateSrcCoord | NearSingular::UpdateTrgCoord))) return;
   update_setup=update_setup & ~(NearSingular::UpdateSrcCoord | NearSingular::UpdateTrgCoord);
 
+  pvfmm::Profile::Tic("NearSetup",&comm,true);
+  bool prof_state=pvfmm::Profile::Enable(false);
+  setup_cnt_++;
+  if(near_skin_>0 && ReuseNearPair()){
+    setup_reuse_cnt_++;
+  }else{
+    SetupNearPair();
+    if(near_skin_>0){ // Save coordinates for the next setup
+      coord_setup.src_coord0=*S;
+      coord_setup.trg_coord0=T;
+    }
+  }
+  SetupProjection();
+  if(near_skin_>0) INFO("Near setup reused for "<<setup_reuse_cnt_<<" of "<<setup_cnt_<<" setups ("<<100*SetupReuseRatio()<<"% skipped)");
+  pvfmm::Profile::Enable(prof_state);
+  pvfmm::Profile::Toc();
+}
+
+template<typename Real_t>
+Real_t NearSingular<Real_t>::MaxVesicleRadius(){
+  size_t omp_p=omp_get_max_threads();
+  size_t M_ves = VES_STRIDE;                 // Points per vesicle
+  size_t N_ves = S->Dim()/(M_ves*COORD_DIM); // Number of vesicles
+
+  std::vector<Real_t> r2_ves_(omp_p);
+  #pragma omp parallel for
+  for(size_t tid=0;tid<omp_p;tid++){
+    size_t a=((tid+0)*N_ves)/omp_p;
+    size_t b=((tid+1)*N_ves)/omp_p;
+
+    Real_t r2_ves=0;
+    Real_t one_over_M=1.0/M_ves;
+    for(size_t i=a;i<b;i++){ // compute r2_ves
+      const Real_t* Si=&S[0][i*M_ves*COORD_DIM];
+      Real_t center_coord[COORD_DIM]={0,0,0};
+      for(size_t j=0;j<M_ves;j++){
+        center_coord[0]+=Si[j*COORD_DIM+0];
+        center_coord[1]+=Si[j*COORD_DIM+1];
+        center_coord[2]+=Si[j*COORD_DIM+2];
+      }
+      center_coord[0]*=one_over_M;
+      center_coord[1]*=one_over_M;
+      center_coord[2]*=one_over_M;
+      for(size_t j=0;j<M_ves;j++){
+        Real_t dx=(Si[j*COORD_DIM+0]-center_coord[0]);
+        Real_t dy=(Si[j*COORD_DIM+1]-center_coord[1]);
+        Real_t dz=(Si[j*COORD_DIM+2]-center_coord[2]);
+        Real_t r2=dx*dx+dy*dy+dz*dz;
+        r2_ves=std::max(r2_ves,r2);
+      }
+    }
+    r2_ves_[tid]=r2_ves;
+  }
+
+  // Determine r_ves (global max)
+  double r_ves_loc=0, r_ves_glb=0;
+  for(size_t tid=0;tid<omp_p;tid++){
+    r_ves_loc=std::max(r2_ves_[tid], r_ves_loc);
+  }
+  r_ves_loc=sqrt(r_ves_loc);
+  MPI_Allreduce(&r_ves_loc, &r_ves_glb, 1, MPI_DOUBLE, MPI_MAX, comm);
+  return r_ves_glb;
+}
+
+template<typename Real_t>
+bool NearSingular<Real_t>::ReuseNearPair(){
+  PVFMMVec_t& S0=coord_setup.src_coord0;
+  PVFMMVec_t& T0=coord_setup.trg_coord0;
+  size_t omp_p=omp_get_max_threads();
+
+  Real_t max_disp=0;
+  bool same_size=true;
+  { // Max displacement of source and target points since the last full setup
+    double disp_loc[2]={0,0}, disp_glb[2]={0,0}; // {displacement, size changed}
+    if(S0.Dim()!=S->Dim() || T0.Dim()!=T.Dim()){
+      disp_loc[1]=1;
+    }else{
+      std::vector<double> disp_(omp_p,0);
+      #pragma omp parallel for
+      for(size_t tid=0;tid<omp_p;tid++){
+        Real_t r2_max=0;
+        size_t a=((tid+0)*S->Dim()/COORD_DIM)/omp_p;
+        size_t b=((tid+1)*S->Dim()/COORD_DIM)/omp_p;
+        for(size_t i=a;i<b;i++){
+          Real_t dx=S[0][i*COORD_DIM+0]-S0[i*COORD_DIM+0];
+          Real_t dy=S[0][i*COORD_DIM+1]-S0[i*COORD_DIM+1];
+          Real_t dz=S[0][i*COORD_DIM+2]-S0[i*COORD_DIM+2];
+          r2_max=std::max(r2_max,dx*dx+dy*dy+dz*dz);
+        }
+        a=((tid+0)*T.Dim()/COORD_DIM)/omp_p;
+        b=((tid+1)*T.Dim()/COORD_DIM)/omp_p;
+        for(size_t i=a;i<b;i++){
+          Real_t dx=T[i*COORD_DIM+0]-T0[i*COORD_DIM+0];
+          Real_t dy=T[i*COORD_DIM+1]-T0[i*COORD_DIM+1];
+          Real_t dz=T[i*COORD_DIM+2]-T0[i*COORD_DIM+2];
+          r2_max=std::max(r2_max,dx*dx+dy*dy+dz*dz);
+        }
+        disp_[tid]=r2_max;
+      }
+      for(size_t tid=0;tid<omp_p;tid++) disp_loc[0]=std::max(disp_loc[0],disp_[tid]);
+      disp_loc[0]=sqrt(disp_loc[0]);
+    }
+    MPI_Allreduce(disp_loc, disp_glb, 2, MPI_DOUBLE, MPI_MAX, comm);
+    max_disp=disp_glb[0];
+    same_size=(disp_glb[1]==0);
+  }
+
+  // Every pair within r_near now was within r_near+2*max_disp at the
+  // last full setup, so the old pair list (built with r_list) has it.
+  Real_t near=2.0/sqrt((Real_t)sh_order_);
+  Real_t r_near=MaxVesicleRadius()*near;
+  if(!same_size || r_near+2*max_disp>coord_setup.r_list) return false;
+  coord_setup.r_near=r_near;
+
+  PVFMMVec_t&           trg_coord=coord_setup.near_trg_coord;
+  pvfmm::Vector<size_t>&  trg_cnt=coord_setup.  near_trg_cnt;
+  pvfmm::Vector<size_t>&  trg_dsp=coord_setup.  near_trg_dsp;
+  { // Gather the new coordinates of the near targets
+    pvfmm::Vector<size_t>& trg_pt_id=coord_setup.near_trg_pt_id;
+    size_t trg_id_offset;
+    { // Get trg_id_offset
+      long long disp=0;
+      long long size=T.Dim()/COORD_DIM;
+      MPI_Scan(&size, &disp, 1, MPI_LONG_LONG, MPI_SUM, comm);
+      trg_id_offset=disp-size;
+    }
+
+    PVFMMVec_t coord(trg_pt_id.Dim()*COORD_DIM);
+    #pragma omp parallel for
+    for(size_t i=0;i<trg_pt_id.Dim();i++){
+      size_t pt_id=trg_pt_id[i]-trg_id_offset;
+      coord[i*COORD_DIM+0]=T[pt_id*COORD_DIM+0];
+      coord[i*COORD_DIM+1]=T[pt_id*COORD_DIM+1];
+      coord[i*COORD_DIM+2]=T[pt_id*COORD_DIM+2];
+    }
+    pvfmm::par::ScatterReverse(coord, coord_setup.near_trg_scatter, comm, trg_coord.Dim()/COORD_DIM);
+    assert(coord.Dim()==trg_coord.Dim());
+    trg_coord.Swap(coord);
+  }
+
+  { // Update the closest vesicle point (and periodic image) of each pair
+    size_t M_ves = VES_STRIDE;                 // Points per vesicle
+    size_t N_ves = S->Dim()/(M_ves*COORD_DIM); // Number of vesicles
+    #pragma omp parallel for
+    for(size_t tid=0;tid<omp_p;tid++){
+      size_t a, b, i;
+      PairPartition(tid, omp_p, a, b, i);
+      for(;a<b;i++){ // loop over vesicles with pairs in [a,b)
+        size_t dsp=a, cnt=std::min(b,trg_dsp[i]+trg_cnt[i])-a; a+=cnt;
+        const Real_t* Si=&S[0][i*M_ves*COORD_DIM];
+        for(size_t j=0;j<cnt;j++){ // loop over near tagets
+          size_t trg_idx=dsp+j;
+          Real_t* t=&trg_coord[trg_idx*COORD_DIM];
+          if(box_size_>0){ // periodic translation
+            size_t k_=coord_setup.near_ves_pt_id[trg_idx]-M_ves*i;
+            for(size_t k=0;k<COORD_DIM;k++){
+              while(t[k]-Si[k_*COORD_DIM+k]> box_size_*0.5) t[k]-=box_size_;
+              while(t[k]-Si[k_*COORD_DIM+k]<-box_size_*0.5) t[k]+=box_size_;
+            }
+          }
+          size_t k_min=0;
+          Real_t r2_min=-1;
+          for(size_t s=0;s<M_ves;s++){
+            Real_t dx=Si[s*COORD_DIM+0]-t[0];
+            Real_t dy=Si[s*COORD_DIM+1]-t[1];
+            Real_t dz=Si[s*COORD_DIM+2]-t[2];
+            Real_t r2=dx*dx+dy*dy+dz*dz;
+            if(r2_min<0 || r2<r2_min){
+              r2_min=r2;
+              k_min=s;
+            }
+          }
+          coord_setup.near_ves_pt_id[trg_idx]=M_ves*i+k_min;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+template<typename Real_t>
+void NearSingular<Real_t>::SetupNearPair(){
+  Real_t near=2.0/sqrt((Real_t)sh_order_); // TODO: some function of sh_order and accuracy
+
   int np, rank;
   MPI_Comm_size(comm,&np);
   MPI_Comm_rank(comm,&rank);
   size_t omp_p=omp_get_max_threads();
 
-  pvfmm::Profile::Tic("NearSetup",&comm,true);
-  bool prof_state=pvfmm::Profile::Enable(false);
   struct{
     pvfmm::Vector<pvfmm::MortonId> mid; // MortonId of leaf nodes
     pvfmm::Vector<size_t> pt_cnt;       // Point count
@@ -113,52 +341,12 @@ void NearSingular<Real_t>::SetupCoordData(){
       pvfmm::Profile::Tic("PtData",&comm,true);
       Real_t* bbox=coord_setup.bbox;
       Real_t& r_near=coord_setup.r_near;
+      Real_t& r_list=coord_setup.r_list;
 
-      Real_t r_ves=0;
-      { // Determine r_ves
-        std::vector<Real_t> r2_ves_(omp_p);
-        #pragma omp parallel for
-        for(size_t tid=0;tid<omp_p;tid++){
-          size_t a=((tid+0)*N_ves)/omp_p;
-          size_t b=((tid+1)*N_ves)/omp_p;
-
-          Real_t r2_ves=0;
-          Real_t one_over_M=1.0/M_ves;
-          for(size_t i=a;i<b;i++){ // compute r2_ves
-            const Real_t* Si=&S[0][i*M_ves*COORD_DIM];
-            Real_t center_coord[COORD_DIM]={0,0,0};
-            for(size_t j=0;j<M_ves;j++){
-              center_coord[0]+=Si[j*COORD_DIM+0];
-              center_coord[1]+=Si[j*COORD_DIM+1];
-              center_coord[2]+=Si[j*COORD_DIM+2];
-            }
-            center_coord[0]*=one_over_M;
-            center_coord[1]*=one_over_M;
-            center_coord[2]*=one_over_M;
-            for(size_t j=0;j<M_ves;j++){
-              Real_t dx=(Si[j*COORD_DIM+0]-center_coord[0]);
-              Real_t dy=(Si[j*COORD_DIM+1]-center_coord[1]);
-              Real_t dz=(Si[j*COORD_DIM+2]-center_coord[2]);
-              Real_t r2=dx*dx+dy*dy+dz*dz;
-              r2_ves=std::max(r2_ves,r2);
-            }
-          }
-          r2_ves_[tid]=r2_ves;
-        }
-
-        { // Determine r_ves (global max)
-          double r_ves_loc=0, r_ves_glb=0;
-          for(size_t tid=0;tid<omp_p;tid++){
-            r_ves_loc=std::max(r2_ves_[tid], r_ves_loc);
-          }
-          r_ves_loc=sqrt(r_ves_loc);
-          MPI_Allreduce(&r_ves_loc, &r_ves_glb, 1, MPI_DOUBLE, MPI_MAX, comm);
-          r_ves=r_ves_glb;
-        }
-      }
-
+      Real_t r_ves=MaxVesicleRadius();
       r_near=r_ves*near; // r_near is some function of r_ves.
-      if(box_size_>0 && 2*r_near+r_ves>box_size_){ // domain too small; abort
+      r_list=r_near*(1+near_skin_); // pairs are searched within r_list
+      if(box_size_>0 && 2*r_list+r_ves>box_size_){ // domain too small; abort
         COUTDEBUG("Domain too small for vesicle size. Multiple copies of a point can be NEAR a vesicle.");
         assert(false);
         exit(0);
@@ -191,9 +379,10 @@ void NearSingular<Real_t>::SetupCoordData(){
           if(scale_tmp==0){
             scale_tmp=1.0;
             r_near=1.0;
+            r_list=1.0;
           }
-          Real_t domain_length=1.0/scale_tmp+4*r_near;
-          Real_t leaf_length=r_near;
+          Real_t domain_length=1.0/scale_tmp+4*r_list;
+          Real_t leaf_length=r_list;
           scale_x=1.0/leaf_length;
           while(domain_length*scale_x>1.0 && tree_depth<MAX_DEPTH-1){
             scale_x*=0.5;
@@ -201,7 +390,7 @@ void NearSingular<Real_t>::SetupCoordData(){
           }
         }
         for(size_t j=0;j<COORD_DIM;j++){ // Update shift_x
-          shift_x[j]=((shift_x[j]/scale_tmp)+2*r_near)*scale_x;
+          shift_x[j]=((shift_x[j]/scale_tmp)+2*r_list)*scale_x;
         }
         coord_setup.bbox[0]=shift_x[0];
         coord_setup.bbox[1]=shift_x[1];
@@ -215,7 +404,7 @@ void NearSingular<Real_t>::SetupCoordData(){
 
         // Determine tree depth
         Real_t leaf_size=1.0/coord_setup.bbox[3];
-        while(leaf_size*0.5>r_near && tree_depth<MAX_DEPTH-1){
+        while(leaf_size*0.5>r_list && tree_depth<MAX_DEPTH-1){
           leaf_size*=0.5;
           tree_depth++;
         }
@@ -804,7 +993,7 @@ void NearSingular<Real_t>::SetupCoordData(){
         size_t tree_depth; Real_t r2_near;
         { // Set tree_depth, r_near
           tree_depth=S_let.mid[0].GetDepth();
-          r2_near=coord_setup.r_near;
+          r2_near=coord_setup.r_list;
           r2_near*=r2_near;
         }
         Real_t s=pow(0.5,tree_depth);
@@ -1023,6 +1212,11 @@ void NearSingular<Real_t>::SetupCoordData(){
 
     pvfmm::Profile::Toc();
   }
+}
+
+template<typename Real_t>
+void NearSingular<Real_t>::SetupProjection(){
+  size_t omp_p=omp_get_max_threads();
   { // projection
     pvfmm::Profile::Tic("Proj",&comm,true);
     PVFMMVec_t&           trg_coord=coord_setup.near_trg_coord;
@@ -1030,6 +1224,7 @@ void NearSingular<Real_t>::SetupCoordData(){
     pvfmm::Vector<size_t>&  trg_dsp=coord_setup.  near_trg_dsp;
 
     pvfmm::Vector<char>& is_extr_pt=coord_setup.is_extr_pt;
+    pvfmm::Vector<char>& is_near_pt=coord_setup.is_near_pt;
     PVFMMVec_t& proj_patch_param=coord_setup.proj_patch_param;
     PVFMMVec_t& proj_coord      =coord_setup.proj_coord      ;
     PVFMMVec_t& repl_force      =coord_setup.repl_force      ;
@@ -1043,19 +1238,40 @@ void NearSingular<Real_t>::SetupCoordData(){
     proj_coord      .ReInit(N_trg*COORD_DIM);
     repl_force      .ReInit(N_trg*COORD_DIM);
     is_extr_pt      .ReInit(N_trg          );
+    is_near_pt      .ReInit(N_trg          );
     Real_t r2repul_inv=(repul_dist_>0?std::pow(1.0/repul_dist_,2.0):0);
     Real_t& r_near=coord_setup.r_near;
     pvfmm::Vector<Real_t> min_dist_loc_(omp_p);
     min_dist_loc_.SetZero();
+    pvfmm::Vector<double> t_thread(omp_p);
     #pragma omp parallel for
     for(size_t tid=0;tid<omp_p;tid++){ // Setup
+      t_thread[tid]=-omp_get_wtime();
       Real_t min_dist_loc=1e10;
-      size_t a=((tid+0)*N_ves)/omp_p;
-      size_t b=((tid+1)*N_ves)/omp_p;
-      for(size_t i=a;i<b;i++) if(trg_cnt[i]){ // loop over all vesicles
+      size_t a, b, i;
+      PairPartition(tid, omp_p, a, b, i);
+      for(;a<b;i++){ // loop over vesicles with pairs in [a,b)
+        size_t dsp=a, cnt=std::min(b,trg_dsp[i]+trg_cnt[i])-a; a+=cnt;
         // Compute projection for near points
-        for(size_t j=0;j<trg_cnt[i];j++){ // loop over target points
-          size_t trg_idx=trg_dsp[i]+j;
+        for(size_t j=0;j<cnt;j++){ // loop over target points
+          size_t trg_idx=dsp+j;
+          { // Skip pairs in the list that are not within r_near
+            size_t k_=coord_setup.near_ves_pt_id[trg_idx];
+            Real_t dx=trg_coord[trg_idx*COORD_DIM+0]-S[0][k_*COORD_DIM+0];
+            Real_t dy=trg_coord[trg_idx*COORD_DIM+1]-S[0][k_*COORD_DIM+1];
+            Real_t dz=trg_coord[trg_idx*COORD_DIM+2]-S[0][k_*COORD_DIM+2];
+            is_near_pt[trg_idx]=(dx*dx+dy*dy+dz*dz<r_near*r_near);
+            if(!is_near_pt[trg_idx]){
+              proj_patch_param[trg_idx*2+0]=0;
+              proj_patch_param[trg_idx*2+1]=0;
+              is_extr_pt[trg_idx]=1;
+              for(size_t k=0;k<COORD_DIM;k++){
+                proj_coord[trg_idx*COORD_DIM+k]=trg_coord[trg_idx*COORD_DIM+k];
+                repl_force[trg_idx*COORD_DIM+k]=0;
+              }
+              continue;
+            }
+          }
           QuadraticPatch patch;
           { // create patch
             Real_t mesh[3*3*COORD_DIM];
@@ -1099,7 +1315,9 @@ void NearSingular<Real_t>::SetupCoordData(){
         }
       }
       min_dist_loc_[tid]=min_dist_loc;
+      t_thread[tid]+=omp_get_wtime();
     }
+    ThreadLoad("Proj", t_thread);
     pvfmm::Profile::Toc();
 
     { // Print minimum distance between surfaces
@@ -1115,8 +1333,6 @@ void NearSingular<Real_t>::SetupCoordData(){
     VelocityScatter(repl_force);
     assert(repl_force.Dim()==T.Dim());
   }
-  pvfmm::Profile::Enable(prof_state);
-  pvfmm::Profile::Toc();
 }
 
 template<typename Real_t>
@@ -1156,25 +1372,38 @@ void NearSingular<Real_t>::SubtractDirect(PVFMMVec_t& vel_fmm){
     size_t N_ves = S->Dim()/(M_ves*COORD_DIM); // Number of vesicles
     assert(N_ves*(M_ves*COORD_DIM) == S->Dim());
 
+    pvfmm::Vector<double> t_thread(omp_p);
     #pragma omp parallel for
     for(size_t tid=0;tid<omp_p;tid++){ // Compute vel_direct for near points.
-      size_t a=((tid+0)*N_ves)/omp_p;
-      size_t b=((tid+1)*N_ves)/omp_p;
-      for(size_t i=a;i<b;i++) if(trg_cnt[i]){ // loop over all vesicles
-        PVFMMVec_t s_coord(     M_ves*COORD_DIM, &S[0]      [   i*M_ves*COORD_DIM], false);
-        PVFMMVec_t t_coord(trg_cnt[i]*COORD_DIM, &trg_coord [trg_dsp[i]*COORD_DIM], false);
-        PVFMMVec_t t_veloc(trg_cnt[i]*COORD_DIM, &vel_direct[trg_dsp[i]*COORD_DIM], false);
+      t_thread[tid]=-omp_get_wtime();
+      size_t a, b, i;
+      PairPartition(tid, omp_p, a, b, i);
+      for(;a<b;i++){ // loop over vesicles with pairs in [a,b)
+        size_t dsp=a, cnt=std::min(b,trg_dsp[i]+trg_cnt[i])-a; a+=cnt;
+        if(!cnt) continue;
+        PVFMMVec_t s_coord(M_ves*COORD_DIM, &S[0]      [i*M_ves*COORD_DIM], false);
+        PVFMMVec_t t_coord(  cnt*COORD_DIM, &trg_coord [  dsp*COORD_DIM], false);
+        PVFMMVec_t t_veloc(  cnt*COORD_DIM, &vel_direct[  dsp*COORD_DIM], false);
 
         if(qforce_single){ // Subtract wrong near potential
           PVFMMVec_t qforce(M_ves*(COORD_DIM*1), &qforce_single[0][0]+M_ves*(COORD_DIM*1)*i, false);
-          StokesKernel<Real_t>::Kernel().k_s2t->      ker_poten(&s_coord[0], M_ves, &qforce[0], 1, &t_coord[0], trg_cnt[i], &t_veloc[0], NULL);
+          StokesKernel<Real_t>::Kernel().k_s2t->      ker_poten(&s_coord[0], M_ves, &qforce[0], 1, &t_coord[0], cnt, &t_veloc[0], NULL);
         }
         if(qforce_double){ // Subtract wrong near potential
           PVFMMVec_t qforce(M_ves*(COORD_DIM*2), &qforce_double[0][0]+M_ves*(COORD_DIM*2)*i, false);
-          StokesKernel<Real_t>::Kernel().k_s2t->dbl_layer_poten(&s_coord[0], M_ves, &qforce[0], 1, &t_coord[0], trg_cnt[i], &t_veloc[0], NULL);
+          StokesKernel<Real_t>::Kernel().k_s2t->dbl_layer_poten(&s_coord[0], M_ves, &qforce[0], 1, &t_coord[0], cnt, &t_veloc[0], NULL);
+        }
+        for(size_t j=0;j<cnt;j++){ // the pair list may have points outside r_near
+          if(!coord_setup.is_near_pt[dsp+j]){
+            t_veloc[j*COORD_DIM+0]=0;
+            t_veloc[j*COORD_DIM+1]=0;
+            t_veloc[j*COORD_DIM+2]=0;
+          }
         }
       }
+      t_thread[tid]+=omp_get_wtime();
     }
+    ThreadLoad("SubtractDirect", t_thread);
     VelocityScatter(vel_direct);
 
     #pragma omp parallel for
@@ -1409,6 +1638,7 @@ const NearSingular<Real_t>::PVFMMVec_t& NearSingular<Real_t>::operator()(bool up
 
   vel_interp.ReInit(trg_coord.Dim());
   pvfmm::Profile::Tic("VelocInterp",&comm,true);
+  pvfmm::Vector<double> t_thread(omp_p);
   #pragma omp parallel for
   for(size_t tid=0;tid<omp_p;tid++){ // Compute vel_interp.
     PVFMMVec_t interp_coord;
@@ -1416,20 +1646,23 @@ const NearSingular<Real_t>::PVFMMVec_t& NearSingular<Real_t>::operator()(bool up
     PVFMMVec_t patch_veloc;
     PVFMMVec_t interp_x;
 
-    size_t a=((tid+0)*N_ves)/omp_p;
-    size_t b=((tid+1)*N_ves)/omp_p;
-    for(size_t i=a;i<b;i++) if(trg_cnt[i]){ // loop over all vesicles
+    t_thread[tid]=-omp_get_wtime();
+    size_t a, b, i;
+    PairPartition(tid, omp_p, a, b, i);
+    for(;a<b;i++){ // loop over vesicles with pairs in [a,b)
+      size_t dsp=a, cnt=std::min(b,trg_dsp[i]+trg_cnt[i])-a; a+=cnt;
+      if(!cnt) continue;
       PVFMMVec_t s_coord(M_ves*COORD_DIM, &S[0][i*M_ves*COORD_DIM], false);
       { // Resize interp_coord, interp_veloc, patch_veloc, interp_x; interp_veloc[:]=0
-        interp_coord.Resize(trg_cnt[i]*(INTERP_DEG-1)*COORD_DIM);
-        interp_veloc.Resize(trg_cnt[i]*(INTERP_DEG-1)*COORD_DIM);
-        patch_veloc .Resize(trg_cnt[i]               *COORD_DIM);
-        interp_x    .Resize(trg_cnt[i]                         );
+        interp_coord.Resize(cnt*(INTERP_DEG-1)*COORD_DIM);
+        interp_veloc.Resize(cnt*(INTERP_DEG-1)*COORD_DIM);
+        patch_veloc .Resize(cnt               *COORD_DIM);
+        interp_x    .Resize(cnt                         );
         interp_veloc.SetZero();
       }
       { // Set interp_x, interp_coord
-        for(size_t j=0;j<trg_cnt[i];j++){ // loop over target points
-          size_t trg_idx=trg_dsp[i]+j;
+        for(size_t j=0;j<cnt;j++){ // loop over target points
+          size_t trg_idx=dsp+j;
           Real_t interp_coord0[COORD_DIM]={proj_coord[trg_idx*COORD_DIM+0],
                                            proj_coord[trg_idx*COORD_DIM+1],
                                            proj_coord[trg_idx*COORD_DIM+2]};
@@ -1462,8 +1695,8 @@ const NearSingular<Real_t>::PVFMMVec_t& NearSingular<Real_t>::operator()(bool up
         }
       }
       { // Set patch_veloc
-        for(size_t j=0;j<trg_cnt[i];j++){ // loop over target points
-          size_t trg_idx=trg_dsp[i]+j;
+        for(size_t j=0;j<cnt;j++){ // loop over target points
+          size_t trg_idx=dsp+j;
           QuadraticPatch patch;
           { // create patch
             Real_t mesh[3*3*COORD_DIM];
@@ -1489,10 +1722,14 @@ const NearSingular<Real_t>::PVFMMVec_t& NearSingular<Real_t>::operator()(bool up
       }
 
       { // Interpolate
-        for(size_t j=0;j<trg_cnt[i];j++){ // loop over target points
-          size_t trg_idx=trg_dsp[i]+j;
+        for(size_t j=0;j<cnt;j++){ // loop over target points
+          size_t trg_idx=dsp+j;
           Real_t* veloc_interp_=&vel_interp[trg_idx*COORD_DIM];
-          if(interp_x[j]==0){
+          if(!coord_setup.is_near_pt[trg_idx]){ // not within r_near
+            for(size_t k=0;k<COORD_DIM;k++){
+              veloc_interp_[k]=0;
+            }
+          }else if(interp_x[j]==0){
             for(size_t k=0;k<COORD_DIM;k++){
               veloc_interp_[k]=patch_veloc[j*COORD_DIM+k];
             }
@@ -1536,7 +1773,9 @@ const NearSingular<Real_t>::PVFMMVec_t& NearSingular<Real_t>::operator()(bool up
         }
       }
     }
+    t_thread[tid]+=omp_get_wtime();
   }
+  ThreadLoad("VelocInterp", t_thread);
   pvfmm::Profile::Toc();
 
   pvfmm::Profile::Tic("Scatter",&comm,true);
@@ -4,9 +4,11 @@ OperatorsMats<Container>::OperatorsMats(bool readFromFile,
     p_(params.sh_order),
     p_up_(params.upsample_freq),
     data_(getDataLength(params)),
-    mats_p_(Container::getDevice(), p_, data_.begin(), readFromFile),
+    mats_p_(Container::getDevice(), p_, data_.begin(), readFromFile,
+        EMPTY_GRID, params.sht_dft),
     mats_p_up_(Container::getDevice(), p_up_, data_.begin() +
-        SHTMats<value_type, device_type>::getDataLength(p_), readFromFile)
+        SHTMats<value_type, device_type>::getDataLength(p_), readFromFile,
+        EMPTY_GRID, params.sht_dft)
 {
     int np = 2 * p_ * ( p_ + 1);
     int np_up = 2 * p_up_ * (p_up_ + 1);
@@ -23,75 +25,260 @@ OperatorsMats<Container>::OperatorsMats(bool readFromFile,
     w_sph_up_             =data_ptr; data_ptr+= np_up;
     assert((data_ptr-data_.begin())==getDataLength(params));
 
-    DataIO fileIO;
-
+    /*
+     * The cache (in VES3D_DIR/precomputed) is only used when asked
+     * for. It is only written by rank 0, after parsing the text files
+     * when the cache is missing or stale on any process; the other
+     * processes then get the matrices from rank 0.
+     */
     if(readFromFile)
     {
-        std::string tname;
-        char buffer[500];
+        double t0(GETSECONDS());
+        int rank(0);
+        bool bcast(false);
+#ifdef HAS_MPI
+        if (params.mats_io!=TextMatsIO)
+            MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
 
-        if ( typeid(value_type) == typeid(float) )
-            tname = "single";
-        else
-            tname = "double";
+        if (params.mats_io==TextMatsIO){
+            readText();
+        } else {
+            int good(1);
+            if (params.mats_io==CacheMatsIO || rank==0)
+                good = (readCache()==ErrorEvent::Success);
+#ifdef HAS_MPI
+            int all_good(good);
+            if (params.mats_io==CacheMatsIO)
+                MPI_Allreduce(&good, &all_good, 1, MPI_INT, MPI_MIN, VES3D_COMM_WORLD);
+            else
+                MPI_Bcast(&all_good, 1, MPI_INT, 0, VES3D_COMM_WORLD);
+            good = all_good;
+#endif
+            if (!good && rank==0){
+                readText();
+                writeCache();
+            }
+            bcast = (params.mats_io==BcastMatsIO || !good);
+        }
 
-        sprintf(buffer,"precomputed/quad_weights_%u_%s.txt", p_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, quad_weights_ - data_.begin(), np);
+#ifdef HAS_MPI
+        if (bcast)
+            CHK(broadcast());
+#endif
 
-        sprintf(buffer,"precomputed/sing_quad_weights_%u_%s.txt", p_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, sing_quad_weights_- data_.begin() , np);
+	INFO("Matrices are loaded ("<<params.mats_io<<") in "<<GETSECONDS()-t0<<"s");
+    } else {
+      INFO("Object created with no data");
+    }
+}
 
-        sprintf(buffer,"precomputed/w_sph_%u_%s.txt", p_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, w_sph_- data_.begin(), np);
+template <typename Container>
+Error_t OperatorsMats<Container>::readText()
+{
+    int np = 2 * p_ * ( p_ + 1);
+    int np_up = 2 * p_up_ * (p_up_ + 1);
 
-        //p
-        sprintf(buffer,"precomputed/legTrans%u_%s.txt", p_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_.dlt_ - data_.begin(),
-            mats_p_.getDLTLength());
+    DataIO fileIO;
+    std::string tname(precisionName());
+    char buffer[500];
 
-        sprintf(buffer,"precomputed/legTransInv%u_%s.txt", p_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_.dlt_inv_ - data_.begin(),
-            mats_p_.getDLTLength());
+    sprintf(buffer,"precomputed/quad_weights_%u_%s.txt", p_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, quad_weights_ - data_.begin(), np);
 
-        sprintf(buffer,"precomputed/d1legTrans%u_%s.txt", p_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_.dlt_inv_d1_ - data_.begin(),
-            mats_p_.getDLTLength());
+    sprintf(buffer,"precomputed/sing_quad_weights_%u_%s.txt", p_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, sing_quad_weights_- data_.begin() , np);
 
-        sprintf(buffer,"precomputed/d2legTrans%u_%s.txt", p_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_.dlt_inv_d2_- data_.begin(),
-            mats_p_.getDLTLength());
+    sprintf(buffer,"precomputed/w_sph_%u_%s.txt", p_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, w_sph_- data_.begin(), np);
 
-        //p_up
-        sprintf(buffer,"precomputed/quad_weights_%u_%s.txt", p_up_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, quad_weights_p_up_ - data_.begin(), np_up);
+    //p
+    sprintf(buffer,"precomputed/legTrans%u_%s.txt", p_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_.dlt_ - data_.begin(),
+        mats_p_.getDLTLength());
 
-        sprintf(buffer,"precomputed/sing_quad_weights_%u_%s.txt", p_up_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, sing_quad_weights_up_- data_.begin() , np_up);
+    sprintf(buffer,"precomputed/legTransInv%u_%s.txt", p_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_.dlt_inv_ - data_.begin(),
+        mats_p_.getDLTLength());
 
-        sprintf(buffer,"precomputed/w_sph_%u_%s.txt", p_up_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, w_sph_up_- data_.begin(), np_up);
+    sprintf(buffer,"precomputed/d1legTrans%u_%s.txt", p_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_.dlt_inv_d1_ - data_.begin(),
+        mats_p_.getDLTLength());
 
-        sprintf(buffer,"precomputed/legTrans%u_%s.txt", p_up_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_up_.dlt_- data_.begin(),
-            mats_p_up_.getDLTLength());
+    sprintf(buffer,"precomputed/d2legTrans%u_%s.txt", p_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_.dlt_inv_d2_- data_.begin(),
+        mats_p_.getDLTLength());
 
-        sprintf(buffer,"precomputed/legTransInv%u_%s.txt", p_up_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_up_.dlt_inv_ - data_.begin(),
-            mats_p_up_.getDLTLength());
+    //p_up
+    sprintf(buffer,"precomputed/quad_weights_%u_%s.txt", p_up_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, quad_weights_p_up_ - data_.begin(), np_up);
 
-        sprintf(buffer,"precomputed/d1legTrans%u_%s.txt", p_up_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_up_.dlt_inv_d1_ - data_.begin(),
-            mats_p_up_.getDLTLength());
+    sprintf(buffer,"precomputed/sing_quad_weights_%u_%s.txt", p_up_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, sing_quad_weights_up_- data_.begin() , np_up);
 
-        sprintf(buffer,"precomputed/d2legTrans%u_%s.txt", p_up_,tname.c_str());
-        fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_up_.dlt_inv_d2_ - data_.begin(),
-            mats_p_up_.getDLTLength());
+    sprintf(buffer,"precomputed/w_sph_%u_%s.txt", p_up_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, w_sph_up_- data_.begin(), np_up);
 
-	INFO("Matrices are loaded from file");
-    } else {
-      INFO("Object created with no data");
+    sprintf(buffer,"precomputed/legTrans%u_%s.txt", p_up_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_up_.dlt_- data_.begin(),
+        mats_p_up_.getDLTLength());
+
+    sprintf(buffer,"precomputed/legTransInv%u_%s.txt", p_up_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_up_.dlt_inv_ - data_.begin(),
+        mats_p_up_.getDLTLength());
+
+    sprintf(buffer,"precomputed/d1legTrans%u_%s.txt", p_up_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_up_.dlt_inv_d1_ - data_.begin(),
+        mats_p_up_.getDLTLength());
+
+    sprintf(buffer,"precomputed/d2legTrans%u_%s.txt", p_up_,tname.c_str());
+    fileIO.ReadData(FullPath(buffer), data_, DataIO::ASCII, mats_p_up_.dlt_inv_d2_ - data_.begin(),
+        mats_p_up_.getDLTLength());
+
+    return ErrorEvent::Success;
+}
+
+template <typename Container>
+std::string OperatorsMats<Container>::precisionName() const
+{
+    return (typeid(value_type) == typeid(float)) ? "single" : "double";
+}
+
+template <typename Container>
+std::string OperatorsMats<Container>::cacheFileName() const
+{
+    char buffer[500];
+    sprintf(buffer,"precomputed/opmats_%u_%u_%s.bin", p_, p_up_, precisionName().c_str());
+    return FullPath(buffer);
+}
+
+/*
+ * The cache is a fixed length ASCII header followed by the raw
+ * content of data_, so that the data is aligned and can be mapped
+ * or read in one call.
+ */
+template <typename Container>
+Error_t OperatorsMats<Container>::readCache()
+{
+    std::string fname(cacheFileName());
+    std::ifstream fh(fname.c_str(), std::ios::binary | std::ios::in);
+    if (!fh){
+        COUTDEBUG("No operator cache "<<fname);
+        return ErrorEvent::IOError;
+    }
+
+    std::string header(CACHE_HEADER_LEN, ' ');
+    fh.read(&header[0], header.size());
+
+    std::stringstream hs(header);
+    std::string s, key, version;
+    int p(0), p_up(0);
+    size_t word(0), len(0);
+    unsigned long cs(0);
+
+    hs>>s;
+    hs>>key>>version;
+    hs>>key>>p>>key>>p_up>>key>>word>>key>>len>>key>>cs;
+
+    if (s!="OPMATS" || !hs || p!=p_ || p_up!=p_up_ ||
+        word!=sizeof(value_type) || len!=data_.size()){
+        WARN("Incompatible operator cache "<<fname<<" (ignored)");
+        return ErrorEvent::IOError;
+    }
+
+    value_type *buf(device_type::IsHost() ? data_.begin() : new value_type[len]);
+    fh.read(reinterpret_cast<char*>(buf), len*sizeof(value_type));
+    bool good((size_t) fh.gcount()==len*sizeof(value_type) &&
+        DataIO::Checksum(reinterpret_cast<const char*>(buf), len*sizeof(value_type))==cs);
+
+    if (good && !device_type::IsHost())
+        data_.getDevice().Memcpy(data_.begin(), buf, data_.mem_size(),
+            device_type::MemcpyHostToDevice);
+    if (!device_type::IsHost()) delete[] buf;
+
+    if (!good){
+        WARN("Corrupted operator cache "<<fname<<" (ignored)");
+        return ErrorEvent::IOError;
+    }
+
+    COUTDEBUG("Read the operator cache "<<fname);
+    return ErrorEvent::Success;
+}
+
+template <typename Container>
+Error_t OperatorsMats<Container>::writeCache() const
+{
+    size_t len(data_.size());
+    const value_type *buf(data_.begin());
+    if (!device_type::IsHost()){
+        value_type *hbuf = new value_type[len];
+        data_.getDevice().Memcpy(hbuf, data_.begin(), data_.mem_size(),
+            device_type::MemcpyDeviceToHost);
+        buf = hbuf;
+    }
+
+    std::stringstream hs;
+    hs<<"OPMATS\n";
+    hs<<"version: "<<VERSION<<"\n";
+    hs<<"p: "<<p_<<"\n";
+    hs<<"p_up: "<<p_up_<<"\n";
+    hs<<"word: "<<sizeof(value_type)<<"\n";
+    hs<<"length: "<<len<<"\n";
+    hs<<"checksum: "<<DataIO::Checksum(reinterpret_cast<const char*>(buf), len*sizeof(value_type))<<"\n";
+    std::string header(hs.str());
+    ASSERT(header.size()<CACHE_HEADER_LEN, "Operator cache header is too long");
+    header.resize(CACHE_HEADER_LEN-1, ' ');
+    header += "\n";
+
+    // written to a temporary file and renamed, so that concurrent
+    // writers (other jobs, possibly on other nodes) and readers see
+    // either no file or a complete one
+    std::string fname(cacheFileName());
+    char host[256];
+    if (gethostname(host, sizeof(host))) host[0] = '\0';
+    host[sizeof(host)-1] = '\0';
+    std::stringstream tname;
+    tname<<fname<<".tmp."<<host<<"."<<getpid();
+
+    std::ofstream fh(tname.str().c_str(), std::ios::binary | std::ios::out);
+    fh.write(header.data(), header.size());
+    fh.write(reinterpret_cast<const char*>(buf), len*sizeof(value_type));
+    fh.close();
+    if (!device_type::IsHost()) delete[] buf;
+
+    if (fh.fail() || rename(tname.str().c_str(), fname.c_str())){
+        remove(tname.str().c_str());
+        WARN("Could not write the operator cache "<<fname);
+        return ErrorEvent::IOError;
     }
+
+    INFO("Wrote the operator cache "<<fname);
+    return ErrorEvent::Success;
+}
+
+#ifdef HAS_MPI
+template <typename Container>
+Error_t OperatorsMats<Container>::broadcast()
+{
+    size_t len(data_.size()*sizeof(value_type));
+    ASSERT(len<(size_t) std::numeric_limits<int>::max(), "Matrices are too large to broadcast");
+
+    char *buf(reinterpret_cast<char*>(data_.begin()));
+    if (!device_type::IsHost()){
+        buf = new char[len];
+        data_.getDevice().Memcpy(buf, data_.begin(), len, device_type::MemcpyDeviceToHost);
+    }
+
+    MPI_Bcast(buf, len, MPI_BYTE, 0, VES3D_COMM_WORLD);
+
+    if (!device_type::IsHost()){
+        data_.getDevice().Memcpy(data_.begin(), buf, len, device_type::MemcpyHostToDevice);
+        delete[] buf;
+    }
+
+    return ErrorEvent::Success;
 }
+#endif
 
 template <typename Container>
 size_t OperatorsMats<Container>::getDataLength(const Parameters<value_type> &params) const
@@ -1,4 +1,10 @@
 #include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
 #include <parUtils.h>
 #include <vector.hpp>
 #include <mortonid.hpp>
@@ -17,130 +23,151 @@ static Real_t machine_eps(){
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-///////////////////////// Kernel Function Declarations ////////////////////////
+//////////////////////// Instruction Set and Dispatch /////////////////////////
+
+// Every vector width is compiled (with GCC target pragmas) and selected at
+// runtime. Other compilers and hosts use the scalar kernels only.
+#if defined __GNUC__ && !defined __clang__ && (defined __x86_64__ || defined __i386__) && !defined __MIC__
+#define VES3D_STOKES_MULTI_ISA
+#include <immintrin.h>
+#endif
+
+inline KernelISA StokesHostISA(){
+#ifdef VES3D_STOKES_MULTI_ISA
+  KernelISA isa=ScalarISA;
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("sse3"   )) isa=SSE3ISA;
+  if(__builtin_cpu_supports("avx"    )) isa=AVXISA;
+  if(__builtin_cpu_supports("avx512f")) isa=AVX512ISA;
+  return isa;
+#else
+  return ScalarISA;
+#endif
+}
 
-////////// Stokes Kernel //////////
+// Storage for the active instruction set, only accessed atomically (the
+// kernels read it from many threads). Statically initialized to UnknownISA,
+// so there is no race on its construction.
+inline int& stokes_isa_(){
+  static int isa=UnknownISA;
+  return isa;
+}
 
-template <class Real_t, class Vec_t=Real_t, Vec_t (*RSQRT_INTRIN)(Vec_t)=pvfmm::rsqrt_intrin0<Vec_t> >
-void stokes_sl_m2l_uKernel(pvfmm::Matrix<Real_t>& src_coord, pvfmm::Matrix<Real_t>& src_value, pvfmm::Matrix<Real_t>& trg_coord, pvfmm::Matrix<Real_t>& trg_value){
-  #define SRC_BLK 500
-  size_t VecLen=sizeof(Vec_t)/sizeof(Real_t);
-
-  //// Number of newton iterations
-  size_t NWTN_ITER=0;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin0<Vec_t,Real_t>) NWTN_ITER=0;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin1<Vec_t,Real_t>) NWTN_ITER=1;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin2<Vec_t,Real_t>) NWTN_ITER=2;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin3<Vec_t,Real_t>) NWTN_ITER=3;
-
-  Real_t nwtn_scal=1; // scaling factor for newton iterations
-  for(int i=0;i<NWTN_ITER;i++){
-    nwtn_scal=2*nwtn_scal*nwtn_scal*nwtn_scal;
-  }
-  const Real_t OOEP = 1.0/(8*nwtn_scal*pvfmm::const_pi<Real_t>());
-  Vec_t inv_nwtn_scal2=pvfmm::set_intrin<Vec_t,Real_t>(1.0/(nwtn_scal*nwtn_scal));
-
-  size_t src_cnt_=src_coord.Dim(1);
-  size_t trg_cnt_=trg_coord.Dim(1);
-  for(size_t sblk=0;sblk<src_cnt_;sblk+=SRC_BLK){
-    size_t src_cnt=src_cnt_-sblk;
-    if(src_cnt>SRC_BLK) src_cnt=SRC_BLK;
-    for(size_t t=0;t<trg_cnt_;t+=VecLen){
-      Vec_t tx=pvfmm::load_intrin<Vec_t>(&trg_coord[0][t]);
-      Vec_t ty=pvfmm::load_intrin<Vec_t>(&trg_coord[1][t]);
-      Vec_t tz=pvfmm::load_intrin<Vec_t>(&trg_coord[2][t]);
-
-      Vec_t tvx=pvfmm::zero_intrin<Vec_t>();
-      Vec_t tvy=pvfmm::zero_intrin<Vec_t>();
-      Vec_t tvz=pvfmm::zero_intrin<Vec_t>();
-      for(size_t s=sblk;s<sblk+src_cnt;s++){
-        Vec_t dx=pvfmm::sub_intrin(tx,pvfmm::bcast_intrin<Vec_t>(&src_coord[0][s]));
-        Vec_t dy=pvfmm::sub_intrin(ty,pvfmm::bcast_intrin<Vec_t>(&src_coord[1][s]));
-        Vec_t dz=pvfmm::sub_intrin(tz,pvfmm::bcast_intrin<Vec_t>(&src_coord[2][s]));
-
-        Vec_t svx       =pvfmm::bcast_intrin<Vec_t>(&src_value[0][s]);
-        Vec_t svy       =pvfmm::bcast_intrin<Vec_t>(&src_value[1][s]);
-        Vec_t svz       =pvfmm::bcast_intrin<Vec_t>(&src_value[2][s]);
-        Vec_t inner_prod=pvfmm::bcast_intrin<Vec_t>(&src_value[3][s]);
-
-        Vec_t r2=               pvfmm::mul_intrin(dx,dx) ;
-        r2=pvfmm::add_intrin(r2,pvfmm::mul_intrin(dy,dy));
-        r2=pvfmm::add_intrin(r2,pvfmm::mul_intrin(dz,dz));
-
-        Vec_t rinv=RSQRT_INTRIN(r2);
-        Vec_t rinv2=pvfmm::mul_intrin(pvfmm::mul_intrin(rinv,rinv),inv_nwtn_scal2);
-
-        inner_prod=pvfmm::add_intrin(inner_prod,pvfmm::mul_intrin(svx,dx));
-        inner_prod=pvfmm::add_intrin(inner_prod,pvfmm::mul_intrin(svy,dy));
-        inner_prod=pvfmm::add_intrin(inner_prod,pvfmm::mul_intrin(svz,dz));
-        inner_prod=pvfmm::mul_intrin(inner_prod,rinv2);
-
-        tvx=pvfmm::add_intrin(tvx,pvfmm::mul_intrin(rinv,pvfmm::add_intrin(svx,pvfmm::mul_intrin(dx,inner_prod))));
-        tvy=pvfmm::add_intrin(tvy,pvfmm::mul_intrin(rinv,pvfmm::add_intrin(svy,pvfmm::mul_intrin(dy,inner_prod))));
-        tvz=pvfmm::add_intrin(tvz,pvfmm::mul_intrin(rinv,pvfmm::add_intrin(svz,pvfmm::mul_intrin(dz,inner_prod))));
+// Defaults to the widest instruction set supported by the host;
+// VES3D_KERNEL_ISA=<name> in the environment can lower it (e.g. for
+// benchmarking).
+inline KernelISA StokesGetISA(){
+  int& isa_=stokes_isa_();
+  int isa;
+  #pragma omp atomic read
+  isa=isa_;
+  if(isa==UnknownISA){
+    #pragma omp critical (StokesISAInit)
+    {
+      #pragma omp atomic read
+      isa=isa_;
+      if(isa==UnknownISA){
+        KernelISA max_isa=StokesHostISA();
+        KernelISA env_isa=UnknownISA;
+        const char* env=getenv("VES3D_KERNEL_ISA");
+        if(env) env_isa=EnumifyKernelISA(env);
+        isa=(env_isa<max_isa?env_isa:max_isa);
+        #pragma omp atomic write
+        isa_=isa;
       }
-      Vec_t ooep=pvfmm::set_intrin<Vec_t,Real_t>(OOEP);
-
-      tvx=pvfmm::add_intrin(pvfmm::mul_intrin(tvx,ooep),pvfmm::load_intrin<Vec_t>(&trg_value[0][t]));
-      tvy=pvfmm::add_intrin(pvfmm::mul_intrin(tvy,ooep),pvfmm::load_intrin<Vec_t>(&trg_value[1][t]));
-      tvz=pvfmm::add_intrin(pvfmm::mul_intrin(tvz,ooep),pvfmm::load_intrin<Vec_t>(&trg_value[2][t]));
-
-      pvfmm::store_intrin(&trg_value[0][t],tvx);
-      pvfmm::store_intrin(&trg_value[1][t],tvy);
-      pvfmm::store_intrin(&trg_value[2][t],tvz);
     }
   }
+  return (KernelISA)isa;
+}
 
-  { // Add FLOPS
-    #ifndef __MIC__
-    pvfmm::Profile::Add_FLOP((long long)trg_cnt_*(long long)src_cnt_*(29+4*(NWTN_ITER)));
-    #endif
+inline KernelISA StokesSetISA(KernelISA isa){
+  KernelISA max_isa=StokesHostISA();
+  int& isa_=stokes_isa_();
+  #pragma omp critical (StokesISAInit)
+  {
+    #pragma omp atomic write
+    isa_=(isa<max_isa?isa:max_isa);
   }
-  #undef SRC_BLK
+  return StokesGetISA();
 }
 
-template <class T, int newton_iter=0>
-void stokes_sl_m2l(T* r_src, int src_cnt, T* v_src, int dof, T* r_trg, int trg_cnt, T* v_trg, pvfmm::mem::MemoryManager* mem_mgr){
-  #define STK_KER_NWTN(nwtn) if(newton_iter==nwtn) \
-        pvfmm::generic_kernel<Real_t, 4, 3, stokes_sl_m2l_uKernel<Real_t,Vec_t, pvfmm::rsqrt_intrin##nwtn<Vec_t,Real_t> > > \
-            ((Real_t*)r_src, src_cnt, (Real_t*)v_src, dof, (Real_t*)r_trg, trg_cnt, (Real_t*)v_trg, mem_mgr)
-  #define STOKES_KERNEL STK_KER_NWTN(0); STK_KER_NWTN(1); STK_KER_NWTN(2); STK_KER_NWTN(3);
-
-  if(pvfmm::mem::TypeTraits<T>::ID()==pvfmm::mem::TypeTraits<float>::ID()){
-    typedef float Real_t;
-    #if defined __MIC__
-      #define Vec_t Real_t
-    #elif defined __AVX__
-      #define Vec_t __m256
-    #elif defined __SSE3__
-      #define Vec_t __m128
-    #else
-      #define Vec_t Real_t
-    #endif
-    STOKES_KERNEL;
-    #undef Vec_t
-  }else if(pvfmm::mem::TypeTraits<T>::ID()==pvfmm::mem::TypeTraits<double>::ID()){
-    typedef double Real_t;
-    #if defined __MIC__
-      #define Vec_t Real_t
-    #elif defined __AVX__
-      #define Vec_t __m256d
-    #elif defined __SSE3__
-      #define Vec_t __m128d
-    #else
-      #define Vec_t Real_t
-    #endif
-    STOKES_KERNEL;
-    #undef Vec_t
-  }else{
-    typedef T Real_t;
-    #define Vec_t Real_t
-    STOKES_KERNEL;
-    #undef Vec_t
+template <class Real_t>
+int StokesNewtonIter(Real_t tol, KernelISA isa){
+  // relative error of the hardware approximation; each Newton iteration maps
+  // e -> 1.5*e^2. The scalar path computes 1/sqrt exactly.
+  Real_t err=0;
+  if(isa==SSE3ISA || isa==AVXISA) err=1.5/4096.0;
+  if(isa==AVX512ISA             ) err=1.0/16384.0;
+
+  Real_t eps=machine_eps<Real_t>();
+  if(tol<eps) tol=eps;
+
+  int newton_iter=0;
+  while(err>tol && newton_iter<3){
+    err=1.5*err*err;
+    newton_iter++;
+  }
+  return newton_iter;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////// Kernel Function Declarations ////////////////////////
+
+////////// Stokes Kernel //////////
+
+namespace stokes_scalar{
+#define STOKES_UKERNEL_ISA 0
+#include "StokesMicroKernels.cc"
+#undef STOKES_UKERNEL_ISA
+}
+
+#ifdef VES3D_STOKES_MULTI_ISA
+#pragma GCC push_options
+#pragma GCC target("sse3")
+namespace stokes_sse3{
+#define STOKES_UKERNEL_ISA 1
+#include "StokesMicroKernels.cc"
+#undef STOKES_UKERNEL_ISA
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx")
+namespace stokes_avx{
+#define STOKES_UKERNEL_ISA 2
+#include "StokesMicroKernels.cc"
+#undef STOKES_UKERNEL_ISA
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+namespace stokes_avx512{
+#define STOKES_UKERNEL_ISA 3
+#include "StokesMicroKernels.cc"
+#undef STOKES_UKERNEL_ISA
+}
+#pragma GCC pop_options
+
+#define STK_ISA_CASES(KER, T, N, ARGS)                                      \
+    case AVX512ISA: stokes_avx512::KER<T,N> ARGS; break;                    \
+    case AVXISA   : stokes_avx   ::KER<T,N> ARGS; break;                    \
+    case SSE3ISA  : stokes_sse3  ::KER<T,N> ARGS; break;
+#else
+#define STK_ISA_CASES(KER, T, N, ARGS)
+#endif
+
+// Run the micro-kernel for the active instruction set.
+#define STOKES_KERNEL_ARGS (r_src, src_cnt, v_src, dof, r_trg, trg_cnt, v_trg, mem_mgr)
+#define STOKES_KERNEL_DISPATCH(KER, T, N)                                   \
+  switch(StokesGetISA()){                                                   \
+    STK_ISA_CASES(KER, T, N, STOKES_KERNEL_ARGS)                            \
+    default: stokes_scalar::KER<T,N> STOKES_KERNEL_ARGS;                    \
   }
 
-  #undef STK_KER_NWTN
-  #undef STOKES_KERNEL
+template <class T, int newton_iter=0>
+void stokes_sl_m2l(T* r_src, int src_cnt, T* v_src, int dof, T* r_trg, int trg_cnt, T* v_trg, pvfmm::mem::MemoryManager* mem_mgr){
+  STOKES_KERNEL_DISPATCH(stokes_sl_m2l, T, newton_iter);
 }
 
 template <class T>
@@ -157,261 +184,20 @@ void stokes_m2l_vol_poten(const T* coord, int n, T* out){
   }
 }
 
-
-template <class Real_t, class Vec_t=Real_t, Vec_t (*RSQRT_INTRIN)(Vec_t)=pvfmm::rsqrt_intrin0<Vec_t> >
-void stokes_sl_uKernel(pvfmm::Matrix<Real_t>& src_coord, pvfmm::Matrix<Real_t>& src_value, pvfmm::Matrix<Real_t>& trg_coord, pvfmm::Matrix<Real_t>& trg_value){
-  #define SRC_BLK 500
-  static Real_t eps=machine_eps<Real_t>()*128;
-  size_t VecLen=sizeof(Vec_t)/sizeof(Real_t);
-
-  //// Number of newton iterations
-  size_t NWTN_ITER=0;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin0<Vec_t,Real_t>) NWTN_ITER=0;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin1<Vec_t,Real_t>) NWTN_ITER=1;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin2<Vec_t,Real_t>) NWTN_ITER=2;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin3<Vec_t,Real_t>) NWTN_ITER=3;
-
-  Real_t nwtn_scal=1; // scaling factor for newton iterations
-  for(int i=0;i<NWTN_ITER;i++){
-    nwtn_scal=2*nwtn_scal*nwtn_scal*nwtn_scal;
-  }
-  const Real_t OOEP = 1.0/(8*nwtn_scal*pvfmm::const_pi<Real_t>());
-  Vec_t inv_nwtn_scal2=pvfmm::set_intrin<Vec_t,Real_t>(1.0/(nwtn_scal*nwtn_scal));
-
-  size_t src_cnt_=src_coord.Dim(1);
-  size_t trg_cnt_=trg_coord.Dim(1);
-  for(size_t sblk=0;sblk<src_cnt_;sblk+=SRC_BLK){
-    size_t src_cnt=src_cnt_-sblk;
-    if(src_cnt>SRC_BLK) src_cnt=SRC_BLK;
-    for(size_t t=0;t<trg_cnt_;t+=VecLen){
-      Vec_t tx=pvfmm::load_intrin<Vec_t>(&trg_coord[0][t]);
-      Vec_t ty=pvfmm::load_intrin<Vec_t>(&trg_coord[1][t]);
-      Vec_t tz=pvfmm::load_intrin<Vec_t>(&trg_coord[2][t]);
-
-      Vec_t tvx=pvfmm::zero_intrin<Vec_t>();
-      Vec_t tvy=pvfmm::zero_intrin<Vec_t>();
-      Vec_t tvz=pvfmm::zero_intrin<Vec_t>();
-      for(size_t s=sblk;s<sblk+src_cnt;s++){
-        Vec_t dx=pvfmm::sub_intrin(tx,pvfmm::bcast_intrin<Vec_t>(&src_coord[0][s]));
-        Vec_t dy=pvfmm::sub_intrin(ty,pvfmm::bcast_intrin<Vec_t>(&src_coord[1][s]));
-        Vec_t dz=pvfmm::sub_intrin(tz,pvfmm::bcast_intrin<Vec_t>(&src_coord[2][s]));
-
-        Vec_t svx=             pvfmm::bcast_intrin<Vec_t>(&src_value[0][s]) ;
-        Vec_t svy=             pvfmm::bcast_intrin<Vec_t>(&src_value[1][s]) ;
-        Vec_t svz=             pvfmm::bcast_intrin<Vec_t>(&src_value[2][s]) ;
-
-        Vec_t r2=               pvfmm::mul_intrin(dx,dx) ;
-        r2=pvfmm::add_intrin(r2,pvfmm::mul_intrin(dy,dy));
-        r2=pvfmm::add_intrin(r2,pvfmm::mul_intrin(dz,dz));
-        r2=pvfmm::and_intrin(pvfmm::cmplt_intrin(pvfmm::set_intrin<Vec_t,Real_t>(eps),r2),r2);
-
-        Vec_t rinv=RSQRT_INTRIN(r2);
-        Vec_t rinv2=pvfmm::mul_intrin(pvfmm::mul_intrin(rinv,rinv),inv_nwtn_scal2);
-
-        Vec_t inner_prod=                       pvfmm::mul_intrin(svx,dx) ;
-        inner_prod=pvfmm::add_intrin(inner_prod,pvfmm::mul_intrin(svy,dy));
-        inner_prod=pvfmm::add_intrin(inner_prod,pvfmm::mul_intrin(svz,dz));
-        inner_prod=pvfmm::mul_intrin(inner_prod,rinv2);
-
-        tvx=pvfmm::add_intrin(tvx,pvfmm::mul_intrin(rinv,pvfmm::add_intrin(svx,pvfmm::mul_intrin(dx,inner_prod))));
-        tvy=pvfmm::add_intrin(tvy,pvfmm::mul_intrin(rinv,pvfmm::add_intrin(svy,pvfmm::mul_intrin(dy,inner_prod))));
-        tvz=pvfmm::add_intrin(tvz,pvfmm::mul_intrin(rinv,pvfmm::add_intrin(svz,pvfmm::mul_intrin(dz,inner_prod))));
-      }
-      Vec_t ooep=pvfmm::set_intrin<Vec_t,Real_t>(OOEP);
-
-      tvx=pvfmm::add_intrin(pvfmm::mul_intrin(tvx,ooep),pvfmm::load_intrin<Vec_t>(&trg_value[0][t]));
-      tvy=pvfmm::add_intrin(pvfmm::mul_intrin(tvy,ooep),pvfmm::load_intrin<Vec_t>(&trg_value[1][t]));
-      tvz=pvfmm::add_intrin(pvfmm::mul_intrin(tvz,ooep),pvfmm::load_intrin<Vec_t>(&trg_value[2][t]));
-
-      pvfmm::store_intrin(&trg_value[0][t],tvx);
-      pvfmm::store_intrin(&trg_value[1][t],tvy);
-      pvfmm::store_intrin(&trg_value[2][t],tvz);
-    }
-  }
-
-  { // Add FLOPS
-    #ifndef __MIC__
-    pvfmm::Profile::Add_FLOP((long long)trg_cnt_*(long long)src_cnt_*(29+4*(NWTN_ITER)));
-    #endif
-  }
-  #undef SRC_BLK
-}
-
 template <class T, int newton_iter=0>
 void stokes_sl(T* r_src, int src_cnt, T* v_src, int dof, T* r_trg, int trg_cnt, T* v_trg, pvfmm::mem::MemoryManager* mem_mgr){
-  #define STK_KER_NWTN(nwtn) if(newton_iter==nwtn) \
-        pvfmm::generic_kernel<Real_t, 3, 3, stokes_sl_uKernel<Real_t,Vec_t, pvfmm::rsqrt_intrin##nwtn<Vec_t,Real_t> > > \
-            ((Real_t*)r_src, src_cnt, (Real_t*)v_src, dof, (Real_t*)r_trg, trg_cnt, (Real_t*)v_trg, mem_mgr)
-  #define STOKES_KERNEL STK_KER_NWTN(0); STK_KER_NWTN(1); STK_KER_NWTN(2); STK_KER_NWTN(3);
-
-  if(pvfmm::mem::TypeTraits<T>::ID()==pvfmm::mem::TypeTraits<float>::ID()){
-    typedef float Real_t;
-    #if defined __MIC__
-      #define Vec_t Real_t
-    #elif defined __AVX__
-      #define Vec_t __m256
-    #elif defined __SSE3__
-      #define Vec_t __m128
-    #else
-      #define Vec_t Real_t
-    #endif
-    STOKES_KERNEL;
-    #undef Vec_t
-  }else if(pvfmm::mem::TypeTraits<T>::ID()==pvfmm::mem::TypeTraits<double>::ID()){
-    typedef double Real_t;
-    #if defined __MIC__
-      #define Vec_t Real_t
-    #elif defined __AVX__
-      #define Vec_t __m256d
-    #elif defined __SSE3__
-      #define Vec_t __m128d
-    #else
-      #define Vec_t Real_t
-    #endif
-    STOKES_KERNEL;
-    #undef Vec_t
-  }else{
-    typedef T Real_t;
-    #define Vec_t Real_t
-    STOKES_KERNEL;
-    #undef Vec_t
-  }
-
-  #undef STK_KER_NWTN
-  #undef STOKES_KERNEL
-}
-
-template <class Real_t, class Vec_t=Real_t, Vec_t (*RSQRT_INTRIN)(Vec_t)=pvfmm::rsqrt_intrin0<Vec_t> >
-void stokes_dl_uKernel(pvfmm::Matrix<Real_t>& src_coord, pvfmm::Matrix<Real_t>& src_value, pvfmm::Matrix<Real_t>& trg_coord, pvfmm::Matrix<Real_t>& trg_value){
-  #define SRC_BLK 500
-  static Real_t eps=machine_eps<Real_t>()*128;
-  size_t VecLen=sizeof(Vec_t)/sizeof(Real_t);
-
-  //// Number of newton iterations
-  size_t NWTN_ITER=0;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin0<Vec_t,Real_t>) NWTN_ITER=0;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin1<Vec_t,Real_t>) NWTN_ITER=1;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin2<Vec_t,Real_t>) NWTN_ITER=2;
-  if(RSQRT_INTRIN==(Vec_t (*)(Vec_t))pvfmm::rsqrt_intrin3<Vec_t,Real_t>) NWTN_ITER=3;
-
-  Real_t nwtn_scal=1; // scaling factor for newton iterations
-  for(int i=0;i<NWTN_ITER;i++){
-    nwtn_scal=2*nwtn_scal*nwtn_scal*nwtn_scal;
-  }
-  const Real_t SCAL_CONST = 3.0/(4.0*nwtn_scal*nwtn_scal*nwtn_scal*nwtn_scal*nwtn_scal*pvfmm::const_pi<Real_t>());
-
-  size_t src_cnt_=src_coord.Dim(1);
-  size_t trg_cnt_=trg_coord.Dim(1);
-  for(size_t sblk=0;sblk<src_cnt_;sblk+=SRC_BLK){
-    size_t src_cnt=src_cnt_-sblk;
-    if(src_cnt>SRC_BLK) src_cnt=SRC_BLK;
-    for(size_t t=0;t<trg_cnt_;t+=VecLen){
-      Vec_t tx=pvfmm::load_intrin<Vec_t>(&trg_coord[0][t]);
-      Vec_t ty=pvfmm::load_intrin<Vec_t>(&trg_coord[1][t]);
-      Vec_t tz=pvfmm::load_intrin<Vec_t>(&trg_coord[2][t]);
-
-      Vec_t tvx=pvfmm::zero_intrin<Vec_t>();
-      Vec_t tvy=pvfmm::zero_intrin<Vec_t>();
-      Vec_t tvz=pvfmm::zero_intrin<Vec_t>();
-      for(size_t s=sblk;s<sblk+src_cnt;s++){
-        Vec_t dx=pvfmm::sub_intrin(tx,pvfmm::bcast_intrin<Vec_t>(&src_coord[0][s]));
-        Vec_t dy=pvfmm::sub_intrin(ty,pvfmm::bcast_intrin<Vec_t>(&src_coord[1][s]));
-        Vec_t dz=pvfmm::sub_intrin(tz,pvfmm::bcast_intrin<Vec_t>(&src_coord[2][s]));
-
-        Vec_t snx=pvfmm::bcast_intrin<Vec_t>(&src_value[0][s]) ;
-        Vec_t sny=pvfmm::bcast_intrin<Vec_t>(&src_value[1][s]) ;
-        Vec_t snz=pvfmm::bcast_intrin<Vec_t>(&src_value[2][s]) ;
-
-        Vec_t svx=pvfmm::bcast_intrin<Vec_t>(&src_value[3][s]) ;
-        Vec_t svy=pvfmm::bcast_intrin<Vec_t>(&src_value[4][s]) ;
-        Vec_t svz=pvfmm::bcast_intrin<Vec_t>(&src_value[5][s]) ;
-
-        Vec_t r2=               pvfmm::mul_intrin(dx,dx) ;
-        r2=pvfmm::add_intrin(r2,pvfmm::mul_intrin(dy,dy));
-        r2=pvfmm::add_intrin(r2,pvfmm::mul_intrin(dz,dz));
-        r2=pvfmm::and_intrin(pvfmm::cmplt_intrin(pvfmm::set_intrin<Vec_t,Real_t>(eps),r2),r2);
-
-        Vec_t rinv=RSQRT_INTRIN(r2);
-        Vec_t rinv2=pvfmm::mul_intrin(rinv ,rinv );
-        Vec_t rinv5=pvfmm::mul_intrin(pvfmm::mul_intrin(rinv2,rinv2),rinv);
-
-        Vec_t r_dot_n=                    pvfmm::mul_intrin(snx,dx) ;
-        r_dot_n=pvfmm::add_intrin(r_dot_n,pvfmm::mul_intrin(sny,dy));
-        r_dot_n=pvfmm::add_intrin(r_dot_n,pvfmm::mul_intrin(snz,dz));
-
-        Vec_t r_dot_f=                    pvfmm::mul_intrin(svx,dx) ;
-        r_dot_f=pvfmm::add_intrin(r_dot_f,pvfmm::mul_intrin(svy,dy));
-        r_dot_f=pvfmm::add_intrin(r_dot_f,pvfmm::mul_intrin(svz,dz));
-
-        Vec_t p=pvfmm::mul_intrin(pvfmm::mul_intrin(r_dot_n,r_dot_f),rinv5);
-        tvx=pvfmm::add_intrin(tvx,pvfmm::mul_intrin(dx,p));
-        tvy=pvfmm::add_intrin(tvy,pvfmm::mul_intrin(dy,p));
-        tvz=pvfmm::add_intrin(tvz,pvfmm::mul_intrin(dz,p));
-      }
-      Vec_t scal_const=pvfmm::set_intrin<Vec_t,Real_t>(SCAL_CONST);
-
-      tvx=pvfmm::add_intrin(pvfmm::mul_intrin(tvx,scal_const),pvfmm::load_intrin<Vec_t>(&trg_value[0][t]));
-      tvy=pvfmm::add_intrin(pvfmm::mul_intrin(tvy,scal_const),pvfmm::load_intrin<Vec_t>(&trg_value[1][t]));
-      tvz=pvfmm::add_intrin(pvfmm::mul_intrin(tvz,scal_const),pvfmm::load_intrin<Vec_t>(&trg_value[2][t]));
-
-      pvfmm::store_intrin(&trg_value[0][t],tvx);
-      pvfmm::store_intrin(&trg_value[1][t],tvy);
-      pvfmm::store_intrin(&trg_value[2][t],tvz);
-    }
-  }
-
-  { // Add FLOPS
-    #ifndef __MIC__
-    pvfmm::Profile::Add_FLOP((long long)trg_cnt_*(long long)src_cnt_*(31+4*(NWTN_ITER)));
-    #endif
-  }
-  #undef SRC_BLK
+  STOKES_KERNEL_DISPATCH(stokes_sl, T, newton_iter);
 }
 
 template <class T, int newton_iter=0>
 void stokes_dl(T* r_src, int src_cnt, T* v_src, int dof, T* r_trg, int trg_cnt, T* v_trg, pvfmm::mem::MemoryManager* mem_mgr){
-  #define STK_KER_NWTN(nwtn) if(newton_iter==nwtn) \
-        pvfmm::generic_kernel<Real_t, 6, 3, stokes_dl_uKernel<Real_t,Vec_t, pvfmm::rsqrt_intrin##nwtn<Vec_t,Real_t> > > \
-            ((Real_t*)r_src, src_cnt, (Real_t*)v_src, dof, (Real_t*)r_trg, trg_cnt, (Real_t*)v_trg, mem_mgr)
-  #define STOKES_KERNEL STK_KER_NWTN(0); STK_KER_NWTN(1); STK_KER_NWTN(2); STK_KER_NWTN(3);
-
-  if(pvfmm::mem::TypeTraits<T>::ID()==pvfmm::mem::TypeTraits<float>::ID()){
-    typedef float Real_t;
-    #if defined __MIC__
-      #define Vec_t Real_t
-    #elif defined __AVX__
-      #define Vec_t __m256
-    #elif defined __SSE3__
-      #define Vec_t __m128
-    #else
-      #define Vec_t Real_t
-    #endif
-    STOKES_KERNEL;
-    #undef Vec_t
-  }else if(pvfmm::mem::TypeTraits<T>::ID()==pvfmm::mem::TypeTraits<double>::ID()){
-    typedef double Real_t;
-    #if defined __MIC__
-      #define Vec_t Real_t
-    #elif defined __AVX__
-      #define Vec_t __m256d
-    #elif defined __SSE3__
-      #define Vec_t __m128d
-    #else
-      #define Vec_t Real_t
-    #endif
-    STOKES_KERNEL;
-    #undef Vec_t
-  }else{
-    typedef T Real_t;
-    #define Vec_t Real_t
-    STOKES_KERNEL;
-    #undef Vec_t
-  }
-
-  #undef STK_KER_NWTN
-  #undef STOKES_KERNEL
+  STOKES_KERNEL_DISPATCH(stokes_dl, T, newton_iter);
 }
 
+#undef STK_ISA_CASES
+#undef STOKES_KERNEL_ARGS
+#undef STOKES_KERNEL_DISPATCH
+
 template <class T>
 void stokes_vol_poten(const T* coord, int n, T* out){
   for(int i=0;i<n;i++){
@@ -427,17 +213,37 @@ void stokes_vol_poten(const T* coord, int n, T* out){
 
 
 template <class Real_t>
-inline const pvfmm::Kernel<Real_t>& StokesKernel<Real_t>::Kernel(){
-
-  static const pvfmm::Kernel<Real_t> ker_m2l=pvfmm::BuildKernel<Real_t, stokes_sl_m2l<Real_t,2>                      >("stokes_m2l", 3, std::pair<int,int>(4,3),
+template <int newton_iter>
+inline const pvfmm::Kernel<Real_t>& StokesKernel<Real_t>::Kernel_(){
+  // PVFMM identifies kernels (and their precomputed operators) by name, so
+  // each accuracy variant gets its own
+  static const char* m2l_name[4]={"stokes_m2l_nwtn0", "stokes_m2l_nwtn1", "stokes_m2l_nwtn2", "stokes_m2l_nwtn3"};
+  static const char* vel_name[4]={"stokes_vel_nwtn0", "stokes_vel_nwtn1", "stokes_vel_nwtn2", "stokes_vel_nwtn3"};
+
+  static const pvfmm::Kernel<Real_t> ker_m2l=pvfmm::BuildKernel<Real_t, stokes_sl_m2l<Real_t,newton_iter>                               >(m2l_name[newton_iter], 3, std::pair<int,int>(4,3),
       NULL,NULL,NULL,     NULL,    NULL,    NULL, NULL,NULL, stokes_m2l_vol_poten);
 
-  static const pvfmm::Kernel<Real_t> ker    =pvfmm::BuildKernel<Real_t, stokes_sl    <Real_t,2>, stokes_dl<Real_t,2> >("stokes_vel", 3, std::pair<int,int>(3,3),
+  static const pvfmm::Kernel<Real_t> ker    =pvfmm::BuildKernel<Real_t, stokes_sl    <Real_t,newton_iter>, stokes_dl<Real_t,newton_iter> >(vel_name[newton_iter], 3, std::pair<int,int>(3,3),
       NULL,NULL,NULL, &ker_m2l,&ker_m2l,&ker_m2l, NULL,NULL, stokes_vol_poten    );
 
   return ker;
 }
 
+template <class Real_t>
+inline const pvfmm::Kernel<Real_t>& StokesKernel<Real_t>::Kernel(){
+  return Kernel_<2>();
+}
+
+template <class Real_t>
+inline const pvfmm::Kernel<Real_t>& StokesKernel<Real_t>::Kernel(Real_t tol){
+  switch(StokesNewtonIter<Real_t>(tol, StokesGetISA())){
+    case 0: return Kernel_<0>();
+    case 1: return Kernel_<1>();
+    case 2: return Kernel_<2>();
+    default: return Kernel_<3>();
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -983,62 +789,140 @@ void PVFMMEval(const T* src_pos, const T* sl_den, const T* dl_den, size_t n_src,
 
 template<typename T>
 void PVFMM_GlobalRepart(size_t nv, size_t stride,
-    const T* x, const T* tension, size_t* nvr, T** xr,
-    T** tensionr, void* user_ptr){
-  assert(false); // I think this doesn't work
-  exit(0);
-
+    const T* x, const T* tension, const T* weight,
+    size_t data_dof, const T* data, size_t* nvr, T** xr,
+    T** tensionr, T** datar, void** context){
   MPI_Comm comm=MPI_COMM_WORLD;
+  int np, rank;
+  MPI_Comm_size(comm,&np);
+  MPI_Comm_rank(comm,&rank);
+
+  // Vesicle centers (x is stored per vesicle as [x_0..x_stride, y_0.., z_0..])
+  std::vector<T> x_ves(nv*COORD_DIM);
+  double loc_min_x[COORD_DIM], loc_max_x[COORD_DIM];
+  for(size_t k=0;k<COORD_DIM;k++){
+    loc_min_x[k]= std::numeric_limits<double>::max();
+    loc_max_x[k]=-std::numeric_limits<double>::max();
+  }
+  for(size_t i=0;i<nv;i++){
+    for(size_t k=0;k<COORD_DIM;k++){
+      const T* x_=&x[(i*COORD_DIM+k)*stride];
+      double sum=0;
+      for(size_t j=0;j<stride;j++) sum+=x_[j];
+      x_ves[i*COORD_DIM+k]=sum/stride;
+      loc_min_x[k]=std::min(loc_min_x[k],sum/stride);
+      loc_max_x[k]=std::max(loc_max_x[k],sum/stride);
+    }
+  }
 
-  // Get bounding box.
+  // Bounding box of the centers (not PVFMMBoundingBox, which skips
+  // the reduction on ranks without vesicles)
   T scale_x, shift_x[COORD_DIM];
-  PVFMMBoundingBox(nv*stride, x, &scale_x, shift_x, comm);
+  { // Compute bounding box
+    double min_x[COORD_DIM], max_x[COORD_DIM];
+    MPI_Allreduce(loc_min_x, min_x, COORD_DIM, MPI_DOUBLE, MPI_MIN, comm);
+    MPI_Allreduce(loc_max_x, max_x, COORD_DIM, MPI_DOUBLE, MPI_MAX, comm);
+
+    double len=0;
+    for(size_t k=0;k<COORD_DIM;k++) len=std::max(len,max_x[k]-min_x[k]);
+    scale_x=(len>0?0.5/len:1.0); // centers in [0.25,0.75]
+    for(size_t k=0;k<COORD_DIM;k++) shift_x[k]=0.25-min_x[k]*scale_x;
+  }
 
   pvfmm::Vector<pvfmm::MortonId> ves_mid(nv);
   { // Create MortonIds for vesicles.
-    scale_x/=stride;
     #pragma omp parallel for
     for(size_t i=0;i<nv;i++){
-      T  x_ves[3]={0,0,0};
-      const T* x_=&x[i*COORD_DIM*stride];
-      for(size_t j=0;j<stride;j++){
-        for(size_t k=0;k<COORD_DIM;k++){
-          x_ves[k]+=x_[0];
-          ++x_;
-        }
-      }
+      T c[COORD_DIM];
       for(size_t k=0;k<COORD_DIM;k++){
-        x_ves[k]=x_ves[k]*scale_x+shift_x[k];
-        assert(x_ves[k]>0.0);
-        assert(x_ves[k]<1.0);
+        c[k]=x_ves[i*COORD_DIM+k]*scale_x+shift_x[k];
+        assert(c[k]>0.0);
+        assert(c[k]<1.0);
       }
-      ves_mid[i]=pvfmm::MortonId(x_ves);
+      ves_mid[i]=pvfmm::MortonId(c);
     }
   }
 
-  // Determine scatter index vector.
+  // Sort by MortonId (equal number of vesicles per rank)
   pvfmm::Vector<size_t> scatter_index;
   pvfmm::par::SortScatterIndex(ves_mid, scatter_index, comm);
 
+  // Cost of the vesicles in sorted order
+  pvfmm::Vector<T> w_sorted(nv);
+  for(size_t i=0;i<nv;i++) w_sorted[i]=(weight?weight[i]:1.0);
+  double cost_before=0;
+  for(size_t i=0;i<nv;i++) cost_before+=w_sorted[i];
+  pvfmm::par::ScatterForward(w_sorted, scatter_index, comm);
+
+  // Split the sorted sequence into np pieces of equal cost
+  pvfmm::Vector<size_t> new_index;
+  { // Compute new_index
+    long n_sorted=scatter_index.Dim();
+    double w_loc=0, w_scan=0, w_glb=0;
+    for(long i=0;i<n_sorted;i++) w_loc+=w_sorted[i];
+    MPI_Scan(&w_loc, &w_scan, 1, MPI_DOUBLE, MPI_SUM, comm);
+    MPI_Allreduce(&w_loc, &w_glb, 1, MPI_DOUBLE, MPI_SUM, comm);
+
+    std::vector<int> send_cnt(np,0), recv_cnt(np,0), send_dsp(np,0), recv_dsp(np,0);
+    double w_pre=w_scan-w_loc;
+    for(long i=0;i<n_sorted;i++){
+      double mid=w_pre+0.5*w_sorted[i];
+      int dest=(w_glb>0?(int)(mid*np/w_glb):0);
+      dest=std::max(0,std::min(np-1,dest));
+      send_cnt[dest]+=sizeof(size_t);
+      w_pre+=w_sorted[i];
+    }
+    MPI_Alltoall(&send_cnt[0], 1, MPI_INT, &recv_cnt[0], 1, MPI_INT, comm);
+    for(int r=1;r<np;r++){
+      send_dsp[r]=send_dsp[r-1]+send_cnt[r-1];
+      recv_dsp[r]=recv_dsp[r-1]+recv_cnt[r-1];
+    }
+    new_index.ReInit((recv_dsp[np-1]+recv_cnt[np-1])/sizeof(size_t));
+    MPI_Alltoallv((n_sorted?&scatter_index[0]:NULL), &send_cnt[0], &send_dsp[0], MPI_BYTE,
+                  (new_index.Dim()?&new_index[0]:NULL), &recv_cnt[0], &recv_dsp[0], MPI_BYTE, comm);
+  }
+
   // Allocate memory for output.
-  nvr[0]=scatter_index.Dim();
+  nvr[0]=new_index.Dim();
   xr      [0]=new T[nvr[0]*stride*COORD_DIM];
   tensionr[0]=new T[nvr[0]*stride          ];
+  datar   [0]=(data_dof?new T[nvr[0]*data_dof]:NULL);
 
   { // Scatter x
     pvfmm::Vector<T> data(nv*stride*COORD_DIM,(T*)x);
-    pvfmm::par::ScatterForward(data, scatter_index, comm);
+    pvfmm::par::ScatterForward(data, new_index, comm);
 
     assert(data.Dim()==nvr[0]*stride*COORD_DIM);
-    memcpy(xr[0],&data[0],data.Dim()*sizeof(T));
+    if(data.Dim()) memcpy(xr[0],&data[0],data.Dim()*sizeof(T));
   }
 
   { // Scatter tension
     pvfmm::Vector<T> data(nv*stride,(T*)tension);
-    pvfmm::par::ScatterForward(data, scatter_index, comm);
+    pvfmm::par::ScatterForward(data, new_index, comm);
 
     assert(data.Dim()==nvr[0]*stride);
-    memcpy(tensionr[0],&data[0],data.Dim()*sizeof(T));
+    if(data.Dim()) memcpy(tensionr[0],&data[0],data.Dim()*sizeof(T));
+  }
+
+  if(data_dof){ // Scatter vesicle data
+    pvfmm::Vector<T> vdata(nv*data_dof,(T*)data);
+    pvfmm::par::ScatterForward(vdata, new_index, comm);
+
+    assert(vdata.Dim()==nvr[0]*data_dof);
+    if(vdata.Dim()) memcpy(datar[0],&vdata[0],vdata.Dim()*sizeof(T));
+  }
+
+  { // Report the imbalance (max/mean cost) before and after
+    pvfmm::Vector<T> w(nv);
+    for(size_t i=0;i<nv;i++) w[i]=(weight?weight[i]:1.0);
+    pvfmm::par::ScatterForward(w, new_index, comm);
+    double cost[2]={cost_before,0}, cost_max[2], cost_sum[2];
+    for(size_t i=0;i<w.Dim();i++) cost[1]+=w[i];
+    MPI_Allreduce(cost, cost_max, 2, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(cost, cost_sum, 2, MPI_DOUBLE, MPI_SUM, comm);
+    if(!rank && cost_sum[0]>0)
+      INFO("Repartition: load imbalance (max/mean cost) "<<cost_max[0]*np/cost_sum[0]
+          <<" -> "<<cost_max[1]*np/cost_sum[1]);
   }
 }
 
@@ -443,7 +443,10 @@ PetscErrorCode PetscMatvecWrapper(Mat A, Vec x, Vec y){
 template<typename T>
 ParallelLinSolverPetsc<T>::ParallelLinSolverPetsc(MPI_Comm &comm) :
     comm_(&comm),
-    precond_(NULL)
+    precond_(NULL),
+    recycle_size_(0),
+    rnorm_(0),
+    rnorm0_(0)
 {
     COUTDEBUG("Creating a parallel linear solver");
     ierr = KSPCreate(*comm_, &ps_); CHK_PETSC(ierr);
@@ -455,6 +458,7 @@ ParallelLinSolverPetsc<T>::~ParallelLinSolverPetsc()
     const char *name;
     ierr = PetscObjectGetName((PetscObject) ps_, &name); CHK_PETSC(ierr);
     COUTDEBUG("Destroying a parallel linear solver (name: "<<name<<")");
+    ClearRecycle();
     ierr = KSPDestroy(&ps_); CHK_PETSC(ierr);
 }
 
@@ -486,6 +490,7 @@ Error_t  ParallelLinSolverPetsc<T>::SetOperator(matvec_type *mv)
     ASSERT(comm_==mv->MPIComm(), "Operator should have the same MPI communicator");
 
     mv_ = static_cast<petsc_matvec_type*>(mv);
+    CHK(ClearRecycle());
 #if PETSC_VERSION<35
     ierr = KSPSetOperators(ps_, mv_->PetscMat(), mv_->PetscMat(), SAME_PRECONDITIONER); CHK_PETSC(ierr);
 #else
@@ -547,7 +552,7 @@ Error_t  ParallelLinSolverPetsc<T>::Configure()
     COUTDEBUG("Configuring the linear solver");
     ierr = KSPSetFromOptions(ps_); CHK_PETSC(ierr);
     ierr = KSPGMRESSetRestart(ps_, 1000); CHK_PETSC(ierr);
-    ierr = KSPMonitorSet(ps_, PetscKSPMonitor<T>,NULL, NULL);  CHK_PETSC(ierr);
+    ierr = KSPMonitorSet(ps_, PetscKSPMonitor<T>, (void*) this, NULL);  CHK_PETSC(ierr);
     return ErrorEvent::Success;
 }
 
@@ -558,6 +563,18 @@ Error_t ParallelLinSolverPetsc<T>::InitialGuessNonzero(bool flg) const
     return ErrorEvent::Success;
 }
 
+template<typename T>
+Error_t ParallelLinSolverPetsc<T>::SetRecycleSize(size_t k)
+{
+    COUTDEBUG("Setting the recycle size to "<<k);
+    recycle_size_ = k;
+    while (recycle_.size()>recycle_size_){
+        ierr = VecDestroy(&recycle_.front()); CHK_PETSC(ierr);
+        recycle_.erase(recycle_.begin());
+    }
+    return ErrorEvent::Success;
+}
+
 template<typename T>
 Error_t ParallelLinSolverPetsc<T>::VecFactory(vec_type **newvec) const
 {
@@ -597,7 +614,22 @@ Error_t  ParallelLinSolverPetsc<T>::Solve(const vec_type *rhs, vec_type *x) cons
     COUTDEBUG("Solving the linear system");
     const petsc_vec_type* rp = static_cast<const petsc_vec_type*>(rhs);
     petsc_vec_type* xp = static_cast<petsc_vec_type*>(x);
+
+    // unknown until the monitor reports the initial residual
+    rnorm_ = rnorm0_ = 0;
+
+    PetscBool nonzero;
+    ierr = KSPGetInitialGuessNonzero(ps_, &nonzero); CHK_PETSC(ierr);
+    if (!recycle_.empty()){
+        CHK(ProjectGuess(rp->PetscVec(), xp->PetscVec(), nonzero));
+        ierr = KSPSetInitialGuessNonzero(ps_, PETSC_TRUE); CHK_PETSC(ierr);
+    }
+
     ierr = KSPSolve(ps_, rp->PetscVec(), xp->PetscVec()); CHK_PETSC(ierr);
+    ierr = KSPSetInitialGuessNonzero(ps_, nonzero); CHK_PETSC(ierr);
+
+    if (recycle_size_>0)
+        CHK(UpdateRecycle(xp->PetscVec()));
 
     PetscReal res(1.0),nrm(0);
     PetscReal rtol(0), atol(0), dtol(0);
@@ -620,6 +652,14 @@ Error_t  ParallelLinSolverPetsc<T>::IterationNumber(size_t &niter) const
     return ErrorEvent::Success;
 }
 
+template<typename T>
+Error_t  ParallelLinSolverPetsc<T>::ResidualNorm(value_type &rnorm, value_type &rnorm0) const
+{
+    rnorm  = rnorm_;
+    rnorm0 = rnorm0_;
+    return ErrorEvent::Success;
+}
+
 template<typename T>
 Error_t  ParallelLinSolverPetsc<T>::ViewReport() const
 {
@@ -655,6 +695,147 @@ Error_t  ParallelLinSolverPetsc<T>::OperatorResidual(const vec_type *rhs,
     return ErrorEvent::Success;
 }
 
+/*
+ * The guess is replaced by the minimizer of |b-Ax| over the span of
+ * the recycled vectors (and the guess itself when nonzero). The
+ * images of the basis are computed with the current operator, which
+ * changes between solves, so this costs one matvec per basis vector;
+ * the images are orthonormalized by modified Gram-Schmidt and the
+ * coefficients follow from the triangular factor.
+ */
+template<typename T>
+Error_t ParallelLinSolverPetsc<T>::ProjectGuess(const Vec &b, Vec &x,
+    bool nonzero) const
+{
+    PetscInt lsz, rsz;
+    ierr = VecGetLocalSize(x, &lsz); CHK_PETSC(ierr);
+    ierr = VecGetLocalSize(recycle_[0], &rsz); CHK_PETSC(ierr);
+    if (lsz!=rsz){
+        COUTDEBUG("Size of the recycled space does not match the solution (cleared)");
+        return ClearRecycle();
+    }
+
+    std::vector<Vec> V, AV;
+    if (nonzero) V.push_back(x);
+    V.insert(V.end(), recycle_.begin(), recycle_.end());
+    size_t m(V.size());
+
+    AV.resize(m);
+    for (size_t j(0); j<m; ++j){
+        ierr = VecDuplicate(b, &AV[j]); CHK_PETSC(ierr);
+        ierr = MatMult(mv_->PetscMat(), V[j], AV[j]); CHK_PETSC(ierr);
+    }
+
+    PetscReal bnrm, r0;
+    ierr = VecNorm(b, NORM_2, &bnrm); CHK_PETSC(ierr);
+    r0 = bnrm;
+    if (nonzero){
+        Vec r;
+        ierr = VecDuplicate(b, &r); CHK_PETSC(ierr);
+        ierr = VecWAXPY(r, -1.0, AV[0], b); CHK_PETSC(ierr);
+        ierr = VecNorm(r, NORM_2, &r0); CHK_PETSC(ierr);
+        ierr = VecDestroy(&r); CHK_PETSC(ierr);
+    }
+
+    std::vector<PetscScalar> R(m*m, 0), h(m, 0), c(m, 0);
+    std::vector<bool> keep(m, false);
+    PetscReal hnrm(0);
+    for (size_t j(0); j<m; ++j){
+        PetscReal nrm0, nrm;
+        ierr = VecNorm(AV[j], NORM_2, &nrm0); CHK_PETSC(ierr);
+        for (size_t i(0); i<j; ++i){
+            if (!keep[i]) continue;
+            ierr = VecDot(AV[j], AV[i], &R[i*m+j]); CHK_PETSC(ierr);
+            ierr = VecAXPY(AV[j], -R[i*m+j], AV[i]); CHK_PETSC(ierr);
+        }
+        ierr = VecNorm(AV[j], NORM_2, &nrm); CHK_PETSC(ierr);
+
+        // skip the directions that are (numerically) in the span of the others
+        if (nrm<=1e-10*nrm0 || nrm==0) continue;
+        keep[j]    = true;
+        R[j*m+j]   = nrm;
+        ierr = VecScale(AV[j], 1.0/nrm); CHK_PETSC(ierr);
+        ierr = VecDot(b, AV[j], &h[j]); CHK_PETSC(ierr);
+        hnrm += h[j]*h[j];
+    }
+
+    for (int j(m-1); j>=0; --j){
+        if (!keep[j]) continue;
+        c[j] = h[j];
+        for (size_t i(j+1); i<m; ++i)
+            if (keep[i]) c[j] -= R[j*m+i]*c[i];
+        c[j] /= R[j*m+j];
+    }
+
+    Vec y;
+    ierr = VecDuplicate(x, &y); CHK_PETSC(ierr);
+    ierr = VecSet(y, 0.0); CHK_PETSC(ierr);
+    ierr = VecMAXPY(y, m, &c[0], &V[0]); CHK_PETSC(ierr);
+    ierr = VecCopy(y, x); CHK_PETSC(ierr);
+    ierr = VecDestroy(&y); CHK_PETSC(ierr);
+
+    for (size_t j(0); j<m; ++j){
+        ierr = VecDestroy(&AV[j]); CHK_PETSC(ierr);
+    }
+
+    INFO("Projection on "<<recycle_.size()<<" recycled vector(s) reduced the initial residual from "
+        <<SCI_PRINT_FRMT<<r0<<" to "<<std::sqrt(std::max(bnrm*bnrm-hnrm, (PetscReal) 0))
+        <<" ("<<m<<" matvecs)");
+
+    return ErrorEvent::Success;
+}
+
+template<typename T>
+Error_t ParallelLinSolverPetsc<T>::UpdateRecycle(const Vec &x) const
+{
+    if (!recycle_.empty()){
+        PetscInt lsz, rsz;
+        ierr = VecGetLocalSize(x, &lsz); CHK_PETSC(ierr);
+        ierr = VecGetLocalSize(recycle_[0], &rsz); CHK_PETSC(ierr);
+        if (lsz!=rsz) CHK(ClearRecycle());
+    }
+
+    Vec w;
+    PetscReal nrm0, nrm;
+    ierr = VecDuplicate(x, &w); CHK_PETSC(ierr);
+    ierr = VecCopy(x, w); CHK_PETSC(ierr);
+    ierr = VecNorm(w, NORM_2, &nrm0); CHK_PETSC(ierr);
+
+    // two passes of Gram-Schmidt keep the basis orthonormal
+    for (int pass(0); pass<2; ++pass)
+        for (size_t i(0); i<recycle_.size(); ++i){
+            PetscScalar d;
+            ierr = VecDot(w, recycle_[i], &d); CHK_PETSC(ierr);
+            ierr = VecAXPY(w, -d, recycle_[i]); CHK_PETSC(ierr);
+        }
+    ierr = VecNorm(w, NORM_2, &nrm); CHK_PETSC(ierr);
+
+    if (nrm<=1e-10*nrm0 || nrm==0){
+        COUTDEBUG("The solution is in the recycled space (not added)");
+        ierr = VecDestroy(&w); CHK_PETSC(ierr);
+        return ErrorEvent::Success;
+    }
+
+    ierr = VecScale(w, 1.0/nrm); CHK_PETSC(ierr);
+    if (recycle_.size()>=recycle_size_){
+        ierr = VecDestroy(&recycle_.front()); CHK_PETSC(ierr);
+        recycle_.erase(recycle_.begin());
+    }
+    recycle_.push_back(w);
+
+    return ErrorEvent::Success;
+}
+
+template<typename T>
+Error_t ParallelLinSolverPetsc<T>::ClearRecycle() const
+{
+    for (size_t i(0); i<recycle_.size(); ++i){
+        ierr = VecDestroy(&recycle_[i]); CHK_PETSC(ierr);
+    }
+    recycle_.clear();
+    return ErrorEvent::Success;
+}
+
 template<typename T>
 const MPI_Comm* ParallelLinSolverPetsc<T>::MPIComm() const
 {
@@ -704,7 +885,12 @@ PetscErrorCode PetscPrecondWrapper(PC P, Vec x, Vec y){
 
 
 template<typename T>
-PetscErrorCode PetscKSPMonitor(KSP K,PetscInt n, PetscReal rnorm, void *dummy){
+PetscErrorCode PetscKSPMonitor(KSP K,PetscInt n, PetscReal rnorm, void *ctx){
+    const ParallelLinSolverPetsc<T> *solver(static_cast<const ParallelLinSolverPetsc<T>*>(ctx));
+    if (solver){
+        if (n==0) solver->rnorm0_ = rnorm;
+        solver->rnorm_ = rnorm;
+    }
     INFO("KSP residual norm at iteration "<<n<<": "<<SCI_PRINT_FRMT<<rnorm);
     return 0;
 }
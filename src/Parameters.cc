@@ -20,10 +20,12 @@ template<typename T>
 void Parameters<T>::init()
 {
     // ordered alphabetically
+    async_io                = false;
     bending_modulus         = 1e-2;
     bg_flow                 = ShearFlow;
     bg_flow_param           = 1e-1;
     checkpoint              = false;
+    checkpoint_format       = Streamable::ASCII;
     checkpoint_stride	    = -1;
     error_factor            = 1;
     excess_density          = 0.0;
@@ -31,8 +33,16 @@ void Parameters<T>::init()
     gravity_field[0]        = 0;
     gravity_field[1]        = 0;
     gravity_field[2]        = -1.0;
+    inexact_krylov          = false;
+    init_min_sep            = 0.1;
+    init_seed               = 1;
+    init_volume_fraction    = 0;
     interaction_upsample    = false;
+    mats_io                 = TextMatsIO;
+    mixed_precision         = false;
+    fmm_overlap             = false;
     n_surfs                 = 1;
+    near_skin               = 0;
     num_threads             = -1;
     periodic_length         = -1;
     pseudospectral          = false;
@@ -43,14 +53,20 @@ void Parameters<T>::init()
     rep_ts                  = -1.0;
     rep_type                = PolyKReparam;
     rep_upsample            = false;
+    repartition_stride      = 0;
     repul_dist              = 5e-2;
     scheme                  = JacobiBlockImplicit;
+    self_op                 = FullSelfOp;
     sh_order                = 12;
+    sht_dft                 = GemmDFT;
+    solver_guess            = PreviousGuess;
+    solver_recycle          = 0;
     singular_stokes         = ViaSpHarm;
     solve_for_velocity      = false;
     time_adaptive           = false;
     time_horizon            = 1;
     time_iter_max           = 100;
+    time_order              = 1;
     time_precond            = NoPrecond;
     time_tol                = 1e-6;
     ts                      = 1;
@@ -126,6 +142,7 @@ Error_t Parameters<T>::expand_templates(const DictString_t *dict){
     CHK(::expand_template(&shape_gallery_file    , d));
     CHK(::expand_template(&vesicle_props_file    , d));
     CHK(::expand_template(&vesicle_geometry_file , d));
+    CHK(::expand_template(&init_geometry_out     , d));
     CHK(::expand_template(&checkpoint_file_name  , d));
     CHK(::expand_template(&load_checkpoint       , d));
     CHK(::expand_template(&write_vtk             , d));
@@ -161,6 +178,10 @@ void Parameters<T>::setUsage(AnyOption *opt)
     opt->addUsage( "          --shape-gallery-file     The possible shapes of vesicles");
     opt->addUsage( "          --vesicle-geometry-file  Each line defines a vesicle by the index of a shape in the shape gallery file, the location, and the scale (for all MPI processes)");
     opt->addUsage( "          --vesicle-props-file     The physical properties of each vesicle (overrides commandline)");
+    opt->addUsage( "          --init-volume-fraction   Generate the vesicles at this volume fraction instead of reading the geometry file" );
+    opt->addUsage( "          --init-min-sep           The minimum distance between the generated vesicles" );
+    opt->addUsage( "          --init-seed              The seed of the generator (the suspension also depends on the number of processes)" );
+    opt->addUsage( "          --init-geometry-out      Write the generated geometry to this (table) file" );
     opt->addUsage( "" );
     opt->addUsage( "  Physical properties for all (for more control use vesicle-props-file):" );
     opt->addUsage( "          --bending-modulus        The bending modulus of the interfaces" );
@@ -171,12 +192,20 @@ void Parameters<T>::setUsage(AnyOption *opt)
     opt->addUsage( "  Time stepping:" );
     opt->addUsage( "          --error-factor           The permissible increase factor in error");
     opt->addUsage( "          --pseudospectral     [F] Form and solve the system for function values on grid points (otherwise Galerkin)" );
+    opt->addUsage( "          --self-op                Storage of the self-interaction operator [Full|Single|MatFree]" );
+    opt->addUsage( "          --near-skin              Reuse the near-singular setup while points move less than skin*r_near (0 to disable)" );
     opt->addUsage( "          --singular-stokes        The scheme for the singular stokes evaluation" );
     opt->addUsage( "          --solve-for-velocity [F] If true, set up the linear system to solve for velocity and tension otherwise for position" );
     opt->addUsage( "          --time-adaptive      [F] Use adaptive time-stepping" );
     opt->addUsage( "          --time-horizon           The time horizon of the simulation" );
     opt->addUsage( "          --time-iter-max          Maximum number of iteration for the choice of time stepper" );
+    opt->addUsage( "          --time-order             The order of the time stepping [1|2] (2 is BDF2, GloballyImplicit only)" );
     opt->addUsage( "          --time-precond           The type of preconditioner to use" );
+    opt->addUsage( "          --solver-guess           Initial guess of the implicit solve [Zero|Previous|Extrapolate]" );
+    opt->addUsage( "          --solver-recycle         Number of previous solutions kept to project the initial guess (0, the default, disables it; costs k+1 matvecs per solve)" );
+    opt->addUsage( "          --inexact-krylov     [F] Relax the far-field accuracy of the matvec as the implicit solve converges" );
+    opt->addUsage( "          --mixed-precision    [F] Evaluate the Stokes potentials of the implicit matvec in single precision" );
+    opt->addUsage( "          --fmm-overlap        [F] Evaluate the far field concurrently with the self and near interactions" );
     opt->addUsage( "          --time-scheme            The time stepping scheme" );
     opt->addUsage( "          --time-tol               The desired error tolerance in the time stepping" );
     opt->addUsage( "          --timestep               The time step size" );
@@ -194,6 +223,8 @@ void Parameters<T>::setUsage(AnyOption *opt)
     opt->addUsage( "          --sh-order               The spherical harmonics order (if set, other frequencies, which are not set explicitly, are adjusted)" );
     opt->addUsage( "          --filter-freq            The differentiation filter frequency" );
     opt->addUsage( "          --upsample-freq          The upsample frequency used for reparametrization and interaction" );
+    opt->addUsage( "          --sht-dft                The longitudinal transform in spherical harmonics [Gemm|FFT]" );
+    opt->addUsage( "          --mats-io                Loading of the precomputed matrices [Text|Cache|Bcast]" );
     opt->addUsage( "          --interaction-upsample [F] To whether upsample (and filter) the interaction force" );
     opt->addUsage( "" );
     opt->addUsage( "  Background flow:" );
@@ -205,10 +236,13 @@ void Parameters<T>::setUsage(AnyOption *opt)
     opt->addUsage( "      -s  --checkpoint         [F] Flag to save data to file" );
     opt->addUsage( "      -o  --checkpoint-file        The output file *template*");
     opt->addUsage( "          --checkpoint-stride      The frequency of saving to file (in time scale)" );
+    opt->addUsage( "          --checkpoint-format      Checkpoint file format [ASCII|BIN] (BIN is one shared file, no {{rank}} needed)" );
     opt->addUsage( "          --write-vtk              Write VTK file along with checkpoint" );
+    opt->addUsage( "          --async-io           [F] Write checkpoint and VTK files from a background thread" );
     opt->addUsage( "" );
     opt->addUsage( "  Miscellaneous:" );
     opt->addUsage( "          --num-threads            The number OpenMP threads" );
+    opt->addUsage( "          --repartition-stride     Balance the vesicles between processes every given steps (0 to disable)" );
     opt->addUsage( "" );
 }
 
@@ -221,11 +255,15 @@ void Parameters<T>::setOptions(AnyOption *opt)
     // a flag (takes no argument), supporting long and short forms
     opt->setCommandFlag( "help", 'h' );
     opt->setFlag( "checkpoint", 's' );
+    opt->setFlag( "async-io" );
     opt->setFlag( "interaction-upsample" );
     opt->setFlag( "rep-upsample" );
     opt->setFlag( "solve-for-velocity" );
     opt->setFlag( "pseudospectral" );
     opt->setFlag( "time-adaptive" );
+    opt->setFlag( "inexact-krylov" );
+    opt->setFlag( "mixed-precision" );
+    opt->setFlag( "fmm-overlap" );
     opt->setOption( "write-vtk" );
 
     //an option (takes an argument), supporting long and short forms
@@ -240,10 +278,15 @@ void Parameters<T>::setOptions(AnyOption *opt)
     opt->setOption( "bg-flow-type" );
     opt->setOption( "vesicle-geometry-file");
     opt->setOption( "vesicle-props-file");
+    opt->setOption( "init-volume-fraction" );
+    opt->setOption( "init-min-sep" );
+    opt->setOption( "init-seed" );
+    opt->setOption( "init-geometry-out" );
     opt->setOption( "error-factor" );
     opt->setOption( "filter-freq" );
     opt->setOption( "n-surfs" );
     opt->setOption( "num-threads" );
+    opt->setOption( "repartition-stride" );
     opt->setOption( "periodic-length" );
 
     opt->setOption( "rep-type" );
@@ -254,13 +297,21 @@ void Parameters<T>::setOptions(AnyOption *opt)
     opt->setOption( "rep-exponent" );
 
     opt->setOption( "repul-dist" );
+    opt->setOption( "near-skin" );
 
     opt->setOption( "checkpoint-stride" );
+    opt->setOption( "checkpoint-format" );
     opt->setOption( "sh-order" );
+    opt->setOption( "sht-dft" );
+    opt->setOption( "mats-io" );
+    opt->setOption( "self-op" );
     opt->setOption( "singular-stokes" );
     opt->setOption( "time-horizon" );
     opt->setOption( "time-iter-max" );
+    opt->setOption( "time-order" );
     opt->setOption( "time-precond" );
+    opt->setOption( "solver-guess" );
+    opt->setOption( "solver-recycle" );
     opt->setOption( "time-scheme" );
     opt->setOption( "time-tol" );
     opt->setOption( "timestep" );
@@ -284,6 +335,9 @@ void Parameters<T>::getOptionValues(AnyOption *opt)
     if( opt->getFlag( "checkpoint" ) || opt->getFlag( 's' ) )
         checkpoint = true;
 
+    if( opt->getFlag( "async-io" ) )
+        async_io = true;
+
     if( opt->getFlag( "interaction-upsample" ) )
         interaction_upsample = true;
 
@@ -299,6 +353,15 @@ void Parameters<T>::getOptionValues(AnyOption *opt)
     if( opt->getFlag( "time-adaptive" ) )
         time_adaptive = true;
 
+    if( opt->getFlag( "inexact-krylov" ) )
+        inexact_krylov = true;
+
+    if( opt->getFlag( "mixed-precision" ) )
+        mixed_precision = true;
+
+    if( opt->getFlag( "fmm-overlap" ) )
+        fmm_overlap = true;
+
     if( opt->getValue( "write-vtk" ) !=NULL )
         write_vtk = opt->getValue( "write-vtk" );
 
@@ -322,6 +385,14 @@ void Parameters<T>::getOptionValues(AnyOption *opt)
     if( opt->getValue( "upsample-freq" ) != NULL  )
         upsample_freq =  atoi(opt->getValue( "upsample-freq" ));
 
+    if( opt->getValue( "sht-dft" ) != NULL  )
+        sht_dft = EnumifyDFT(opt->getValue( "sht-dft" ));
+    ASSERT(sht_dft != UnknownDFT, "Failed to parse the SHT transform type");
+
+    if( opt->getValue( "mats-io" ) != NULL  )
+        mats_io = EnumifyMatsIO(opt->getValue( "mats-io" ));
+    ASSERT(mats_io != UnknownMatsIO, "Failed to parse the matrices IO mode");
+
     if( opt->getValue( "filter-freq" ) != NULL  )
         filter_freq =  atoi(opt->getValue( "filter-freq" ));
 
@@ -360,6 +431,20 @@ void Parameters<T>::getOptionValues(AnyOption *opt)
     if( opt->getValue( "vesicle-geometry-file") !=NULL )
         vesicle_geometry_file = opt->getValue( "vesicle-geometry-file" );
 
+    if( opt->getValue( "init-volume-fraction" ) != NULL  )
+        init_volume_fraction =  atof(opt->getValue( "init-volume-fraction" ));
+    ASSERT(init_volume_fraction>=0 && init_volume_fraction<1,
+        "The initial volume fraction should be in [0,1)");
+
+    if( opt->getValue( "init-min-sep" ) != NULL  )
+        init_min_sep =  atof(opt->getValue( "init-min-sep" ));
+
+    if( opt->getValue( "init-seed" ) != NULL  )
+        init_seed =  atoi(opt->getValue( "init-seed" ));
+
+    if( opt->getValue( "init-geometry-out" ) != NULL  )
+        init_geometry_out = opt->getValue( "init-geometry-out" );
+
     if( opt->getValue( "error-factor" ) != NULL  )
         error_factor =  atof(opt->getValue( "error-factor" ));
 
@@ -369,6 +454,10 @@ void Parameters<T>::getOptionValues(AnyOption *opt)
     if( opt->getValue( "num-threads" ) != NULL  )
         num_threads =  atoi(opt->getValue( "num-threads" ));
 
+    if( opt->getValue( "repartition-stride" ) != NULL  )
+        repartition_stride =  atoi(opt->getValue( "repartition-stride" ));
+    ASSERT(repartition_stride>=0, "The repartition stride should be non-negative");
+
     if( opt->getValue( "rep-type"  ) != NULL  )
         rep_type = EnumifyReparam(opt->getValue( "rep-type" ));
     ASSERT(rep_type != UnknownReparam, "Failed to parse the reparametrization type");
@@ -385,9 +474,16 @@ void Parameters<T>::getOptionValues(AnyOption *opt)
     if( opt->getValue( "repul-dist" ) != NULL  )
         repul_dist =  atof(opt->getValue( "repul-dist" ));
 
+    if( opt->getValue( "near-skin" ) != NULL  )
+        near_skin =  atof(opt->getValue( "near-skin" ));
+    ASSERT(near_skin>=0, "The near skin should be non-negative");
+
     if( opt->getValue( "checkpoint-stride" ) != NULL  )
         checkpoint_stride =  atof(opt->getValue( "checkpoint-stride" ));
 
+    if( opt->getValue( "checkpoint-format" ) != NULL  )
+        checkpoint_format = EnumifyFormat(opt->getValue( "checkpoint-format" ));
+
     if( opt->getValue( "time-scheme" ) != NULL  )
         scheme = EnumifyScheme(opt->getValue( "time-scheme" ));
     ASSERT(scheme != UnknownScheme, "Failed to parse the time scheme name");
@@ -396,6 +492,18 @@ void Parameters<T>::getOptionValues(AnyOption *opt)
         time_precond = EnumifyPrecond(opt->getValue( "time-precond" ));
     ASSERT(time_precond != UnknownPrecond, "Failed to parse the preconditioner name" );
 
+    if( opt->getValue( "solver-guess" ) != NULL  )
+        solver_guess = EnumifySolverGuess(opt->getValue( "solver-guess" ));
+    ASSERT(solver_guess != UnknownGuess, "Failed to parse the initial guess type" );
+
+    if( opt->getValue( "solver-recycle" ) != NULL  )
+        solver_recycle =  atoi(opt->getValue( "solver-recycle" ));
+    ASSERT(solver_recycle>=0, "The recycle size should be non-negative");
+
+    if( opt->getValue( "self-op" ) != NULL  )
+        self_op = EnumifySelfOp(opt->getValue( "self-op" ));
+    ASSERT(self_op != UnknownSelfOp, "Failed to parse the self-interaction storage" );
+
     if( opt->getValue( "singular-stokes" ) != NULL  )
         singular_stokes = EnumifyStokesRot(opt->getValue( "singular-stokes" ));
 
@@ -417,14 +525,17 @@ void Parameters<T>::getOptionValues(AnyOption *opt)
     if( opt->getValue( "time-iter-max" ) != NULL  )
         time_iter_max =  atof(opt->getValue( "time-iter-max" ));
 
+    if( opt->getValue( "time-order" ) != NULL  )
+        time_order =  atoi(opt->getValue( "time-order" ));
+    ASSERT(time_order==1 || time_order==2, "The time order should be 1 or 2");
+
     //   other methods: (bool) opt.getFlag( ... long or short ... )
 }
 
 template<typename T>
 Error_t Parameters<T>::pack(std::ostream &os, Format format) const
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
-
+    // the same key-value records are used for both formats
     os<<"PARAMETERS\n";
     os<<"version: "<<VERSION<<"\n";
     os<<"name: "<<Streamable::name_<<"\n";
@@ -468,6 +579,23 @@ Error_t Parameters<T>::pack(std::ostream &os, Format format) const
     os<<"num_threads: "<<num_threads<<"\n";
     os<<"excess_density: "<<excess_density<<"\n";
     os<<"gravity_field: "<<gravity_field[0]<<" "<<gravity_field[1]<<" "<<gravity_field[2]<<"\n";
+    os<<"sht_dft: "<<sht_dft<<"\n";
+    os<<"self_op: "<<self_op<<"\n";
+    os<<"repartition_stride: "<<repartition_stride<<"\n";
+    os<<"near_skin: "<<near_skin<<"\n";
+    os<<"checkpoint_format: "<<checkpoint_format<<"\n";
+    os<<"async_io: "<<async_io<<"\n";
+    os<<"mats_io: "<<mats_io<<"\n";
+    os<<"solver_guess: "<<solver_guess<<"\n";
+    os<<"solver_recycle: "<<solver_recycle<<"\n";
+    os<<"inexact_krylov: "<<inexact_krylov<<"\n";
+    os<<"mixed_precision: "<<mixed_precision<<"\n";
+    os<<"fmm_overlap: "<<fmm_overlap<<"\n";
+    os<<"init_volume_fraction: "<<init_volume_fraction<<"\n";
+    os<<"init_min_sep: "<<init_min_sep<<"\n";
+    os<<"init_seed: "<<init_seed<<"\n";
+    os<<"init_geometry_out: "<<init_geometry_out<<" |\n";
+    os<<"time_order: "<<time_order<<"\n";
     os<<"/PARAMETERS\n";
     return ErrorEvent::Success;
 }
@@ -475,7 +603,6 @@ Error_t Parameters<T>::pack(std::ostream &os, Format format) const
 template<typename T>
 Error_t Parameters<T>::unpack(std::istream &is, Format format)
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
     std::string s, key;
     int version(0);
     is>>s;
@@ -573,7 +700,49 @@ Error_t Parameters<T>::unpack(std::istream &is, Format format)
     is>>key>>gravity_field[0]>>gravity_field[1]>>gravity_field[2];
     ASSERT(key=="gravity_field:", "Unexpected key (expected gravity_field)");
 
+    // optional keys (absent in older files)
     is>>s;
+    while (s!="/PARAMETERS" && is.good()){
+        if (s=="sht_dft:"){
+            is>>s; sht_dft=EnumifyDFT(s.c_str());
+        } else if (s=="self_op:"){
+            is>>s; self_op=EnumifySelfOp(s.c_str());
+        } else if (s=="repartition_stride:"){
+            is>>repartition_stride;
+        } else if (s=="near_skin:"){
+            is>>near_skin;
+        } else if (s=="checkpoint_format:"){
+            is>>s; checkpoint_format=EnumifyFormat(s.c_str());
+        } else if (s=="async_io:"){
+            is>>async_io;
+        } else if (s=="mats_io:"){
+            is>>s; mats_io=EnumifyMatsIO(s.c_str());
+        } else if (s=="solver_guess:"){
+            is>>s; solver_guess=EnumifySolverGuess(s.c_str());
+        } else if (s=="solver_recycle:"){
+            is>>solver_recycle;
+        } else if (s=="inexact_krylov:"){
+            is>>inexact_krylov;
+        } else if (s=="mixed_precision:"){
+            is>>mixed_precision;
+        } else if (s=="fmm_overlap:"){
+            is>>fmm_overlap;
+        } else if (s=="init_volume_fraction:"){
+            is>>init_volume_fraction;
+        } else if (s=="init_min_sep:"){
+            is>>init_min_sep;
+        } else if (s=="init_seed:"){
+            is>>init_seed;
+        } else if (s=="init_geometry_out:"){
+            is>>s;
+            if (s!="|"){init_geometry_out=s; is>>s; /* consume | */}else{init_geometry_out="";}
+        } else if (s=="time_order:"){
+            is>>time_order;
+        } else {
+            ASSERT(false, "Unexpected key "<<s);
+        }
+        is>>s;
+    }
     ASSERT(s=="/PARAMETERS", "Bad input string (missing footer).");
 
     INFO("Unpacked "<<Streamable::name_<<" data from version "<<version<<" (current version "<<VERSION<<")");
@@ -593,6 +762,8 @@ std::ostream& operator<<(std::ostream& output, const Parameters<T>& par)
     output<<"   Filter freq              : "<<par.filter_freq<<std::endl;
     output<<"   Upsample freq            : "<<par.upsample_freq<<std::endl;
     output<<"   Rep filter freq          : "<<par.rep_filter_freq<<std::endl;
+    output<<"   Longitudinal transform   : "<<par.sht_dft<<std::endl;
+    output<<"   Matrices IO              : "<<par.mats_io<<std::endl;
 
     output<<"------------------------------------"<<std::endl;
     output<<" Surface:"<<std::endl;
@@ -600,6 +771,7 @@ std::ostream& operator<<(std::ostream& output, const Parameters<T>& par)
     output<<"   Bending modulus          : "<<par.bending_modulus<<std::endl;
     output<<"   viscosity contrast       : "<<par.viscosity_contrast<<std::endl;
     output<<"   Singular Stokes          : "<<par.singular_stokes<<std::endl;
+    output<<"   Self-interaction storage : "<<par.self_op<<std::endl;
     output<<"   Excess density           : "<<par.excess_density<<std::endl;
 
     output<<"------------------------------------"<<std::endl;
@@ -610,10 +782,16 @@ std::ostream& operator<<(std::ostream& output, const Parameters<T>& par)
     output<<"   Time tol                 : "<<par.time_tol<<std::endl;
     output<<"   Time iter max            : "<<par.time_iter_max<<std::endl;
     output<<"   Time adaptivity          : "<<std::boolalpha<<par.time_adaptive<<std::endl;
+    output<<"   Time order               : "<<par.time_order<<std::endl;
     output<<"   Precond                  : "<<par.time_precond<<std::endl;
     output<<"   Error Factor             : "<<par.error_factor<<std::endl;
     output<<"   Solve for velocity       : "<<std::boolalpha<<par.solve_for_velocity<<std::endl;
     output<<"   Pseudospectral           : "<<std::boolalpha<<par.pseudospectral<<std::endl;
+    output<<"   Solver initial guess     : "<<par.solver_guess<<std::endl;
+    output<<"   Solver recycle size      : "<<par.solver_recycle<<std::endl;
+    output<<"   Inexact Krylov           : "<<std::boolalpha<<par.inexact_krylov<<std::endl;
+    output<<"   Mixed precision          : "<<std::boolalpha<<par.mixed_precision<<std::endl;
+    output<<"   Overlapped far field     : "<<std::boolalpha<<par.fmm_overlap<<std::endl;
 
     output<<"------------------------------------"<<std::endl;
     output<<" Reparametrization:"<<std::endl;
@@ -627,18 +805,25 @@ std::ostream& operator<<(std::ostream& output, const Parameters<T>& par)
     output<<"------------------------------------"<<std::endl;
     output<<" Repulsion:"<<std::endl;
     output<<"   Repulsion distance       : "<<par.repul_dist<<std::endl;
+    output<<"   Near setup skin          : "<<par.near_skin<<std::endl;
 
     output<<"------------------------------------"<<std::endl;
     output<<" Initialization:"<<std::endl;
     output<<"   Shape gallery file       : "<<par.shape_gallery_file<<std::endl;
     output<<"   Vesicle geometry file    : "<<par.vesicle_geometry_file<<std::endl;
     output<<"   Vesicle properties file  : "<<par.vesicle_props_file<<std::endl;
+    output<<"   Initial volume fraction  : "<<par.init_volume_fraction<<std::endl;
+    output<<"   Initial min separation   : "<<par.init_min_sep<<std::endl;
+    output<<"   Initial seed             : "<<par.init_seed<<std::endl;
+    output<<"   Initial geometry output  : "<<par.init_geometry_out<<std::endl;
 
     output<<"------------------------------------"<<std::endl;
     output<<" Checkpointing:"<<std::endl;
     output<<"   Checkpoint               : "<<std::boolalpha<<par.checkpoint<<std::endl;
     output<<"   Checkpoint file name     : "<<par.checkpoint_file_name<<std::endl;
     output<<"   Checkpoint stride        : "<<par.checkpoint_stride<<std::endl;
+    output<<"   Checkpoint format        : "<<par.checkpoint_format<<std::endl;
+    output<<"   Asynchronous IO          : "<<std::boolalpha<<par.async_io<<std::endl;
     output<<"   Load checkpoint          : "<<par.load_checkpoint<<std::endl;
     output<<"   Write VTK                : "<<par.write_vtk<<std::endl;
 
@@ -656,6 +841,7 @@ std::ostream& operator<<(std::ostream& output, const Parameters<T>& par)
     output<<"------------------------------------"<<std::endl;
     output<<" Misc:"<<std::endl;
     output<<"   OpenMP num threads       : "<<par.num_threads<<std::endl;
+    output<<"   Repartition stride       : "<<par.repartition_stride<<std::endl;
     output<<"====================================";
 
     return output;
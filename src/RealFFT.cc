@@ -0,0 +1,270 @@
+#include "RealFFT.h"
+
+#include <algorithm>
+#include <complex>
+#include <omp.h>
+
+#include "Enums.h"
+#include "Logger.h"
+
+namespace {
+
+// complex product without the inf/nan recovery of std::complex
+template<typename T>
+inline std::complex<T> realfft_cmul(const std::complex<T> &a,
+    const std::complex<T> &b)
+{
+    return(std::complex<T>(a.real()*b.real() - a.imag()*b.imag(),
+            a.real()*b.imag() + a.imag()*b.real()));
+}
+
+// the interleaved (re, im) arrays of the header have the layout of
+// an array of std::complex
+template<typename T>
+inline std::complex<T>* as_cplx(T *a)
+{
+    return(reinterpret_cast<std::complex<T>*>(a));
+}
+
+template<typename T>
+inline const std::complex<T>* as_cplx(const T *a)
+{
+    return(reinterpret_cast<const std::complex<T>*>(a));
+}
+
+/*
+ * Recursive mixed-radix step of the complex FFT of length mtot,
+ * factors are the (radix, remaining length) pairs from init.
+ */
+template<typename T>
+void realfft_work(std::complex<T> *out, const std::complex<T> *in,
+    int fstride, const int *factors, const std::complex<T> *tw, int mtot,
+    bool inv, std::complex<T> *scratch)
+{
+    typedef std::complex<T> cplx;
+    int p(factors[0]), m(factors[1]);
+
+    if (m==1)
+        for (int q=0; q<p; ++q)
+            out[q] = in[q*fstride];
+    else
+        for (int q=0; q<p; ++q)
+            realfft_work(out+q*m, in+q*fstride, fstride*p, factors+2, tw,
+                mtot, inv, scratch);
+
+    // radix-p butterflies
+    switch (p){
+        case 2:
+            for (int u=0; u<m; ++u){
+                cplx t(realfft_cmul(out[u+m], tw[u*fstride]));
+                out[u+m] = out[u] - t;
+                out[u]  += t;
+            }
+            break;
+
+        case 3:
+            {
+                T epi3(tw[fstride*m].imag());
+                for (int u=0; u<m; ++u){
+                    cplx s1(realfft_cmul(out[u+  m], tw[u*fstride  ]));
+                    cplx s2(realfft_cmul(out[u+2*m], tw[u*fstride*2]));
+                    cplx s3(s1+s2), s0((s1-s2)*epi3);
+                    cplx h(out[u] - s3*(T) 0.5);
+                    out[u]    += s3;
+                    out[u+2*m] = cplx(h.real() + s0.imag(), h.imag() - s0.real());
+                    out[u+  m] = cplx(h.real() - s0.imag(), h.imag() + s0.real());
+                }
+            }
+            break;
+
+        case 4:
+            for (int u=0; u<m; ++u){
+                cplx s0(realfft_cmul(out[u+  m], tw[u*fstride  ]));
+                cplx s1(realfft_cmul(out[u+2*m], tw[u*fstride*2]));
+                cplx s2(realfft_cmul(out[u+3*m], tw[u*fstride*3]));
+                cplx s5(out[u]-s1), s3(s0+s2), s4(s0-s2);
+                out[u]    += s1;
+                out[u+2*m] = out[u] - s3;
+                out[u]    += s3;
+                if (inv){
+                    out[u+  m] = cplx(s5.real() - s4.imag(), s5.imag() + s4.real());
+                    out[u+3*m] = cplx(s5.real() + s4.imag(), s5.imag() - s4.real());
+                } else {
+                    out[u+  m] = cplx(s5.real() + s4.imag(), s5.imag() - s4.real());
+                    out[u+3*m] = cplx(s5.real() - s4.imag(), s5.imag() + s4.real());
+                }
+            }
+            break;
+
+        default:
+            for (int u=0; u<m; ++u){
+                for (int q=0, k=u; q<p; ++q, k+=m)
+                    scratch[q] = out[k];
+
+                for (int q1=0, k=u; q1<p; ++q1, k+=m){
+                    int twidx(0);
+                    out[k] = scratch[0];
+                    for (int q=1; q<p; ++q){
+                        twidx += fstride*k;
+                        if (twidx>=mtot) twidx -= mtot;
+                        out[k] += realfft_cmul(scratch[q], tw[twidx]);
+                    }
+                }
+            }
+    }
+}
+
+/*
+ * Coefficient k (0<=k<=m) of the half spectrum of a ring of n=2m
+ * coefficients, with the derivative applied.
+ */
+template<typename T>
+inline std::complex<T> realfft_half(const T *c, int k, int m, int deriv)
+{
+    typedef std::complex<T> cplx;
+    if (k==0) return((deriv==0) ? c[0] : 0);
+    if (k==m) return((deriv==0) ? c[2*m-1] : ((deriv==1) ? 0 : -((T) m*m)*c[2*m-1]));
+
+    cplx y(cplx(c[2*k-1], -c[2*k])*(T) 0.5);
+    if (deriv==1) y = cplx(-k*y.imag(), k*y.real());
+    if (deriv==2) y *= -(T) k*k;
+    return(y);
+}
+
+} // namespace
+
+template<typename T>
+RealFFT<T>::RealFFT(int n) :
+    n_(0),
+    m_(0),
+    max_radix_(1)
+{
+    if (n>0) init(n);
+}
+
+template<typename T>
+void RealFFT<T>::init(int n)
+{
+    ASSERT(n>0 && n%2==0, "The length of the real FFT should be even, n="<<n);
+    n_ = n;
+    m_ = n/2;
+
+    // factorization of the complex length, preferring radix 4
+    factors_.clear();
+    max_radix_ = 1;
+    int m(m_), p(4);
+    do {
+        while (m%p){
+            if (p==4) p=2;
+            else if (p==2) p=3;
+            else p+=2;
+            if (p*p>m) p=m;
+        }
+        m /= p;
+        factors_.push_back(p);
+        factors_.push_back(m);
+        max_radix_ = std::max(max_radix_,p);
+    } while (m>1);
+
+    T pi(PI64<T>());
+    tw_fwd_.resize(2*m_);
+    tw_bwd_.resize(2*m_);
+    for (int k=0; k<m_; ++k){
+        as_cplx(&tw_fwd_[0])[k] = std::polar((T) 1.0, -2*pi*k/m_);
+        as_cplx(&tw_bwd_[0])[k] = std::conj(as_cplx(&tw_fwd_[0])[k]);
+    }
+
+    tw_half_.resize(2*(m_+1));
+    for (int k=0; k<=m_; ++k)
+        as_cplx(&tw_half_[0])[k] = std::polar((T) 1.0, -2*pi*k/n_);
+}
+
+template<typename T>
+int RealFFT<T>::num_threads(int howmany, size_t work_len) const
+{
+    ASSERT(work_len>=work_size(), "The FFT needs at least "<<work_size()
+        <<" values of scratch, got "<<work_len);
+    long nt(std::min<long>(omp_get_max_threads(), work_len/work_size()));
+    return(std::max<long>(std::min<long>(nt, howmany), 1));
+}
+
+template<typename T>
+void RealFFT<T>::forward(const T *in, int howmany, T *out, T *work,
+    size_t work_len) const
+{
+    const T scal((T) 1.0/n_);
+
+    typedef std::complex<T> cplx;
+    const cplx *tw_fwd  = as_cplx(&tw_fwd_[0]);
+    const cplx *tw_half = as_cplx(&tw_half_[0]);
+
+#pragma omp parallel num_threads(num_threads(howmany, work_len))
+    {
+        cplx *Z       = as_cplx(work + omp_get_thread_num()*work_size());
+        cplx *scratch = Z + m_;
+
+#pragma omp for
+        for (int r=0; r<howmany; ++r){
+            // a ring of n reals is the packed sequence of m complex values
+            const cplx *z = as_cplx(in + r*n_);
+            T *c          = out + r*n_;
+            realfft_work(Z, z, 1, &factors_[0], tw_fwd, m_, false, scratch);
+
+            // split the transform of the packed sequence into the
+            // transforms of the even and odd samples
+            for (int k=0; k<=m_; ++k){
+                cplx zk (Z[k%m_]);
+                cplx zmk(std::conj(Z[(m_-k)%m_]));
+                cplx d  (realfft_cmul(tw_half[k], zk-zmk));
+                cplx Xk ((zk+zmk)*(T) 0.5 + cplx(d.imag(), -d.real())*(T) 0.5);
+
+                if (k==0)
+                    c[0] = Xk.real()*scal;
+                else if (k==m_)
+                    c[n_-1] = Xk.real()*scal;
+                else {
+                    c[2*k-1] =  2*Xk.real()*scal;
+                    c[2*k  ] = -2*Xk.imag()*scal;
+                }
+            }
+        }
+    }
+}
+
+template<typename T>
+void RealFFT<T>::backward(const T *in, int howmany, T *out, int deriv,
+    T *work, size_t work_len) const
+{
+    ASSERT(deriv>=0 && deriv<=2, "Only up to second derivative is supported");
+
+    typedef std::complex<T> cplx;
+    const cplx *tw_bwd  = as_cplx(&tw_bwd_[0]);
+    const cplx *tw_half = as_cplx(&tw_half_[0]);
+
+#pragma omp parallel num_threads(num_threads(howmany, work_len))
+    {
+        cplx *Z       = as_cplx(work + omp_get_thread_num()*work_size());
+        cplx *scratch = Z + m_;
+
+#pragma omp for
+        for (int r=0; r<howmany; ++r){
+            const T *c = in  + r*n_;
+            T *f       = out + r*n_;
+
+            // pack the half-spectrum (with the derivative applied) into
+            // a half-length complex sequence
+            for (int k=0; k<m_; ++k){
+                cplx yk (realfft_half(c, k, m_, deriv));
+                cplx ymk(std::conj(realfft_half(c, m_-k, m_, deriv)));
+                cplx d(realfft_cmul(yk-ymk, std::conj(tw_half[k])));
+                Z[k] = (yk+ymk) + cplx(-d.imag(), d.real());
+            }
+
+            // the samples are the packed sequence, f may alias c
+            realfft_work(as_cplx(f), Z, 1, &factors_[0], tw_bwd, m_, true, scratch);
+        }
+    }
+}
+
+template class RealFFT<float>;
+template class RealFFT<double>;
@@ -13,16 +13,13 @@ Repartition<T>::Repartition(GlobalRepart_t fun_ptr,
     all_tension_(NULL),
     posr_(NULL),
     tensionr_(NULL),
-    context_(NULL),
-    nvr_(0)
+    datar_(NULL),
+    nvr_(0),
+    context_(NULL)
 {
     COUTDEBUG("creating a repartion object");
     for(int ii=0; ii<num_threads_; ++ii)
         each_thread_idx_[ii] = each_thread_nv_[ii] = 0;
-
-    if (this->g_repart_handle_ && !this->clear_context_)
-      WARN("No deallocator is defined for the repartition_context."
-	" This may cause memory leak.");
 }
 
 template<typename T>
@@ -35,9 +32,12 @@ Repartition<T>::~Repartition()
     delete[] all_pos_;
     delete[] all_tension_;
 
-    if (this->context_){
+    if (this->context_ && this->clear_context_){
         COUTDEBUG("deleting the repartion context");
         this->clear_context_(&(this->context_));
+    } else if (this->context_){
+        WARN("No deallocator is defined for the repartition_context."
+            " This may cause memory leak.");
     }
 }
 
@@ -45,7 +45,8 @@ Repartition<T>::~Repartition()
 template<typename T>
 template<typename VecContainer, typename ScaContainer>
 Error_t Repartition<T>::operator()(VecContainer &coord,
-    ScaContainer &tension) const
+    ScaContainer &tension, const std::vector<T> *weight,
+    std::vector<T> *ves_data, size_t data_dof) const
 {
     assert( typeid(T) == typeid(typename VecContainer::value_type) );
     assert( typeid(T) == typeid(typename ScaContainer::value_type) );
@@ -57,6 +58,14 @@ Error_t Repartition<T>::operator()(VecContainer &coord,
         return(ErrorEvent::ReferenceError);
     }
 
+    ASSERT((weight==NULL && ves_data==NULL) || omp_get_num_threads()==1,
+        "Weights and vesicle data are only supported outside parallel regions");
+    ASSERT(weight==NULL || weight->size()==tension.getNumSubs(),
+        "Weight should have one value per vesicle");
+    ASSERT(ves_data==NULL || ves_data->size()==data_dof*tension.getNumSubs(),
+        "Vesicle data should have data_dof values per vesicle");
+    if (ves_data==NULL) data_dof=0;
+
     //Getting the sizes
     size_t nv(tension.getNumSubs());
     size_t stride(tension.getStride());
@@ -80,9 +89,13 @@ Error_t Repartition<T>::operator()(VecContainer &coord,
 #pragma omp barrier
 
 #pragma omp master
-    COUTDEBUG("repartitioning vesicle distribution with "<<nv_<<" vesicles");
-    g_repart_handle_(nv_, stride, all_pos_, all_tension_, &nvr_,
-        &posr_, &tensionr_, &(this->context_));
+    {
+        COUTDEBUG("repartitioning vesicle distribution with "<<nv_<<" vesicles");
+        g_repart_handle_(nv_, stride, all_pos_, all_tension_,
+            ((weight && nv_) ? &(*weight)[0] : NULL), data_dof,
+            ((data_dof && nv_) ? &(*ves_data)[0] : NULL), &nvr_,
+            &posr_, &tensionr_, &datar_, &(this->context_));
+    }
 
 #pragma omp barrier
 
@@ -101,10 +114,15 @@ Error_t Repartition<T>::operator()(VecContainer &coord,
         tension.size() * sizeof(T),
         VecContainer::getDevice().MemcpyHostToDevice);
 
+    if (data_dof)
+        ves_data->assign(datar_, datar_ + nvr_ * data_dof);
+
 #pragma omp master
     {
         delete[] posr_;
         delete[] tensionr_;
+        delete[] datar_;
+        datar_ = NULL;
     }
 
 
@@ -1,11 +1,12 @@
 template<typename T, typename Device>
 SHTMats<T, Device>::SHTMats(const Device &dev, int sh_order, T *data,
-    bool generateMats, std::pair<int, int> grid_dim) :
+    bool generateMats, std::pair<int, int> grid_dim, DFTType dft_type) :
     sh_order_(sh_order),
     grid_dim_((grid_dim == EMPTY_GRID) ? SpharmGridDim(sh_order_) : grid_dim),
     data_(data),
     dft_size(grid_dim_.second),
-    device_(dev)
+    device_(dev),
+    dft_type_(dft_type)
 {
     ASSERT(data_ != NULL,"NULL pointer passed!");
 
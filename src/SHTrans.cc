@@ -6,18 +6,24 @@ const typename Container::value_type SHTrans<Container, Mats>::beta_;
 
 template<typename Container, typename Mats>
 SHTrans<Container, Mats>::SHTrans(int p_in, const Mats &mats,
-    int filter_freq, value_type filter_exponent) :
+    int filter_freq, value_type filter_exponent, DFTType dft_type) :
     device_(Container::getDevice()),
     mats_(mats),
     p(p_in),
     dft_size(2*p),
     filter_freq_(filter_freq),
     filter_exponent_(filter_exponent),
+    dft_type_(dft_type == UnknownDFT ? mats.getDFTType() : dft_type),
     filter_coeff_((value_type*) device_.Malloc(p * (p + 2) * sizeof(value_type))),
     filter_coeff_poly_((value_type*) device_.Malloc(p * (p + 2) * sizeof(value_type)))
 {
     filter_freq_ = (filter_freq_ == -1) ? 2*p/3 : filter_freq_;
-    INFO("Initializing with p="<<p<<", filter_freq="<<filter_freq_<<", filter_exponent="<<filter_exponent_);
+    if (dft_type_ == FFTDFT && !device_type::IsHost()){
+        WARN("FFT is only supported on the host, using GemmDFT");
+        dft_type_ = GemmDFT;
+    }
+    if (dft_type_ == FFTDFT) fft_.init(dft_size);
+    INFO("Initializing with p="<<p<<", filter_freq="<<filter_freq_<<", filter_exponent="<<filter_exponent_<<", dft="<<dft_type_);
 
     value_type *buffer = (value_type*) malloc(p * (p + 2) * sizeof(value_type));
     int idx = 0, len;
@@ -82,19 +88,29 @@ void SHTrans<Container, Mats>::DLT(value_type *trans,
 template<typename Container, typename Mats>
 void SHTrans<Container, Mats>::back(const value_type *inputs,
     value_type *work_arr, int n_funs, value_type *outputs,
-    value_type *trans, value_type *dft) const
+    value_type *trans, value_type *dft, int dft_deriv) const
 {
     PROFILESTART();
     int num_dft_inputs = n_funs * (p + 1);
-    DLT(trans, inputs, outputs, p + 1, 2 * n_funs, p + 1, 0, 0, 1);
-
-    device_.Transpose(outputs, dft_size, num_dft_inputs, work_arr);
-
-    PROFILESTART();
-    device_.gemm("T", "N", &dft_size, &num_dft_inputs,
-        &dft_size, &alpha_, dft, &dft_size,
-        work_arr, &dft_size, &beta_, outputs, &dft_size);
-    PROFILEEND("SHT_DFT_",0);
+    if (dft_type_ == FFTDFT){
+        // the FFT runs in place on outputs, with work_arr as its scratch
+        DLT(trans, inputs, work_arr, p + 1, 2 * n_funs, p + 1, 0, 0, 1);
+        device_.Transpose(work_arr, dft_size, num_dft_inputs, outputs);
+
+        PROFILESTART();
+        fft_.backward(outputs, num_dft_inputs, outputs, dft_deriv, work_arr,
+            (size_t) num_dft_inputs * dft_size);
+        PROFILEEND("SHT_DFT_",0);
+    } else {
+        DLT(trans, inputs, outputs, p + 1, 2 * n_funs, p + 1, 0, 0, 1);
+        device_.Transpose(outputs, dft_size, num_dft_inputs, work_arr);
+
+        PROFILESTART();
+        device_.gemm("T", "N", &dft_size, &num_dft_inputs,
+            &dft_size, &alpha_, dft, &dft_size,
+            work_arr, &dft_size, &beta_, outputs, &dft_size);
+        PROFILEEND("SHT_DFT_",0);
+    }
 
     PROFILEEND("SHT_",0);
 }
@@ -108,9 +124,13 @@ void SHTrans<Container, Mats>::forward(const Container &in, Container &work,
     int num_dft_inputs = n_funs * (p + 1);
 
     PROFILESTART();
-    device_.gemm("N", "N", &dft_size, &num_dft_inputs, &dft_size,
-        &alpha_, mats_.dft_, &dft_size,in.begin(), &dft_size, &beta_,
-        shc.begin(), &dft_size);
+    if (dft_type_ == FFTDFT)
+        fft_.forward(in.begin(), num_dft_inputs, shc.begin(), work.begin(),
+            work.size());
+    else
+        device_.gemm("N", "N", &dft_size, &num_dft_inputs, &dft_size,
+            &alpha_, mats_.dft_, &dft_size,in.begin(), &dft_size, &beta_,
+            shc.begin(), &dft_size);
     PROFILEEND("SHT_DFT_",0);
 
     device_.Transpose(shc.begin(), num_dft_inputs, dft_size, work.begin());
@@ -125,7 +145,7 @@ void SHTrans<Container, Mats>::backward(const Container &shc,
     Container &work, Container &out) const
 {
     back(shc.begin(), work.begin(), out.getNumSubFuncs(), out.begin(),
-        mats_.dlt_inv_, mats_.dft_inv_);
+        mats_.dlt_inv_, mats_.dft_inv_, 0);
 }
 
 
@@ -134,7 +154,7 @@ void SHTrans<Container, Mats>::backward_du(const Container &shc,
     Container &work, Container &out) const
 {
     back(shc.begin(), work.begin(), out.getNumSubFuncs(), out.begin(),
-        mats_.dlt_inv_d1_, mats_.dft_inv_);
+        mats_.dlt_inv_d1_, mats_.dft_inv_, 0);
 }
 
 template<typename Container, typename Mats>
@@ -142,7 +162,7 @@ void SHTrans<Container, Mats>::backward_d2u(const Container &shc,
     Container &work, Container &out) const
 {
     back(shc.begin(), work.begin(), out.getNumSubFuncs(), out.begin(),
-        mats_.dlt_inv_d2_, mats_.dft_inv_);
+        mats_.dlt_inv_d2_, mats_.dft_inv_, 0);
 }
 
 template<typename Container, typename Mats>
@@ -150,7 +170,7 @@ void SHTrans<Container, Mats>::backward_dv(const Container &shc,
     Container &work, Container &out) const
 {
     back(shc.begin(), work.begin(), out.getNumSubFuncs(), out.begin(),
-        mats_.dlt_inv_, mats_.dft_inv_d1_);
+        mats_.dlt_inv_, mats_.dft_inv_d1_, 1);
 }
 
 template<typename Container, typename Mats>
@@ -158,7 +178,7 @@ void SHTrans<Container, Mats>::backward_d2v(const Container &shc,
     Container &work, Container &out) const
 {
     back(shc.begin(), work.begin(), out.getNumSubFuncs(), out.begin(),
-        mats_.dlt_inv_, mats_.dft_inv_d2_);
+        mats_.dlt_inv_, mats_.dft_inv_d2_, 2);
 }
 
 template<typename Container, typename Mats>
@@ -166,7 +186,7 @@ void SHTrans<Container, Mats>::backward_duv(const Container &shc,
     Container &work, Container &out) const
 {
     back(shc.begin(), work.begin(), out.getNumSubFuncs(), out.begin(),
-        mats_.dlt_inv_d1_, mats_.dft_inv_d1_);
+        mats_.dlt_inv_d1_, mats_.dft_inv_d1_, 1);
 }
 
 template<typename Container, typename Mats>
@@ -219,8 +219,6 @@ Scalars<T, DT, DEVICE>::getSubFuncN_end(size_t n) const
 template<typename T, typename DT, const DT &DEVICE>
 Error_t Scalars<T, DT, DEVICE>::pack(std::ostream &os, Streamable::Format format) const
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
-
     os<<"SCALARS\n";
     os<<"version: "<<VERSION<<"\n";
     os<<"nsubs: "<<getNumSubs()<<"\n";
@@ -237,7 +235,6 @@ Error_t Scalars<T, DT, DEVICE>::pack(std::ostream &os, Streamable::Format format
 template<typename T, typename DT, const DT &DEVICE>
 Error_t Scalars<T, DT, DEVICE>::unpack(std::istream &is, Streamable::Format format)
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
     std::string s,key;
     int version(0);
     is>>s;
@@ -1,7 +1,54 @@
 #include <legendre_rule.hpp>
 
 template <class Real>
-void SphericalHarmonics<Real>::SHC2Grid(const pvfmm::Vector<Real>& S, long p0, long p1, pvfmm::Vector<Real>& X, pvfmm::Vector<Real>* X_theta, pvfmm::Vector<Real>* X_phi){
+SHWorkspace<Real>::SHWorkspace() :
+  top_(0),
+  high_water_(0)
+{}
+
+template <class Real>
+SHWorkspace<Real>::~SHWorkspace(){
+  Clear();
+}
+
+template <class Real>
+size_t SHWorkspace<Real>::Bytes() const{
+  size_t bytes=0;
+  for(size_t i=0;i<buf_.size();i++) bytes+=buf_[i]->Capacity()*sizeof(Real);
+  return bytes;
+}
+
+template <class Real>
+void SHWorkspace<Real>::Clear(){
+  assert(top_==0);
+  for(size_t i=0;i<buf_.size();i++) delete buf_[i];
+  buf_.clear();
+}
+
+template <class Real>
+SHWorkspace<Real>::Frame::Frame(SHWorkspace* ws) :
+  own_(ws?NULL:new SHWorkspace),
+  ws_(ws?ws:own_),
+  top0_(ws_->top_)
+{}
+
+template <class Real>
+SHWorkspace<Real>::Frame::~Frame(){
+  size_t bytes=0;
+  for(size_t i=0;i<ws_->top_;i++) bytes+=ws_->buf_[i]->Capacity()*sizeof(Real);
+  ws_->high_water_=std::max(ws_->high_water_, bytes);
+  ws_->top_=top0_;
+  if(own_) delete own_;
+}
+
+template <class Real>
+pvfmm::Vector<Real>& SHWorkspace<Real>::Frame::Get(){
+  if(ws_->top_==ws_->buf_.size()) ws_->buf_.push_back(new pvfmm::Vector<Real>);
+  return *ws_->buf_[ws_->top_++];
+}
+
+template <class Real>
+void SphericalHarmonics<Real>::SHC2Grid(const pvfmm::Vector<Real>& S, long p0, long p1, pvfmm::Vector<Real>& X, pvfmm::Vector<Real>* X_theta, pvfmm::Vector<Real>* X_phi, SHWorkspace<Real>* ws){
   pvfmm::Matrix<Real>& Mf =SphericalHarmonics<Real>::MatFourier(p0,p1);
   pvfmm::Matrix<Real>& Mdf=SphericalHarmonics<Real>::MatFourierGrad(p0,p1);
   std::vector<pvfmm::Matrix<Real> >& Ml =SphericalHarmonics<Real>::MatLegendre(p0,p1);
@@ -17,7 +64,9 @@ void SphericalHarmonics<Real>::SHC2Grid(const pvfmm::Vector<Real>& S, long p0, l
   if(X_phi   && X_phi  ->Dim()!=N*2*p1*(p1+1)) X_phi  ->ReInit(N*2*p1*(p1+1));
   if(X_theta && X_theta->Dim()!=N*2*p1*(p1+1)) X_theta->ReInit(N*2*p1*(p1+1));
 
-  static pvfmm::Vector<Real> B0, B1;
+  typename SHWorkspace<Real>::Frame frame(ws);
+  pvfmm::Vector<Real>& B0=frame.Get();
+  pvfmm::Vector<Real>& B1=frame.Get();
   B0.ReInit(N*  p0*(p0+2));
   B1.ReInit(N*2*p0*(p1+1));
 
@@ -149,9 +198,9 @@ void SphericalHarmonics<Real>::SHC2Grid(const pvfmm::Vector<Real>& S, long p0, l
 }
 
 template <class Real>
-void SphericalHarmonics<Real>::Grid2SHC(const pvfmm::Vector<Real>& X, long p0, long p1, pvfmm::Vector<Real>& S){
-  pvfmm::Matrix<Real> Mf =SphericalHarmonics<Real>::MatFourierInv(p0,p1);
-  std::vector<pvfmm::Matrix<Real> > Ml =SphericalHarmonics<Real>::MatLegendreInv(p0,p1);
+void SphericalHarmonics<Real>::Grid2SHC(const pvfmm::Vector<Real>& X, long p0, long p1, pvfmm::Vector<Real>& S, SHWorkspace<Real>* ws){
+  pvfmm::Matrix<Real>& Mf =SphericalHarmonics<Real>::MatFourierInv(p0,p1);
+  std::vector<pvfmm::Matrix<Real> >& Ml =SphericalHarmonics<Real>::MatLegendreInv(p0,p1);
   assert(p1==Ml.size()-1);
   assert(p0==Mf.Dim(0)/2);
   assert(p1==Mf.Dim(1)/2);
@@ -160,7 +209,9 @@ void SphericalHarmonics<Real>::Grid2SHC(const pvfmm::Vector<Real>& X, long p0, l
   assert(N*2*p0*(p0+1)==X.Dim());
   if(S.Dim()!=N*(p1*(p1+2))) S.ReInit(N*(p1*(p1+2)));
 
-  static pvfmm::Vector<Real> B0, B1;
+  typename SHWorkspace<Real>::Frame frame(ws);
+  pvfmm::Vector<Real>& B0=frame.Get();
+  pvfmm::Vector<Real>& B1=frame.Get();
   B0.ReInit(N*  p1*(p1+2));
   B1.ReInit(N*2*p1*(p0+1));
 
@@ -235,7 +286,7 @@ void SphericalHarmonics<Real>::Grid2SHC(const pvfmm::Vector<Real>& X, long p0, l
 }
 
 template <class Real>
-void SphericalHarmonics<Real>::SHC2GridTranspose(const pvfmm::Vector<Real>& X, long p0, long p1, pvfmm::Vector<Real>& S){
+void SphericalHarmonics<Real>::SHC2GridTranspose(const pvfmm::Vector<Real>& X, long p0, long p1, pvfmm::Vector<Real>& S, SHWorkspace<Real>* ws){
   pvfmm::Matrix<Real> Mf =SphericalHarmonics<Real>::MatFourier(p1,p0).Transpose();
   std::vector<pvfmm::Matrix<Real> > Ml =SphericalHarmonics<Real>::MatLegendre(p1,p0);
   for(long i=0;i<Ml.size();i++) Ml[i]=Ml[i].Transpose();
@@ -247,7 +298,9 @@ void SphericalHarmonics<Real>::SHC2GridTranspose(const pvfmm::Vector<Real>& X, l
   assert(N*2*p0*(p0+1)==X.Dim());
   if(S.Dim()!=N*(p1*(p1+2))) S.ReInit(N*(p1*(p1+2)));
 
-  static pvfmm::Vector<Real> B0, B1;
+  typename SHWorkspace<Real>::Frame frame(ws);
+  pvfmm::Vector<Real>& B0=frame.Get();
+  pvfmm::Vector<Real>& B1=frame.Get();
   B0.ReInit(N*  p1*(p1+2));
   B1.ReInit(N*2*p1*(p0+1));
 
@@ -540,16 +593,36 @@ void SphericalHarmonics<Real>::RotateTranspose(const pvfmm::Vector<Real>& S_, lo
   }
 }
 
+template <class Real>
+bool SphericalHarmonics<Real>::CacheReady(int cache, long idx){
+  int& flag=matrix.done_[cache*SHMAXDEG*SHMAXDEG+idx];
+  int done;
+  #pragma omp atomic read
+  done=flag;
+  return done;
+}
+
+template <class Real>
+void SphericalHarmonics<Real>::CacheSetReady(int cache, long idx){
+  int& flag=matrix.done_[cache*SHMAXDEG*SHMAXDEG+idx];
+  #pragma omp atomic write
+  flag=1;
+}
+
 template <class Real>
 pvfmm::Vector<Real>& SphericalHarmonics<Real>::LegendreNodes(long p1){
   assert(p1<SHMAXDEG);
   matrix.Qx_.resize(SHMAXDEG);
   pvfmm::Vector<Real>& Qx=matrix.Qx_[p1];
-  if(!Qx.Dim()){
-    std::vector<Real> qx1(p1+1);
-    std::vector<Real> qw1(p1+1);
-    cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
-    Qx=qx1;
+  if(!CacheReady(QxCache, p1)){
+    #pragma omp critical (SHCacheQx)
+    if(!CacheReady(QxCache, p1)){
+      std::vector<Real> qx1(p1+1);
+      std::vector<Real> qw1(p1+1);
+      cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
+      Qx=qx1;
+      CacheSetReady(QxCache, p1);
+    }
   }
   return Qx;
 }
@@ -559,12 +632,16 @@ pvfmm::Vector<Real>& SphericalHarmonics<Real>::LegendreWeights(long p1){
   assert(p1<SHMAXDEG);
   matrix.Qw_.resize(SHMAXDEG);
   pvfmm::Vector<Real>& Qw=matrix.Qw_[p1];
-  if(!Qw.Dim()){
-    std::vector<Real> qx1(p1+1);
-    std::vector<Real> qw1(p1+1);
-    cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
-    for(long i=0;i<qw1.size();i++) qw1[i]*=M_PI/p1/sqrt(1-qx1[i]*qx1[i]);
-    Qw=qw1;
+  if(!CacheReady(QwCache, p1)){
+    #pragma omp critical (SHCacheQw)
+    if(!CacheReady(QwCache, p1)){
+      std::vector<Real> qx1(p1+1);
+      std::vector<Real> qw1(p1+1);
+      cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
+      for(long i=0;i<qw1.size();i++) qw1[i]*=M_PI/p1/sqrt(1-qx1[i]*qx1[i]);
+      Qw=qw1;
+      CacheSetReady(QwCache, p1);
+    }
   }
   return Qw;
 }
@@ -574,30 +651,34 @@ pvfmm::Vector<Real>& SphericalHarmonics<Real>::SingularWeights(long p1){
   assert(p1<SHMAXDEG);
   matrix.Sw_.resize(SHMAXDEG);
   pvfmm::Vector<Real>& Sw=matrix.Sw_[p1];
-  if(!Sw.Dim()){
-    std::vector<Real> qx1(p1+1);
-    std::vector<Real> qw1(p1+1);
-    cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
-
-    std::vector<Real> Yf(p1+1,0);
-    { // Set Yf
-      Real x0=1.0;
-      std::vector<Real> alp0((p1+1)*(p1+2)/2);
-      LegPoly(&alp0[0], &x0, 1, p1);
-
-      std::vector<Real> alp((p1+1) * (p1+1)*(p1+2)/2);
-      LegPoly(&alp[0], &qx1[0], p1+1, p1);
-
-      for(long j=0;j<p1+1;j++){
-        for(long i=0;i<p1+1;i++){
-          Yf[i]+=4*M_PI/(2*j+1) * alp0[j] * alp[j*(p1+1)+i];
+  if(!CacheReady(SwCache, p1)){
+    #pragma omp critical (SHCacheSw)
+    if(!CacheReady(SwCache, p1)){
+      std::vector<Real> qx1(p1+1);
+      std::vector<Real> qw1(p1+1);
+      cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
+
+      std::vector<Real> Yf(p1+1,0);
+      { // Set Yf
+        Real x0=1.0;
+        std::vector<Real> alp0((p1+1)*(p1+2)/2);
+        LegPoly(&alp0[0], &x0, 1, p1);
+
+        std::vector<Real> alp((p1+1) * (p1+1)*(p1+2)/2);
+        LegPoly(&alp[0], &qx1[0], p1+1, p1);
+
+        for(long j=0;j<p1+1;j++){
+          for(long i=0;i<p1+1;i++){
+            Yf[i]+=4*M_PI/(2*j+1) * alp0[j] * alp[j*(p1+1)+i];
+          }
         }
       }
-    }
 
-    Sw.ReInit(p1+1);
-    for(long i=0;i<p1+1;i++){
-      Sw[i]=(qw1[i]*M_PI/p1)*Yf[i]/cos(acos(qx1[i])/2);
+      Sw.ReInit(p1+1);
+      for(long i=0;i<p1+1;i++){
+        Sw[i]=(qw1[i]*M_PI/p1)*Yf[i]/cos(acos(qx1[i])/2);
+      }
+      CacheSetReady(SwCache, p1);
     }
   }
   return Sw;
@@ -608,19 +689,23 @@ pvfmm::Matrix<Real>& SphericalHarmonics<Real>::MatFourier(long p0, long p1){
   assert(p0<SHMAXDEG && p1<SHMAXDEG);
   matrix.Mf_ .resize(SHMAXDEG*SHMAXDEG);
   pvfmm::Matrix<Real>& Mf =matrix.Mf_ [p0*SHMAXDEG+p1];
-  if(!Mf.Dim(0)){
-    const Real SQRT2PI=sqrt(2*M_PI);
-    { // Set Mf
-      pvfmm::Matrix<Real> M(2*p0,2*p1);
-      for(long j=0;j<2*p1;j++){
-        M[0][j]=SQRT2PI*1.0;
-        for(long k=1;k<p0;k++){
-          M[2*k-1][j]=SQRT2PI*cos(j*k*M_PI/p1);
-          M[2*k-0][j]=SQRT2PI*sin(j*k*M_PI/p1);
+  if(!CacheReady(MfCache, p0*SHMAXDEG+p1)){
+    #pragma omp critical (SHCacheMf)
+    if(!CacheReady(MfCache, p0*SHMAXDEG+p1)){
+      const Real SQRT2PI=sqrt(2*M_PI);
+      { // Set Mf
+        pvfmm::Matrix<Real> M(2*p0,2*p1);
+        for(long j=0;j<2*p1;j++){
+          M[0][j]=SQRT2PI*1.0;
+          for(long k=1;k<p0;k++){
+            M[2*k-1][j]=SQRT2PI*cos(j*k*M_PI/p1);
+            M[2*k-0][j]=SQRT2PI*sin(j*k*M_PI/p1);
+          }
+          M[2*p0-1][j]=SQRT2PI*cos(j*p0*M_PI/p1);
         }
-        M[2*p0-1][j]=SQRT2PI*cos(j*p0*M_PI/p1);
+        Mf=M;
       }
-      Mf=M;
+      CacheSetReady(MfCache, p0*SHMAXDEG+p1);
     }
   }
   return Mf;
@@ -631,22 +716,26 @@ pvfmm::Matrix<Real>& SphericalHarmonics<Real>::MatFourierInv(long p0, long p1){
   assert(p0<SHMAXDEG && p1<SHMAXDEG);
   matrix.Mfinv_ .resize(SHMAXDEG*SHMAXDEG);
   pvfmm::Matrix<Real>& Mf =matrix.Mfinv_ [p0*SHMAXDEG+p1];
-  if(!Mf.Dim(0)){
-    const Real INVSQRT2PI=1.0/sqrt(2*M_PI)/p0;
-    { // Set Mf
-      pvfmm::Matrix<Real> M(2*p0,2*p1);
-      M.SetZero();
-      if(p1>p0) p1=p0;
-      for(long j=0;j<2*p0;j++){
-        M[j][0]=INVSQRT2PI*0.5;
-        for(long k=1;k<p1;k++){
-          M[j][2*k-1]=INVSQRT2PI*cos(j*k*M_PI/p0);
-          M[j][2*k-0]=INVSQRT2PI*sin(j*k*M_PI/p0);
+  if(!CacheReady(MfinvCache, p0*SHMAXDEG+p1)){
+    #pragma omp critical (SHCacheMfinv)
+    if(!CacheReady(MfinvCache, p0*SHMAXDEG+p1)){
+      const Real INVSQRT2PI=1.0/sqrt(2*M_PI)/p0;
+      { // Set Mf
+        pvfmm::Matrix<Real> M(2*p0,2*p1);
+        M.SetZero();
+        if(p1>p0) p1=p0;
+        for(long j=0;j<2*p0;j++){
+          M[j][0]=INVSQRT2PI*0.5;
+          for(long k=1;k<p1;k++){
+            M[j][2*k-1]=INVSQRT2PI*cos(j*k*M_PI/p0);
+            M[j][2*k-0]=INVSQRT2PI*sin(j*k*M_PI/p0);
+          }
+          M[j][2*p1-1]=INVSQRT2PI*cos(j*p1*M_PI/p0);
         }
-        M[j][2*p1-1]=INVSQRT2PI*cos(j*p1*M_PI/p0);
+        if(p1==p0) for(long j=0;j<2*p0;j++) M[j][2*p1-1]*=0.5;
+        Mf=M;
       }
-      if(p1==p0) for(long j=0;j<2*p0;j++) M[j][2*p1-1]*=0.5;
-      Mf=M;
+      CacheSetReady(MfinvCache, p0*SHMAXDEG+p1);
     }
   }
   return Mf;
@@ -657,19 +746,23 @@ pvfmm::Matrix<Real>& SphericalHarmonics<Real>::MatFourierGrad(long p0, long p1){
   assert(p0<SHMAXDEG && p1<SHMAXDEG);
   matrix.Mdf_.resize(SHMAXDEG*SHMAXDEG);
   pvfmm::Matrix<Real>& Mdf=matrix.Mdf_[p0*SHMAXDEG+p1];
-  if(!Mdf.Dim(0)){
-    const Real SQRT2PI=sqrt(2*M_PI);
-    { // Set Mdf_
-      pvfmm::Matrix<Real> M(2*p0,2*p1);
-      for(long j=0;j<2*p1;j++){
-        M[0][j]=SQRT2PI*0.0;
-        for(long k=1;k<p0;k++){
-          M[2*k-1][j]=-SQRT2PI*k*sin(j*k*M_PI/p1);
-          M[2*k-0][j]= SQRT2PI*k*cos(j*k*M_PI/p1);
+  if(!CacheReady(MdfCache, p0*SHMAXDEG+p1)){
+    #pragma omp critical (SHCacheMdf)
+    if(!CacheReady(MdfCache, p0*SHMAXDEG+p1)){
+      const Real SQRT2PI=sqrt(2*M_PI);
+      { // Set Mdf_
+        pvfmm::Matrix<Real> M(2*p0,2*p1);
+        for(long j=0;j<2*p1;j++){
+          M[0][j]=SQRT2PI*0.0;
+          for(long k=1;k<p0;k++){
+            M[2*k-1][j]=-SQRT2PI*k*sin(j*k*M_PI/p1);
+            M[2*k-0][j]= SQRT2PI*k*cos(j*k*M_PI/p1);
+          }
+          M[2*p0-1][j]=-SQRT2PI*p0*sin(j*p0*M_PI/p1);
         }
-        M[2*p0-1][j]=-SQRT2PI*p0*sin(j*p0*M_PI/p1);
+        Mdf=M;
       }
-      Mdf=M;
+      CacheSetReady(MdfCache, p0*SHMAXDEG+p1);
     }
   }
   return Mdf;
@@ -680,21 +773,25 @@ std::vector<pvfmm::Matrix<Real> >& SphericalHarmonics<Real>::MatLegendre(long p0
   assert(p0<SHMAXDEG && p1<SHMAXDEG);
   matrix.Ml_ .resize(SHMAXDEG*SHMAXDEG);
   std::vector<pvfmm::Matrix<Real> >& Ml =matrix.Ml_ [p0*SHMAXDEG+p1];
-  if(!Ml.size()){
-    std::vector<Real> qx1(p1+1);
-    std::vector<Real> qw1(p1+1);
-    cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
-
-    { // Set Ml
-      std::vector<Real> alp(qx1.size()*(p0+1)*(p0+2)/2);
-      LegPoly(&alp[0], &qx1[0], qx1.size(), p0);
-
-      Ml.resize(p0+1);
-      Real* ptr=&alp[0];
-      for(long i=0;i<=p0;i++){
-        Ml[i].ReInit(p0+1-i, qx1.size(), ptr);
-        ptr+=Ml[i].Dim(0)*Ml[i].Dim(1);
+  if(!CacheReady(MlCache, p0*SHMAXDEG+p1)){
+    #pragma omp critical (SHCacheMl)
+    if(!CacheReady(MlCache, p0*SHMAXDEG+p1)){
+      std::vector<Real> qx1(p1+1);
+      std::vector<Real> qw1(p1+1);
+      cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
+
+      { // Set Ml
+        std::vector<Real> alp(qx1.size()*(p0+1)*(p0+2)/2);
+        LegPoly(&alp[0], &qx1[0], qx1.size(), p0);
+
+        Ml.resize(p0+1);
+        Real* ptr=&alp[0];
+        for(long i=0;i<=p0;i++){
+          Ml[i].ReInit(p0+1-i, qx1.size(), ptr);
+          ptr+=Ml[i].Dim(0)*Ml[i].Dim(1);
+        }
       }
+      CacheSetReady(MlCache, p0*SHMAXDEG+p1);
     }
   }
   return Ml;
@@ -705,27 +802,31 @@ std::vector<pvfmm::Matrix<Real> >& SphericalHarmonics<Real>::MatLegendreInv(long
   assert(p0<SHMAXDEG && p1<SHMAXDEG);
   matrix.Mlinv_ .resize(SHMAXDEG*SHMAXDEG);
   std::vector<pvfmm::Matrix<Real> >& Ml =matrix.Mlinv_ [p0*SHMAXDEG+p1];
-  if(!Ml.size()){
-    std::vector<Real> qx1(p0+1);
-    std::vector<Real> qw1(p0+1);
-    cgqf(p0+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
-
-    { // Set Ml
-      std::vector<Real> alp(qx1.size()*(p1+1)*(p1+2)/2);
-      LegPoly(&alp[0], &qx1[0], qx1.size(), p1);
-
-      Ml.resize(p1+1);
-      Real* ptr=&alp[0];
-      for(long i=0;i<=p1;i++){
-        Ml[i].ReInit(qx1.size(), p1+1-i);
-        pvfmm::Matrix<Real> M(p1+1-i, qx1.size(), ptr, false);
-        for(long j=0;j<p1+1-i;j++){ // Transpose and weights
-          for(long k=0;k<qx1.size();k++){
-            Ml[i][k][j]=M[j][k]*qw1[k]*2*M_PI;
+  if(!CacheReady(MlinvCache, p0*SHMAXDEG+p1)){
+    #pragma omp critical (SHCacheMlinv)
+    if(!CacheReady(MlinvCache, p0*SHMAXDEG+p1)){
+      std::vector<Real> qx1(p0+1);
+      std::vector<Real> qw1(p0+1);
+      cgqf(p0+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
+
+      { // Set Ml
+        std::vector<Real> alp(qx1.size()*(p1+1)*(p1+2)/2);
+        LegPoly(&alp[0], &qx1[0], qx1.size(), p1);
+
+        Ml.resize(p1+1);
+        Real* ptr=&alp[0];
+        for(long i=0;i<=p1;i++){
+          Ml[i].ReInit(qx1.size(), p1+1-i);
+          pvfmm::Matrix<Real> M(p1+1-i, qx1.size(), ptr, false);
+          for(long j=0;j<p1+1-i;j++){ // Transpose and weights
+            for(long k=0;k<qx1.size();k++){
+              Ml[i][k][j]=M[j][k]*qw1[k]*2*M_PI;
+            }
           }
+          ptr+=Ml[i].Dim(0)*Ml[i].Dim(1);
         }
-        ptr+=Ml[i].Dim(0)*Ml[i].Dim(1);
       }
+      CacheSetReady(MlinvCache, p0*SHMAXDEG+p1);
     }
   }
   return Ml;
@@ -736,21 +837,25 @@ std::vector<pvfmm::Matrix<Real> >& SphericalHarmonics<Real>::MatLegendreGrad(lon
   assert(p0<SHMAXDEG && p1<SHMAXDEG);
   matrix.Mdl_.resize(SHMAXDEG*SHMAXDEG);
   std::vector<pvfmm::Matrix<Real> >& Mdl=matrix.Mdl_[p0*SHMAXDEG+p1];
-  if(!Mdl.size()){
-    std::vector<Real> qx1(p1+1);
-    std::vector<Real> qw1(p1+1);
-    cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
-
-    { // Set Mdl
-      std::vector<Real> alp(qx1.size()*(p0+1)*(p0+2)/2);
-      LegPolyDeriv(&alp[0], &qx1[0], qx1.size(), p0);
-
-      Mdl.resize(p0+1);
-      Real* ptr=&alp[0];
-      for(long i=0;i<=p0;i++){
-        Mdl[i].ReInit(p0+1-i, qx1.size(), ptr);
-        ptr+=Mdl[i].Dim(0)*Mdl[i].Dim(1);
+  if(!CacheReady(MdlCache, p0*SHMAXDEG+p1)){
+    #pragma omp critical (SHCacheMdl)
+    if(!CacheReady(MdlCache, p0*SHMAXDEG+p1)){
+      std::vector<Real> qx1(p1+1);
+      std::vector<Real> qw1(p1+1);
+      cgqf(p1+1, 1, 0.0, 0.0, -1.0, 1.0, &qx1[0], &qw1[0]);
+
+      { // Set Mdl
+        std::vector<Real> alp(qx1.size()*(p0+1)*(p0+2)/2);
+        LegPolyDeriv(&alp[0], &qx1[0], qx1.size(), p0);
+
+        Mdl.resize(p0+1);
+        Real* ptr=&alp[0];
+        for(long i=0;i<=p0;i++){
+          Mdl[i].ReInit(p0+1-i, qx1.size(), ptr);
+          ptr+=Mdl[i].Dim(0)*Mdl[i].Dim(1);
+        }
       }
+      CacheSetReady(MdlCache, p0*SHMAXDEG+p1);
     }
   }
   return Mdl;
@@ -774,93 +879,97 @@ std::vector<pvfmm::Matrix<Real> >& SphericalHarmonics<Real>::MatRotate(long p0){
   assert(p0<SHMAXDEG);
   matrix.Mr_.resize(SHMAXDEG);
   std::vector<pvfmm::Matrix<Real> >& Mr=matrix.Mr_[p0];
-  if(!Mr.size()){
-    const Real SQRT2PI=sqrt(2*M_PI);
-    long Ncoef=p0*(p0+2);
-    long Ngrid=2*p0*(p0+1);
-    long Naleg=(p0+1)*(p0+2)/2;
-
-    pvfmm::Matrix<Real> Mcoord0(3,Ngrid);
-    pvfmm::Vector<Real>& x=LegendreNodes(p0);
-    for(long i=0;i<p0+1;i++){ // Set Mcoord0
-      for(long j=0;j<2*p0;j++){
-        Mcoord0[0][i*2*p0+j]=x[i];
-        Mcoord0[1][i*2*p0+j]=sqrt(1-x[i]*x[i])*sin(M_PI*j/p0);
-        Mcoord0[2][i*2*p0+j]=sqrt(1-x[i]*x[i])*cos(M_PI*j/p0);
+  if(!CacheReady(MrCache, p0)){
+    #pragma omp critical (SHCacheMr)
+    if(!CacheReady(MrCache, p0)){
+      const Real SQRT2PI=sqrt(2*M_PI);
+      long Ncoef=p0*(p0+2);
+      long Ngrid=2*p0*(p0+1);
+      long Naleg=(p0+1)*(p0+2)/2;
+
+      pvfmm::Matrix<Real> Mcoord0(3,Ngrid);
+      pvfmm::Vector<Real>& x=LegendreNodes(p0);
+      for(long i=0;i<p0+1;i++){ // Set Mcoord0
+        for(long j=0;j<2*p0;j++){
+          Mcoord0[0][i*2*p0+j]=x[i];
+          Mcoord0[1][i*2*p0+j]=sqrt(1-x[i]*x[i])*sin(M_PI*j/p0);
+          Mcoord0[2][i*2*p0+j]=sqrt(1-x[i]*x[i])*cos(M_PI*j/p0);
+        }
       }
-    }
 
-    for(long l=0;l<p0+1;l++){ // For each rotation angle
-      pvfmm::Matrix<Real> Mcoord1;
-      { // Rotate coordinates
-        pvfmm::Matrix<Real> M(COORD_DIM, COORD_DIM);
-        Real cos_=-x[l];
-        Real sin_=-sqrt(1.0-x[l]*x[l]);
-        M[0][0]= cos_; M[0][1]=0; M[0][2]=-sin_;
-        M[1][0]=    0; M[1][1]=1; M[1][2]=    0;
-        M[2][0]= sin_; M[2][1]=0; M[2][2]= cos_;
-        Mcoord1=M*Mcoord0;
-      }
+      for(long l=0;l<p0+1;l++){ // For each rotation angle
+        pvfmm::Matrix<Real> Mcoord1;
+        { // Rotate coordinates
+          pvfmm::Matrix<Real> M(COORD_DIM, COORD_DIM);
+          Real cos_=-x[l];
+          Real sin_=-sqrt(1.0-x[l]*x[l]);
+          M[0][0]= cos_; M[0][1]=0; M[0][2]=-sin_;
+          M[1][0]=    0; M[1][1]=1; M[1][2]=    0;
+          M[2][0]= sin_; M[2][1]=0; M[2][2]= cos_;
+          Mcoord1=M*Mcoord0;
+        }
 
-      pvfmm::Matrix<Real> Mleg(Naleg, Ngrid);
-      { // Set Mleg
-        LegPoly(&Mleg[0][0], &Mcoord1[0][0], Ngrid, p0);
-      }
+        pvfmm::Matrix<Real> Mleg(Naleg, Ngrid);
+        { // Set Mleg
+          LegPoly(&Mleg[0][0], &Mcoord1[0][0], Ngrid, p0);
+        }
 
-      pvfmm::Vector<Real> theta(Ngrid);
-      for(long i=0;i<theta.Dim();i++){ // Set theta
-        theta[i]=atan2(Mcoord1[1][i],Mcoord1[2][i]);
-      }
+        pvfmm::Vector<Real> theta(Ngrid);
+        for(long i=0;i<theta.Dim();i++){ // Set theta
+          theta[i]=atan2(Mcoord1[1][i],Mcoord1[2][i]);
+        }
 
-      pvfmm::Matrix<Real> Mcoef2grid(Ncoef, Ngrid);
-      { // Build Mcoef2grid
-        long offset0=0;
-        long offset1=0;
-        for(long i=0;i<p0+1;i++){
-          long len=p0+1-i;
-          { // P * cos
-            for(long j=0;j<len;j++){
-              for(long k=0;k<Ngrid;k++){
-                Mcoef2grid[offset1+j][k]=SQRT2PI*Mleg[offset0+j][k]*cos(i*theta[k]);
+        pvfmm::Matrix<Real> Mcoef2grid(Ncoef, Ngrid);
+        { // Build Mcoef2grid
+          long offset0=0;
+          long offset1=0;
+          for(long i=0;i<p0+1;i++){
+            long len=p0+1-i;
+            { // P * cos
+              for(long j=0;j<len;j++){
+                for(long k=0;k<Ngrid;k++){
+                  Mcoef2grid[offset1+j][k]=SQRT2PI*Mleg[offset0+j][k]*cos(i*theta[k]);
+                }
               }
+              offset1+=len;
             }
-            offset1+=len;
-          }
-          if(i!=0 && i!=p0){ // P * sin
-            for(long j=0;j<len;j++){
-              for(long k=0;k<Ngrid;k++){
-                Mcoef2grid[offset1+j][k]=SQRT2PI*Mleg[offset0+j][k]*sin(i*theta[k]);
+            if(i!=0 && i!=p0){ // P * sin
+              for(long j=0;j<len;j++){
+                for(long k=0;k<Ngrid;k++){
+                  Mcoef2grid[offset1+j][k]=SQRT2PI*Mleg[offset0+j][k]*sin(i*theta[k]);
+                }
               }
+              offset1+=len;
             }
-            offset1+=len;
+            offset0+=len;
           }
-          offset0+=len;
+          assert(offset0==Naleg);
+          assert(offset1==Ncoef);
         }
-        assert(offset0==Naleg);
-        assert(offset1==Ncoef);
-      }
 
-      pvfmm::Vector<Real> Vcoef2coef(Ncoef*Ncoef);
-      pvfmm::Vector<Real> Vcoef2grid(Ncoef*Ngrid, &Mcoef2grid[0][0],false);
-      Grid2SHC(Vcoef2grid, p0, p0, Vcoef2coef);
+        pvfmm::Vector<Real> Vcoef2coef(Ncoef*Ncoef);
+        pvfmm::Vector<Real> Vcoef2grid(Ncoef*Ngrid, &Mcoef2grid[0][0],false);
+        Grid2SHC(Vcoef2grid, p0, p0, Vcoef2coef);
 
-      pvfmm::Matrix<Real> Mcoef2coef(Ncoef, Ncoef, &Vcoef2coef[0],false);
-      for(long n=0;n<=p0;n++){ // Create matrices for fast rotation
-        pvfmm::Matrix<Real> M(coeff_perm[n].size(),coeff_perm[n].size());
-        for(long i=0;i<coeff_perm[n].size();i++){
-          for(long j=0;j<coeff_perm[n].size();j++){
-            M[i][j]=Mcoef2coef[coeff_perm[n][i]][coeff_perm[n][j]];
+        pvfmm::Matrix<Real> Mcoef2coef(Ncoef, Ncoef, &Vcoef2coef[0],false);
+        for(long n=0;n<=p0;n++){ // Create matrices for fast rotation
+          pvfmm::Matrix<Real> M(coeff_perm[n].size(),coeff_perm[n].size());
+          for(long i=0;i<coeff_perm[n].size();i++){
+            for(long j=0;j<coeff_perm[n].size();j++){
+              M[i][j]=Mcoef2coef[coeff_perm[n][i]][coeff_perm[n][j]];
+            }
           }
+          Mr.push_back(M);
         }
-        Mr.push_back(M);
       }
+      CacheSetReady(MrCache, p0);
     }
   }
   return Mr;
 }
 
 template <class Real>
-void SphericalHarmonics<Real>::StokesSingularInteg(const pvfmm::Vector<Real>& S, long p0, long p1, pvfmm::Vector<Real>* SLMatrix, pvfmm::Vector<Real>* DLMatrix){
+void SphericalHarmonics<Real>::StokesSingularInteg(const pvfmm::Vector<Real>& S, long p0, long p1, pvfmm::Vector<Real>* SLMatrix, pvfmm::Vector<Real>* DLMatrix, SHWorkspace<Real>* ws){
   long Ngrid=2*p0*(p0+1);
   long Ncoef=  p0*(p0+2);
   long Nves=S.Dim()/(Ngrid*COORD_DIM);
@@ -871,6 +980,7 @@ void SphericalHarmonics<Real>::StokesSingularInteg(const pvfmm::Vector<Real>& S,
   BLOCK_SIZE=std::min<long>(BLOCK_SIZE,omp_get_max_threads());
   BLOCK_SIZE=std::max<long>(BLOCK_SIZE,1);
 
+  typename SHWorkspace<Real>::Frame frame(ws); // shared by the blocks
   for(long a=0;a<Nves;a+=BLOCK_SIZE){
     long b=std::min(a+BLOCK_SIZE, Nves);
 
@@ -879,9 +989,9 @@ void SphericalHarmonics<Real>::StokesSingularInteg(const pvfmm::Vector<Real>& S,
     if(DLMatrix) _DLMatrix.ReInit((b-a)*(Ncoef*COORD_DIM)*(Ncoef*COORD_DIM),&DLMatrix[0][a*(Ncoef*COORD_DIM)*(Ncoef*COORD_DIM)],false);
     _S                    .ReInit((b-a)*(Ngrid*COORD_DIM)                  ,&S          [a*(Ngrid*COORD_DIM)                  ],false);
 
-    if(SLMatrix && DLMatrix) StokesSingularInteg_< true,  true>(_S, p0, p1, _SLMatrix, _DLMatrix);
-    else        if(SLMatrix) StokesSingularInteg_< true, false>(_S, p0, p1, _SLMatrix, _DLMatrix);
-    else        if(DLMatrix) StokesSingularInteg_<false,  true>(_S, p0, p1, _SLMatrix, _DLMatrix);
+    if(SLMatrix && DLMatrix) StokesSingularInteg_< true,  true>(_S, p0, p1, _SLMatrix, _DLMatrix, frame.Workspace());
+    else        if(SLMatrix) StokesSingularInteg_< true, false>(_S, p0, p1, _SLMatrix, _DLMatrix, frame.Workspace());
+    else        if(DLMatrix) StokesSingularInteg_<false,  true>(_S, p0, p1, _SLMatrix, _DLMatrix, frame.Workspace());
   }
 }
 
@@ -951,40 +1061,43 @@ void SphericalHarmonics<Real>::LegPolyDeriv(Real* poly_val, const Real* X, long
 
 template <class Real>
 template <bool SLayer, bool DLayer>
-void SphericalHarmonics<Real>::StokesSingularInteg_(const pvfmm::Vector<Real>& X0, long p0, long p1, pvfmm::Vector<Real>& SL, pvfmm::Vector<Real>& DL){
+void SphericalHarmonics<Real>::StokesSingularInteg_(const pvfmm::Vector<Real>& X0, long p0, long p1, pvfmm::Vector<Real>& SL, pvfmm::Vector<Real>& DL, SHWorkspace<Real>* ws){
 
+  typename SHWorkspace<Real>::Frame frame(ws);
+  pvfmm::Vector<Real>& S0=frame.Get();
+  pvfmm::Vector<Real>& S =frame.Get();
   pvfmm::Profile::Tic("Rotate");
-  static pvfmm::Vector<Real> S0, S;
-  SphericalHarmonics<Real>::Grid2SHC(X0, p0, p0, S0);
+  SphericalHarmonics<Real>::Grid2SHC(X0, p0, p0, S0, frame.Workspace());
   SphericalHarmonics<Real>::RotateAll(S0, p0, COORD_DIM, S);
   pvfmm::Profile::Toc();
 
 
   pvfmm::Profile::Tic("Upsample");
-  pvfmm::Vector<Real> X, X_phi, X_theta, trg;
-  SphericalHarmonics<Real>::SHC2Grid(S, p0, p1, X, &X_theta, &X_phi);
+  pvfmm::Vector<Real>& X      =frame.Get();
+  pvfmm::Vector<Real>& X_phi  =frame.Get();
+  pvfmm::Vector<Real>& X_theta=frame.Get();
+  pvfmm::Vector<Real>& trg    =frame.Get();
+  SphericalHarmonics<Real>::SHC2Grid(S, p0, p1, X, &X_theta, &X_phi, frame.Workspace());
   SphericalHarmonics<Real>::SHC2Pole(S, p0, trg);
   pvfmm::Profile::Toc();
 
 
   pvfmm::Profile::Tic("Stokes");
-  pvfmm::Vector<Real> SL0, DL0;
+  pvfmm::Vector<Real>& SL0=frame.Get();
+  pvfmm::Vector<Real>& DL0=frame.Get();
   { // Stokes kernel
     long M0=2*p0*(p0+1);
     long M1=2*p1*(p1+1);
     long N=trg.Dim()/(2*COORD_DIM);
     assert(X.Dim()==M1*COORD_DIM*N);
-    if(SLayer && SL0.Dim()!=N*2*6*M1) SL0.ReInit(2*N*6*M1);
-    if(DLayer && DL0.Dim()!=N*2*6*M1) DL0.ReInit(2*N*6*M1);
+    SL0.ReInit(SLayer?2*N*6*M1:0); // unused layer stays empty
+    DL0.ReInit(DLayer?2*N*6*M1:0);
     pvfmm::Vector<Real>& qw=SphericalHarmonics<Real>::SingularWeights(p1);
 
     const Real scal_const_dl = 3.0/(4.0*M_PI);
     const Real scal_const_sl = 1.0/(8.0*M_PI);
-    static Real eps=-1;
-    if(eps<0){
-      eps=1;
-      while(eps*(Real)0.5+(Real)1.0>1.0) eps*=0.5;
-    }
+    Real eps=1;
+    while(eps*(Real)0.5+(Real)1.0>1.0) eps*=0.5;
 
     #pragma omp parallel
     {
@@ -1074,21 +1187,24 @@ void SphericalHarmonics<Real>::StokesSingularInteg_(const pvfmm::Vector<Real>& X
 
 
   pvfmm::Profile::Tic("UpsampleTranspose");
-  static pvfmm::Vector<Real> SL1, DL1;
-  SphericalHarmonics<Real>::SHC2GridTranspose(SL0, p1, p0, SL1);
-  SphericalHarmonics<Real>::SHC2GridTranspose(DL0, p1, p0, DL1);
+  pvfmm::Vector<Real>& SL1=frame.Get();
+  pvfmm::Vector<Real>& DL1=frame.Get();
+  SphericalHarmonics<Real>::SHC2GridTranspose(SL0, p1, p0, SL1, frame.Workspace());
+  SphericalHarmonics<Real>::SHC2GridTranspose(DL0, p1, p0, DL1, frame.Workspace());
   pvfmm::Profile::Toc();
 
 
   pvfmm::Profile::Tic("RotateTranspose");
-  static pvfmm::Vector<Real> SL2, DL2;
+  pvfmm::Vector<Real>& SL2=frame.Get();
+  pvfmm::Vector<Real>& DL2=frame.Get();
   SphericalHarmonics<Real>::RotateTranspose(SL1, p0, 2*6, SL2);
   SphericalHarmonics<Real>::RotateTranspose(DL1, p0, 2*6, DL2);
   pvfmm::Profile::Toc();
 
 
   pvfmm::Profile::Tic("Rearrange");
-  static pvfmm::Vector<Real> SL3, DL3;
+  pvfmm::Vector<Real>& SL3=frame.Get();
+  pvfmm::Vector<Real>& DL3=frame.Get();
   { // Transpose
     long Ncoef=p0*(p0+2);
     long Ngrid=2*p0*(p0+1);
@@ -1173,8 +1289,8 @@ void SphericalHarmonics<Real>::StokesSingularInteg_(const pvfmm::Vector<Real>& X
 
 
   pvfmm::Profile::Tic("Grid2SHC");
-  SphericalHarmonics<Real>::Grid2SHC(SL3, p0, p0, SL);
-  SphericalHarmonics<Real>::Grid2SHC(DL3, p0, p0, DL);
+  SphericalHarmonics<Real>::Grid2SHC(SL3, p0, p0, SL, frame.Workspace());
+  SphericalHarmonics<Real>::Grid2SHC(DL3, p0, p0, DL, frame.Workspace());
   pvfmm::Profile::Toc();
 
 }
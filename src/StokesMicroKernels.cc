@@ -0,0 +1,504 @@
+/**
+ * Direct Stokes micro-kernels for one instruction set.
+ *
+ * PVFMMInterface.cc includes this file once per instruction set, each time
+ * inside its own namespace and with the matching GCC target enabled, so
+ * that every vector width is compiled into the same binary whatever the
+ * compiler flags. STOKES_UKERNEL_ISA selects the vector types (the order
+ * of the KernelISA enum): 0 scalar, 1 SSE3, 2 AVX, 3 AVX-512.
+ *
+ * The intrinsic wrappers follow the PVFMM ones but are local to the
+ * namespace: the PVFMM versions are only defined for the widths enabled at
+ * compile time. Scalar masks are 0 or 1, so that and_intrin(cmplt_intrin())
+ * selects as the bit masks of the vector versions do.
+ */
+
+template <class Real_t> struct VecType{ typedef Real_t type; };
+
+template <class Vec_t> inline Vec_t zero_intrin(){ return 0; }
+template <class Vec_t, class Real_t> inline Vec_t set_intrin  (const Real_t& a){ return a; }
+template <class Vec_t, class Real_t> inline Vec_t load_intrin (Real_t const* a){ return a[0]; }
+template <class Vec_t, class Real_t> inline Vec_t bcast_intrin(Real_t const* a){ return a[0]; }
+template <class Vec_t, class Real_t> inline void  store_intrin(Real_t* a, const Vec_t& b){ a[0]=b; }
+
+template <class Vec_t> inline Vec_t mul_intrin  (const Vec_t& a, const Vec_t& b){ return a*b; }
+template <class Vec_t> inline Vec_t add_intrin  (const Vec_t& a, const Vec_t& b){ return a+b; }
+template <class Vec_t> inline Vec_t sub_intrin  (const Vec_t& a, const Vec_t& b){ return a-b; }
+template <class Vec_t> inline Vec_t cmplt_intrin(const Vec_t& a, const Vec_t& b){ return (a<b?1:0); }
+template <class Vec_t> inline Vec_t and_intrin  (const Vec_t& a, const Vec_t& b){ return a*b; }
+
+// Exact for scalars; zero for r2=0 as the vector versions
+template <class Vec_t> inline Vec_t rsqrt_approx_intrin(const Vec_t& r2){ return (r2>0?1/sqrt(r2):0); }
+
+template <class Vec_t, class Real_t> inline void rsqrt_newton_intrin(Vec_t& rinv, const Vec_t& r2, const Real_t& nwtn_const){
+  rinv=rinv*(nwtn_const-r2*rinv*rinv);
+}
+
+#if STOKES_UKERNEL_ISA==1
+template <> struct VecType<float >{ typedef __m128  type; };
+template <> struct VecType<double>{ typedef __m128d type; };
+
+template <> inline __m128  zero_intrin<__m128 >(){ return _mm_setzero_ps(); }
+template <> inline __m128d zero_intrin<__m128d>(){ return _mm_setzero_pd(); }
+
+template <> inline __m128  set_intrin<__m128 , float >(const float & a){ return _mm_set1_ps(a); }
+template <> inline __m128d set_intrin<__m128d, double>(const double& a){ return _mm_set1_pd(a); }
+
+template <> inline __m128  load_intrin<__m128 , float >(float  const* a){ return _mm_load_ps(a); }
+template <> inline __m128d load_intrin<__m128d, double>(double const* a){ return _mm_load_pd(a); }
+
+template <> inline __m128  bcast_intrin<__m128 , float >(float  const* a){ return _mm_set1_ps(a[0]); }
+template <> inline __m128d bcast_intrin<__m128d, double>(double const* a){ return _mm_set1_pd(a[0]); }
+
+template <> inline void store_intrin(float * a, const __m128 & b){ _mm_store_ps(a,b); }
+template <> inline void store_intrin(double* a, const __m128d& b){ _mm_store_pd(a,b); }
+
+template <> inline __m128  mul_intrin(const __m128 & a, const __m128 & b){ return _mm_mul_ps(a,b); }
+template <> inline __m128d mul_intrin(const __m128d& a, const __m128d& b){ return _mm_mul_pd(a,b); }
+
+template <> inline __m128  add_intrin(const __m128 & a, const __m128 & b){ return _mm_add_ps(a,b); }
+template <> inline __m128d add_intrin(const __m128d& a, const __m128d& b){ return _mm_add_pd(a,b); }
+
+template <> inline __m128  sub_intrin(const __m128 & a, const __m128 & b){ return _mm_sub_ps(a,b); }
+template <> inline __m128d sub_intrin(const __m128d& a, const __m128d& b){ return _mm_sub_pd(a,b); }
+
+template <> inline __m128  cmplt_intrin(const __m128 & a, const __m128 & b){ return _mm_cmplt_ps(a,b); }
+template <> inline __m128d cmplt_intrin(const __m128d& a, const __m128d& b){ return _mm_cmplt_pd(a,b); }
+
+template <> inline __m128  and_intrin(const __m128 & a, const __m128 & b){ return _mm_and_ps(a,b); }
+template <> inline __m128d and_intrin(const __m128d& a, const __m128d& b){ return _mm_and_pd(a,b); }
+
+template <> inline __m128  rsqrt_approx_intrin(const __m128 & r2){
+  return _mm_andnot_ps(_mm_cmpeq_ps(r2,_mm_setzero_ps()),_mm_rsqrt_ps(r2));
+}
+template <> inline __m128d rsqrt_approx_intrin(const __m128d& r2){
+  return _mm_andnot_pd(_mm_cmpeq_pd(r2,_mm_setzero_pd()),_mm_cvtps_pd(_mm_rsqrt_ps(_mm_cvtpd_ps(r2))));
+}
+
+template <> inline void rsqrt_newton_intrin(__m128 & rinv, const __m128 & r2, const float & nwtn_const){
+  rinv=_mm_mul_ps(rinv,_mm_sub_ps(_mm_set1_ps(nwtn_const),_mm_mul_ps(r2,_mm_mul_ps(rinv,rinv))));
+}
+template <> inline void rsqrt_newton_intrin(__m128d& rinv, const __m128d& r2, const double& nwtn_const){
+  rinv=_mm_mul_pd(rinv,_mm_sub_pd(_mm_set1_pd(nwtn_const),_mm_mul_pd(r2,_mm_mul_pd(rinv,rinv))));
+}
+#endif
+
+#if STOKES_UKERNEL_ISA==2
+template <> struct VecType<float >{ typedef __m256  type; };
+template <> struct VecType<double>{ typedef __m256d type; };
+
+template <> inline __m256  zero_intrin<__m256 >(){ return _mm256_setzero_ps(); }
+template <> inline __m256d zero_intrin<__m256d>(){ return _mm256_setzero_pd(); }
+
+template <> inline __m256  set_intrin<__m256 , float >(const float & a){ return _mm256_set1_ps(a); }
+template <> inline __m256d set_intrin<__m256d, double>(const double& a){ return _mm256_set1_pd(a); }
+
+template <> inline __m256  load_intrin<__m256 , float >(float  const* a){ return _mm256_load_ps(a); }
+template <> inline __m256d load_intrin<__m256d, double>(double const* a){ return _mm256_load_pd(a); }
+
+template <> inline __m256  bcast_intrin<__m256 , float >(float  const* a){ return _mm256_broadcast_ss(a); }
+template <> inline __m256d bcast_intrin<__m256d, double>(double const* a){ return _mm256_broadcast_sd(a); }
+
+template <> inline void store_intrin(float * a, const __m256 & b){ _mm256_store_ps(a,b); }
+template <> inline void store_intrin(double* a, const __m256d& b){ _mm256_store_pd(a,b); }
+
+template <> inline __m256  mul_intrin(const __m256 & a, const __m256 & b){ return _mm256_mul_ps(a,b); }
+template <> inline __m256d mul_intrin(const __m256d& a, const __m256d& b){ return _mm256_mul_pd(a,b); }
+
+template <> inline __m256  add_intrin(const __m256 & a, const __m256 & b){ return _mm256_add_ps(a,b); }
+template <> inline __m256d add_intrin(const __m256d& a, const __m256d& b){ return _mm256_add_pd(a,b); }
+
+template <> inline __m256  sub_intrin(const __m256 & a, const __m256 & b){ return _mm256_sub_ps(a,b); }
+template <> inline __m256d sub_intrin(const __m256d& a, const __m256d& b){ return _mm256_sub_pd(a,b); }
+
+template <> inline __m256  cmplt_intrin(const __m256 & a, const __m256 & b){ return _mm256_cmp_ps(a,b,_CMP_LT_OS); }
+template <> inline __m256d cmplt_intrin(const __m256d& a, const __m256d& b){ return _mm256_cmp_pd(a,b,_CMP_LT_OS); }
+
+template <> inline __m256  and_intrin(const __m256 & a, const __m256 & b){ return _mm256_and_ps(a,b); }
+template <> inline __m256d and_intrin(const __m256d& a, const __m256d& b){ return _mm256_and_pd(a,b); }
+
+template <> inline __m256  rsqrt_approx_intrin(const __m256 & r2){
+  return _mm256_andnot_ps(_mm256_cmp_ps(r2,_mm256_setzero_ps(),_CMP_EQ_OS),_mm256_rsqrt_ps(r2));
+}
+template <> inline __m256d rsqrt_approx_intrin(const __m256d& r2){
+  return _mm256_andnot_pd(_mm256_cmp_pd(r2,_mm256_setzero_pd(),_CMP_EQ_OS),_mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(r2))));
+}
+
+template <> inline void rsqrt_newton_intrin(__m256 & rinv, const __m256 & r2, const float & nwtn_const){
+  rinv=_mm256_mul_ps(rinv,_mm256_sub_ps(_mm256_set1_ps(nwtn_const),_mm256_mul_ps(r2,_mm256_mul_ps(rinv,rinv))));
+}
+template <> inline void rsqrt_newton_intrin(__m256d& rinv, const __m256d& r2, const double& nwtn_const){
+  rinv=_mm256_mul_pd(rinv,_mm256_sub_pd(_mm256_set1_pd(nwtn_const),_mm256_mul_pd(r2,_mm256_mul_pd(rinv,rinv))));
+}
+#endif
+
+#if STOKES_UKERNEL_ISA==3
+template <> struct VecType<float >{ typedef __m512  type; };
+template <> struct VecType<double>{ typedef __m512d type; };
+
+template <> inline __m512  zero_intrin<__m512 >(){ return _mm512_setzero_ps(); }
+template <> inline __m512d zero_intrin<__m512d>(){ return _mm512_setzero_pd(); }
+
+template <> inline __m512  set_intrin<__m512 , float >(const float & a){ return _mm512_set1_ps(a); }
+template <> inline __m512d set_intrin<__m512d, double>(const double& a){ return _mm512_set1_pd(a); }
+
+template <> inline __m512  load_intrin<__m512 , float >(float  const* a){ return _mm512_load_ps(a); }
+template <> inline __m512d load_intrin<__m512d, double>(double const* a){ return _mm512_load_pd(a); }
+
+template <> inline __m512  bcast_intrin<__m512 , float >(float  const* a){ return _mm512_set1_ps(a[0]); }
+template <> inline __m512d bcast_intrin<__m512d, double>(double const* a){ return _mm512_set1_pd(a[0]); }
+
+template <> inline void store_intrin(float * a, const __m512 & b){ _mm512_store_ps(a,b); }
+template <> inline void store_intrin(double* a, const __m512d& b){ _mm512_store_pd(a,b); }
+
+template <> inline __m512  mul_intrin(const __m512 & a, const __m512 & b){ return _mm512_mul_ps(a,b); }
+template <> inline __m512d mul_intrin(const __m512d& a, const __m512d& b){ return _mm512_mul_pd(a,b); }
+
+template <> inline __m512  add_intrin(const __m512 & a, const __m512 & b){ return _mm512_add_ps(a,b); }
+template <> inline __m512d add_intrin(const __m512d& a, const __m512d& b){ return _mm512_add_pd(a,b); }
+
+template <> inline __m512  sub_intrin(const __m512 & a, const __m512 & b){ return _mm512_sub_ps(a,b); }
+template <> inline __m512d sub_intrin(const __m512d& a, const __m512d& b){ return _mm512_sub_pd(a,b); }
+
+// AVX-512F compares into a mask register; expand it to a bit-mask vector
+// so that the kernels can keep using and_intrin(cmplt_intrin(...),...).
+template <> inline __m512  cmplt_intrin(const __m512 & a, const __m512 & b){
+  return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(a,b,_CMP_LT_OS),-1));
+}
+template <> inline __m512d cmplt_intrin(const __m512d& a, const __m512d& b){
+  return _mm512_castsi512_pd(_mm512_maskz_set1_epi64(_mm512_cmp_pd_mask(a,b,_CMP_LT_OS),-1));
+}
+
+template <> inline __m512  and_intrin(const __m512 & a, const __m512 & b){
+  return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a),_mm512_castps_si512(b)));
+}
+template <> inline __m512d and_intrin(const __m512d& a, const __m512d& b){
+  return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a),_mm512_castpd_si512(b)));
+}
+
+// rsqrt14 is accurate to 2^-14 and returns inf for r2=0, zero those lanes
+// as the 128/256-bit versions do.
+template <> inline __m512  rsqrt_approx_intrin(const __m512 & r2){
+  return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(r2,_mm512_setzero_ps(),_CMP_NEQ_OQ),_mm512_rsqrt14_ps(r2));
+}
+template <> inline __m512d rsqrt_approx_intrin(const __m512d& r2){
+  return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(r2,_mm512_setzero_pd(),_CMP_NEQ_OQ),_mm512_rsqrt14_pd(r2));
+}
+
+template <> inline void rsqrt_newton_intrin(__m512 & rinv, const __m512 & r2, const float & nwtn_const){
+  rinv=_mm512_mul_ps(rinv,_mm512_sub_ps(_mm512_set1_ps(nwtn_const),_mm512_mul_ps(r2,_mm512_mul_ps(rinv,rinv))));
+}
+template <> inline void rsqrt_newton_intrin(__m512d& rinv, const __m512d& r2, const double& nwtn_const){
+  rinv=_mm512_mul_pd(rinv,_mm512_sub_pd(_mm512_set1_pd(nwtn_const),_mm512_mul_pd(r2,_mm512_mul_pd(rinv,rinv))));
+}
+#endif
+
+// Approximate 1/sqrt(r2) refined by NWTN Newton iterations; the result is
+// scaled by nwtn_scal (see the kernels), which saves a multiplication per
+// iteration.
+template <class Vec_t, class Real_t, int NWTN>
+inline Vec_t rsqrt_intrin(const Vec_t& r2){
+  Vec_t rinv=rsqrt_approx_intrin(r2);
+  if(NWTN>0) rsqrt_newton_intrin(rinv,r2,(Real_t)3);
+  if(NWTN>1) rsqrt_newton_intrin(rinv,r2,(Real_t)12);
+  if(NWTN>2) rsqrt_newton_intrin(rinv,r2,(Real_t)768);
+  return rinv;
+}
+
+/**
+ * Same as pvfmm::generic_kernel but the padding and alignment of the
+ * rearranged arrays follow Vec_t (generic_kernel pads for at most 256-bit
+ * vectors).
+ */
+template <class Real_t, class Vec_t, int SRC_DIM, int TRG_DIM, void (*uKernel)(pvfmm::Matrix<Real_t>&, pvfmm::Matrix<Real_t>&, pvfmm::Matrix<Real_t>&, pvfmm::Matrix<Real_t>&)>
+void stokes_generic_kernel(Real_t* r_src, int src_cnt, Real_t* v_src, int dof, Real_t* r_trg, int trg_cnt, Real_t* v_trg, pvfmm::mem::MemoryManager* mem_mgr){
+  #define STACK_BUFF_SIZE 4096
+  #define BUFF_ALIGN 64
+  assert(dof==1);
+  int VecLen=sizeof(Vec_t)/sizeof(Real_t);
+  int src_cnt_=((src_cnt+VecLen-1)/VecLen)*VecLen;
+  int trg_cnt_=((trg_cnt+VecLen-1)/VecLen)*VecLen;
+
+  Real_t stack_buff[STACK_BUFF_SIZE+BUFF_ALIGN];
+  Real_t* buff=NULL;
+  Real_t* buff_ptr=NULL;
+  size_t buff_size=src_cnt_*(COORD_DIM+SRC_DIM)+trg_cnt_*(COORD_DIM+TRG_DIM);
+  if(buff_size>STACK_BUFF_SIZE){
+    buff=pvfmm::mem::aligned_new<Real_t>(buff_size, mem_mgr);
+    buff_ptr=buff;
+  }else{
+    uintptr_t ptr=(uintptr_t)stack_buff;
+    buff_ptr=(Real_t*)((ptr+BUFF_ALIGN-1) & ~((uintptr_t)BUFF_ALIGN-1));
+  }
+
+  pvfmm::Matrix<Real_t> src_coord, src_value, trg_coord, trg_value;
+  src_coord.ReInit(COORD_DIM, src_cnt_, buff_ptr, false); buff_ptr+=COORD_DIM*src_cnt_;
+  src_value.ReInit(  SRC_DIM, src_cnt_, buff_ptr, false); buff_ptr+=  SRC_DIM*src_cnt_;
+  trg_coord.ReInit(COORD_DIM, trg_cnt_, buff_ptr, false); buff_ptr+=COORD_DIM*trg_cnt_;
+  trg_value.ReInit(  TRG_DIM, trg_cnt_, buff_ptr, false);
+
+  for(int i=0;i<src_cnt_;i++){
+    for(int j=0;j<COORD_DIM;j++) src_coord[j][i]=(i<src_cnt?r_src[i*COORD_DIM+j]:0);
+    for(int j=0;j<  SRC_DIM;j++) src_value[j][i]=(i<src_cnt?v_src[i*  SRC_DIM+j]:0);
+  }
+  for(int i=0;i<trg_cnt_;i++){
+    for(int j=0;j<COORD_DIM;j++) trg_coord[j][i]=(i<trg_cnt?r_trg[i*COORD_DIM+j]:0);
+    for(int j=0;j<  TRG_DIM;j++) trg_value[j][i]=0;
+  }
+
+  uKernel(src_coord,src_value,trg_coord,trg_value);
+
+  for(int i=0;i<trg_cnt;i++){
+    for(int j=0;j<TRG_DIM;j++) v_trg[i*TRG_DIM+j]+=trg_value[j][i];
+  }
+
+  if(buff) pvfmm::mem::aligned_delete<Real_t>(buff,mem_mgr);
+  #undef STACK_BUFF_SIZE
+  #undef BUFF_ALIGN
+}
+
+////////// Stokes Kernel //////////
+
+template <class Real_t, class Vec_t, int NWTN_ITER>
+void stokes_sl_m2l_uKernel(pvfmm::Matrix<Real_t>& src_coord, pvfmm::Matrix<Real_t>& src_value, pvfmm::Matrix<Real_t>& trg_coord, pvfmm::Matrix<Real_t>& trg_value){
+  #define SRC_BLK 500
+  size_t VecLen=sizeof(Vec_t)/sizeof(Real_t);
+
+  Real_t nwtn_scal=1; // scaling factor for newton iterations
+  for(int i=0;i<NWTN_ITER;i++){
+    nwtn_scal=2*nwtn_scal*nwtn_scal*nwtn_scal;
+  }
+  const Real_t OOEP = 1.0/(8*nwtn_scal*pvfmm::const_pi<Real_t>());
+  Vec_t inv_nwtn_scal2=set_intrin<Vec_t,Real_t>(1.0/(nwtn_scal*nwtn_scal));
+
+  size_t src_cnt_=src_coord.Dim(1);
+  size_t trg_cnt_=trg_coord.Dim(1);
+  for(size_t sblk=0;sblk<src_cnt_;sblk+=SRC_BLK){
+    size_t src_cnt=src_cnt_-sblk;
+    if(src_cnt>SRC_BLK) src_cnt=SRC_BLK;
+    for(size_t t=0;t<trg_cnt_;t+=VecLen){
+      Vec_t tx=load_intrin<Vec_t>(&trg_coord[0][t]);
+      Vec_t ty=load_intrin<Vec_t>(&trg_coord[1][t]);
+      Vec_t tz=load_intrin<Vec_t>(&trg_coord[2][t]);
+
+      Vec_t tvx=zero_intrin<Vec_t>();
+      Vec_t tvy=zero_intrin<Vec_t>();
+      Vec_t tvz=zero_intrin<Vec_t>();
+      for(size_t s=sblk;s<sblk+src_cnt;s++){
+        Vec_t dx=sub_intrin(tx,bcast_intrin<Vec_t>(&src_coord[0][s]));
+        Vec_t dy=sub_intrin(ty,bcast_intrin<Vec_t>(&src_coord[1][s]));
+        Vec_t dz=sub_intrin(tz,bcast_intrin<Vec_t>(&src_coord[2][s]));
+
+        Vec_t svx       =bcast_intrin<Vec_t>(&src_value[0][s]);
+        Vec_t svy       =bcast_intrin<Vec_t>(&src_value[1][s]);
+        Vec_t svz       =bcast_intrin<Vec_t>(&src_value[2][s]);
+        Vec_t inner_prod=bcast_intrin<Vec_t>(&src_value[3][s]);
+
+        Vec_t r2=        mul_intrin(dx,dx) ;
+        r2=add_intrin(r2,mul_intrin(dy,dy));
+        r2=add_intrin(r2,mul_intrin(dz,dz));
+
+        Vec_t rinv=rsqrt_intrin<Vec_t,Real_t,NWTN_ITER>(r2);
+        Vec_t rinv2=mul_intrin(mul_intrin(rinv,rinv),inv_nwtn_scal2);
+
+        inner_prod=add_intrin(inner_prod,mul_intrin(svx,dx));
+        inner_prod=add_intrin(inner_prod,mul_intrin(svy,dy));
+        inner_prod=add_intrin(inner_prod,mul_intrin(svz,dz));
+        inner_prod=mul_intrin(inner_prod,rinv2);
+
+        tvx=add_intrin(tvx,mul_intrin(rinv,add_intrin(svx,mul_intrin(dx,inner_prod))));
+        tvy=add_intrin(tvy,mul_intrin(rinv,add_intrin(svy,mul_intrin(dy,inner_prod))));
+        tvz=add_intrin(tvz,mul_intrin(rinv,add_intrin(svz,mul_intrin(dz,inner_prod))));
+      }
+      Vec_t ooep=set_intrin<Vec_t,Real_t>(OOEP);
+
+      tvx=add_intrin(mul_intrin(tvx,ooep),load_intrin<Vec_t>(&trg_value[0][t]));
+      tvy=add_intrin(mul_intrin(tvy,ooep),load_intrin<Vec_t>(&trg_value[1][t]));
+      tvz=add_intrin(mul_intrin(tvz,ooep),load_intrin<Vec_t>(&trg_value[2][t]));
+
+      store_intrin(&trg_value[0][t],tvx);
+      store_intrin(&trg_value[1][t],tvy);
+      store_intrin(&trg_value[2][t],tvz);
+    }
+  }
+
+  { // Add FLOPS
+    #ifndef __MIC__
+    pvfmm::Profile::Add_FLOP((long long)trg_cnt_*(long long)src_cnt_*(29+4*(NWTN_ITER)));
+    #endif
+  }
+  #undef SRC_BLK
+}
+
+template <class Real_t, class Vec_t, int NWTN_ITER>
+void stokes_sl_uKernel(pvfmm::Matrix<Real_t>& src_coord, pvfmm::Matrix<Real_t>& src_value, pvfmm::Matrix<Real_t>& trg_coord, pvfmm::Matrix<Real_t>& trg_value){
+  #define SRC_BLK 500
+  static Real_t eps=machine_eps<Real_t>()*128;
+  size_t VecLen=sizeof(Vec_t)/sizeof(Real_t);
+
+  Real_t nwtn_scal=1; // scaling factor for newton iterations
+  for(int i=0;i<NWTN_ITER;i++){
+    nwtn_scal=2*nwtn_scal*nwtn_scal*nwtn_scal;
+  }
+  const Real_t OOEP = 1.0/(8*nwtn_scal*pvfmm::const_pi<Real_t>());
+  Vec_t inv_nwtn_scal2=set_intrin<Vec_t,Real_t>(1.0/(nwtn_scal*nwtn_scal));
+
+  size_t src_cnt_=src_coord.Dim(1);
+  size_t trg_cnt_=trg_coord.Dim(1);
+  for(size_t sblk=0;sblk<src_cnt_;sblk+=SRC_BLK){
+    size_t src_cnt=src_cnt_-sblk;
+    if(src_cnt>SRC_BLK) src_cnt=SRC_BLK;
+    for(size_t t=0;t<trg_cnt_;t+=VecLen){
+      Vec_t tx=load_intrin<Vec_t>(&trg_coord[0][t]);
+      Vec_t ty=load_intrin<Vec_t>(&trg_coord[1][t]);
+      Vec_t tz=load_intrin<Vec_t>(&trg_coord[2][t]);
+
+      Vec_t tvx=zero_intrin<Vec_t>();
+      Vec_t tvy=zero_intrin<Vec_t>();
+      Vec_t tvz=zero_intrin<Vec_t>();
+      for(size_t s=sblk;s<sblk+src_cnt;s++){
+        Vec_t dx=sub_intrin(tx,bcast_intrin<Vec_t>(&src_coord[0][s]));
+        Vec_t dy=sub_intrin(ty,bcast_intrin<Vec_t>(&src_coord[1][s]));
+        Vec_t dz=sub_intrin(tz,bcast_intrin<Vec_t>(&src_coord[2][s]));
+
+        Vec_t svx=bcast_intrin<Vec_t>(&src_value[0][s]);
+        Vec_t svy=bcast_intrin<Vec_t>(&src_value[1][s]);
+        Vec_t svz=bcast_intrin<Vec_t>(&src_value[2][s]);
+
+        Vec_t r2=        mul_intrin(dx,dx) ;
+        r2=add_intrin(r2,mul_intrin(dy,dy));
+        r2=add_intrin(r2,mul_intrin(dz,dz));
+
+        r2=and_intrin(cmplt_intrin(set_intrin<Vec_t,Real_t>(eps),r2),r2);
+
+        Vec_t rinv=rsqrt_intrin<Vec_t,Real_t,NWTN_ITER>(r2);
+        Vec_t rinv2=mul_intrin(mul_intrin(rinv,rinv),inv_nwtn_scal2);
+
+        Vec_t inner_prod=                mul_intrin(svx,dx) ;
+        inner_prod=add_intrin(inner_prod,mul_intrin(svy,dy));
+        inner_prod=add_intrin(inner_prod,mul_intrin(svz,dz));
+        inner_prod=mul_intrin(inner_prod,rinv2);
+
+        tvx=add_intrin(tvx,mul_intrin(rinv,add_intrin(svx,mul_intrin(dx,inner_prod))));
+        tvy=add_intrin(tvy,mul_intrin(rinv,add_intrin(svy,mul_intrin(dy,inner_prod))));
+        tvz=add_intrin(tvz,mul_intrin(rinv,add_intrin(svz,mul_intrin(dz,inner_prod))));
+      }
+      Vec_t ooep=set_intrin<Vec_t,Real_t>(OOEP);
+
+      tvx=add_intrin(mul_intrin(tvx,ooep),load_intrin<Vec_t>(&trg_value[0][t]));
+      tvy=add_intrin(mul_intrin(tvy,ooep),load_intrin<Vec_t>(&trg_value[1][t]));
+      tvz=add_intrin(mul_intrin(tvz,ooep),load_intrin<Vec_t>(&trg_value[2][t]));
+
+      store_intrin(&trg_value[0][t],tvx);
+      store_intrin(&trg_value[1][t],tvy);
+      store_intrin(&trg_value[2][t],tvz);
+    }
+  }
+
+  { // Add FLOPS
+    #ifndef __MIC__
+    pvfmm::Profile::Add_FLOP((long long)trg_cnt_*(long long)src_cnt_*(29+4*(NWTN_ITER)));
+    #endif
+  }
+  #undef SRC_BLK
+}
+
+template <class Real_t, class Vec_t, int NWTN_ITER>
+void stokes_dl_uKernel(pvfmm::Matrix<Real_t>& src_coord, pvfmm::Matrix<Real_t>& src_value, pvfmm::Matrix<Real_t>& trg_coord, pvfmm::Matrix<Real_t>& trg_value){
+  #define SRC_BLK 500
+  static Real_t eps=machine_eps<Real_t>()*128;
+  size_t VecLen=sizeof(Vec_t)/sizeof(Real_t);
+
+  Real_t nwtn_scal=1; // scaling factor for newton iterations
+  for(int i=0;i<NWTN_ITER;i++){
+    nwtn_scal=2*nwtn_scal*nwtn_scal*nwtn_scal;
+  }
+  const Real_t SCAL_CONST = 3.0/(4.0*nwtn_scal*nwtn_scal*nwtn_scal*nwtn_scal*nwtn_scal*pvfmm::const_pi<Real_t>());
+
+  size_t src_cnt_=src_coord.Dim(1);
+  size_t trg_cnt_=trg_coord.Dim(1);
+  for(size_t sblk=0;sblk<src_cnt_;sblk+=SRC_BLK){
+    size_t src_cnt=src_cnt_-sblk;
+    if(src_cnt>SRC_BLK) src_cnt=SRC_BLK;
+    for(size_t t=0;t<trg_cnt_;t+=VecLen){
+      Vec_t tx=load_intrin<Vec_t>(&trg_coord[0][t]);
+      Vec_t ty=load_intrin<Vec_t>(&trg_coord[1][t]);
+      Vec_t tz=load_intrin<Vec_t>(&trg_coord[2][t]);
+
+      Vec_t tvx=zero_intrin<Vec_t>();
+      Vec_t tvy=zero_intrin<Vec_t>();
+      Vec_t tvz=zero_intrin<Vec_t>();
+      for(size_t s=sblk;s<sblk+src_cnt;s++){
+        Vec_t dx=sub_intrin(tx,bcast_intrin<Vec_t>(&src_coord[0][s]));
+        Vec_t dy=sub_intrin(ty,bcast_intrin<Vec_t>(&src_coord[1][s]));
+        Vec_t dz=sub_intrin(tz,bcast_intrin<Vec_t>(&src_coord[2][s]));
+
+        Vec_t snx=bcast_intrin<Vec_t>(&src_value[0][s]) ;
+        Vec_t sny=bcast_intrin<Vec_t>(&src_value[1][s]) ;
+        Vec_t snz=bcast_intrin<Vec_t>(&src_value[2][s]) ;
+
+        Vec_t svx=bcast_intrin<Vec_t>(&src_value[3][s]) ;
+        Vec_t svy=bcast_intrin<Vec_t>(&src_value[4][s]) ;
+        Vec_t svz=bcast_intrin<Vec_t>(&src_value[5][s]) ;
+
+        Vec_t r2=        mul_intrin(dx,dx) ;
+        r2=add_intrin(r2,mul_intrin(dy,dy));
+        r2=add_intrin(r2,mul_intrin(dz,dz));
+        r2=and_intrin(cmplt_intrin(set_intrin<Vec_t,Real_t>(eps),r2),r2);
+
+        Vec_t rinv=rsqrt_intrin<Vec_t,Real_t,NWTN_ITER>(r2);
+        Vec_t rinv2=mul_intrin(rinv ,rinv );
+        Vec_t rinv5=mul_intrin(mul_intrin(rinv2,rinv2),rinv);
+
+        Vec_t r_dot_n=             mul_intrin(snx,dx) ;
+        r_dot_n=add_intrin(r_dot_n,mul_intrin(sny,dy));
+        r_dot_n=add_intrin(r_dot_n,mul_intrin(snz,dz));
+
+        Vec_t r_dot_f=             mul_intrin(svx,dx) ;
+        r_dot_f=add_intrin(r_dot_f,mul_intrin(svy,dy));
+        r_dot_f=add_intrin(r_dot_f,mul_intrin(svz,dz));
+
+        Vec_t p=mul_intrin(mul_intrin(r_dot_n,r_dot_f),rinv5);
+        tvx=add_intrin(tvx,mul_intrin(dx,p));
+        tvy=add_intrin(tvy,mul_intrin(dy,p));
+        tvz=add_intrin(tvz,mul_intrin(dz,p));
+      }
+      Vec_t scal_const=set_intrin<Vec_t,Real_t>(SCAL_CONST);
+
+      tvx=add_intrin(mul_intrin(tvx,scal_const),load_intrin<Vec_t>(&trg_value[0][t]));
+      tvy=add_intrin(mul_intrin(tvy,scal_const),load_intrin<Vec_t>(&trg_value[1][t]));
+      tvz=add_intrin(mul_intrin(tvz,scal_const),load_intrin<Vec_t>(&trg_value[2][t]));
+
+      store_intrin(&trg_value[0][t],tvx);
+      store_intrin(&trg_value[1][t],tvy);
+      store_intrin(&trg_value[2][t],tvz);
+    }
+  }
+
+  { // Add FLOPS
+    #ifndef __MIC__
+    pvfmm::Profile::Add_FLOP((long long)trg_cnt_*(long long)src_cnt_*(31+4*(NWTN_ITER)));
+    #endif
+  }
+  #undef SRC_BLK
+}
+
+// Entry points with the PVFMM kernel signature, Real_t is float or double
+// (any other type runs the scalar code).
+template <class Real_t, int NWTN_ITER>
+void stokes_sl_m2l(Real_t* r_src, int src_cnt, Real_t* v_src, int dof, Real_t* r_trg, int trg_cnt, Real_t* v_trg, pvfmm::mem::MemoryManager* mem_mgr){
+  typedef typename VecType<Real_t>::type Vec_t;
+  stokes_generic_kernel<Real_t, Vec_t, 4, 3, stokes_sl_m2l_uKernel<Real_t,Vec_t,NWTN_ITER> >(r_src, src_cnt, v_src, dof, r_trg, trg_cnt, v_trg, mem_mgr);
+}
+
+template <class Real_t, int NWTN_ITER>
+void stokes_sl(Real_t* r_src, int src_cnt, Real_t* v_src, int dof, Real_t* r_trg, int trg_cnt, Real_t* v_trg, pvfmm::mem::MemoryManager* mem_mgr){
+  typedef typename VecType<Real_t>::type Vec_t;
+  stokes_generic_kernel<Real_t, Vec_t, 3, 3, stokes_sl_uKernel<Real_t,Vec_t,NWTN_ITER> >(r_src, src_cnt, v_src, dof, r_trg, trg_cnt, v_trg, mem_mgr);
+}
+
+template <class Real_t, int NWTN_ITER>
+void stokes_dl(Real_t* r_src, int src_cnt, Real_t* v_src, int dof, Real_t* r_trg, int trg_cnt, Real_t* v_trg, pvfmm::mem::MemoryManager* mem_mgr){
+  typedef typename VecType<Real_t>::type Vec_t;
+  stokes_generic_kernel<Real_t, Vec_t, 6, 3, stokes_dl_uKernel<Real_t,Vec_t,NWTN_ITER> >(r_src, src_cnt, v_src, dof, r_trg, trg_cnt, v_trg, mem_mgr);
+}
@@ -3,22 +3,74 @@
 #include <profile.hpp>
 #include <SphericalHarmonics.h>
 #include <legendre_rule.h>
+#include "VesBlas.h"
+
+// The pvfmm::Profile phases are also Logger events (named pvfmm::<name>),
+// so that they appear in the trace written by PROFILETRACE
+#define STOKES_TIC(name,comm,sync) do{ pvfmm::Profile::Tic(name,comm,sync); PROFILESTART(); } while(0)
+#define STOKES_TOC(name) do{ PROFILEENDNAME("pvfmm::" name,0); pvfmm::Profile::Toc(); } while(0)
 
 #define __ENABLE_PVFMM_PROFILER__
 //#define __SH_FILTER__
 
 template<class Real>
-StokesVelocity<Real>::StokesVelocity(int sh_order_, int sh_order_up_, Real box_size_, Real repul_dist_, MPI_Comm comm_):
-  sh_order(sh_order_), sh_order_up_self(sh_order_up_), sh_order_up(sh_order_up_), box_size(box_size_), comm(comm_), trg_is_surf(true), near_singular0(box_size_, repul_dist_, comm_), near_singular1(box_size_, 0, comm_)
+StokesVelocity<Real>::StokesVelocity(int sh_order_, int sh_order_up_, Real box_size_, Real repul_dist_, MPI_Comm comm_, SelfOpStorage self_op_):
+  sh_order(sh_order_), sh_order_up_self(sh_order_up_), sh_order_up(sh_order_up_), box_size(box_size_), comm(comm_), near_comm(DupComm(comm_)), trg_is_surf(true), self_op(self_op_), near_singular0(box_size_, repul_dist_, near_comm), near_singular1(box_size_, 0, near_comm)
 {
+  ASSERT(self_op!=UnknownSelfOp, "Unknown self-interaction storage");
   pvfmm_ctx=PVFMMCreateContext<Real>(box_size_);
   add_repul=false;
   fmm_setup=true;
+  fmm_level=0;
+  pvfmm_ctx_lvl.assign(AccuracyLevels(), NULL);
+  fmm_stale.assign(AccuracyLevels(), 1);
+  fmm_overlap=false;
+  fmm_share=0.5;
+  overlap_hidden=0;
+  overlap_total=0;
 }
 
 template <class Real>
 StokesVelocity<Real>::~StokesVelocity(){
   PVFMMDestroyContext<Real>(&pvfmm_ctx);
+  for(size_t i=0;i<pvfmm_ctx_lvl.size();i++){
+    if(pvfmm_ctx_lvl[i]) PVFMMDestroyContext<Real>(&pvfmm_ctx_lvl[i]);
+  }
+  int finalized=0;
+  MPI_Finalized(&finalized);
+  if(!finalized) MPI_Comm_free(&near_comm);
+}
+
+template <class Real>
+MPI_Comm StokesVelocity<Real>::DupComm(MPI_Comm c){
+  MPI_Comm d;
+  MPI_Comm_dup(c,&d);
+  return d;
+}
+
+template <class Real>
+int StokesVelocity<Real>::AccuracyLevels(){
+  return 4;
+}
+
+template <class Real>
+Real StokesVelocity<Real>::AccuracyTol(int level){
+  // Nominal relative error of the far field with multipole order 10, 8, 6, 4
+  static const Real tol[]={0, 1e-5, 1e-4, 1e-3};
+  assert(level>=0 && level<AccuracyLevels());
+  return tol[level];
+}
+
+template <class Real>
+int StokesVelocity<Real>::SetAccuracy(Real tol){
+  int level=0;
+  while(level+1<AccuracyLevels() && AccuracyTol(level+1)<=tol) level++;
+  if(level!=fmm_level){
+    fmm_level=level;
+    fmm_vel.ReInit(0);
+    trg_vel.ReInit(0);
+  }
+  return level;
 }
 
 
@@ -37,8 +89,7 @@ void StokesVelocity<Real>::SetSrcCoord(const PVFMMVec& S, int sh_order_up_self_,
   }
   fmm_setup=true;
 
-  SLMatrix.ReInit(0);
-  DLMatrix.ReInit(0);
+  ClearSelfMatrix();
 
   scoord_far.ReInit(0);
   tcoord_repl.ReInit(0);
@@ -56,6 +107,12 @@ void StokesVelocity<Real>::SetSrcCoord(const PVFMMVec& S, int sh_order_up_self_,
   trg_vel.ReInit(0);
 }
 
+template <class Real>
+void StokesVelocity<Real>::SetNearSkin(Real skin){
+  near_singular0.SetNearSkin(skin);
+  near_singular1.SetNearSkin(skin);
+}
+
 template <class Real>
 template <class Vec>
 void StokesVelocity<Real>::SetSrcCoord(const Vec& S, int sh_order_up_self_, int sh_order_up_){
@@ -164,33 +221,21 @@ template <class Real>
 const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
 #ifdef __ENABLE_PVFMM_PROFILER__
   bool prof_state=pvfmm::Profile::Enable(true);
-  pvfmm::Profile::Tic("StokesVelocity",&comm, true);
+  STOKES_TIC("StokesVelocity",&comm,true);
 #endif
 
   { // Setup
-    pvfmm::Profile::Tic("Setup",&comm, true);
+    STOKES_TIC("Setup",&comm,true);
     bool prof_state=pvfmm::Profile::Enable(false);
 
-    if(!SLMatrix.Dim() || !DLMatrix.Dim()){
-      pvfmm::Profile::Tic("SelfMatrix",&comm, true);
-      if(!SLMatrix.Dim() && !DLMatrix.Dim() && force_single.Dim() && force_double.Dim()){
-        if(1){
-          pvfmm::Vector<Real> tmp1; tmp1.Swap(SLMatrix);
-          pvfmm::Vector<Real> tmp2; tmp2.Swap(DLMatrix);
-        }
-        SphericalHarmonics<Real>::StokesSingularInteg(scoord, sh_order, sh_order_up_self, &SLMatrix, &DLMatrix);
-      }else if(!SLMatrix.Dim() && force_single.Dim()){
-        if(1){
-          pvfmm::Vector<Real> tmp1; tmp1.Swap(SLMatrix);
-        }
-        SphericalHarmonics<Real>::StokesSingularInteg(scoord, sh_order, sh_order_up_self, &SLMatrix, NULL);
-      }else if(!DLMatrix.Dim() && force_double.Dim()){
-        if(1){
-          pvfmm::Vector<Real> tmp2; tmp2.Swap(DLMatrix);
-        }
-        SphericalHarmonics<Real>::StokesSingularInteg(scoord, sh_order, sh_order_up_self, NULL, &DLMatrix);
+    if(self_op!=MatFreeSelfOp){
+      bool sl=(force_single.Dim() && !SLMatrix.Dim() && !SLMatrix_sp.Dim());
+      bool dl=(force_double.Dim() && !DLMatrix.Dim() && !DLMatrix_sp.Dim());
+      if(sl || dl){
+        STOKES_TIC("SelfMatrix",&comm,true);
+        SetupSelfMatrix(sl, dl);
+        STOKES_TOC("SelfMatrix");
       }
-      pvfmm::Profile::Toc();
     }
 
     if(!scoord_far.Dim()){
@@ -198,10 +243,15 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
       assert(!scoord_area.Dim());
       assert(!tcoord_repl.Dim());
 
-      pvfmm::Profile::Tic("SCoordFar",&comm, true);
-      static PVFMMVec scoord_shc, scoord_up, X_theta, X_phi, scoord_pole;
-      SphericalHarmonics<Real>::Grid2SHC(scoord    , sh_order, sh_order   , scoord_shc);
-      SphericalHarmonics<Real>::SHC2Grid(scoord_shc, sh_order, sh_order_up, scoord_up, &X_theta, &X_phi);
+      STOKES_TIC("SCoordFar",&comm,true);
+      typename SHWorkspace<Real>::Frame frame(&sh_ws);
+      PVFMMVec& scoord_shc =frame.Get();
+      PVFMMVec& scoord_up  =frame.Get();
+      PVFMMVec& X_theta    =frame.Get();
+      PVFMMVec& X_phi      =frame.Get();
+      PVFMMVec& scoord_pole=frame.Get();
+      SphericalHarmonics<Real>::Grid2SHC(scoord    , sh_order, sh_order   , scoord_shc, &sh_ws);
+      SphericalHarmonics<Real>::SHC2Grid(scoord_shc, sh_order, sh_order_up, scoord_up, &X_theta, &X_phi, &sh_ws);
       SphericalHarmonics<Real>::SHC2Pole(scoord_shc, sh_order, scoord_pole);
       { // Set scoord_far
         long Nves=scoord_pole.Dim()/COORD_DIM/2;
@@ -220,11 +270,11 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
           }
         }
       }
-      pvfmm::Profile::Toc();
+      STOKES_TOC("SCoordFar");
 
-      pvfmm::Profile::Tic("SCoordNear",&comm, true);
+      STOKES_TIC("SCoordNear",&comm,true);
       { // Set tcoord_repl
-        SphericalHarmonics<Real>::SHC2Grid(scoord_shc, sh_order, sh_order, scoord); // Use filtered surface for tcoord_repl
+        SphericalHarmonics<Real>::SHC2Grid(scoord_shc, sh_order, sh_order, scoord, NULL, NULL, &sh_ws); // Use filtered surface for tcoord_repl
         long Nves=scoord_pole.Dim()/COORD_DIM/2;
         long Mves=2*sh_order*(1+sh_order);
         tcoord_repl.ReInit(Nves*Mves*COORD_DIM);
@@ -240,9 +290,9 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
       near_singular0.SetTrgCoord(&tcoord_repl[0],tcoord_repl.Dim()/COORD_DIM,true);
       near_singular0.SetSrcCoord(scoord_far,sh_order_up);
       near_singular1.SetSrcCoord(scoord_far,sh_order_up);
-      pvfmm::Profile::Toc();
+      STOKES_TOC("SCoordNear");
 
-      pvfmm::Profile::Tic("AreaNormal",&comm, true);
+      STOKES_TIC("AreaNormal",&comm,true);
       { // Set scoord_norm, scoord_area
         long Mves=2*sh_order_up*(sh_order_up+1);
         long N=X_theta.Dim()/Mves/COORD_DIM;
@@ -274,11 +324,12 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
           }
         }
       }
-      pvfmm::Profile::Toc();
+      STOKES_TOC("AreaNormal");
     }
 
     if(!rforce_single.Dim() && add_repul){ // Add repulsion
-      pvfmm::Profile::Tic("Repulsion",&comm);
+      ASSERT(force_single.Dim()<=scoord.Dim(), "Repulsion is only added to a single density");
+      STOKES_TIC("Repulsion",&comm,false);
       const PVFMMVec& f_repl=near_singular0.ForceRepul();
       long Mves=2*sh_order*(sh_order+1);
       long Nves=f_repl.Dim()/Mves/COORD_DIM;
@@ -292,7 +343,7 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
           }
         }
       }
-      pvfmm::Profile::Toc();
+      STOKES_TOC("Repulsion");
       if(force_single.Dim()){
         assert(force_single.Dim()==Nves*Mves*COORD_DIM);
         #pragma omp parallel for
@@ -307,13 +358,16 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
     { // Compute qforce_single, qforce_double
       pvfmm::Vector<Real>& qw=SphericalHarmonics<Real>::LegendreWeights(sh_order_up);
       if(!qforce_single.Dim() && rforce_single.Dim()){ // Compute qforce_single
-        static PVFMMVec shc, grid;
-        SphericalHarmonics<Real>::Grid2SHC(rforce_single, sh_order, sh_order, shc);
-        SphericalHarmonics<Real>::SHC2Grid(shc, sh_order, sh_order_up, grid);
+        typename SHWorkspace<Real>::Frame frame(&sh_ws);
+        PVFMMVec& shc =frame.Get();
+        PVFMMVec& grid=frame.Get();
+        SphericalHarmonics<Real>::Grid2SHC(rforce_single, sh_order, sh_order, shc, &sh_ws);
+        SphericalHarmonics<Real>::SHC2Grid(shc, sh_order, sh_order_up, grid, NULL, NULL, &sh_ws);
 
         long Mves=2*sh_order_up*(sh_order_up+1);
         long Nves=grid.Dim()/Mves/COORD_DIM;
-        assert(scoord_area.Dim()==Nves*Mves);
+        long Nsrc=scoord_area.Dim()/Mves; // densities are stacked one after the other
+        assert(Nsrc && Nves%Nsrc==0);
 
         qforce_single.ReInit(Nves*(Mves+2)*COORD_DIM);
         #pragma omp parallel for
@@ -325,7 +379,7 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
           for(long j0=0;j0<sh_order_up+1;j0++){
             for(long j1=0;j1<sh_order_up*2;j1++){
               long j=j0*sh_order_up*2+j1;
-              Real w=scoord_area[i*Mves+j]*qw[j0];
+              Real w=scoord_area[(i%Nsrc)*Mves+j]*qw[j0];
               for(long k=0;k<COORD_DIM;k++){
                 qforce_single[(i*(Mves+2)+(j+2))*COORD_DIM+k]=grid[(i*COORD_DIM+k)*Mves+j]*w;
               }
@@ -338,15 +392,19 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
       if(!qforce_double.Dim() &&  force_double.Dim()){ // Compute qforce_double
         assert(!uforce_double.Dim());
 
-        static PVFMMVec shc, grid, pole;
-        SphericalHarmonics<Real>::Grid2SHC(force_double, sh_order, sh_order, shc);
-        SphericalHarmonics<Real>::SHC2Grid(shc, sh_order, sh_order_up, grid);
+        typename SHWorkspace<Real>::Frame frame(&sh_ws);
+        PVFMMVec& shc =frame.Get();
+        PVFMMVec& grid=frame.Get();
+        PVFMMVec& pole=frame.Get();
+        SphericalHarmonics<Real>::Grid2SHC(force_double, sh_order, sh_order, shc, &sh_ws);
+        SphericalHarmonics<Real>::SHC2Grid(shc, sh_order, sh_order_up, grid, NULL, NULL, &sh_ws);
         SphericalHarmonics<Real>::SHC2Pole(shc, sh_order, pole);
 
         long Mves=2*sh_order_up*(sh_order_up+1);
         long Nves=grid.Dim()/Mves/COORD_DIM;
-        assert(scoord_norm.Dim()==Nves*Mves*COORD_DIM);
-        assert(scoord_area.Dim()==Nves*Mves);
+        long Nsrc=scoord_area.Dim()/Mves;
+        assert(scoord_norm.Dim()==Nsrc*Mves*COORD_DIM);
+        assert(Nsrc && Nves%Nsrc==0);
 
         uforce_double.ReInit(Nves*(Mves+2)*(1*COORD_DIM));
         qforce_double.ReInit(Nves*(Mves+2)*(2*COORD_DIM));
@@ -364,11 +422,11 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
           for(long j0=0;j0<sh_order_up+1;j0++){
             for(long j1=0;j1<sh_order_up*2;j1++){
               long j=j0*sh_order_up*2+j1;
-              Real w=scoord_area[i*Mves+j]*qw[j0];
+              Real w=scoord_area[(i%Nsrc)*Mves+j]*qw[j0];
               for(long k=0;k<COORD_DIM;k++){
                 uforce_double[(i*(Mves+2)+(j+2))*1*COORD_DIM+0*COORD_DIM+k]=       grid[(i*COORD_DIM+k)*Mves+j];
                 qforce_double[(i*(Mves+2)+(j+2))*2*COORD_DIM+0*COORD_DIM+k]=       grid[(i*COORD_DIM+k)*Mves+j]*w;
-                qforce_double[(i*(Mves+2)+(j+2))*2*COORD_DIM+1*COORD_DIM+k]=scoord_norm[(i*COORD_DIM+k)*Mves+j];
+                qforce_double[(i*(Mves+2)+(j+2))*2*COORD_DIM+1*COORD_DIM+k]=scoord_norm[((i%Nsrc)*COORD_DIM+k)*Mves+j];
               }
             }
           }
@@ -379,122 +437,47 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
     }
 
     pvfmm::Profile::Enable(prof_state);
-    pvfmm::Profile::Toc();
+    STOKES_TOC("Setup");
+  }
+
+  long n_rhs=DensityCount();
+  NearSingular<Real>& near_singular=(trg_is_surf?near_singular0:near_singular1);
+  PVFMMVec& trg_coord=(trg_is_surf?tcoord_repl:tcoord);
+  if(n_rhs==1 && fmm_overlap && !S_vel.Dim() && !fmm_vel.Dim() && omp_get_max_threads()>1){ // Overlap far with self and near
+    PipelinedInteraction(near_singular, trg_coord);
   }
 
   if(!S_vel.Dim()){ // Compute self interaction
-    pvfmm::Profile::Tic("SelfInteraction",&comm);
+    STOKES_TIC("SelfInteraction",&comm,false);
     bool prof_state=pvfmm::Profile::Enable(false);
-    assert(!S_vel_up.Dim());
-    static PVFMMVec vel_up, vel_pole, Vcoef;
-    { // Compute Vcoeff
-      long Ncoef =   sh_order*(sh_order+2);
-      long Ngrid = 2*sh_order*(sh_order+1);
-      static PVFMMVec SL_vel, DL_vel;
-      SL_vel.ReInit(0);
-      DL_vel.ReInit(0);
-
-      if(rforce_single.Dim()){ // Set SL_vel
-        static pvfmm::Vector<Real> F;
-        SphericalHarmonics<Real>::Grid2SHC(rforce_single,sh_order,sh_order,F);
-
-        long nv = rforce_single.Dim()/Ngrid/COORD_DIM;
-        SL_vel.ReInit(nv*COORD_DIM*Ncoef);
-        #pragma omp parallel
-        { // mat-vec
-          long tid=omp_get_thread_num();
-          long omp_p=omp_get_num_threads();
-
-          long a=(tid+0)*nv/omp_p;
-          long b=(tid+1)*nv/omp_p;
-          for(long i=a;i<b;i++){
-            pvfmm::Matrix<Real> Mv(1,COORD_DIM*Ncoef,&SL_vel[i*COORD_DIM*Ncoef],false);
-            pvfmm::Matrix<Real> Mf(1,COORD_DIM*Ncoef,&F     [i*COORD_DIM*Ncoef],false);
-            pvfmm::Matrix<Real> M(COORD_DIM*Ncoef,COORD_DIM*Ncoef,&SLMatrix[i*COORD_DIM*Ncoef*COORD_DIM*Ncoef],false);
-            pvfmm::Matrix<Real>::GEMM(Mv,Mf,M);
-          }
-        }
-      }
-      if(force_double.Dim()){ // Set DL_vel
-        static pvfmm::Vector<Real> F;
-        SphericalHarmonics<Real>::Grid2SHC(force_double,sh_order,sh_order,F);
-
-        long nv = force_double.Dim()/Ngrid/COORD_DIM;
-        DL_vel.ReInit(nv*COORD_DIM*Ncoef);
-        #pragma omp parallel
-        { // mat-vec
-          long tid=omp_get_thread_num();
-          long omp_p=omp_get_num_threads();
-
-          long a=(tid+0)*nv/omp_p;
-          long b=(tid+1)*nv/omp_p;
-          for(long i=a;i<b;i++){
-            pvfmm::Matrix<Real> Mv(1,COORD_DIM*Ncoef,&DL_vel[i*COORD_DIM*Ncoef],false);
-            pvfmm::Matrix<Real> Mf(1,COORD_DIM*Ncoef,&F     [i*COORD_DIM*Ncoef],false);
-            pvfmm::Matrix<Real> M(COORD_DIM*Ncoef,COORD_DIM*Ncoef,&DLMatrix[i*COORD_DIM*Ncoef*COORD_DIM*Ncoef],false);
-            pvfmm::Matrix<Real>::GEMM(Mv,Mf,M);
-          }
-        }
-      }
-      if(SL_vel.Dim() && DL_vel.Dim()){ // Vcoef=SL_vel+DL_vel
-        Vcoef.ReInit(SL_vel.Dim());
-        #pragma omp parallel for
-        for(long i=0;i<Vcoef.Dim();i++) Vcoef[i]=SL_vel[i]+DL_vel[i];
-      }else{
-        if(SL_vel.Dim()) Vcoef.ReInit(SL_vel.Dim(),&SL_vel[0]);
-        else if(DL_vel.Dim()) Vcoef.ReInit(DL_vel.Dim(),&DL_vel[0]);
-        else Vcoef.ReInit(0);
-      }
-    }
-    SphericalHarmonics<Real>::SHC2Grid(Vcoef, sh_order, sh_order   , S_vel);
-    SphericalHarmonics<Real>::SHC2Grid(Vcoef, sh_order, sh_order_up, vel_up);
-    SphericalHarmonics<Real>::SHC2Pole(Vcoef, sh_order, vel_pole);
-    { // Set S_vel_up
-      long Nves=vel_pole.Dim()/COORD_DIM/2;
-      long Mves=2*sh_order_up*(1+sh_order_up);
-      S_vel_up.ReInit(Nves*(Mves+2)*COORD_DIM);
-      #pragma omp parallel for
-      for(long i=0;i<Nves;i++){
-        for(long k=0;k<COORD_DIM;k++){
-          S_vel_up[(i*(Mves+2)+0)*COORD_DIM+k]=vel_pole[(i*COORD_DIM+k)*2+0];
-          S_vel_up[(i*(Mves+2)+1)*COORD_DIM+k]=vel_pole[(i*COORD_DIM+k)*2+1];
-        }
-        for(long j=0;j<Mves;j++){
-          for(long k=0;k<COORD_DIM;k++){
-            S_vel_up[(i*(Mves+2)+(j+2))*COORD_DIM+k]=vel_up[(i*COORD_DIM+k)*Mves+j];
-          }
-        }
-      }
-    }
-    near_singular0.SetSurfaceVel(&S_vel_up);
-    near_singular1.SetSurfaceVel(&S_vel_up);
+    SelfInteraction();
     pvfmm::Profile::Enable(prof_state);
-    pvfmm::Profile::Toc();
+    STOKES_TOC("SelfInteraction");
+  }
+
+  if(n_rhs>1 && !fmm_vel.Dim()){ // Far and near interaction of each density
+    STOKES_TIC("BatchedInteraction",&comm,true);
+    bool prof_state=pvfmm::Profile::Enable(false);
+    BatchedInteraction(near_singular, trg_coord, n_rhs);
+    pvfmm::Profile::Enable(prof_state);
+    STOKES_TOC("BatchedInteraction");
   }
 
-  NearSingular<Real>& near_singular=(trg_is_surf?near_singular0:near_singular1);
-  PVFMMVec& trg_coord=(trg_is_surf?tcoord_repl:tcoord);
   if(!fmm_vel.Dim()){ // Compute far interaction
-    pvfmm::Profile::Tic("FarInteraction",&comm,true);
+    STOKES_TIC("FarInteraction",&comm,true);
     bool prof_state=pvfmm::Profile::Enable(false);
-    fmm_vel.ReInit(trg_coord.Dim());
-    PVFMMEval(&scoord_far[0],
-              (qforce_single.Dim()?&qforce_single[0]:NULL),
-              (qforce_double.Dim()?&qforce_double[0]:NULL),
-              scoord_far.Dim()/COORD_DIM,
-              &trg_coord[0], &fmm_vel[0], trg_coord.Dim()/COORD_DIM, &pvfmm_ctx, fmm_setup);
-    fmm_setup=false;
+    FarInteraction(trg_coord, qforce_single, qforce_double, fmm_vel);
     near_singular.SubtractDirect(fmm_vel);
     pvfmm::Profile::Enable(prof_state);
-    pvfmm::Profile::Toc();
+    STOKES_TOC("FarInteraction");
   }
 
   if(!trg_vel.Dim()){ // Compute near interaction
-    pvfmm::Profile::Tic("NearInteraction",&comm,true);
+    STOKES_TIC("NearInteraction",&comm,true);
     bool prof_state=pvfmm::Profile::Enable(false);
-    const PVFMMVec& near_vel=near_singular();
+    const PVFMMVec& near_vel=(n_rhs>1?near_vel_batch:near_singular());
     { // Compute trg_vel = fmm_vel + near_vel
-      trg_vel.ReInit(trg_coord.Dim());
+      trg_vel.ReInit(n_rhs*trg_coord.Dim()); // the densities one after the other
       assert(trg_vel.Dim()==fmm_vel.Dim());
       assert(trg_vel.Dim()==near_vel.Dim());
       #pragma omp parallel for
@@ -504,9 +487,11 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
     }
     if(trg_is_surf){ // trg_vel+=S_vel
       long Ngrid = 2*sh_order*(sh_order+1);
-      long Nves = S_vel.Dim()/Ngrid/COORD_DIM;
+      long Nves = S_vel.Dim()/Ngrid/COORD_DIM; // n_rhs times the vesicles
+      assert(trg_vel.Dim()==Nves*Ngrid*COORD_DIM);
 
-      static PVFMMVec tmp;
+      typename SHWorkspace<Real>::Frame frame(&sh_ws);
+      PVFMMVec& tmp=frame.Get(); // swapped with trg_vel, the workspace keeps the old array
       tmp.ReInit(Nves*COORD_DIM*Ngrid);
       #pragma omp parallel for
       for(long i=0;i<Nves;i++){
@@ -527,17 +512,200 @@ const StokesVelocity<Real>::PVFMMVec& StokesVelocity<Real>::operator()(){
       }
     }
     pvfmm::Profile::Enable(prof_state);
-    pvfmm::Profile::Toc();
+    STOKES_TOC("NearInteraction");
   }
 
 #ifdef __ENABLE_PVFMM_PROFILER__
-  pvfmm::Profile::Toc();
+  STOKES_TOC("StokesVelocity");
   pvfmm::Profile::Enable(prof_state);
 #endif
 
   return trg_vel;
 }
 
+template <class Real>
+void StokesVelocity<Real>::SelfInteraction(){
+  assert(!S_vel_up.Dim());
+  typename SHWorkspace<Real>::Frame frame(&sh_ws);
+  PVFMMVec& vel_up  =frame.Get();
+  PVFMMVec& vel_pole=frame.Get();
+  PVFMMVec& Vcoef   =frame.Get();
+  { // Compute Vcoeff
+    PVFMMVec& SL_vel=frame.Get();
+    PVFMMVec& DL_vel=frame.Get();
+    PVFMMVec& Fs    =frame.Get();
+    PVFMMVec& Fd    =frame.Get();
+    SL_vel.ReInit(0);
+    DL_vel.ReInit(0);
+
+    if(rforce_single.Dim()) SphericalHarmonics<Real>::Grid2SHC(rforce_single,sh_order,sh_order,Fs,&sh_ws);
+    if( force_double.Dim()) SphericalHarmonics<Real>::Grid2SHC( force_double,sh_order,sh_order,Fd,&sh_ws);
+    SelfMatVec((rforce_single.Dim()?&Fs:NULL), (force_double.Dim()?&Fd:NULL), SL_vel, DL_vel);
+    if(SL_vel.Dim() && DL_vel.Dim()){ // Vcoef=SL_vel+DL_vel
+      Vcoef.ReInit(SL_vel.Dim());
+      #pragma omp parallel for
+      for(long i=0;i<Vcoef.Dim();i++) Vcoef[i]=SL_vel[i]+DL_vel[i];
+    }else{
+      if(SL_vel.Dim()) Vcoef.ReInit(SL_vel.Dim(),&SL_vel[0]);
+      else if(DL_vel.Dim()) Vcoef.ReInit(DL_vel.Dim(),&DL_vel[0]);
+      else Vcoef.ReInit(0);
+    }
+  }
+  SphericalHarmonics<Real>::SHC2Grid(Vcoef, sh_order, sh_order   , S_vel , NULL, NULL, &sh_ws);
+  SphericalHarmonics<Real>::SHC2Grid(Vcoef, sh_order, sh_order_up, vel_up, NULL, NULL, &sh_ws);
+  SphericalHarmonics<Real>::SHC2Pole(Vcoef, sh_order, vel_pole);
+  { // Set S_vel_up
+    long Nves=vel_pole.Dim()/COORD_DIM/2;
+    long Mves=2*sh_order_up*(1+sh_order_up);
+    S_vel_up.ReInit(Nves*(Mves+2)*COORD_DIM);
+    #pragma omp parallel for
+    for(long i=0;i<Nves;i++){
+      for(long k=0;k<COORD_DIM;k++){
+        S_vel_up[(i*(Mves+2)+0)*COORD_DIM+k]=vel_pole[(i*COORD_DIM+k)*2+0];
+        S_vel_up[(i*(Mves+2)+1)*COORD_DIM+k]=vel_pole[(i*COORD_DIM+k)*2+1];
+      }
+      for(long j=0;j<Mves;j++){
+        for(long k=0;k<COORD_DIM;k++){
+          S_vel_up[(i*(Mves+2)+(j+2))*COORD_DIM+k]=vel_up[(i*COORD_DIM+k)*Mves+j];
+        }
+      }
+    }
+  }
+  near_singular0.SetSurfaceVel(&S_vel_up);
+  near_singular1.SetSurfaceVel(&S_vel_up);
+}
+
+template <class Real>
+void StokesVelocity<Real>::FarInteraction(PVFMMVec& trg_coord, const PVFMMVec& qs, const PVFMMVec& qd, PVFMMVec& vel){
+  if(fmm_setup){ // every cached context needs a new tree
+    fmm_stale.assign(AccuracyLevels(), 1);
+    fmm_setup=false;
+  }
+  void** ctx=&pvfmm_ctx;
+  if(fmm_level){ // lower multipole order and cheaper kernel
+    ctx=&pvfmm_ctx_lvl[fmm_level];
+    if(!ctx[0]) ctx[0]=PVFMMCreateContext<Real>(box_size, 1000, 10-2*fmm_level, MAX_DEPTH,
+        &StokesKernel<Real>::Kernel(AccuracyTol(fmm_level)), comm);
+  }
+  if(vel.Dim()!=trg_coord.Dim()) vel.ReInit(trg_coord.Dim());
+  PVFMMEval(&scoord_far[0],
+            (qs.Dim()?&qs[0]:NULL),
+            (qd.Dim()?&qd[0]:NULL),
+            scoord_far.Dim()/COORD_DIM,
+            &trg_coord[0], &vel[0], trg_coord.Dim()/COORD_DIM, ctx, fmm_stale[fmm_level]);
+  fmm_stale[fmm_level]=0;
+}
+
+template <class Real>
+long StokesVelocity<Real>::DensityCount() const{
+  if(!scoord.Dim()) return 1;
+  long ns=force_single.Dim()/scoord.Dim();
+  long nd=force_double.Dim()/scoord.Dim();
+  assert(ns*scoord.Dim()==force_single.Dim());
+  assert(nd*scoord.Dim()==force_double.Dim());
+  ASSERT(!ns || !nd || ns==nd, "The single- and double-layer densities differ in number");
+  return std::max<long>(std::max(ns,nd),1);
+}
+
+template <class Real>
+void StokesVelocity<Real>::BatchedInteraction(NearSingular<Real>& near_singular, PVFMMVec& trg_coord, long n_rhs){
+  long n_trg=trg_coord.Dim();
+  long n_qs=qforce_single.Dim()/n_rhs;
+  long n_qd=qforce_double.Dim()/n_rhs;
+  long n_ud=uforce_double.Dim()/n_rhs;
+  long n_sv=S_vel_up.Dim()/n_rhs;
+  fmm_vel.ReInit(n_rhs*n_trg);
+  near_vel_batch.ReInit(n_rhs*n_trg);
+
+  // The tree, the near pairs and the projections depend only on the
+  // geometry and are set up for the first density only. The traversals
+  // themselves are repeated per density: the PVFMM kernels and the
+  // near-pair evaluation only take one density (dof==1).
+  for(long r=0;r<n_rhs;r++){
+    qforce_single_r.ReInit(n_qs, (n_qs?&qforce_single[r*n_qs]:NULL), false);
+    qforce_double_r.ReInit(n_qd, (n_qd?&qforce_double[r*n_qd]:NULL), false);
+    uforce_double_r.ReInit(n_ud, (n_ud?&uforce_double[r*n_ud]:NULL), false);
+    S_vel_up_r     .ReInit(n_sv, &S_vel_up[r*n_sv], false);
+    near_singular.SetDensitySL(n_qs?&qforce_single_r:NULL);
+    near_singular.SetDensityDL(n_qd?&qforce_double_r:NULL, n_ud?&uforce_double_r:NULL);
+    near_singular.SetSurfaceVel(&S_vel_up_r);
+
+    PVFMMVec fmm_vel_r(n_trg, &fmm_vel[r*n_trg], false);
+    FarInteraction(trg_coord, qforce_single_r, qforce_double_r, fmm_vel_r);
+    near_singular.SubtractDirect(fmm_vel_r);
+
+    const PVFMMVec& near_vel=near_singular();
+    assert(near_vel.Dim()==n_trg);
+    #pragma omp parallel for
+    for(long i=0;i<n_trg;i++) near_vel_batch[r*n_trg+i]=near_vel[i];
+  }
+}
+
+template <class Real>
+void StokesVelocity<Real>::PipelinedInteraction(NearSingular<Real>& near_singular, PVFMMVec& trg_coord){
+  STOKES_TIC("Pipelined",&comm,true);
+  bool prof_state=pvfmm::Profile::Enable(false); // the profiler is not thread safe
+
+  // The near interaction communicates (on near_comm, so its collectives
+  // never interleave with those of the FMM on comm), so it only joins
+  // the local team when MPI allows calls from two threads at once.
+  int mpi_level=MPI_THREAD_SINGLE;
+  MPI_Query_thread(&mpi_level);
+  bool near_local=(mpi_level==MPI_THREAD_MULTIPLE);
+
+  long omp_p=omp_get_max_threads();
+  long fmm_p=std::min(std::max<long>((long)(fmm_share*omp_p+0.5),1),omp_p-1);
+  int max_levels=omp_get_max_active_levels();
+  omp_set_max_active_levels(std::max(max_levels,2));
+
+  double t_far=0, t_local=0, t_wall=-omp_get_wtime();
+  int n_teams=1;
+  #pragma omp parallel num_threads(2)
+  {
+    long tid=omp_get_thread_num();
+    int nt=omp_get_num_threads();
+    if(tid==0){ // far field on the master thread, enough for MPI_THREAD_FUNNELED
+      n_teams=nt;
+      omp_set_num_threads(nt==2?fmm_p:omp_p);
+      t_far=-omp_get_wtime();
+      FarInteraction(trg_coord, qforce_single, qforce_double, fmm_vel);
+      t_far+=omp_get_wtime();
+    }
+    if(tid==1 || nt==1){ // self and near on the remaining threads
+      omp_set_num_threads(nt==2?omp_p-fmm_p:omp_p);
+      t_local=-omp_get_wtime();
+      SelfInteraction();
+      if(near_local) near_singular();
+      t_local+=omp_get_wtime();
+    }
+  }
+  t_wall+=omp_get_wtime();
+  omp_set_max_active_levels(max_levels);
+
+  if(n_teams==2){ // balance the teams for the next evaluation
+    Real w_far=t_far*fmm_p, w_local=t_local*(omp_p-fmm_p);
+    if(w_far+w_local>0) fmm_share=(fmm_share+w_far/(w_far+w_local))/2;
+    overlap_hidden+=std::max(t_far+t_local-t_wall,0.0);
+    overlap_total +=std::min(t_far,t_local);
+  }
+  COUTDEBUG("StokesVelocity: far "<<t_far<<"s on "<<fmm_p<<" threads, local "<<t_local<<"s on "
+      <<omp_p-fmm_p<<" threads"<<(near_local?" (with near)":"")<<", wall "<<t_wall<<"s");
+
+  near_singular.SubtractDirect(fmm_vel);
+  pvfmm::Profile::Enable(prof_state);
+  STOKES_TOC("Pipelined");
+}
+
+template <class Real>
+void StokesVelocity<Real>::SetOverlap(bool overlap){
+  fmm_overlap=overlap;
+}
+
+template <class Real>
+Real StokesVelocity<Real>::OverlapRatio() const{
+  return (overlap_total>0?overlap_hidden/overlap_total:0);
+}
+
 template <class Real>
 template <class Vec>
 void StokesVelocity<Real>::operator()(Vec& vel){
@@ -548,11 +716,169 @@ void StokesVelocity<Real>::operator()(Vec& vel){
   trg_vel_=trg_vel;
 }
 
+template <class Real>
+template <class Vec>
+void StokesVelocity<Real>::SelfVelocity(Vec& vel){
+  if(self_op!=MatFreeSelfOp){
+    bool sl=(force_single.Dim() && !SLMatrix.Dim() && !SLMatrix_sp.Dim());
+    bool dl=(force_double.Dim() && !DLMatrix.Dim() && !DLMatrix_sp.Dim());
+    if(sl || dl) SetupSelfMatrix(sl, dl);
+  }
+
+  typename SHWorkspace<Real>::Frame frame(&sh_ws);
+  PVFMMVec& Fs      =frame.Get();
+  PVFMMVec& Fd      =frame.Get();
+  PVFMMVec& SL_vel  =frame.Get();
+  PVFMMVec& DL_vel  =frame.Get();
+  PVFMMVec& vel_grid=frame.Get();
+  SL_vel.ReInit(0);
+  DL_vel.ReInit(0);
+  if(force_single.Dim()) SphericalHarmonics<Real>::Grid2SHC(force_single,sh_order,sh_order,Fs,&sh_ws);
+  if(force_double.Dim()) SphericalHarmonics<Real>::Grid2SHC(force_double,sh_order,sh_order,Fd,&sh_ws);
+  SelfMatVec((force_single.Dim()?&Fs:NULL), (force_double.Dim()?&Fd:NULL), SL_vel, DL_vel);
+  if(SL_vel.Dim() && DL_vel.Dim()){
+    #pragma omp parallel for
+    for(long i=0;i<SL_vel.Dim();i++) SL_vel[i]+=DL_vel[i];
+  }
+
+  PVFMMVec vel_(vel.size(),vel.begin(),false);
+  if(SL_vel.Dim() || DL_vel.Dim()){
+    SphericalHarmonics<Real>::SHC2Grid((SL_vel.Dim()?SL_vel:DL_vel), sh_order, sh_order, vel_grid, NULL, NULL, &sh_ws);
+    assert(vel_grid.Dim()==vel_.Dim());
+    vel_=vel_grid;
+  }else{
+    vel_.SetZero();
+  }
+}
+
+template <class Real>
+size_t StokesVelocity<Real>::SelfOpBytes() const{
+  long Ncoef=sh_order*(sh_order+2);
+  size_t mat_size=(COORD_DIM*Ncoef)*(COORD_DIM*Ncoef);
+  size_t nmat=(force_single.Dim()?1:0)+(force_double.Dim()?1:0);
+  if(self_op==FullSelfOp  ) return nmat*mat_size*sizeof(Real);
+  if(self_op==SingleSelfOp) return nmat*mat_size*sizeof(float);
+  return 0; // only a block workspace of omp_get_max_threads() matrices
+}
+
+template <class Real>
+void StokesVelocity<Real>::ClearSelfMatrix(){
+  SLMatrix.ReInit(0);
+  DLMatrix.ReInit(0);
+  SLMatrix_sp.ReInit(0);
+  DLMatrix_sp.ReInit(0);
+}
+
+template <class Real>
+void StokesVelocity<Real>::SetupSelfMatrix(bool sl, bool dl){
+  if(self_op==FullSelfOp){
+    if(sl){ pvfmm::Vector<Real> tmp; tmp.Swap(SLMatrix); }
+    if(dl){ pvfmm::Vector<Real> tmp; tmp.Swap(DLMatrix); }
+    SphericalHarmonics<Real>::StokesSingularInteg(scoord, sh_order, sh_order_up_self, (sl?&SLMatrix:NULL), (dl?&DLMatrix:NULL), &sh_ws);
+  }else{ // SingleSelfOp: build blocks of vesicles in working precision and round
+    assert(self_op==SingleSelfOp);
+    long Ncoef=sh_order*(sh_order+2);
+    long Ngrid=2*sh_order*(sh_order+1);
+    long Nves=scoord.Dim()/(Ngrid*COORD_DIM);
+    long Nmat=(COORD_DIM*Ncoef)*(COORD_DIM*Ncoef);
+    if(sl){ pvfmm::Vector<float> tmp; tmp.Swap(SLMatrix_sp); SLMatrix_sp.ReInit(Nves*Nmat); }
+    if(dl){ pvfmm::Vector<float> tmp; tmp.Swap(DLMatrix_sp); DLMatrix_sp.ReInit(Nves*Nmat); }
+
+    long BLOCK_SIZE=std::max<long>(omp_get_max_threads(),1);
+    PVFMMVec S_blk, SL_blk, DL_blk;
+    for(long a=0;a<Nves;a+=BLOCK_SIZE){
+      long b=std::min(a+BLOCK_SIZE, Nves);
+      S_blk.ReInit((b-a)*Ngrid*COORD_DIM, &scoord[a*Ngrid*COORD_DIM], false);
+      SphericalHarmonics<Real>::StokesSingularInteg(S_blk, sh_order, sh_order_up_self, (sl?&SL_blk:NULL), (dl?&DL_blk:NULL), &sh_ws);
+      #pragma omp parallel for
+      for(long i=0;i<(b-a)*Nmat;i++){
+        if(sl) SLMatrix_sp[a*Nmat+i]=(float)SL_blk[i];
+        if(dl) DLMatrix_sp[a*Nmat+i]=(float)DL_blk[i];
+      }
+    }
+  }
+  INFO("StokesVelocity: self-interaction operator ("<<self_op<<") uses "<<SelfOpBytes()/1024.0/1024.0<<" MB per vesicle");
+}
+
+// v_r=f_r*M for nrhs rows f_r, v_r at stride ld and a dense row-major
+// N-by-N matrix M. Read column-major, M is M^T and the rows are the
+// columns of an N-by-nrhs matrix, so a single BLAS call gives V=M^T*F.
+template <class Real>
+inline void SelfGEMM(long N, long nrhs, long ld, const Real* f, const Real* M, Real* v){
+  int n=N, m=nrhs, ldv=ld;
+  Real one=1, zero=0;
+  Gemm("N", "N", &n, &m, &n, &one, M, &n, f, &ldv, &zero, v, &ldv);
+}
+
+// Same for a matrix in single precision: the rows are rounded to float
+// in buf for sgemm (the float matrix bounds the accuracy anyway)
+template <class Real>
+inline void SelfGEMM(long N, long nrhs, long ld, const Real* f, const float* M, Real* v, pvfmm::Vector<float>& buf){
+  if(buf.Dim()!=2*nrhs*N) buf.ReInit(2*nrhs*N);
+  float* fs=&buf[0];
+  float* vs=&buf[nrhs*N];
+  for(long r=0;r<nrhs;r++){
+    for(long k=0;k<N;k++) fs[r*N+k]=(float)f[r*ld+k];
+  }
+  SelfGEMM<float>(N, nrhs, N, fs, M, vs);
+  for(long r=0;r<nrhs;r++){
+    for(long k=0;k<N;k++) v[r*ld+k]=vs[r*N+k];
+  }
+}
+
+template <class Real>
+void StokesVelocity<Real>::SelfMatVec(const PVFMMVec* Fs, const PVFMMVec* Fd, PVFMMVec& SL_vel, PVFMMVec& DL_vel){
+  long Ncoef=sh_order*(sh_order+2);
+  long Ngrid=2*sh_order*(sh_order+1);
+  long N=COORD_DIM*Ncoef;
+  long Nmat=N*N;
+  long nv=scoord.Dim()/(Ngrid*COORD_DIM);
+  long nrhs=(nv?(Fs?Fs->Dim():(Fd?Fd->Dim():0))/(nv*N):0); // densities one after the other
+  long ld=nv*N;
+  if(Fs) SL_vel.ReInit(nrhs*ld);
+  if(Fd) DL_vel.ReInit(nrhs*ld);
+  if(!nrhs) return;
+
+  if(self_op==MatFreeSelfOp){ // rebuild the matrices for a block of vesicles, apply and discard
+    long BLOCK_SIZE=std::max<long>(omp_get_max_threads(),1);
+    PVFMMVec S_blk, SL_blk, DL_blk;
+    for(long a=0;a<nv;a+=BLOCK_SIZE){
+      long b=std::min(a+BLOCK_SIZE, nv);
+      S_blk.ReInit((b-a)*Ngrid*COORD_DIM, &scoord[a*Ngrid*COORD_DIM], false);
+      SphericalHarmonics<Real>::StokesSingularInteg(S_blk, sh_order, sh_order_up_self, (Fs?&SL_blk:NULL), (Fd?&DL_blk:NULL), &sh_ws);
+      #pragma omp parallel for
+      for(long i=a;i<b;i++){
+        if(Fs) SelfGEMM(N, nrhs, ld, &Fs[0][i*N], &SL_blk[(i-a)*Nmat], &SL_vel[i*N]);
+        if(Fd) SelfGEMM(N, nrhs, ld, &Fd[0][i*N], &DL_blk[(i-a)*Nmat], &DL_vel[i*N]);
+      }
+    }
+    return;
+  }
+
+  #pragma omp parallel
+  { // mat-vec
+    long tid=omp_get_thread_num();
+    long omp_p=omp_get_num_threads();
+    pvfmm::Vector<float> buf;
+
+    long a=(tid+0)*nv/omp_p;
+    long b=(tid+1)*nv/omp_p;
+    for(long i=a;i<b;i++){
+      if(self_op==SingleSelfOp){
+        if(Fs) SelfGEMM(N, nrhs, ld, &Fs[0][i*N], &SLMatrix_sp[i*Nmat], &SL_vel[i*N], buf);
+        if(Fd) SelfGEMM(N, nrhs, ld, &Fd[0][i*N], &DLMatrix_sp[i*Nmat], &DL_vel[i*N], buf);
+      }else{
+        if(Fs) SelfGEMM(N, nrhs, ld, &Fs[0][i*N], &SLMatrix[i*Nmat], &SL_vel[i*N]);
+        if(Fd) SelfGEMM(N, nrhs, ld, &Fd[0][i*N], &DLMatrix[i*Nmat], &DL_vel[i*N]);
+      }
+    }
+  }
+}
 
 template <class Real>
 Real StokesVelocity<Real>::MonitorError(Real tol){
-  static PVFMMVec force_single_orig, force_double_orig, tcoord_orig;
-  pvfmm::Profile::Tic("StokesMonitor",&comm, true);
+  PVFMMVec force_single_orig, force_double_orig, tcoord_orig;
+  STOKES_TIC("StokesMonitor",&comm,true);
   bool trg_is_surf_orig;
   { // Save original state
     force_single_orig=force_single;
@@ -561,8 +887,7 @@ Real StokesVelocity<Real>::MonitorError(Real tol){
     if(!trg_is_surf) tcoord_orig=tcoord;
   }
 
-  static PVFMMVec force;
-  force.ReInit(scoord.Dim());
+  PVFMMVec force(scoord.Dim());
   long Ngrid = 2*sh_order*(sh_order+1);
   long N_ves = scoord.Dim()/COORD_DIM/Ngrid;
   for(size_t i=0;i<N_ves;i++){ // Set force
@@ -634,7 +959,7 @@ Real StokesVelocity<Real>::MonitorError(Real tol){
     else SetDensityDL(NULL);
     if(!trg_is_surf_orig) SetTrgCoord(&tcoord_orig);
   }
-  pvfmm::Profile::Toc();
+  STOKES_TOC("StokesMonitor");
 
   { // Update sh_order_up_self, sh_order_up
     bool change_order=false;
@@ -658,8 +983,7 @@ Real StokesVelocity<Real>::MonitorError(Real tol){
       add_repul=false;
       fmm_setup=true;
 
-      SLMatrix.ReInit(0);
-      DLMatrix.ReInit(0);
+      ClearSelfMatrix();
 
       scoord_far.ReInit(0);
       tcoord_repl.ReInit(0);
@@ -770,7 +1094,7 @@ void StokesVelocity<Real>::Test(){
 
 
 template <class Real>
-void WriteVTK(const pvfmm::Vector<Real>& S, long p0, long p1, const char* fname, Real period=0, const pvfmm::Vector<Real>* v_ptr=NULL, MPI_Comm comm=MPI_COMM_WORLD){
+Error_t WriteVTK(const pvfmm::Vector<Real>& S, long p0, long p1, const char* fname, Real period=0, const pvfmm::Vector<Real>* v_ptr=NULL, MPI_Comm comm=MPI_COMM_WORLD, AsyncWriter* writer=NULL){
   typedef double VTKReal;
   int data__dof=COORD_DIM;
 
@@ -883,12 +1207,10 @@ void WriteVTK(const pvfmm::Vector<Real>& S, long p0, long p1, const char* fname,
   int pt_cnt=coord.size()/COORD_DIM;
   int poly_cnt=poly_offset.size();
 
-  //Open file for writing.
+  //The file is assembled in memory and written directly or by the writer thread.
   std::stringstream vtufname;
   vtufname<<fname<<"_"<<std::setfill('0')<<std::setw(6)<<myrank<<".vtp";
-  std::ofstream vtufile;
-  vtufile.open(vtufname.str().c_str());
-  if(vtufile.fail()) return;
+  std::stringstream vtufile;
 
   bool isLittleEndian;
   {
@@ -945,15 +1267,17 @@ void WriteVTK(const pvfmm::Vector<Real>& S, long p0, long p1, const char* fname,
   vtufile<<"  </AppendedData>\n";
   //===========================================================================
   vtufile<<"</VTKFile>\n";
-  vtufile.close();
+  { // Write vtufile
+    std::string data(vtufile.str());
+    Error_t err(writer ? writer->push(vtufname.str(), data) : AsyncWriter::Write(vtufname.str(), data));
+    if(err) return err;
+  }
 
 
-  if(myrank) return;
+  if(myrank) return ErrorEvent::Success;
   std::stringstream pvtufname;
   pvtufname<<fname<<".pvtp";
-  std::ofstream pvtufile;
-  pvtufile.open(pvtufname.str().c_str());
-  if(pvtufile.fail()) return;
+  std::stringstream pvtufile;
   pvtufile<<"<?xml version=\"1.0\"?>\n";
   pvtufile<<"<VTKFile type=\"PPolyData\">\n";
   pvtufile<<"  <PPolyData GhostLevel=\"0\">\n";
@@ -976,11 +1300,16 @@ void WriteVTK(const pvfmm::Vector<Real>& S, long p0, long p1, const char* fname,
   }
   pvtufile<<"  </PPolyData>\n";
   pvtufile<<"</VTKFile>\n";
-  pvtufile.close();
+  { // Write pvtufile
+    std::string data(pvtufile.str());
+    Error_t err(writer ? writer->push(pvtufname.str(), data) : AsyncWriter::Write(pvtufname.str(), data));
+    if(err) return err;
+  }
+  return ErrorEvent::Success;
 }
 
 template <class Surf>
-void WriteVTK(const Surf& S, const char* fname, MPI_Comm comm=MPI_COMM_WORLD, const typename Surf::Vec_t* v_ptr=NULL, int order=-1, typename Surf::value_type period=0){
+Error_t WriteVTK(const Surf& S, const char* fname, MPI_Comm comm=MPI_COMM_WORLD, const typename Surf::Vec_t* v_ptr=NULL, int order=-1, typename Surf::value_type period=0, AsyncWriter* writer=NULL){
   typedef typename Surf::value_type Real;
   typedef typename Surf::Vec_t Vec;
   size_t p0=S.getShOrder();
@@ -989,6 +1318,9 @@ void WriteVTK(const Surf& S, const char* fname, MPI_Comm comm=MPI_COMM_WORLD, co
   pvfmm::Vector<Real> S_, v_;
   S_.ReInit(S.getPosition().size(),(Real*)S.getPosition().begin(),false);
   if(v_ptr) v_.ReInit(v_ptr->size(),(Real*)v_ptr->begin(),false);
-  WriteVTK(S_, p0, p1, fname, period, (v_ptr?&v_:NULL), comm);
+  return WriteVTK(S_, p0, p1, fname, period, (v_ptr?&v_:NULL), comm, writer);
 }
 
+
+#undef STOKES_TIC
+#undef STOKES_TOC
@@ -46,6 +46,11 @@ std::string Streamable::name()
 template<typename T>
 Error_t Streamable::pack_array(std::ostream &os, Format format, const T* arr, size_t n, const char *sep) const
 {
+    if (format==BIN){
+        os.write(reinterpret_cast<const char*>(arr), n*sizeof(T));
+        return os.good() ? ErrorEvent::Success : ErrorEvent::IOBadStream;
+    }
+
     ASSERT(sep=="\n" || sep=="\t" || sep==" ", "unsupported separator");
     if(n>0) {
 	for (size_t ii=0; ii+1<n; ++ii) os<<arr[ii]<<sep;
@@ -57,8 +62,14 @@ Error_t Streamable::pack_array(std::ostream &os, Format format, const T* arr, si
 template<typename T>
 Error_t Streamable::unpack_array(std::istream &is, Format format, T* arr, size_t &n, const char* sep) const
 {
-    ASSERT(sep=="\n" || sep=="\t" || sep==" ", "unsupported separator");
     size_t N(n);
+    if (format==BIN){
+        is.read(reinterpret_cast<char*>(arr), N*sizeof(T));
+        n = is.gcount()/sizeof(T);
+        return (n==N) ? ErrorEvent::Success : ErrorEvent::IOBadStream;
+    }
+
+    ASSERT(sep=="\n" || sep=="\t" || sep==" ", "unsupported separator");
     for (n=0; n<N; ++n){
 	if(!is.good()) return ErrorEvent::IOBadStream;
 	is>>arr[n];
@@ -66,6 +77,30 @@ Error_t Streamable::unpack_array(std::istream &is, Format format, T* arr, size_t
     return ErrorEvent::Success;
 }
 
+Streamable::Format EnumifyFormat(const char * name)
+{
+  std::string ns(name);
+  if ( ns.compare(0,3,"BIN") == 0 )
+    return Streamable::BIN;
+  else
+    return Streamable::ASCII;
+}
+
+std::ostream& operator<<(std::ostream& output, const Streamable::Format &F)
+{
+    switch (F)
+    {
+        case Streamable::BIN:
+            output<<"BIN";
+            break;
+        case Streamable::ASCII:
+            output<<"ASCII";
+            break;
+    }
+
+    return output;
+}
+
 std::ostream& operator<<(std::ostream& os, const Streamable *o)
 {
     o->pack(os, Streamable::ASCII);
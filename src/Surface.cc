@@ -23,6 +23,7 @@ Surface<ScalarContainer, VectorContainer>::Surface(
     containers_are_stale_(true),
     first_forms_are_stale_(true),
     second_forms_are_stale_(true),
+    position_version_(newVersion()),
     checked_out_work_sca_(0),
     checked_out_work_vec_(0)
 {
@@ -61,6 +62,7 @@ void Surface<ScalarContainer, VectorContainer>::setPosition(const Vec_t& x_in)
     containers_are_stale_ = true;
     first_forms_are_stale_ = true;
     second_forms_are_stale_ = true;
+    position_version_ = newVersion();
 
     x_.replicate(x_in);
     axpy(static_cast<value_type>(1), x_in, x_);
@@ -74,6 +76,7 @@ Surface<ScalarContainer,VectorContainer>::getPositionModifiable()
     containers_are_stale_ = true;
     first_forms_are_stale_ = true;
     second_forms_are_stale_ = true;
+    position_version_ = newVersion();
 
     return(x_);
 }
@@ -220,42 +223,17 @@ updateFirstForms() const
     std::auto_ptr<Vec_t> wrk(checkoutVec());
     std::auto_ptr<Vec_t> shc(checkoutVec());
     std::auto_ptr<Vec_t> dif(checkoutVec());
-    std::auto_ptr<Sca_t> scp(checkoutSca());
 
     // Spherical harmonic coefficient (dif=du,normal=dv)
     sht_.FirstDerivatives(x_, *wrk, *shc, *dif, normal_);
 
-    // First fundamental coefficients
-    GeometricDot(*dif, *dif, E);
-    GeometricDot(*dif, normal_, F);
-    GeometricDot(normal_, normal_, G);
-
-    // Area element
-    xy(E, G, w_);
-    xy(F, F, *scp);
-    axpy(static_cast<value_type>(-1), *scp, w_, w_);
-
-    // Dividing EFG by W^2
-    xyInv(E, w_, E);
-    xyInv(F, w_, F);
-    xyInv(G, w_, G);
-    Sqrt(w_, w_);
-
-    //Div and Grad coefficients
-    xv(F, normal_, cu_);
-    axpy(static_cast<value_type>(-1), cu_, cu_);
-    xvpw(G, *dif, cu_, cu_);
-
-    xv(F, *dif, cv_);
-    axpy(static_cast<value_type>(-1), cv_, cv_);
-    xvpw(E, normal_, cv_, cv_);
-    GeometricCross(*dif, normal_, normal_);
-    uyInv(normal_, w_, normal_);
+    // First fundamental coefficients (divided by W^2), area element,
+    // div and grad coefficients, and normal in one pass
+    FirstForms(*dif, normal_, E, F, G, w_, cu_, cv_, normal_);
 
     recycle(wrk);
     recycle(shc);
     recycle(dif);
-    recycle(scp);
 
     first_forms_are_stale_ = false;
     PROFILEEND("",0);
@@ -272,49 +250,27 @@ updateAll() const
 
     std::auto_ptr<Vec_t> wrk(checkoutVec());
     std::auto_ptr<Vec_t> shc(checkoutVec());
-    std::auto_ptr<Vec_t> dif(checkoutVec());
+    std::auto_ptr<Vec_t> duu(checkoutVec());
+    std::auto_ptr<Vec_t> duv(checkoutVec());
+    std::auto_ptr<Vec_t> dvv(checkoutVec());
 
     sht_.forward(x_, *wrk, *shc);
+    sht_.backward_d2u(*shc, *wrk, *duu);
+    sht_.backward_duv(*shc, *wrk, *duv);
+    sht_.backward_d2v(*shc, *wrk, *dvv);
 
-    sht_.backward_duv(*shc, *wrk, *dif);
-    GeometricDot(*dif, normal_, h_);
-
-    xy(h_, h_, k_);
-    axpy(static_cast<value_type>(-1), k_, k_);
-
-    xy(F, h_, h_);
-    axpy(static_cast<value_type>(-1), h_, h_);
-
-    std::auto_ptr<Sca_t> L(checkoutSca());
-    sht_.backward_d2u(*shc, *wrk, *dif);
-    GeometricDot(*dif, normal_, *L);
-
-    std::auto_ptr<Sca_t> N(checkoutSca());
-    xy(G, *L, *N);
-    axpy(static_cast<value_type>(.5), *N, h_, h_);
-
-
-    sht_.backward_d2v(*shc, *wrk, *dif);
-    GeometricDot(*dif, normal_, *N);
-
-    xy(*L, *N, *L);
-    axpy(static_cast<value_type>(1), *L, k_, k_);
-
-    xyInv(k_,w_,k_);
-    xyInv(k_,w_,k_);
-
-    xy(E, *N, *N);
-    axpy(static_cast<value_type>(.5), *N, h_, h_);
+    // Mean and Gaussian curvature in one pass
+    SecondForms(*duu, *duv, *dvv, normal_, E, F, G, w_, h_, k_);
 
-    recycle(L);
-    recycle(N);
+    recycle(duu);
+    recycle(duv);
+    recycle(dvv);
 
     sht_.lowPassFilter(k_, *wrk, *shc, k_);
     sht_.lowPassFilter(h_, *wrk, *shc, h_);
 
     recycle(wrk);
     recycle(shc);
-    recycle(dif);
 
     second_forms_are_stale_ = false;
     PROFILEEND("",0);
@@ -407,6 +363,20 @@ volume(ScalarContainer &vol_out) const
     PROFILEEND("",0);
 }
 
+template< typename ScalarContainer, typename VectorContainer >
+void Surface<ScalarContainer, VectorContainer>::
+areaVolume(ScalarContainer &area_out, ScalarContainer &vol_out) const
+{
+    PROFILESTART();
+    if(first_forms_are_stale_)
+        updateFirstForms();
+
+    COUTDEBUG("Computing area and volume");
+    AreaVolume(x_, normal_, w_, *integrator_.getQuadWeights(x_.getShOrder()),
+        area_out, vol_out);
+    PROFILEEND("",0);
+}
+
 template< typename ScalarContainer, typename VectorContainer>
 void Surface<ScalarContainer, VectorContainer>::
 getCenters(Vec_t &centers) const
@@ -608,8 +578,6 @@ Error_t Surface<S, V>::resample(int new_sh_freq, Surface **new_surf /* delete wh
 template <typename S, typename V>
 Error_t Surface<S, V>::pack(std::ostream &os, Streamable::Format format) const{
 
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
-
     os<<"SURFACE\n";
     os<<"version: "<<VERSION<<"\n";
     os<<"name: "<<Streamable::name_<<"\n";
@@ -629,7 +597,6 @@ Error_t Surface<S, V>::pack(std::ostream &os, Streamable::Format format) const{
 template <typename S, typename V>
 Error_t Surface<S, V>::unpack(std::istream &is, Streamable::Format format){
 
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
     std::string s,key;
     int ii,version(0);
     value_type v;
@@ -679,6 +646,10 @@ Error_t Surface<S, V>::unpack(std::istream &is, Streamable::Format format){
     if(rt!=reparam_type_) WARN("Reparametrization type switched from "<<rt<<" to "<<reparam_type_);
 
     x_.unpack(is, format);
+    containers_are_stale_ = true;
+    first_forms_are_stale_ = true;
+    second_forms_are_stale_ = true;
+    position_version_ = newVersion();
     is>>s;
     ASSERT(s=="/SURFACE", "Bad input string (missing footer).");
 
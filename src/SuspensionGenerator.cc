@@ -0,0 +1,395 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>  //erand48
+
+template<typename T>
+SuspensionGenerator<T>::SuspensionGenerator(const std::vector<T> &shapes,
+    int stride, const std::vector<T> &volumes) :
+    stride_(stride),
+    nshapes_(volumes.size()),
+    shapes_(shapes),
+    volumes_(volumes),
+    radius_(nshapes_, 0),
+    spacing_(nshapes_, 0),
+    box_(0),
+    scale_(1),
+    min_sep_(0),
+    periodic_(false),
+    nbins_(1),
+    bin_size_(0)
+{
+    ASSERT(shapes_.size() >= (size_t) nshapes_*DIM*stride_,
+        "The shape gallery is smaller than the number of volumes");
+
+    for (int iS(0); iS<nshapes_; ++iS){
+        const T *x(&shapes_[iS*DIM*stride_]);
+        for (int i(0); i<stride_; ++i){
+            T r2(0), d2min(-1);
+            for (int d(0); d<DIM; ++d)
+                r2 += x[d*stride_+i]*x[d*stride_+i];
+            radius_[iS] = std::max(radius_[iS], (T) std::sqrt(r2));
+
+            for (int j(0); j<stride_; ++j){
+                if (j==i) continue;
+                T d2(0);
+                for (int d(0); d<DIM; ++d){
+                    T dx(x[d*stride_+i]-x[d*stride_+j]);
+                    d2 += dx*dx;
+                }
+                if (d2min<0 || d2<d2min) d2min = d2;
+            }
+            spacing_[iS] = std::max(spacing_[iS], (T) std::sqrt(d2min));
+        }
+    }
+}
+
+template<typename T>
+T SuspensionGenerator<T>::uniform()
+{
+    return erand48(rng_);
+}
+
+template<typename T>
+void SuspensionGenerator<T>::transform(Vesicle &ves) const
+{
+    int iS(ves.geo[0]);
+    T scale(ves.geo[1]);
+    std::vector<T> rot;
+    _rotation_matrix_zyz(ves.geo[5], ves.geo[6], ves.geo[7], rot);
+
+    const T *x(&shapes_[iS*DIM*stride_]);
+    const T zero[] = {0, 0, 0};
+    ves.pts.resize(DIM*stride_);
+    for (int i(0); i<stride_; ++i){
+        T px(x[i]), py(x[stride_+i]), pz(x[2*stride_+i]);
+        _transform_point(px, py, pz, scale, &rot[0], zero);
+        ves.pts[DIM*i  ] = px;
+        ves.pts[DIM*i+1] = py;
+        ves.pts[DIM*i+2] = pz;
+    }
+    ves.radius  = scale*radius_[iS];
+    ves.spacing = scale*spacing_[iS];
+}
+
+template<typename T>
+long SuspensionGenerator<T>::bin(const T *c, int *ijk) const
+{
+    long key(0);
+    for (int d(0); d<DIM; ++d){
+        int i(std::floor(c[d]/bin_size_));
+        i = std::max(0, std::min(i, nbins_-1));
+        if (ijk) ijk[d] = i;
+        key = key*nbins_ + i;
+    }
+    return key;
+}
+
+template<typename T>
+void SuspensionGenerator<T>::insert(Hash_t &hash, const Vesicle &ves, int idx) const
+{
+    hash[bin(ves.geo+2)].push_back(idx);
+}
+
+template<typename T>
+bool SuspensionGenerator<T>::overlaps(const Vesicle &ves, const Hash_t &hash) const
+{
+    int ijk[DIM];
+    bin(ves.geo+2, ijk);
+
+    // the bins are at least as large as the cut-off, the neighbors
+    // are in the adjacent bins
+    std::vector<int> cand[DIM];
+    for (int d(0); d<DIM; ++d){
+        for (int o(-1); o<=1; ++o){
+            int i(ijk[d]+o);
+            if (periodic_)
+                i = (i+nbins_)%nbins_;
+            else if (i<0 || i>=nbins_)
+                continue;
+            cand[d].push_back(i);
+        }
+        std::sort(cand[d].begin(), cand[d].end());
+        cand[d].erase(std::unique(cand[d].begin(), cand[d].end()), cand[d].end());
+    }
+
+    for (size_t i(0); i<cand[0].size(); ++i)
+        for (size_t j(0); j<cand[1].size(); ++j)
+            for (size_t k(0); k<cand[2].size(); ++k){
+                long key((cand[0][i]*(long) nbins_ + cand[1][j])*nbins_ + cand[2][k]);
+                typename Hash_t::const_iterator it(hash.find(key));
+                if (it == hash.end()) continue;
+
+                for (size_t n(0); n<it->second.size(); ++n){
+                    int idx(it->second[n]);
+                    const Vesicle &other(idx>=0 ? local_[idx] : halo_[-1-idx]);
+                    if (overlaps(ves, other)) return true;
+                }
+            }
+
+    return false;
+}
+
+template<typename T>
+bool SuspensionGenerator<T>::overlaps(const Vesicle &a, const Vesicle &b) const
+{
+    T dc[DIM], d2(0);
+    for (int d(0); d<DIM; ++d){
+        dc[d] = b.geo[2+d] - a.geo[2+d];
+        if (periodic_) dc[d] -= box_*std::floor(dc[d]/box_+0.5);
+        d2 += dc[d]*dc[d];
+    }
+
+    // near the closest points of two surfaces closer than min_sep,
+    // there is a pair of samples about min_sep apart in the normal
+    // direction and at most the sample spacing in the tangential one
+    // (when min_sep and the spacing are small relative to the size)
+    T spacing(std::max(a.spacing, b.spacing));
+    T thresh(std::sqrt(min_sep_*min_sep_ + spacing*spacing));
+    T reach(b.radius + thresh);
+    if (d2 >= (a.radius + reach)*(a.radius + reach)) return false;
+
+    T thresh2(thresh*thresh), reach2(reach*reach);
+    for (int i(0); i<stride_; ++i){
+        // point of a relative to the center of b
+        T q[DIM], q2(0);
+        for (int d(0); d<DIM; ++d){
+            q[d] = a.pts[DIM*i+d] - dc[d];
+            q2  += q[d]*q[d];
+        }
+        if (q2 > reach2) continue;
+
+        for (int j(0); j<stride_; ++j){
+            T dx(q[0]-b.pts[DIM*j  ]);
+            T dy(q[1]-b.pts[DIM*j+1]);
+            T dz(q[2]-b.pts[DIM*j+2]);
+            if (dx*dx+dy*dy+dz*dz < thresh2) return true;
+        }
+    }
+
+    return false;
+}
+
+template<typename T>
+Error_t SuspensionGenerator<T>::operator()(int nves, T volume_fraction,
+    T periodic_length, T min_sep, int seed, std::vector<T> &geo_spec)
+{
+    ASSERT(volume_fraction>0 && volume_fraction<1, "The volume fraction should be in (0,1)");
+    double tic(Logger::Now());
+
+    int nproc(1), rank(0);
+#ifdef HAS_MPI
+    MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
+
+    // an independent stream for each process: all bits of the seed and
+    // the rank are mixed (splitmix64 finalizer) into the 48-bit state
+    unsigned long long st(((unsigned long long) (unsigned int) seed << 32) | (unsigned int) rank);
+    st = (st ^ (st >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    st = (st ^ (st >> 27)) * 0x94d049bb133111ebULL;
+    st ^= st >> 31;
+    rng_[0] = st & 0xffff;
+    rng_[1] = (st >> 16) & 0xffff;
+    rng_[2] = (st >> 32) & 0xffff;
+    for (int i(0); i<16; ++i) uniform();
+
+    // shapes and the total volume at scale one
+    std::vector<int> shape(nves);
+    double vol(0), vol_all(0);
+    long n_all(nves);
+    for (int iV(0); iV<nves; ++iV){
+        shape[iV] = std::min((int) (uniform()*nshapes_), nshapes_-1);
+        vol += volumes_[shape[iV]];
+    }
+    vol_all = vol;
+#ifdef HAS_MPI
+    long n_loc(nves);
+    MPI_Allreduce(&vol, &vol_all, 1, MPI_DOUBLE, MPI_SUM, VES3D_COMM_WORLD);
+    MPI_Allreduce(&n_loc, &n_all, 1, MPI_LONG, MPI_SUM, VES3D_COMM_WORLD);
+#endif
+
+    periodic_ = periodic_length > 0;
+    min_sep_  = min_sep;
+    if (periodic_){
+        box_   = periodic_length;
+        scale_ = std::pow(volume_fraction*box_*box_*box_/vol_all, 1.0/3);
+    } else {
+        scale_ = 1;
+        box_   = std::pow(vol_all/volume_fraction, 1.0/3);
+    }
+
+    T rmax(0), smax(0);
+    for (int iS(0); iS<nshapes_; ++iS){
+        rmax = std::max(rmax, scale_*radius_[iS]);
+        smax = std::max(smax, scale_*spacing_[iS]);
+    }
+    T cut(2*rmax + min_sep_ + smax);
+    nbins_    = std::max(1, (int) (box_/cut));
+    bin_size_ = box_/nbins_;
+
+    // the grid of processes, the cells are at least as large as the
+    // cut-off so that only the adjacent cells interact
+    int dims[DIM] = {0, 0, 0};
+#ifdef HAS_MPI
+    MPI_Dims_create(nproc, DIM, dims);
+#else
+    dims[0] = dims[1] = dims[2] = 1;
+#endif
+    int coord[DIM] = {rank/(dims[1]*dims[2]), (rank/dims[2])%dims[1], rank%dims[2]};
+
+    if ( (periodic_ && box_ < 2*cut) || (!periodic_ && box_ < 2*rmax) ){
+        CERR("The box ("<<box_<<") is too small for the vesicles (radius "<<rmax<<")");
+        return ErrorEvent::InvalidParameterError;
+    }
+
+    T lo[DIM], hi[DIM];
+    int ncolors[DIM], color[DIM];
+    for (int d(0); d<DIM; ++d){
+        T h(box_/dims[d]);
+        if (dims[d]>1 && h<cut){
+            CERR("Too many processes ("<<nproc<<") for the box, the cell size "<<h
+                <<" is smaller than the cut-off "<<cut);
+            return ErrorEvent::InvalidParameterError;
+        }
+
+        lo[d] = coord[d]*h;
+        hi[d] = lo[d] + h;
+
+        if (dims[d]==1){
+            ncolors[d] = 1;
+            color[d]   = 0;
+        } else if (periodic_ && dims[d]%2){
+            ncolors[d] = 3;
+            color[d]   = (coord[d]==dims[d]-1) ? 2 : coord[d]%2;
+        } else {
+            ncolors[d] = 2;
+            color[d]   = coord[d]%2;
+        }
+    }
+
+    // the adjacent processes
+    std::vector<int> nbrs;
+    for (int ox(-1); ox<=1; ++ox)
+        for (int oy(-1); oy<=1; ++oy)
+            for (int oz(-1); oz<=1; ++oz){
+                int c[DIM] = {coord[0]+ox, coord[1]+oy, coord[2]+oz};
+                bool valid(true);
+                for (int d(0); d<DIM; ++d)
+                    if (c[d]<0 || c[d]>=dims[d]){
+                        if (periodic_) c[d] = (c[d]+dims[d])%dims[d];
+                        else valid = false;
+                    }
+                int r((c[0]*dims[1]+c[1])*dims[2]+c[2]);
+                if (valid && r!=rank) nbrs.push_back(r);
+            }
+    std::sort(nbrs.begin(), nbrs.end());
+    nbrs.erase(std::unique(nbrs.begin(), nbrs.end()), nbrs.end());
+
+    COUTDEBUG("Process grid "<<dims[0]<<"x"<<dims[1]<<"x"<<dims[2]<<", box "<<box_
+        <<", cut-off "<<cut<<", "<<nbins_<<"^3 bins, "<<nbrs.size()<<" neighbors");
+
+    // random sequential addition, one color at a time
+    const int max_trials(100000);
+    long trials(0);
+    int failed(0);
+    Hash_t hash;
+    local_.clear();
+    halo_.clear();
+
+    for (int cx(0); cx<ncolors[0]; ++cx)
+        for (int cy(0); cy<ncolors[1]; ++cy)
+            for (int cz(0); cz<ncolors[2]; ++cz){
+                if (cx==color[0] && cy==color[1] && cz==color[2] && !failed){
+                    hash.clear();
+                    for (size_t i(0); i<halo_.size(); ++i)
+                        insert(hash, halo_[i], -1-(int) i);
+
+                    for (int iV(0); iV<nves && !failed; ++iV){
+                        Vesicle ves;
+                        ves.geo[0] = shape[iV];
+                        ves.geo[1] = scale_;
+
+                        int trial(0);
+                        for (; trial<max_trials; ++trial){
+                            for (int d(0); d<DIM; ++d)
+                                ves.geo[2+d] = lo[d] + uniform()*(hi[d]-lo[d]);
+                            ves.geo[5] = 2*M_PI*uniform();
+                            ves.geo[6] = std::acos(1-2*uniform());
+                            ves.geo[7] = 2*M_PI*uniform();
+                            transform(ves);
+                            if (!overlaps(ves, hash)) break;
+                        }
+                        trials += trial+1;
+
+                        if (trial==max_trials){
+                            CERR("Could not place vesicle "<<iV<<" of process "<<rank<<" after "
+                                <<max_trials<<" trials, the volume fraction may be too high");
+                            failed = 1;
+                        } else {
+                            local_.push_back(ves);
+                            insert(hash, local_.back(), local_.size()-1);
+                        }
+                    }
+                }
+
+#ifdef HAS_MPI
+                // send the vesicles near the cell faces to the neighbors
+                std::vector<double> send;
+                for (size_t i(0); i<local_.size(); ++i){
+                    bool band(false);
+                    for (int d(0); d<DIM; ++d)
+                        band |= (local_[i].geo[2+d]-lo[d] < cut) || (hi[d]-local_[i].geo[2+d] < cut);
+                    if (band) send.insert(send.end(), local_[i].geo, local_[i].geo+8);
+                }
+
+                int nsend(send.size()), nn(nbrs.size());
+                std::vector<int> nrecv(nn);
+                std::vector<MPI_Request> req(2*nn);
+                for (int k(0); k<nn; ++k){
+                    MPI_Irecv(&nrecv[k], 1, MPI_INT, nbrs[k], 0, VES3D_COMM_WORLD, &req[2*k]);
+                    MPI_Isend(&nsend   , 1, MPI_INT, nbrs[k], 0, VES3D_COMM_WORLD, &req[2*k+1]);
+                }
+                if (nn) MPI_Waitall(2*nn, &req[0], MPI_STATUSES_IGNORE);
+
+                std::vector<std::vector<double> > recv(nn);
+                for (int k(0); k<nn; ++k){
+                    recv[k].resize(nrecv[k]);
+                    MPI_Irecv(recv[k].empty() ? NULL : &recv[k][0], nrecv[k], MPI_DOUBLE,
+                        nbrs[k], 1, VES3D_COMM_WORLD, &req[2*k]);
+                    MPI_Isend(send.empty() ? NULL : &send[0], nsend, MPI_DOUBLE,
+                        nbrs[k], 1, VES3D_COMM_WORLD, &req[2*k+1]);
+                }
+                if (nn) MPI_Waitall(2*nn, &req[0], MPI_STATUSES_IGNORE);
+
+                halo_.clear();
+                for (int k(0); k<nn; ++k)
+                    for (size_t i(0); i<recv[k].size(); i+=8){
+                        Vesicle ves;
+                        std::copy(recv[k].begin()+i, recv[k].begin()+i+8, ves.geo);
+                        transform(ves);
+                        halo_.push_back(ves);
+                    }
+#endif
+            }
+
+#ifdef HAS_MPI
+    int any_failed(0);
+    MPI_Allreduce(&failed, &any_failed, 1, MPI_INT, MPI_MAX, VES3D_COMM_WORLD);
+    failed = any_failed;
+#endif
+    if (failed) return ErrorEvent::InvalidParameterError;
+
+    geo_spec.clear();
+    for (size_t i(0); i<local_.size(); ++i)
+        geo_spec.insert(geo_spec.end(), local_[i].geo, local_[i].geo+8);
+
+    INFO("Placed "<<n_all<<" vesicles (scale "<<scale_<<") in the "
+        <<(periodic_ ? "periodic " : "")<<"box [0,"<<box_<<"]^3 at volume fraction "
+        <<vol_all*scale_*scale_*scale_/(box_*box_*box_)<<" on "<<nproc<<" processes ("
+        <<dims[0]<<"x"<<dims[1]<<"x"<<dims[2]<<"), "<<trials<<" trials on process 0, in "
+        <<Logger::Now()-tic<<"s");
+
+    local_.clear();
+    halo_.clear();
+    return ErrorEvent::Success;
+}
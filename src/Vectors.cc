@@ -85,8 +85,6 @@ enum CoordinateOrder Vectors<T, DT, DEVICE>::getPointOrder() const
 template<typename T, typename DT, const DT &DEVICE>
 Error_t Vectors<T, DT, DEVICE>::pack(std::ostream &os, Streamable::Format format) const
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
-
     os<<"VECTORS\n";
     os<<"version: "<<VERSION<<"\n";
     os<<"CoordinateOrder: "<<point_order_<<"\n";
@@ -99,7 +97,6 @@ Error_t Vectors<T, DT, DEVICE>::pack(std::ostream &os, Streamable::Format format
 template<typename T, typename DT, const DT &DEVICE>
 Error_t Vectors<T, DT, DEVICE>::unpack(std::istream &is, Streamable::Format format)
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
     std::string s, key;
     int version(0);
 
@@ -109,7 +109,6 @@ Error_t VesicleProperties<T>::setFromParams(Parameters<value_type> &params){
 template<typename T>
 Error_t VesicleProperties<T>::pack(std::ostream &os, Format format) const
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
     os<<"VESICLEPROPS\n";
     os<<"version: "<<VERSION<<"\n";
     os<<"name: "<<Streamable::name_<<"\n";
@@ -123,7 +122,6 @@ Error_t VesicleProperties<T>::pack(std::ostream &os, Format format) const
 template<typename T>
 Error_t VesicleProperties<T>::unpack(std::istream &is, Format format)
 {
-    ASSERT(format==Streamable::ASCII, "BIN is not supported yet");
     std::string s,key;
     int version(0);
 
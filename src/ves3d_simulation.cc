@@ -40,6 +40,7 @@ Simulation<DT,DEVICE>::Simulation(const Param_t &ip) :
     vInf_(NULL),
     ksp_(NULL),
     interaction_(NULL),
+    repartition_(NULL),
     timestepper_(NULL)
 {
     CHK(prepare_run_params(ip));
@@ -53,6 +54,7 @@ Simulation<DT,DEVICE>::Simulation(int argc, char** argv, const DictString_t *dic
     vInf_(NULL),
     ksp_(NULL),
     interaction_(NULL),
+    repartition_(NULL),
     timestepper_(NULL)
 {
     CHK(prepare_run_params(argc,argv,dict));
@@ -108,8 +110,10 @@ Error_t Simulation<DT,DEVICE>::setup_basics(){
 
 #ifdef HAVE_PVFMM
     interaction_ = new Inter_t(&PVFMMEval, &PVFMMDestroyContext<real_t>);
+    repartition_ = new Repart_t(&PVFMM_GlobalRepart<real_t>);
 #else
     interaction_ = new Inter_t(&StokesAlltoAll);
+    repartition_ = new Repart_t();
 #endif
 
     return ErrorEvent::Success;
@@ -118,8 +122,95 @@ Error_t Simulation<DT,DEVICE>::setup_basics(){
 template<typename DT, const DT &DEVICE>
 Error_t Simulation<DT,DEVICE>::setup_from_checkpoint(){
 
-    timestepper_ = new Evolve_t(&run_params_, *Mats_, vInf_, NULL, interaction_, NULL, ksp_);
-    timestepper_->unpack(checkpoint_data_, Streamable::ASCII);
+    if (checkpoint_header_.count.size()==0){
+        timestepper_ = new Evolve_t(&run_params_, *Mats_, vInf_, NULL, interaction_, repartition_, ksp_);
+        timestepper_->unpack(checkpoint_data_, Streamable::ASCII);
+        return ErrorEvent::Success;
+    }
+
+    int nproc(1), rank(0);
+#ifdef HAS_MPI
+    MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
+
+    if ((int) checkpoint_header_.count.size() != nproc)
+        return redistribute_checkpoint();
+
+    // each process only reads its own block
+    checkpoint_data_.str("");
+    checkpoint_data_.clear();
+    CHK(DataIO::ReadBlock(checkpoint_file_.c_str(), checkpoint_header_, rank, checkpoint_data_));
+    timestepper_ = new Evolve_t(&run_params_, *Mats_, vInf_, NULL, interaction_, repartition_, ksp_);
+    timestepper_->unpack(checkpoint_data_, Streamable::BIN);
+    return ErrorEvent::Success;
+}
+
+template<typename DT, const DT &DEVICE>
+Error_t Simulation<DT,DEVICE>::redistribute_checkpoint()
+{
+    int nproc(1), rank(0);
+#ifdef HAS_MPI
+    MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
+
+    const DataIO::BlockHeader &hdr(checkpoint_header_);
+    int nblocks(hdr.count.size());
+    size_t N(0);
+    for (int ib(0); ib<nblocks; ++ib) N += hdr.count[ib];
+
+    // vesicles [lo,hi) of the global ordering go to this process
+    size_t lo(N*rank/nproc), hi(N*(rank+1)/nproc), nves(hi-lo);
+    INFO("Redistributing "<<N<<" vesicles from "<<nblocks<<" checkpoint blocks to "
+        <<nproc<<" processes, local vesicles "<<lo<<" to "<<hi);
+    ASSERT(nves>0, "Too many processes for the number of vesicles in the checkpoint");
+    run_params_.n_surfs = nves;
+
+    Vec_t x0(nves, run_params_.sh_order);
+    size_t ves_sz(x0.getTheDim()*x0.getStride());
+    int nprops(VProp_t::n_props);
+
+    ves_props_ = new VProp_t();
+    for (int iP(0);iP<nprops;++iP)
+        ves_props_->getPropIdx(iP)->resize(nves);
+
+    // only the state of the blocks is unpacked (no solver is built),
+    // into a surface and properties reused for all the blocks
+    Sur_t blk_S(run_params_.sh_order, *Mats_, NULL, run_params_.filter_freq,
+        run_params_.rep_filter_freq, run_params_.rep_type, run_params_.rep_exponent);
+    VProp_t blk_props;
+    std::string blk_name;
+
+    size_t b0(0), b1(0);
+    for (int ib(0); ib<nblocks; ++ib, b0=b1){
+        b1 = b0+hdr.count[ib];
+        if (b1<=lo || b0>=hi) continue;
+
+        std::stringstream ss;
+        CHK(DataIO::ReadBlock(checkpoint_file_.c_str(), hdr, ib, ss));
+        CHK(Evolve_t::unpackState(ss, Streamable::BIN, run_params_, blk_props, blk_S, blk_name));
+        ASSERT(blk_S.getPosition().getNumSubs()==hdr.count[ib], "Inconsistent block "<<ib);
+
+        size_t s0(std::max(lo,b0)), s1(std::min(hi,b1));
+        x0.getDevice().Memcpy(x0.begin() + (s0-lo)*ves_sz,
+            blk_S.getPosition().begin() + (s0-b0)*ves_sz,
+            (s1-s0) * ves_sz * sizeof(value_type),
+            DT::MemcpyDeviceToDevice);
+
+        for (int iP(0);iP<nprops;++iP){
+            typename VProp_t::container_type* prp(ves_props_->getPropIdx(iP));
+            prp->getDevice().Memcpy(prp->begin() + (s0-lo),
+                blk_props.getPropIdx(iP)->begin() + (s0-b0),
+                (s1-s0) * sizeof(value_type),
+                DT::MemcpyDeviceToDevice);
+        }
+    }
+    ves_props_->update();
+
+    timestepper_ = new Evolve_t(&run_params_, *Mats_, vInf_, NULL,
+        interaction_, repartition_, ksp_, &x0, ves_props_);
+
     return ErrorEvent::Success;
 }
 
@@ -140,28 +231,55 @@ Error_t Simulation<DT,DEVICE>::setup_from_options()
     int nshapes(shapes.size()/x0.getStride()/DIM);
     INFO("Loaded "<<nshapes<<" shape(s)");
 
-    // load centers and transformations for current mpi process
-    ASSERT(run_params_.vesicle_geometry_file.size()>0,"geometry file is required");
-    fname = FullPath(run_params_.vesicle_geometry_file);
-    INFO("Reading geometry file "<<fname);
-    std::vector<value_type> all_geo_spec;
-    io.ReadDataStl(fname, all_geo_spec, DataIO::ASCII);
-
-    int nproc(1), rank(0);
+    int nproc(1);
+    bool distributed(false);
 #ifdef HAVE_PVFMM
     MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
-    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+    distributed = true;
 #endif
 
     /*
-     * slicing the geometry data for current process. expected
-     * number of fields per line is currently 8: shape_idx scale center_x
+     * load centers and transformations for current mpi process (the
+     * rows following those of the lower ranks). expected number of
+     * fields per row is currently 8: shape_idx scale center_x
      * center_y center_z rot_z, rot_y, rot_z
      */
-    int stride(8*nves);
-    ASSERT(all_geo_spec.size()>=nproc*stride,"bad initialization file");
-    std::vector<value_type> geo_spec(all_geo_spec.begin() + rank     * stride,
-                                     all_geo_spec.begin() + (rank+1) * stride);
+    double tic(Logger::Now());
+    std::vector<value_type> geo_spec;
+    if (run_params_.init_volume_fraction > 0){
+        // the volume of the shapes sets the size of the box (or the
+        // scale of the vesicles in the periodic domain)
+        Vec_t xs(nshapes, run_params_.sh_order);
+        xs.getDevice().Memcpy(xs.begin(), &shapes[0],
+            xs.size() * sizeof(value_type),
+            DT::MemcpyHostToDevice);
+        typename Evolve_t::Sur_t S(run_params_.sh_order, *Mats_, &xs);
+        typename Evolve_t::Sca_t vol(nshapes, 1);
+        S.volume(vol);
+        std::vector<value_type> volumes(nshapes);
+        vol.getDevice().Memcpy(&volumes[0], vol.begin(),
+            nshapes * sizeof(value_type),
+            DT::MemcpyDeviceToHost);
+
+        INFO("Generating the vesicles at volume fraction "<<run_params_.init_volume_fraction);
+        SuspensionGenerator<value_type> gen(shapes, x0.getStride(), volumes);
+        CHK(gen(nves, run_params_.init_volume_fraction, run_params_.periodic_length,
+                run_params_.init_min_sep, run_params_.init_seed, geo_spec));
+
+        if (run_params_.init_geometry_out.size()){
+            fname = FullPath(run_params_.init_geometry_out);
+            INFO("Writing the generated geometry to "<<fname);
+            std::vector<double> geo_rows(geo_spec.begin(), geo_spec.end());
+            CHK(DataIO::WriteRows(fname.c_str(), 8, geo_rows, distributed));
+        }
+    } else {
+        ASSERT(run_params_.vesicle_geometry_file.size()>0,"geometry file is required");
+        fname = FullPath(run_params_.vesicle_geometry_file);
+        INFO("Reading geometry file "<<fname);
+        std::vector<double> geo_rows;
+        CHK(DataIO::ReadRows(fname.c_str(), 8, nves, geo_rows, distributed));
+        geo_spec.assign(geo_rows.begin(), geo_rows.end());
+    }
 
     //Initial vesicle position container
     INFO("Initializing the starting shapes");
@@ -173,20 +291,25 @@ Error_t Simulation<DT,DEVICE>::setup_from_options()
 
     if (run_params_.vesicle_props_file.size()) {
         INFO("Loading vesicle properties from file: "<<run_params_.vesicle_props_file);
-        Arr_t propsf( nprops * nves * nproc);
-        Arr_t props( nprops * nves * nproc);
+        std::vector<double> prop_rows;
+        CHK(DataIO::ReadRows(FullPath(run_params_.vesicle_props_file).c_str(),
+                nprops, nves, prop_rows, distributed));
+        std::vector<value_type> buffer(prop_rows.begin(), prop_rows.end());
 
-        io.ReadData( FullPath(run_params_.vesicle_props_file), propsf,
-            DataIO::ASCII, 0, propsf.size());
+        Arr_t propsf( nprops * nves);
+        Arr_t props( nprops * nves);
+        propsf.getDevice().Memcpy(propsf.begin(), &buffer[0],
+            propsf.size() * sizeof(value_type),
+            DT::MemcpyHostToDevice);
 
         //order by property (column)
-        props.getDevice().Transpose(propsf.begin(),nves*nproc,nprops,props.begin());
+        props.getDevice().Transpose(propsf.begin(),nves,nprops,props.begin());
 
         for (int iP(0);iP<nprops;++iP){
             typename VProp_t::container_type* prp(ves_props_->getPropIdx(iP));
             prp->resize(nves);
             prp->getDevice().Memcpy(prp->begin(),
-                props.begin() + (iP*nproc + rank)*nves,
+                props.begin() + iP*nves,
                 nves * sizeof(VProp_t::value_type),
                 DT::MemcpyDeviceToDevice);
         }
@@ -194,9 +317,11 @@ Error_t Simulation<DT,DEVICE>::setup_from_options()
     } else { /* populate the properties from commandline */
         CHK(ves_props_->setFromParams(run_params_));
     }
+    INFO("Read the initial configuration of "<<nves<<" vesicles per process ("
+        <<nproc<<" processes) in "<<Logger::Now()-tic<<"s");
 
     timestepper_ = new Evolve_t(&run_params_, *Mats_, vInf_, NULL,
-        interaction_, NULL, ksp_, &x0, ves_props_);
+        interaction_, repartition_, ksp_, &x0, ves_props_);
 
     return ErrorEvent::Success;
 }
@@ -209,12 +334,15 @@ Error_t Simulation<DT,DEVICE>::cleanup_run()
     delete Mats_;        Mats_        = NULL;
     delete vInf_;        vInf_	      = NULL;
     delete ksp_;         ksp_	      = NULL;
-    delete interaction_; interaction_ = NULL;
     delete timestepper_; timestepper_ = NULL;
+    delete interaction_; interaction_ = NULL;
+    delete repartition_; repartition_ = NULL;
 
     load_checkpoint_ = false;
     checkpoint_data_.str("");
     checkpoint_data_.clear();
+    checkpoint_file_.clear();
+    checkpoint_header_ = DataIO::BlockHeader();
     return ErrorEvent::Success;
 }
 
@@ -237,7 +365,15 @@ Error_t Simulation<DT,DEVICE>::prepare_run_params(const Param_t &ip)
     if (ip.load_checkpoint != ""){
         std::string fname = FullPath(ip.load_checkpoint);
         INFO("Loading checkpoint file "<<fname);
-        DataIO::SlurpFile(fname.c_str(), checkpoint_data_);
+        if (DataIO::IsBlockFile(fname.c_str())){
+            // only the header is read here, the blocks are read
+            // when setting up the state
+            CHK(DataIO::ReadBlockHeader(fname.c_str(), checkpoint_header_));
+            checkpoint_data_<<checkpoint_header_.preamble;
+            checkpoint_file_ = fname;
+        } else {
+            DataIO::SlurpFile(fname.c_str(), checkpoint_data_);
+        }
         load_checkpoint_ = true;
     } else {
         ip.pack(checkpoint_data_, Streamable::ASCII);
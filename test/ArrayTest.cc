@@ -55,6 +55,26 @@ void test_array(){
             ASSERT(d[i]==i*i,"memcpy");
     }
 
+    {
+        size_t sz(6);
+        COUT(" . Test wrapping external memory");
+
+        T *c = (T*) Arr::getDevice().Malloc(2*sz*sizeof(T));
+        {
+            Arr a(sz);
+            a.wrap(c, 2*sz);
+            ASSERT(a.size()==0, "wrapped size");
+            a.resize(sz);
+            ASSERT(a.begin()==c, "resize within capacity keeps the buffer");
+            a.resize(2*sz);
+            ASSERT(a.begin()==c, "resize to capacity keeps the buffer");
+            a.resize(3*sz);
+            ASSERT(a.begin()!=c, "resize beyond capacity allocates");
+            a.wrap(c, sz);
+        } // a does not free c
+        Arr::getDevice().Free(c);
+    }
+
     { //streaming
         size_t sz(11);
         COUT(" . Test streaming");
@@ -89,6 +109,15 @@ void test_array(){
 	d.pack(s3, Streamable::ASCII);
 	ASSERT(s3.str()==ref, "bad stream d");
 
+        // binary round trip
+        Arr e;
+        a.pack(s4, Streamable::BIN);
+        e.unpack(s4, Streamable::BIN);
+        ASSERT(e.size()==sz, "bad binary stream size");
+        a.getDevice().Memcpy(c, e.begin(), e.mem_size(), DT::MemcpyDeviceToHost);
+        for(size_t i=0;i<sz;++i)
+            ASSERT(c[i]==i*i*i, "bad binary stream e");
+
 	delete[] c;
     }
 }
@@ -0,0 +1,133 @@
+/**
+ * @file
+ * @author Rahimian, Abtin <arahimian@acm.org>
+ * @revision $Revision$
+ * @tags $Tags$
+ * @date $Date$
+ *
+ * @brief unit test
+ */
+
+/*
+ * Copyright (c) 2014, Abtin Rahimian
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include "BDF2.h"
+#include "Logger.h"
+#include "ves3d_common.h"
+
+typedef double real;
+
+/*
+ * A scalar model of the BDF2 stepping of EvolveSurface: x' = L(x) x +
+ * u with L(g) = -k(1+g^2), where each step solves the implicit Euler
+ * equation of BDF2Coeffs with L frozen at the extrapolated position
+ * (as the vesicle operator is linearized about it).
+ */
+const real k(5), u(1), x_init(0.2);
+
+real rhs(real x){ return -k*(1+x*x)*x + u; }
+
+// x = x_start + h (L(g) x + u)
+real euler_solve(real g, real x_start, real h){
+    return (x_start + h*u)/(1 + h*k*(1+g*g));
+}
+
+// RK4 with n substeps, as the reference solution
+real exact(real x, real T, int n){
+    real h(T/n);
+    for (int i(0); i<n; ++i){
+        real k1(rhs(x)), k2(rhs(x+h/2*k1)), k3(rhs(x+h/2*k2)), k4(rhs(x+h*k3));
+        x += h/6*(k1+2*k2+2*k3+k4);
+    }
+    return x;
+}
+
+real run(real h, real T, int order){
+    real x(x_init), d1(0), t(0);
+    bool has_hist(false);
+    while (t < T-1e-12){
+        real xn;
+        if (order==1 || !has_hist){
+            xn = euler_solve(x, x, h);
+        } else {
+            BDF2Coeffs<real> bdf(h, h);
+            xn = euler_solve(x + bdf.extrap*d1, x + bdf.start*d1, bdf.step);
+        }
+        d1 = xn-x;
+        x = xn;
+        t += h;
+        has_hist = true;
+    }
+    return x;
+}
+
+void test_order(real ref){
+    real h[] = {0.02, 0.01, 0.005};
+    for (int order(1); order<=2; ++order){
+        real e[3];
+        for (int i(0); i<3; ++i) e[i] = fabs(run(h[i], 1.0, order) - ref);
+        for (int i(0); i<2; ++i){
+            real observed(log(e[i]/e[i+1])/log(2.0));
+            COUT("  order "<<order<<", dt="<<h[i+1]<<": error="<<e[i+1]<<", observed order="<<observed);
+            ASSERT(fabs(observed-order)<0.2, "Unexpected order of convergence "<<observed);
+        }
+    }
+}
+
+/*
+ * The local error estimate from the quadratic extrapolation of the
+ * last two (exact) steps against the true local error of the step
+ */
+void test_estimate(const real *hs){
+    real x0(x_init), x1(exact(x0, hs[0], 1000)), x2(exact(x1, hs[1], 1000));
+    real h(hs[2]), d1(x2-x1), d2(x1-x0);
+
+    BDF2Coeffs<real> bdf(h, hs[1], hs[0]);
+    real xn(euler_solve(x2 + bdf.extrap*d1, x2 + bdf.start*d1, bdf.step));
+    real x_pred(x2 + bdf.pred1*d1 + bdf.pred2*d2);
+    real est(bdf.err_scale*fabs(xn-x_pred));
+    real err(fabs(xn-exact(x2, h, 1000)));
+
+    COUT("  steps "<<hs[0]<<", "<<hs[1]<<", "<<hs[2]<<": local error="<<err
+        <<", estimate="<<est<<", ratio="<<est/err);
+    ASSERT(est>err/2 && est<2*err, "The local error estimate is off by "<<est/err);
+}
+
+int main(int argc, char** argv)
+{
+    VES3D_INITIALIZE(&argc,&argv,NULL,NULL);
+
+    COUT("Observed order of convergence:");
+    test_order(exact(x_init, 1.0, 200000));
+
+    COUT("Local error estimate:");
+    real hs[][3] = {{0.01, 0.01, 0.01}, {0.01, 0.013, 0.009}, {0.02, 0.01, 0.015}};
+    for (int i(0); i<3; ++i)
+        test_estimate(hs[i]);
+
+    COUT(emph<<" *** BDF2 passed ***"<<emph);
+    VES3D_FINALIZE();
+    return 0;
+}
@@ -35,6 +35,7 @@
 #include <typeinfo> //for typeid
 #include "Logger.h"
 #include "DataIO.h"
+#include "AsyncWriter.h"
 #include "Array.h"
 #include "Device.h"
 
@@ -49,6 +50,10 @@ public:
     TestWriteReadData_BIN();
     TestAppend_ASCII();
     TestAppend_BIN();
+    TestBlocks(NULL);
+    AsyncWriter writer;
+    TestBlocks(&writer);
+    TestRows();
 
     COUT(emph<<" *** DataIO class with "<<typeid(C).name()
 	 <<" container type passed ***"<<emph);
@@ -220,6 +225,94 @@ public:
     return true;
   }
 
+  bool TestBlocks(AsyncWriter *writer){
+    std::string fname("DataIOTest.out");
+    C* X(get_filled_container());
+    int rank(0);
+#ifdef HAS_MPI
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
+
+    std::stringstream block;
+    X->pack(block, Streamable::BIN);
+    ASSERT(DataIO::DumpBlocks(fname.c_str(), "preamble", block.str(), rank+1, writer)==ErrorEvent::Success, "Write block file");
+    if (writer) ASSERT(writer->flush()==ErrorEvent::Success, "Flush the writer");
+#ifdef HAS_MPI
+    MPI_Barrier(VES3D_COMM_WORLD);
+#endif
+
+    DataIO::BlockHeader hdr;
+    ASSERT(DataIO::IsBlockFile(fname.c_str()), "Block file header");
+    ASSERT(DataIO::ReadBlockHeader(fname.c_str(), hdr)==ErrorEvent::Success, "Read block file header");
+    ASSERT(hdr.version==VERSION, "Expected version "<<VERSION<<", got "<<hdr.version);
+    ASSERT(hdr.preamble=="preamble", "Expected preamble");
+    ASSERT(hdr.count[rank]==rank+1, "Expected count");
+
+    std::stringstream content;
+    ASSERT(DataIO::ReadBlock(fname.c_str(), hdr, rank, content)==ErrorEvent::Success, "Read block");
+    ASSERT(content.str()==block.str(), "Expected block content");
+
+#ifdef HAS_MPI
+    MPI_Barrier(VES3D_COMM_WORLD);
+#endif
+    if (rank==0) remove(fname.c_str());
+    delete X;
+    return true;
+  }
+
+  bool TestRows(){
+    std::string tname("DataIOTest.txt"), bname("DataIOTest.tbl");
+    int nproc(1), rank(0);
+#ifdef HAS_MPI
+    MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
+
+    // rank r owns r+1 rows, value of field j in row i is 10*i+j
+    size_t fields(3), nrows(nproc*(nproc+1)/2), row0(rank*(rank+1)/2);
+    if (rank==0){
+      std::vector<double> all(nrows*fields);
+      std::ofstream fh(tname.c_str());
+      fh<<"# a comment line"<<std::endl;
+      for (size_t i(0); i<nrows; ++i){
+        for (size_t j(0); j<fields; ++j){
+          all[i*fields+j] = 10*i+j;
+          fh<<(j ? " " : "")<<all[i*fields+j];
+        }
+        fh<<std::endl;
+      }
+      fh.close();
+      ASSERT(DataIO::WriteTable(bname.c_str(), fields, all)==ErrorEvent::Success, "Write table file");
+    }
+#ifdef HAS_MPI
+    MPI_Barrier(VES3D_COMM_WORLD);
+#endif
+
+    ASSERT(!DataIO::IsTableFile(tname.c_str()), "Text is not a table file");
+    ASSERT(DataIO::IsTableFile(bname.c_str()), "Table file header");
+
+    for (int k(0); k<2; ++k){
+      const char* fname(k ? bname.c_str() : tname.c_str());
+      std::vector<double> rows;
+      ASSERT(DataIO::ReadRows(fname, fields, rank+1, rows)==ErrorEvent::Success, "Read distributed rows");
+      ASSERT(rows.size()==(rank+1)*fields, "Expected number of rows");
+      for (size_t i(0); i<rows.size(); ++i)
+        ASSERT(rows[i]==10*(row0+i/fields)+i%fields, "Expected row content");
+
+      ASSERT(DataIO::ReadRows(fname, fields, 1, rows, false)==ErrorEvent::Success, "Read first row");
+      ASSERT(rows.size()==fields && rows[fields-1]==fields-1, "Expected first row");
+    }
+
+#ifdef HAS_MPI
+    MPI_Barrier(VES3D_COMM_WORLD);
+#endif
+    if (rank==0){
+      remove(tname.c_str());
+      remove(bname.c_str());
+    }
+    return true;
+  }
+
 };
 
 typedef Device<CPU> DevCPU;
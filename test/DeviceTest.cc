@@ -1,6 +1,7 @@
 #include "DeviceTest.h"
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 int main(int argc, char** argv)
 {
@@ -46,6 +47,18 @@ int main(int argc, char** argv)
         Device<CPU> cpu;
         DeviceTest<CPU,double> dvt_d(&cpu);
         res &= dvt_d.PerformAll();
+
+        // non-numeric entries, below and above the serial reduction length
+        double zero(0);
+        std::vector<double> x(100012, 1.0);
+        bool numeric(cpu.isNumeric(&x[0], 12) && cpu.isNumeric(&x[0], x.size()));
+        x[5] = 1/zero;
+        numeric = numeric && !cpu.isNumeric(&x[0], 12);
+        x[5] = 1;
+        x[x.size()-1] = zero/zero;
+        numeric = numeric && !cpu.isNumeric(&x[0], x.size());
+        COUT(" * Device::isNumeric : "<<(numeric ? "Passed" : "Failed")<<" *");
+        res &= numeric;
     }
 
 #ifdef GPU_ACTIVE
@@ -39,6 +39,7 @@ class DeviceTest
     bool TestReduce();
     bool TestTranspose();
     bool TestMax();
+    bool TestAreaVolume();
 };
 
 template<enum DeviceType DT, typename T>
@@ -71,7 +72,8 @@ bool DeviceTest<DT,T>::PerformAll()
         && Testxvpw()
         && TestReduce()
         && TestTranspose()
-        && TestMax();
+        && TestMax()
+        && TestAreaVolume();
 
     if (test_result){
         COUT(emph<<"\n *** Device Class tests with DT="<<DT
@@ -88,8 +90,9 @@ bool DeviceTest<DT,T>::TestMalloc()
 {
     size_t arr_size(static_cast<size_t>(1e6));
     bool res(false);
+    size_t cnt(Device<DT>::MallocCount());
     T* a = (T*) device->Malloc(arr_size * sizeof(T));
-    if(a != NULL)
+    if(a != NULL && Device<DT>::MallocCount()==cnt+1)
         res = true;
 
     device->Free(a);
@@ -970,33 +973,114 @@ template<enum DeviceType DT, typename T>
 bool DeviceTest<DT,T>::TestMax()
 {
     bool res = true;
+    // below and above the length of the serial reductions
+    int lengths[] = {1012, 100012};
+    for(int ll=0;ll<2;ll++)
     {
-        int length = 10012;
+        int length = lengths[ll];
         T* x = (T*) device->Malloc(length * sizeof(T));
         T* x_host = (T*) malloc(length * sizeof(T));
 
         T max = 0;
+        double dot = 0;
         for(int idx=0;idx<length;idx++)
         {
             x_host[idx] = (T) drand48() * 10 - 5;
             max = (max > std::abs(x_host[idx])) ?
                 max : std::abs(x_host[idx]);
+            dot += x_host[idx] * x_host[idx];
         }
 
         device->Memcpy(x,
             x_host,
             length * sizeof(T),
             Device<DT>::MemcpyHostToDevice);
+        size_t cnt(Device<DT>::MallocCount());
         T mx = device->MaxAbs(x,length);
+        T dt = device->AlgebraicDot(x,x,length);
+        bool no_malloc(Device<DT>::MallocCount()==cnt);
 
         device->Free(x);
         free(x_host);
 
         T err = fabs(mx-max);
         res = res && (err<eps) ? true : false;
+        res = res && (fabs(dt-dot)<sqrt(length)*eps*dot) ? true : false;
+        res = res && no_malloc;
 
         string res_print = (res) ? "Passed" : "Failed";
-        COUT(" * Device::Max : " + res_print + " *");
+        COUT(" * Device::Max (length "<<length<<") : " + res_print + " *");
     }
     return res;
 }
+
+template<enum DeviceType DT, typename T>
+bool DeviceTest<DT,T>::TestAreaVolume()
+{
+    bool res = true;
+
+    int stride = 312;
+    int ns = 5;
+    int length = ns*stride;
+
+    T *x = (T*) device->Malloc(DIM * length * sizeof(T));
+    T *n = (T*) device->Malloc(DIM * length * sizeof(T));
+    T *w = (T*) device->Malloc(length * sizeof(T));
+    T *q = (T*) device->Malloc(stride * sizeof(T));
+    T *a = (T*) device->Malloc(ns * sizeof(T));
+    T *v = (T*) device->Malloc(ns * sizeof(T));
+
+    T *x_host = (T*) malloc(DIM * length * sizeof(T));
+    T *n_host = (T*) malloc(DIM * length * sizeof(T));
+    T *w_host = (T*) malloc(length * sizeof(T));
+    T *q_host = (T*) malloc(stride * sizeof(T));
+    T *a_host = (T*) malloc(ns * sizeof(T));
+    T *v_host = (T*) malloc(ns * sizeof(T));
+
+    // x.n = ii+1 at every point of surface ii
+    for(int ii=0;ii<ns;++ii)
+        for(int jj=0;jj<stride;++jj)
+            for(int dd=0;dd<DIM;++dd)
+            {
+                x_host[ii*DIM*stride+dd*stride+jj] = ii+1;
+                n_host[ii*DIM*stride+dd*stride+jj] = (dd==0);
+                w_host[ii*stride+jj] = .5;
+                q_host[jj] = .25;
+            }
+
+    device->Memcpy(x,x_host,DIM * length * sizeof(T),Device<DT>::MemcpyHostToDevice);
+    device->Memcpy(n,n_host,DIM * length * sizeof(T),Device<DT>::MemcpyHostToDevice);
+    device->Memcpy(w,w_host,length * sizeof(T),Device<DT>::MemcpyHostToDevice);
+    device->Memcpy(q,q_host,stride * sizeof(T),Device<DT>::MemcpyHostToDevice);
+
+    device->AreaVolume(x, n, w, q, stride, ns, a, v);
+    device->Memcpy(a_host,a,ns * sizeof(T),Device<DT>::MemcpyDeviceToHost);
+    device->Memcpy(v_host,v,ns * sizeof(T),Device<DT>::MemcpyDeviceToHost);
+
+    T err = 0;
+    T A = stride/8.0;
+    for(int ii=0;ii<ns;++ii)
+    {
+        err = std::max(err, (T) fabs(a_host[ii]-A));
+        err = std::max(err, (T) fabs(v_host[ii]-A*(ii+1)/3));
+    }
+    res = res && (err<eps*stride) ? true : false;
+
+    free(x_host);
+    free(n_host);
+    free(w_host);
+    free(q_host);
+    free(a_host);
+    free(v_host);
+
+    device->Free(x);
+    device->Free(n);
+    device->Free(w);
+    device->Free(q);
+    device->Free(a);
+    device->Free(v);
+
+    string res_print = (res) ? "Passed" : "Failed";
+    COUT(" * Device::AreaVolume : " + res_print + " *");
+    return res;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @author Rahimian, Abtin <arahimian@acm.org>
+ * @revision $Revision$
+ * @tags $Tags$
+ * @date $Date$
+ *
+ * @brief unit test
+ */
+
+/*
+ * Copyright (c) 2014, Abtin Rahimian
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Scalars.h"
+#include "Vectors.h"
+#include "HelperFuns.h"
+
+typedef double real;
+typedef Device<CPU> DevCPU;
+extern const DevCPU the_cpu_device(0);
+
+typedef Scalars<real, DevCPU, the_cpu_device> Sca_t;
+typedef Vectors<real, DevCPU, the_cpu_device> Vec_t;
+
+// The elementwise chain that Surface::updateFirstForms and
+// Surface::updateAll used before the fused kernels
+void first_forms_chain(const Vec_t &du, Vec_t &nor, Sca_t &E, Sca_t &F,
+    Sca_t &G, Sca_t &W, Vec_t &cu, Vec_t &cv, Sca_t &scp)
+{
+    GeometricDot(du, du, E);
+    GeometricDot(du, nor, F);
+    GeometricDot(nor, nor, G);
+
+    xy(E, G, W);
+    xy(F, F, scp);
+    axpy(static_cast<real>(-1), scp, W, W);
+
+    xyInv(E, W, E);
+    xyInv(F, W, F);
+    xyInv(G, W, G);
+    Sqrt(W, W);
+
+    xv(F, nor, cu);
+    axpy(static_cast<real>(-1), cu, cu);
+    xvpw(G, du, cu, cu);
+
+    xv(F, du, cv);
+    axpy(static_cast<real>(-1), cv, cv);
+    xvpw(E, nor, cv, cv);
+    GeometricCross(du, nor, nor);
+    uyInv(nor, W, nor);
+}
+
+void second_forms_chain(const Vec_t &duu, const Vec_t &duv, const Vec_t &dvv,
+    const Vec_t &nor, const Sca_t &E, const Sca_t &F, const Sca_t &G,
+    const Sca_t &W, Sca_t &h, Sca_t &k, Sca_t &L, Sca_t &N)
+{
+    GeometricDot(duv, nor, h);
+
+    xy(h, h, k);
+    axpy(static_cast<real>(-1), k, k);
+
+    xy(F, h, h);
+    axpy(static_cast<real>(-1), h, h);
+
+    GeometricDot(duu, nor, L);
+    xy(G, L, N);
+    axpy(static_cast<real>(.5), N, h, h);
+
+    GeometricDot(dvv, nor, N);
+    xy(L, N, L);
+    axpy(static_cast<real>(1), L, k, k);
+
+    xyInv(k, W, k);
+    xyInv(k, W, k);
+
+    xy(E, N, N);
+    axpy(static_cast<real>(.5), N, h, h);
+}
+
+template<typename C>
+real rel_err(const C &a, const C &b)
+{
+    C d;
+    d.replicate(a);
+    axpy(static_cast<real>(-1), a, b, d);
+    return MaxAbs(d)/MaxAbs(a);
+}
+
+void test_geometry_kernels(int p, int nves, int nrep)
+{
+    Vec_t du(nves, p), dv(nves, p), duu(nves, p), duv(nves, p), dvv(nves, p);
+    fillRand(du);
+    fillRand(dv);
+    fillRand(duu);
+    fillRand(duv);
+    fillRand(dvv);
+
+    Sca_t E0(nves, p), F0(nves, p), G0(nves, p), W0(nves, p), H0(nves, p), K0(nves, p);
+    Sca_t E1(nves, p), F1(nves, p), G1(nves, p), W1(nves, p), H1(nves, p), K1(nves, p);
+    Sca_t s1(nves, p), s2(nves, p);
+    Vec_t cu0(nves, p), cv0(nves, p), n0(nves, p);
+    Vec_t cu1(nves, p), cv1(nves, p), n1(nves, p);
+
+    double t_chain(0), t_fused(0), ts;
+    for (int r(0); r<nrep; ++r){
+        axpy(static_cast<real>(1), dv, n0);
+        ts = GETSECONDS();
+        first_forms_chain(du, n0, E0, F0, G0, W0, cu0, cv0, s1);
+        second_forms_chain(duu, duv, dvv, n0, E0, F0, G0, W0, H0, K0, s1, s2);
+        t_chain += GETSECONDS()-ts;
+
+        axpy(static_cast<real>(1), dv, n1);
+        ts = GETSECONDS();
+        FirstForms(du, n1, E1, F1, G1, W1, cu1, cv1, n1);
+        SecondForms(duu, duv, dvv, n1, E1, F1, G1, W1, H1, K1);
+        t_fused += GETSECONDS()-ts;
+    }
+
+    real err(0);
+    err = std::max(err, rel_err(E0, E1));
+    err = std::max(err, rel_err(F0, F1));
+    err = std::max(err, rel_err(G0, G1));
+    err = std::max(err, rel_err(W0, W1));
+    err = std::max(err, rel_err(cu0, cu1));
+    err = std::max(err, rel_err(cv0, cv1));
+    err = std::max(err, rel_err(n0, n1));
+    err = std::max(err, rel_err(H0, H1));
+    err = std::max(err, rel_err(K0, K1));
+
+    COUT("p="<<p<<", "<<nves<<" vesicles: chain "<<t_chain/nrep
+        <<"s, fused "<<t_fused/nrep<<"s, speedup "<<t_chain/t_fused
+        <<", relative difference "<<err);
+    ASSERT(err<1e-10, "fused geometry kernels differ from the elementwise chain");
+}
+
+int main(int argc, char** argv)
+{
+    VES3D_INITIALIZE(&argc,&argv,NULL,NULL);
+    COUT("Fused geometry kernels against the elementwise chain:");
+
+    int p[] = {6, 8, 12, 16, 24, 32};
+    for (int i(0); i<6; ++i)
+        test_geometry_kernels(p[i], 64, 20);
+
+    COUT(emph<<" *** Geometry kernels passed ***"<<emph);
+    VES3D_FINALIZE();
+    return 0;
+}
@@ -120,10 +120,98 @@ int main(int argc, char** argv){
         sim.run_params()->solve_for_velocity=false;
         F->updateImplicit(*E->S_,ts,dxx);
 
-        axpy(-1.0,dxv,dxx,dxv);
-        err = MaxAbs(dxv);
+        axpy(-1.0,dxv,dxx,dxx);
+        err = MaxAbs(dxx);
         COUT("Difference in solving for position or velocity: "<<err);
         ASSERT(err<tol,"large error between velocity and position solve");
+        size_t diag_iter(F->SolveIterations());
+
+        INFO("Block-Jacobi preconditioner");
+        sim_par.time_precond = BlockJacobiSelf;
+        Sim_t sim_blk(sim_par);
+        sim_blk.setup();
+        Evolve_t *E_blk(sim_blk.time_stepper());
+        E_blk->ReinitInterfacialVelocity();
+        IntVel_t *F_blk(E_blk->F_);
+        F_blk->Prepare(GloballyImplicit);
+        ASSERT(F_blk->ActivePrecond()==BlockJacobiSelf, "The block preconditioner is not used");
+
+        err = F_blk->BlockPrecondError();
+        COUT("Block preconditioner applied to the self operator, error: "<<err);
+        ASSERT(err<1e-8,"the block preconditioner does not invert the self-interaction block");
+
+        Vec_t dxb(nves,p);
+        sim_blk.run_params()->solve_for_velocity=false;
+        CHK(F_blk->updateImplicit(*E_blk->S_,ts,dxb));
+        size_t blk_iter(F_blk->SolveIterations());
+        ASSERT(blk_iter<sim_par.time_iter_max, "The block preconditioned solve did not converge");
+
+        axpy(-1.0,dxv,dxb,dxb);
+        err = MaxAbs(dxb);
+        COUT("Block preconditioned solve: "<<blk_iter<<" iterations (diagonal: "<<diag_iter
+            <<"), difference: "<<err);
+        ASSERT(err<tol,"large error between the block and diagonal preconditioned solves");
+
+        /*
+         * Reparametrization: the energy should decrease and converge,
+         * and the result for each vesicle should not depend on the
+         * other vesicles of the container. Only the first vesicle is
+         * perturbed, so the second one converges first and is dropped
+         * from the active set; each vesicle is then reparametrized
+         * alone (no compaction) and compared.
+         */
+        INFO("Reparametrization");
+        sim_par.time_precond = DiagonalSpectral;
+        sim_par.rep_ts       = 1e-1;
+        sim_par.rep_tol      = 1e-6;
+        sim_par.rep_maxit    = 2000;
+        Sim_t sim_rep(sim_par);
+        sim_rep.setup();
+        Evolve_t *E_rep(sim_rep.time_stepper());
+        E_rep->ReinitInterfacialVelocity();
+        IntVel_t *F_rep(E_rep->F_);
+
+        Vec_t dx(nves,p), x0(nves,p);
+        fillRand(dx);
+        Vec_t::getDevice().Memset(dx.getSubN_begin(1), zero, dx.getTheDim()*dx.getStride()*sizeof(value_type));
+        axpy(static_cast<value_type>(1e-2), dx, E_rep->S_->getPosition(), x0);
+        E_rep->S_->setPosition(x0);
+
+        CHK(F_rep->reparam());
+        size_t rep_iter(F_rep->ReparamIterations());
+        value_type E0(F_rep->ReparamEnergy(true)), E1(F_rep->ReparamEnergy());
+        COUT("Reparametrization: "<<rep_iter<<" iterations, energy "<<E0<<" -> "<<E1);
+        ASSERT(E1<E0, "reparametrization did not decrease the energy");
+        ASSERT(rep_iter<(size_t) sim_par.rep_maxit, "reparametrization did not converge");
+
+        CHK(F_rep->reparam());
+        COUT("Second reparametrization: "<<F_rep->ReparamIterations()<<" iterations, energy "<<F_rep->ReparamEnergy());
+        ASSERT(F_rep->ReparamEnergy()<=E1*(1+1e-12), "the energy increased after convergence");
+        ASSERT(E1-F_rep->ReparamEnergy()<1e-1*(E0-E1), "reparametrization did not converge");
+
+        sim_par.n_surfs = 1;
+        size_t sub_len(x0.getTheDim()*x0.getStride());
+        err = 0;
+        for (int k=0; k<nves; ++k){
+            Sim_t sim_one(sim_par);
+            sim_one.setup();
+            Evolve_t *E_one(sim_one.time_stepper());
+            E_one->ReinitInterfacialVelocity();
+
+            Vec_t xk(1,p), yk(1,p);
+            Vec_t::getDevice().Memcpy(xk.begin(), x0.getSubN_begin(k), sub_len*sizeof(value_type),
+                Dev::MemcpyDeviceToDevice);
+            E_one->S_->setPosition(xk);
+            CHK(E_one->F_->reparam());
+
+            Vec_t::getDevice().Memcpy(yk.begin(), E_rep->S_->getPosition().getSubN_begin(k),
+                sub_len*sizeof(value_type), Dev::MemcpyDeviceToDevice);
+            axpy(-one, yk, E_one->S_->getPosition(), yk);
+            err = std::max(err, MaxAbs(yk)/MaxAbs(xk));
+        }
+        sim_par.n_surfs = nves;
+        COUT("Reparametrization with and without compaction, difference: "<<err);
+        ASSERT(err<1e-8, "compacting the active set changed the reparametrization");
     }
     VES3D_FINALIZE();
 }
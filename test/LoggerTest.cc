@@ -1,6 +1,10 @@
 #include "Logger.h"
 
+#include <cstdio>
 #include <fstream>
+#include <map>
+#include <vector>
+#include <omp.h>
 #include <unistd.h>  //for sleep()
 
 using namespace std;
@@ -33,6 +37,84 @@ int Dummy(int ii)
     return(ii);
 }
 
+double Work(int n)
+{
+    PROFILESTART();
+    double s(0);
+    for(int ii=0;ii<n;++ii)
+        s += 1.0/(ii+1);
+    PROFILEEND("",n);
+    return(s);
+}
+
+struct TraceRecord
+{
+    string name;
+    double ts, dur;
+    int tid;
+};
+
+/*
+ * Reads back the trace written by WriteTrace (one event per line) and
+ * checks that every thread of the parallel region has one
+ * parallel_main event with n_work Work events nested in it, and that
+ * the named phase was traced once.
+ */
+void CheckTrace(const string &file_name, int n_work, const string &phase)
+{
+    ifstream in(file_name.c_str());
+    ASSERT(in.good(), "The trace file was not written");
+
+    string line;
+    getline(in, line);
+    ASSERT(line.find("\"traceEvents\":[")!=string::npos, "Not a Chrome trace: "<<line);
+
+    vector<TraceRecord> events;
+    while (getline(in, line) && line[0]=='{'){
+        TraceRecord ev;
+        size_t b(line.find("\"name\":\"")+8), e(line.find('"',b));
+        size_t t(line.find("\"ts\":"));
+        ASSERT(b!=string::npos+8 && e!=string::npos && t!=string::npos, "Bad trace event: "<<line);
+        ev.name = line.substr(b, e-b);
+        int pid;
+        ASSERT(sscanf(line.c_str()+t, "\"ts\":%lf,\"dur\":%lf,\"pid\":%d,\"tid\":%d",
+                &ev.ts, &ev.dur, &pid, &ev.tid)==4, "Bad trace event: "<<line);
+        events.push_back(ev);
+    }
+    ASSERT(line=="]}", "The trace is not closed: "<<line);
+
+    map<int, int> n_outer, n_inner;
+    int n_phase(0);
+    for (size_t i=0; i<events.size(); ++i){
+        if (events[i].name=="parallel_main") ++n_outer[events[i].tid];
+        if (events[i].name==phase) ++n_phase;
+    }
+    ASSERT(n_phase==1, "Expected one "<<phase<<" event, found "<<n_phase);
+
+    for (size_t i=0; i<events.size(); ++i){
+        if (events[i].name!="Work") continue;
+        const TraceRecord &w(events[i]);
+        for (size_t j=0; j<events.size(); ++j){
+            const TraceRecord &o(events[j]);
+            if (o.name=="parallel_main" && o.tid==w.tid &&
+                o.ts<=w.ts+1e-3 && w.ts+w.dur<=o.ts+o.dur+1e-3){
+                ++n_inner[w.tid];
+                break;
+            }
+        }
+    }
+
+    int nthreads(omp_get_max_threads());
+    ASSERT((int) n_outer.size()==nthreads, "Expected events on "<<nthreads
+        <<" threads, found "<<n_outer.size());
+    for (map<int,int>::iterator it=n_outer.begin(); it!=n_outer.end(); ++it){
+        ASSERT(it->second==1, "Thread "<<it->first<<" has "<<it->second<<" parallel_main events");
+        ASSERT(n_inner[it->first]==n_work, "Thread "<<it->first<<" has "<<n_inner[it->first]
+            <<" nested Work events, expected "<<n_work);
+    }
+    COUT(" Trace : "<<events.size()<<" events on "<<n_outer.size()<<" threads, nesting checked");
+}
+
 #endif //Doxygen_skip
 
 int main(int argc, char** argv)
@@ -64,6 +146,32 @@ int main(int argc, char** argv)
     PROFILEEND("",0);
     PROFILEREPORT(SortTime);
 
+    //nested events on several threads, each with its own Tic stack
+    PROFILECLEAR();
+    Logger::SetTrace(true);
+    double sum(0);
+#pragma omp parallel reduction(+:sum)
+    {
+        PROFILESTART();
+        for(int ii=0;ii<100;++ii)
+            sum += Work(10000);
+        PROFILEEND("parallel_",0);
+    }
+    COUT(" Sum over threads : "<<sum);
+
+    //a phase inside a function, named like the pvfmm::Profile phases
+    PROFILESTART();
+    sum += Work(10000);
+    PROFILEENDNAME("pvfmm::Phase",0);
+    PROFILEREPORT(SortFlop);
+
+    string trace_file("LoggerTest.json");
+    PROFILETRACE(trace_file);
+#ifdef PROFILING
+    CheckTrace(trace_file, 100, "pvfmm::Phase");
+#endif
+    remove(trace_file.c_str());
+
     //printing the log file
     COUT("\n  Content of the log file: \n"
         <<" ==============================");
@@ -0,0 +1,93 @@
+/**
+ * @file
+ * @author Rahimian, Abtin <arahimian@acm.org>
+ * @revision $Revision$
+ * @tags $Tags$
+ * @date $Date$
+ *
+ * @brief Trajectories with the single precision matvec against all double runs
+ */
+
+/*
+ * Copyright (c) 2014, Abtin Rahimian
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ves3d_simulation.h"
+
+typedef Device<CPU> Dev;
+extern const Dev cpu(0);
+typedef Simulation<Dev, cpu> Sim_t;
+typedef Sim_t::Param_t Param_t;
+
+int main(int argc, char **argv)
+{
+    VES3D_INITIALIZE(&argc,&argv,NULL,NULL);
+
+    DictString_t dict;
+    int nproc(1), rank(0);
+
+#ifdef HAS_MPI
+    // Adding nproc and rank to template expansion dictionary
+    MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
+    std::stringstream snp, sr;
+    snp<<nproc; sr<<rank;
+    dict["nprocs"] = snp.str();
+    dict["rank"]   = sr.str();
+
+    // the shear flow experiment, shortened to a few steps
+    std::string fname(FullPath("experiment/shear_config.in"));
+    char *opts[] = {argv[0], (char*) "-f", (char*) fname.c_str()};
+    Param_t params(3, opts);
+    params.time_horizon = 10*params.ts;
+    params.checkpoint   = false;
+    params.write_vtk    = "";
+    params.expand_templates(&dict);
+
+    INFO("Running the all double precision simulation");
+    params.mixed_precision = false;
+    Sim_t sim1(params);
+    CHK(sim1.Run());
+    const Sim_t::Vec_t &xref(sim1.time_stepper()->S_->getPosition());
+
+    INFO("Running the mixed precision simulation");
+    params.mixed_precision = true;
+    Sim_t sim2(params);
+    CHK(sim2.Run());
+    const Sim_t::Vec_t &x(sim2.time_stepper()->S_->getPosition());
+
+    // the trajectories should agree to the solver tolerance
+    Sim_t::Vec_t err;
+    err.replicate(x);
+    axpy((real_t) -1.0, xref, x, err);
+    real_t maxerr = MaxAbs(err);
+    INFO("Difference of the mixed and double precision trajectories: "<<maxerr);
+    ASSERT(maxerr<10*params.time_tol, "mixed precision trajectory deviates, error="<<maxerr);
+
+    COUT(emph<<"** MixedPrecisionTest passed **"<<emph);
+
+    VES3D_FINALIZE();
+
+    return 0;
+}
@@ -1,4 +1,255 @@
 #include <StokesVelocity.h>
+#include <DataIO.h>
+
+/*
+ * Accuracy, memory, and time of the self-interaction storage schemes
+ * (relative to FullSelfOp) for the shapes in the shape galleries. The
+ * order 48 gallery is skipped since its dense operators need ~800MB
+ * per vesicle.
+ */
+template<class Real>
+void self_op_benchmark(MPI_Comm comm){
+  int orders[]={6, 8, 12, 16, 24, 32};
+  SelfOpStorage schemes[]={FullSelfOp, SingleSelfOp, MatFreeSelfOp};
+  DataIO io;
+
+  COUT("  Self-interaction benchmark (times in seconds, memory in MB per vesicle)");
+  COUT("      p  shape          storage    memory     setup     apply    rel-err");
+  for(int ii=0;ii<(int)(sizeof(orders)/sizeof(int));ii++){
+    int p=orders[ii];
+    long Ngrid=2*p*(p+1);
+
+    char fname[200];
+    sprintf(fname, "precomputed/shape_gallery_%d.txt", p);
+    std::vector<Real> shapes;
+    io.ReadDataStl(FullPath(fname), shapes, DataIO::ASCII);
+    long nshapes=shapes.size()/(Ngrid*COORD_DIM);
+
+    for(long s=0;s<nshapes;s++){
+      pvfmm::Vector<Real> X(Ngrid*COORD_DIM, &shapes[s*Ngrid*COORD_DIM], false);
+      pvfmm::Vector<Real> FS(Ngrid*COORD_DIM), FD(Ngrid*COORD_DIM);
+      for(long i=0;i<Ngrid;i++){ // smooth densities
+        FS[0*Ngrid+i]=X[1*Ngrid+i]; FD[0*Ngrid+i]=1.0;
+        FS[1*Ngrid+i]=X[2*Ngrid+i]; FD[1*Ngrid+i]=X[0*Ngrid+i];
+        FS[2*Ngrid+i]=X[0*Ngrid+i]; FD[2*Ngrid+i]=X[1*Ngrid+i]*X[2*Ngrid+i];
+      }
+
+      pvfmm::Vector<Real> vel_ref;
+      for(int k=0;k<3;k++){
+        StokesVelocity<Real> S(p, 2*p, -1, 1e-3, comm, schemes[k]);
+        S.SetTrgCoord(NULL);
+        S.SetSrcCoord(X);
+        S.SetDensitySL(&FS);
+        S.SetDensityDL(&FD);
+
+        double tsetup=-omp_get_wtime();
+        pvfmm::Vector<Real> vel=S();
+        tsetup+=omp_get_wtime();
+
+        S.SetDensitySL(&FS);
+        S.SetDensityDL(&FD);
+        double tapply=-omp_get_wtime();
+        vel=S();
+        tapply+=omp_get_wtime();
+
+        if(k==0) vel_ref=vel;
+        Real err=0, nrm=0;
+        for(long i=0;i<vel.Dim();i++){
+          err=std::max<Real>(err, fabs(vel[i]-vel_ref[i]));
+          nrm=std::max<Real>(nrm, fabs(vel_ref[i]));
+        }
+
+        COUT("  "<<std::setw(5)<<p<<std::setw(7)<<s
+            <<std::setw(17)<<schemes[k]
+            <<std::setw(10)<<S.SelfOpBytes()/1024.0/1024.0
+            <<std::setw(10)<<tsetup<<std::setw(10)<<tapply
+            <<std::setw(11)<<err/nrm);
+      }
+    }
+  }
+}
+
+/*
+ * Two copies of the first shape of the gallery side by side, at a
+ * distance of a fifth of the shape width; returns the shape width.
+ */
+template<class Real>
+Real two_vesicles(int p, pvfmm::Vector<Real>& X, pvfmm::Vector<Real>& F){
+  long Ngrid=2*p*(p+1);
+  DataIO io;
+
+  char fname[200];
+  sprintf(fname, "precomputed/shape_gallery_%d.txt", p);
+  std::vector<Real> shapes;
+  io.ReadDataStl(FullPath(fname), shapes, DataIO::ASCII);
+
+  Real xmin=shapes[0], xmax=shapes[0];
+  for(long i=0;i<Ngrid;i++){
+    xmin=std::min(xmin,shapes[i]);
+    xmax=std::max(xmax,shapes[i]);
+  }
+  Real gap=(xmax-xmin)*0.2;
+
+  X.ReInit(2*Ngrid*COORD_DIM); F.ReInit(2*Ngrid*COORD_DIM);
+  for(long i=0;i<Ngrid*COORD_DIM;i++){
+    X[i]=X[Ngrid*COORD_DIM+i]=shapes[i];
+    F[i]=F[Ngrid*COORD_DIM+i]=shapes[(i+Ngrid)%(Ngrid*COORD_DIM)];
+  }
+  for(long i=0;i<Ngrid;i++) X[Ngrid*COORD_DIM+i]+=xmax-xmin+gap;
+  return xmax-xmin;
+}
+
+template<class Real>
+Real max_rel_diff(const pvfmm::Vector<Real>& v0, const pvfmm::Vector<Real>& v1){
+  Real e=0, nrm=0;
+  for(long i=0;i<v0.Dim();i++){
+    e=std::max<Real>(e, fabs(v0[i]-v1[i]));
+    nrm=std::max<Real>(nrm, fabs(v0[i]));
+  }
+  return e/nrm;
+}
+
+/*
+ * Two nearby vesicles approaching each other in small steps; the
+ * velocity with the near setup reused (skin>0) should match the
+ * velocity with the setup rebuilt at every step.
+ */
+template<class Real>
+void near_skin_test(MPI_Comm comm){
+  int p=12;
+  long Ngrid=2*p*(p+1);
+  pvfmm::Vector<Real> X, F;
+  Real dx=two_vesicles(p, X, F)*0.2/20;
+
+  StokesVelocity<Real> S0(p, 2*p, -1, 0, comm);
+  StokesVelocity<Real> S1(p, 2*p, -1, 0, comm);
+  S1.SetNearSkin(0.2);
+  Real err=0;
+  for(int step=0;step<10;step++){
+    for(long i=0;i<Ngrid;i++) X[Ngrid*COORD_DIM+i]-=dx;
+    S0.SetTrgCoord(NULL); S0.SetSrcCoord(X); S0.SetDensitySL(&F); S0.SetDensityDL(NULL);
+    S1.SetTrgCoord(NULL); S1.SetSrcCoord(X); S1.SetDensitySL(&F); S1.SetDensityDL(NULL);
+    pvfmm::Vector<Real> v0=S0();
+    pvfmm::Vector<Real> v1=S1();
+    err=std::max(err,max_rel_diff(v0,v1));
+  }
+  COUT("  Near setup reuse: skipped "<<100*S1.NearSetupReuseRatio()<<"% of setups, rel-err="<<err);
+  ASSERT(err<1e-10, "Reusing the near setup changed the velocity");
+
+  const char* phases[]={"Proj", "SubtractDirect", "VelocInterp"};
+  for(int k=0;k<3;k++){
+    double r=S0.NearThreadImbalance(phases[k]);
+    COUT("  "<<phases[k]<<" thread imbalance (max/mean busy time): "<<r);
+    ASSERT(r>=1, "No thread load recorded for "<<phases[k]);
+  }
+}
+
+/*
+ * The far field overlapped with the self and near interactions
+ * (running on two thread teams, with the near collectives on their
+ * own communicator when MPI allows it) should give the same velocity
+ * as the sequential evaluation, for single and double layers and for
+ * a few geometries (so that the near setup is rebuilt).
+ */
+template<class Real>
+void overlap_test(MPI_Comm comm){
+  int p=12;
+  long Ngrid=2*p*(p+1);
+  pvfmm::Vector<Real> X, F;
+  Real dx=two_vesicles(p, X, F)*0.2/4;
+
+  StokesVelocity<Real> S0(p, 2*p, -1, 0, comm);
+  StokesVelocity<Real> S1(p, 2*p, -1, 0, comm);
+  S1.SetOverlap(true);
+  Real err=0;
+  for(int step=0;step<3;step++){
+    for(long i=0;i<Ngrid;i++) X[Ngrid*COORD_DIM+i]-=dx;
+    S0.SetTrgCoord(NULL); S0.SetSrcCoord(X); S0.SetDensitySL(&F); S0.SetDensityDL(&F);
+    S1.SetTrgCoord(NULL); S1.SetSrcCoord(X); S1.SetDensitySL(&F); S1.SetDensityDL(&F);
+    pvfmm::Vector<Real> v0=S0();
+    pvfmm::Vector<Real> v1=S1();
+    err=std::max(err,max_rel_diff(v0,v1));
+  }
+  COUT("  Overlapped far field: hidden "<<100*S1.OverlapRatio()<<"% of the time, rel-err="<<err);
+  ASSERT(err<1e-10, "Overlapping the far field changed the velocity");
+}
+
+/*
+ * k densities stacked in one evaluation should give the same
+ * velocities as k separate evaluations on the same geometry.
+ */
+template<class Real>
+void batched_test(MPI_Comm comm){
+  int p=12, k=3;
+  pvfmm::Vector<Real> X, F;
+  two_vesicles(p, X, F);
+  long n=F.Dim();
+
+  pvfmm::Vector<Real> Fk(k*n);
+  for(long r=0;r<k;r++){
+    for(long i=0;i<n;i++) Fk[r*n+i]=F[(i+r*n/7)%n]*(r+1);
+  }
+
+  StokesVelocity<Real> S(p, 2*p, -1, 0, comm);
+  S.SetTrgCoord(NULL); S.SetSrcCoord(X); S.SetDensitySL(&Fk); S.SetDensityDL(&Fk);
+  pvfmm::Vector<Real> vk=S();
+  ASSERT(vk.Dim()==k*n, "Wrong number of velocities for "<<k<<" densities");
+
+  Real err=0;
+  for(long r=0;r<k;r++){
+    pvfmm::Vector<Real> Fr(n,&Fk[r*n],false);
+    S.SetTrgCoord(NULL); S.SetSrcCoord(X); S.SetDensitySL(&Fr); S.SetDensityDL(&Fr);
+    pvfmm::Vector<Real> v1=S();
+    pvfmm::Vector<Real> vr(n,&vk[r*n],false);
+    err=std::max(err,max_rel_diff(v1,vr));
+  }
+  COUT("  Batched densities: k="<<k<<", rel-err="<<err);
+  ASSERT(err<1e-10, "Evaluating the densities together changed the velocity");
+}
+
+/*
+ * Time of one pass with k densities against k passes with one density,
+ * setup excluded. The far and near interactions run once per density
+ * in both cases, so only the self interaction and the setup transforms
+ * gain from batching.
+ */
+template<class Real>
+void batched_benchmark(MPI_Comm comm){
+  int p=12;
+  pvfmm::Vector<Real> X, F;
+  two_vesicles(p, X, F);
+  long n=F.Dim();
+
+  COUT("  Batched pass:    k   t_batch  t_single     ratio");
+  for(int k=1;k<=8;k*=2){
+    pvfmm::Vector<Real> Fk(k*n);
+    for(long r=0;r<k;r++){
+      for(long i=0;i<n;i++) Fk[r*n+i]=F[(i+r*n/7)%n]*(r+1);
+    }
+
+    StokesVelocity<Real> S(p, 2*p, -1, 0, comm);
+    S.SetTrgCoord(NULL); S.SetSrcCoord(X); S.SetDensitySL(&Fk); S.SetDensityDL(&Fk);
+    S(); // setup
+    S.SetDensitySL(&Fk); S.SetDensityDL(&Fk);
+    double tbatch=-omp_get_wtime();
+    S();
+    tbatch+=omp_get_wtime();
+
+    StokesVelocity<Real> S1(p, 2*p, -1, 0, comm);
+    S1.SetTrgCoord(NULL); S1.SetSrcCoord(X); S1.SetDensitySL(&F); S1.SetDensityDL(&F);
+    S1(); // setup
+    double tsingle=-omp_get_wtime();
+    for(long r=0;r<k;r++){
+      pvfmm::Vector<Real> Fr(n,&Fk[r*n],false);
+      S1.SetDensitySL(&Fr); S1.SetDensityDL(&Fr);
+      S1();
+    }
+    tsingle+=omp_get_wtime();
+
+    COUT("  "<<std::setw(19)<<k<<std::setw(10)<<tbatch<<std::setw(10)<<tsingle
+        <<std::setw(10)<<tbatch/tsingle);
+  }
+}
 
 int main(int argc, char** argv){
   VES3D_INITIALIZE(&argc,&argv,NULL,NULL);
@@ -9,6 +260,11 @@ int main(int argc, char** argv){
 
   typedef double Real;
   StokesVelocity<Real>::Test();
+  near_skin_test<Real>(comm);
+  overlap_test<Real>(comm);
+  batched_test<Real>(comm);
+  batched_benchmark<Real>(comm);
+  self_op_benchmark<Real>(comm);
 
   pvfmm::Profile::print(&comm);
   VES3D_FINALIZE();
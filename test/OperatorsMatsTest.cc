@@ -0,0 +1,133 @@
+/**
+ * @file
+ * @author Rahimian, Abtin <arahimian@acm.org>
+ * @revision $Revision$
+ * @tags $Tags$
+ * @date $Date$
+ *
+ * @brief unit test
+ */
+
+/*
+ * Copyright (c) 2014, Abtin Rahimian
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include "OperatorsMats.h"
+#include "Device.h"
+#include "Array.h"
+
+typedef double real;
+typedef Device<CPU> DCPU;
+extern const DCPU the_cpu_dev(0);
+typedef Array<real,DCPU,the_cpu_dev> Arr_t;
+typedef OperatorsMats<Arr_t> OMats_t;
+
+real max_diff(const OMats_t &a, const OMats_t &b, size_t len)
+{
+    const real *x(a.mats_p_.dft_), *y(b.mats_p_.dft_); // start of the data
+    real err(0);
+    for (size_t i=0; i<len; ++i)
+        err = std::max(err, std::abs(x[i]-y[i]));
+    return err;
+}
+
+/*
+ * Loading through the binary cache should give exactly the matrices
+ * parsed from the text files: when the cache is written, when it is
+ * read back, when rank 0 broadcasts it, and when a corrupted cache is
+ * rebuilt.
+ */
+bool test_cache_roundtrip(int p)
+{
+    int rank(0);
+#ifdef HAS_MPI
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+#endif
+
+    Parameters<real> params;
+    params.sh_order      = p;
+    params.upsample_freq = 2*p;
+
+    char buffer[500];
+    sprintf(buffer,"precomputed/opmats_%u_%u_double.bin", p, 2*p);
+    std::string fname(FullPath(buffer));
+    bool existed(std::ifstream(fname.c_str()).good());
+#ifdef HAS_MPI
+    MPI_Barrier(VES3D_COMM_WORLD);
+#endif
+    if (rank==0) remove(fname.c_str());
+
+    params.mats_io = TextMatsIO;
+    OMats_t text(true, params);
+    size_t len(text.getDataLength(params));
+    ASSERT(!std::ifstream(fname.c_str()).good(), "TextMatsIO should not write the cache");
+
+    params.mats_io = CacheMatsIO;
+    OMats_t written(true, params);
+    ASSERT(std::ifstream(fname.c_str()).good(), "The cache was not written");
+    ASSERT(max_diff(text, written, len)==0, "Matrices differ after writing the cache");
+
+    OMats_t read(true, params);
+    ASSERT(max_diff(text, read, len)==0, "Matrices differ after reading the cache");
+
+    params.mats_io = BcastMatsIO;
+    OMats_t bcast(true, params);
+    ASSERT(max_diff(text, bcast, len)==0, "Matrices differ after broadcasting the cache");
+
+    // flip a byte of the data, the checksum should reject the cache
+#ifdef HAS_MPI
+    MPI_Barrier(VES3D_COMM_WORLD);
+#endif
+    if (rank==0){
+        std::fstream fh(fname.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        std::streamoff pos(-(std::streamoff) (len*sizeof(real)/2));
+        fh.seekg(pos, std::ios::end);
+        char c(fh.get());
+        fh.seekp(pos, std::ios::end);
+        fh.put(~c);
+    }
+#ifdef HAS_MPI
+    MPI_Barrier(VES3D_COMM_WORLD);
+#endif
+    params.mats_io = CacheMatsIO;
+    OMats_t rebuilt(true, params);
+    ASSERT(max_diff(text, rebuilt, len)==0, "Matrices differ after rebuilding a corrupted cache");
+
+#ifdef HAS_MPI
+    MPI_Barrier(VES3D_COMM_WORLD);
+#endif
+    if (rank==0 && !existed) remove(fname.c_str());
+
+    COUT(emph<<" *** OperatorsMats cache round trip (p="<<p<<") passed ***"<<emph);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    VES3D_INITIALIZE(&argc,&argv,NULL,NULL);
+    test_cache_roundtrip(6);
+    VES3D_FINALIZE();
+    return 0;
+}
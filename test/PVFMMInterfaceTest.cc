@@ -50,6 +50,82 @@ void nbody(std::vector<Real_t>&  src_coord, std::vector<Real_t>&  src_value, std
   trg_value.assign(&glb_trg_value[0]+recv_disp[rank]/COORD_DIM*kernel_fn.ker_dim[1], &glb_trg_value[0]+(recv_disp[rank]/COORD_DIM+n_trg)*kernel_fn.ker_dim[1]);
 }
 
+void ukernel_benchmark(MPI_Comm& comm){
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  if(rank) return;
+
+  size_t N=2000;
+  int n_rep=10;
+  std::vector<Real_t> src_coord(N*COORD_DIM), trg_coord(N*COORD_DIM);
+  std::vector<Real_t> sl_den(N*3), dl_den(N*6), m2l_den(N*4), trg_value(N*3), ref_value(N*3);
+  for(size_t i=0;i<src_coord.size();i++) src_coord[i]=drand48();
+  for(size_t i=0;i<trg_coord.size();i++) trg_coord[i]=drand48();
+  for(size_t i=0;i<sl_den   .size();i++) sl_den   [i]=drand48();
+  for(size_t i=0;i<dl_den   .size();i++) dl_den   [i]=drand48();
+  for(size_t i=0;i<m2l_den  .size();i++) m2l_den  [i]=drand48();
+
+  KernelISA max_isa=StokesGetISA();
+  const pvfmm::Kernel<Real_t>& ker=StokesKernel<Real_t>::Kernel();
+  const char* ker_name[3]={"SL", "DL", "M2L"};
+  long long ker_flop[3]={29+4*2, 31+4*2, 29+4*2}; // Kernel() uses 2 Newton iterations
+  std::vector<Real_t> scalar_value[3];
+
+  for(int isa=ScalarISA;isa<=max_isa;isa++){ // GFLOP/s for each instruction set
+    if(StokesSetISA((KernelISA)isa)!=isa) continue;
+    for(int k=0;k<3;k++){
+      double t=-omp_get_wtime();
+      for(int r=0;r<n_rep;r++){
+        std::fill(trg_value.begin(), trg_value.end(), 0);
+        if(k==0) ker.ker_poten         (&src_coord[0], N, & sl_den[0], 1, &trg_coord[0], N, &trg_value[0], NULL);
+        if(k==1) ker.dbl_layer_poten   (&src_coord[0], N, & dl_den[0], 1, &trg_coord[0], N, &trg_value[0], NULL);
+        if(k==2) ker.k_m2l->ker_poten  (&src_coord[0], N, &m2l_den[0], 1, &trg_coord[0], N, &trg_value[0], NULL);
+      }
+      t+=omp_get_wtime();
+      std::cout<<(KernelISA)isa<<" "<<ker_name[k]<<": "<<(double)N*N*n_rep*ker_flop[k]/t*1e-9<<" GFLOP/s\n";
+
+      // every variant is selected at runtime, check it against the scalar one
+      if(isa==ScalarISA) scalar_value[k]=trg_value;
+      double max_err=0, max_val=0;
+      for(size_t j=0;j<trg_value.size();j++){
+        max_err=std::max(max_err, (double)fabs(scalar_value[k][j]-trg_value[j]));
+        max_val=std::max(max_val, (double)fabs(scalar_value[k][j]));
+      }
+      if(max_err>max_val*1e-10){
+        std::cout<<(KernelISA)isa<<" "<<ker_name[k]<<" differs from the scalar kernel, error="<<max_err/max_val<<'\n';
+        MPI_Abort(comm, 1);
+      }
+    }
+  }
+  StokesSetISA(max_isa);
+
+  { // Accuracy of the tolerance-driven Newton iteration count
+    std::fill(ref_value.begin(), ref_value.end(), 0);
+    StokesKernel<Real_t>::Kernel(1e-16).ker_poten(&src_coord[0], N, &sl_den[0], 1, &trg_coord[0], N, &ref_value[0], NULL);
+
+    Real_t tol[3]={1e-4, 1e-7, 1e-12};
+    for(int i=0;i<3;i++){
+      std::fill(trg_value.begin(), trg_value.end(), 0);
+      StokesKernel<Real_t>::Kernel(tol[i]).ker_poten(&src_coord[0], N, &sl_den[0], 1, &trg_coord[0], N, &trg_value[0], NULL);
+
+      double max_err=0, max_val=0;
+      for(size_t j=0;j<ref_value.size();j++){
+        max_err=std::max(max_err, (double)fabs(ref_value[j]-trg_value[j]));
+        max_val=std::max(max_val, (double)fabs(ref_value[j]));
+      }
+      std::cout<<max_isa<<" tol="<<tol[i]<<", newton_iter="<<StokesNewtonIter<Real_t>(tol[i])
+               <<", relative error="<<max_err/max_val<<'\n';
+
+      // each term (up to r^-3) has a relative error of a few tol, plus the rounding of the sum
+      double bound=std::max<double>(tol[i], N*machine_eps<Real_t>());
+      if(max_err>max_val*bound*10){
+        std::cout<<"Kernel(tol) error exceeds the tolerance, tol="<<tol[i]<<" error="<<max_err/max_val<<'\n';
+        MPI_Abort(comm, 1);
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv){
   MPI_Init(&argc,&argv);
   pvfmm::Profile::Enable(true);
@@ -120,6 +196,8 @@ int main(int argc, char** argv){
     if(!rank) std::cout<<"Maximum Relative Error:"<<max_err_glb/max_val_glb<<'\n';
   }
 
+  ukernel_benchmark(comm);
+
   pvfmm::Profile::print(&comm);
   MPI_Finalize();
   return 0;
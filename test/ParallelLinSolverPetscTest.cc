@@ -89,5 +89,10 @@ int main(int argc, char **argv){
         TestParallelSolver(&ksp, matvec, precond, 10);
     }
 
+    {   // Iterations with and without recycling
+        ParallelLinSolverPetsc<real_t> ksp(VES3D_COMM_WORLD);
+        RecycleBenchmark(&ksp, matvec, 50);
+    }
+
     PetscFinalize();
 }
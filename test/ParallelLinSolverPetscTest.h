@@ -36,6 +36,7 @@
 #include "Logger.h"
 #include "mpi.h"
 #include "TestTools.h"
+#include <cmath>
 
 template<typename T>
 void TestParallelVec(ParallelVec<T> *pv, size_t sz=10){
@@ -292,6 +293,10 @@ void TestParallelSolver(
 
 	CHK(KSP->OperatorResidual(b, u, res));
 	INFO("KSP residual="<<res);
+
+	value_type rnorm, rnorm0;
+	CHK(KSP->ResidualNorm(rnorm, rnorm0));
+	testtools::AssertTrue(rnorm0>0 && rnorm<rnorm0, "residual norm tracked", "residual norm not tracked");
     }
     testtools::AssertTrue(res<1e3*rtol, "KSP converged", "KSP failed");
 
@@ -301,8 +306,140 @@ void TestParallelSolver(
     INFO("norm="<<err);
     testtools::AssertTrue(err<1e3*rtol, "acceptable error", "large failed");
 
+    // recycled solutions; after the first solve the projection on the
+    // previous solution is exact
+    CHK(KSP->SetRecycleSize(2));
+    for (int i=0;i<repeat; ++i)
+    {
+	CHK(KSP->InitialGuessNonzero(false));
+	CHK(KSP->Solve(b, u));
+	size_t niter;
+	CHK(KSP->IterationNumber(niter));
+	INFO("Recycled try"<<i<<": KSP num_iterations="<<niter);
+	if (i>0) testtools::AssertTrue(niter<=1, "recycled solution reused", "recycled space not used");
+    }
+    CHK(KSP->SetRecycleSize(0));
+
+    CHK(u->axpy(-1.0, x));
+    CHK(u->Norm(err));
+    INFO("norm="<<err);
+    testtools::AssertTrue(err<1e3*rtol, "acceptable error with recycling", "large error with recycling");
+
     MPI_Barrier(*KSP->MPIComm()); //for nicer print log
     COUT(emph<<"Prallel linear solver test passed\n"
 	    <<"----------------------------------------------------------------------------"<<emph<<std::endl);
 
 }
+
+// counts the applications of the operator, including those the solver
+// makes outside the Krylov iteration (projecting on the recycled space)
+template<typename T>
+struct CountedMatvec
+{
+    static typename ParallelLinSolver<T>::apply_type matvec;
+    static size_t count;
+
+    static Error_t Apply(const ParallelLinOp<T> *M, const T *x, T *y){
+	++count;
+	return matvec(M, x, y);
+    }
+};
+
+template<typename T>
+typename ParallelLinSolver<T>::apply_type CountedMatvec<T>::matvec(NULL);
+
+template<typename T>
+size_t CountedMatvec<T>::count(0);
+
+/*
+ * Iterations and matvecs of a sequence of solves whose solution drifts
+ * slowly (a bump moving through the unknowns), as in time stepping,
+ * with the previous solution as the guess and recycle sizes 0, 2, 4.
+ */
+template<typename T>
+void RecycleBenchmark(
+    ParallelLinSolver<T> *KSP,
+    typename ParallelLinSolver<T>::apply_type matvec,
+    size_t sz=50,
+    int nsolves=20)
+{
+    INFO("Comparing the solves with and without recycling");
+
+    typedef ParallelLinSolver<T> PSol;
+    typedef typename PSol::matvec_type POp;
+    typedef typename PSol::vec_type PVec;
+    typedef typename PVec::size_type size_type;
+    typedef typename PVec::value_type value_type;
+
+    int rank, np;
+    MPI_Comm_rank(*KSP->MPIComm(), &rank);
+    MPI_Comm_size(*KSP->MPIComm(), &np);
+
+    // Setting up the operator
+    CountedMatvec<T>::matvec = matvec;
+    POp *A(NULL);
+    CHK(KSP->LinOpFactory(&A));
+    CHK(A->SetSizes(sz,sz));
+    CHK(A->SetName("A"));
+    CHK(A->SetApply(CountedMatvec<T>::Apply));
+    CHK(A->Configure());
+
+    PVec *x(NULL), *b(NULL), *u(NULL);
+    CHK(KSP->VecFactory(&x));
+    CHK(x->SetSizes(sz));
+    CHK(x->SetName("reference"));
+    CHK(x->Configure());
+    CHK(x->ReplicateTo(&b));
+    CHK(b->SetName("rhs"));
+    CHK(x->ReplicateTo(&u));
+    CHK(u->SetName("solution"));
+
+    value_type rtol(1e-8);
+    CHK(KSP->SetTolerances(rtol));
+    CHK(KSP->SetOperator(A));
+    CHK(KSP->Configure());
+    CHK(KSP->UpdatePrecond(NULL));
+
+    value_type *xv = new value_type[sz];
+    size_type N(np*sz);
+    int recycle[] = {0, 2, 4};
+    COUT("  recycle  iterations  matvecs  ("<<nsolves<<" solves, "<<N<<" unknowns)");
+    for (int r=0; r<3; ++r)
+    {
+	CHK(KSP->SetRecycleSize(0)); // start from an empty space
+	CHK(KSP->SetRecycleSize(recycle[r]));
+	for (size_type i = 0; i<sz; ++i) xv[i] = 0;
+	u->SetValuesLocal(xv);
+
+	size_t iters(0), matvecs(0);
+	for (int n=0; n<nsolves; ++n)
+	{
+	    value_type c(N*(0.25+0.5*n/nsolves)), w(0.1*N);
+	    for (size_type i = 0; i<sz; ++i){
+		value_type d((rank*sz+i-c)/w);
+		xv[i] = 1.0+exp(-d*d);
+	    }
+	    x->SetValuesLocal(xv);
+	    CHK(A->Apply(x, b));
+
+	    size_t niter, count0(CountedMatvec<T>::count);
+	    CHK(KSP->InitialGuessNonzero(true));
+	    CHK(KSP->Solve(b, u));
+	    CHK(KSP->IterationNumber(niter));
+	    iters   += niter;
+	    matvecs += CountedMatvec<T>::count-count0;
+
+	    value_type res, bnrm;
+	    CHK(KSP->OperatorResidual(b, u, res));
+	    CHK(b->Norm(bnrm));
+	    testtools::AssertTrue(res<1e2*rtol*bnrm, "drifting solve converged", "drifting solve failed");
+	}
+	COUT("  "<<recycle[r]<<"        "<<iters<<"          "<<matvecs);
+    }
+    CHK(KSP->SetRecycleSize(0));
+    delete[] xv;
+
+    MPI_Barrier(*KSP->MPIComm()); //for nicer print log
+    COUT(emph<<"Recycling benchmark done\n"
+	    <<"----------------------------------------------------------------------------"<<emph<<std::endl);
+}
@@ -0,0 +1,202 @@
+/**
+ * @file
+ * @author Rahimian, Abtin <arahimian@acm.org>
+ * @revision $Revision$
+ * @tags $Tags$
+ * @date $Date$
+ *
+ * @brief Migration of the vesicles by EvolveSurface::RepartitionVesicles
+ */
+
+/*
+ * Copyright (c) 2014, Abtin Rahimian
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+
+#include "EvolveSurface.h"
+#include "Error.h"
+#include "HelperFuns.h"
+#include "CPUKernels.h"
+
+typedef double real;
+typedef Device<CPU> DevCPU;
+extern const DevCPU the_cpu_device(0);
+
+typedef EvolveSurface<real, DevCPU, the_cpu_device> Evolve_t;
+typedef Evolve_t::Vec_t Vec_t;
+typedef Evolve_t::Sca_t Sca_t;
+
+/*
+ * Vesicle gid is centered at (0,3 gid,0); its tension, properties,
+ * area and volume are tagged with gid so the test can check that they
+ * moved with it.
+ */
+real tension_tag(long gid, size_t j){ return gid+1e-3*j; }
+real prop_tag(long gid, int iP){ return 1+iP+0.25*gid; }
+real area_tag(long gid){ return 10+gid; }
+real vol_tag(long gid){ return 20+gid; }
+
+// Checks the local vesicles against their tags, returns their gids
+std::vector<long> check_vesicles(Evolve_t &E, const Vec_t &proto, Sca_t &area, Sca_t &vol){
+    const Vec_t &x(E.S_->getPosition());
+    const Sca_t &ten(E.F_->tension());
+    size_t nv(x.getNumSubs()), stride(x.getStride());
+    ASSERT(ten.getNumSubs()==nv, "tension does not match the positions");
+    ASSERT(area.size()==nv && vol.size()==nv, "area and volume do not match the positions");
+
+    real y0(0);
+    for (size_t j(0); j<stride; ++j) y0 += proto.begin()[stride+j];
+    y0 /= stride;
+
+    std::vector<long> gids(nv);
+    for (size_t i(0); i<nv; ++i){
+        const real *xi(x.begin()+i*DIM*stride);
+        real yc(0);
+        for (size_t j(0); j<stride; ++j) yc += xi[stride+j];
+        long gid(floor((yc/stride-y0)/3+0.5));
+        gids[i] = gid;
+
+        real err(0);
+        for (int d(0); d<DIM; ++d)
+            for (size_t j(0); j<stride; ++j)
+                err = std::max(err, fabs(xi[d*stride+j]-proto.begin()[d*stride+j]-(d==1?3*gid:0)));
+        for (size_t j(0); j<stride; ++j)
+            err = std::max(err, fabs(ten.begin()[i*stride+j]-tension_tag(gid,j)));
+        for (int iP(0); iP<Evolve_t::VProp_t::n_props; ++iP)
+            err = std::max(err, fabs(E.ves_props_->getPropIdx(iP)->begin()[i]-prop_tag(gid,iP)));
+        err = std::max(err, fabs(area.begin()[i]-area_tag(gid)));
+        err = std::max(err, fabs(vol.begin()[i]-vol_tag(gid)));
+        ASSERT(err<1e-12, "vesicle "<<gid<<" did not move intact, error="<<err);
+    }
+    return gids;
+}
+
+// max/mean of the number of vesicles (their cost is uniform here)
+real imbalance(size_t nv, MPI_Comm comm){
+    long n(nv), n_max, n_sum;
+    int np;
+    MPI_Comm_size(comm, &np);
+    MPI_Allreduce(&n, &n_max, 1, MPI_LONG, MPI_MAX, comm);
+    MPI_Allreduce(&n, &n_sum, 1, MPI_LONG, MPI_SUM, comm);
+    return (real) n_max*np/n_sum;
+}
+
+void RepartitionTest(Parameters<real> &sim_par, MPI_Comm comm){
+    int np, rank;
+    MPI_Comm_size(comm, &np);
+    MPI_Comm_rank(comm, &rank);
+
+    // three vesicles on rank 0 and one on each other rank
+    int nv(rank ? 1 : 3);
+    long gid0(rank ? rank+2 : 0), n_glb(np+2);
+    sim_par.n_surfs = nv;
+
+    Vec_t proto(1, sim_par.sh_order), x0(nv, sim_par.sh_order);
+    DataIO myIO;
+    char fname[300];
+    sprintf(fname,"precomputed/dumbbell_%u_double.txt",sim_par.sh_order);
+    myIO.ReadData(FullPath(fname), proto, DataIO::ASCII, 0, proto.getSubLength());
+    myIO.ReadData(FullPath(fname), x0, DataIO::ASCII, 0, x0.getSubLength());
+
+    std::vector<real> cntrs_host(nv*DIM, 0);
+    for (int i(0); i<nv; ++i) cntrs_host[DIM*i+1] = 3*(gid0+i);
+    Array<real, DevCPU, the_cpu_device> cntrs(DIM*nv);
+    cntrs.getDevice().Memcpy(cntrs.begin(), &cntrs_host[0],
+        cntrs.size() * sizeof(real), DevCPU::MemcpyHostToDevice);
+    Populate(x0, cntrs);
+
+    Evolve_t::Mats_t Mats(true, sim_par);
+    BgFlowBase<Vec_t> *vInf(NULL);
+    CHK(BgFlowFactory(sim_par, &vInf));
+    Evolve_t::Repartition_t repart(&PVFMM_GlobalRepart<real>);
+    Evolve_t::VProp_t props;
+    CHK(props.setFromParams(sim_par));
+
+    Evolve_t E(&sim_par, Mats, vInf, NULL, NULL, &repart, NULL, &x0, &props);
+    CHK(E.ReinitInterfacialVelocity());
+
+    // tag the vesicles
+    Sca_t area, vol;
+    area.resize(nv,1);
+    vol .resize(nv,1);
+    size_t stride(x0.getStride());
+    for (int i(0); i<nv; ++i){
+        for (size_t j(0); j<stride; ++j)
+            E.F_->tension().begin()[i*stride+j] = tension_tag(gid0+i,j);
+        for (int iP(0); iP<Evolve_t::VProp_t::n_props; ++iP)
+            props.getPropIdx(iP)->begin()[i] = prop_tag(gid0+i,iP);
+        area.begin()[i] = area_tag(gid0+i);
+        vol .begin()[i] = vol_tag(gid0+i);
+    }
+    CHK(props.update());
+    check_vesicles(E, proto, area, vol);
+
+    // there, then a second pass on the balanced partition
+    real imb0(imbalance(nv, comm)), imb1(0);
+    for (int pass(0); pass<2; ++pass){
+        bool reset(false);
+        CHK(E.RepartitionVesicles(area, vol, reset));
+        ASSERT(reset, "the interfacial velocity should be rebuilt");
+
+        std::vector<long> gids(check_vesicles(E, proto, area, vol));
+        size_t nv_new(gids.size());
+        real imb(imbalance(nv_new, comm));
+        COUT("  pass "<<pass<<": "<<nv_new<<" vesicles, imbalance "<<imb0<<" -> "<<imb);
+        if (pass==0) imb1=imb;
+        else ASSERT(imb==imb1, "a balanced partition should stay balanced");
+
+        // every vesicle is on exactly one rank
+        std::vector<int> cnt(n_glb,0), cnt_glb(n_glb,0);
+        for (size_t i(0); i<nv_new; ++i){
+            ASSERT(gids[i]>=0 && gids[i]<n_glb, "unknown vesicle "<<gids[i]);
+            ++cnt[gids[i]];
+        }
+        MPI_Allreduce(&cnt[0], &cnt_glb[0], n_glb, MPI_INT, MPI_SUM, comm);
+        for (long g(0); g<n_glb; ++g)
+            ASSERT(cnt_glb[g]==1, "vesicle "<<g<<" is on "<<cnt_glb[g]<<" ranks");
+    }
+    ASSERT(imb1<=imb0, "repartitioning should not increase the imbalance");
+    ASSERT(np==1 || imb1<imb0, "repartitioning should reduce the imbalance");
+
+    delete vInf;
+}
+
+int main(int argc, char **argv)
+{
+    VES3D_INITIALIZE(&argc, &argv, NULL, NULL);
+    COUT("==============================\n  Repartition test: "
+        <<"\n==============================");
+
+    Parameters<real> sim_par;
+    sim_par.sh_order        = 6;
+    sim_par.filter_freq     = 4;
+    sim_par.upsample_freq   = 12;
+    sim_par.rep_filter_freq = 2;
+    sim_par.scheme          = JacobiBlockExplicit;
+    sim_par.singular_stokes = Direct;
+    sim_par.bg_flow_param   = 0;
+
+    RepartitionTest(sim_par, VES3D_COMM_WORLD);
+
+    COUT(emph<<"Repartition test passed (run on two or more ranks to move vesicles)"<<emph);
+    VES3D_FINALIZE();
+    return 0;
+}
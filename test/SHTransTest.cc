@@ -96,11 +96,145 @@ bool test_inverse(){
     return true;
 }
 
+bool test_fft(int p){
+    typedef Scalars<real,DCPU,the_cpu_dev> Sca_t;
+    typedef typename Sca_t::array_type Arr_t;
+    typedef OperatorsMats<Arr_t> OMats_t;
+    typedef SHTMats<real,DCPU> SMats_t;
+    typedef SHTrans<Sca_t,SMats_t> Sh_t;
+
+    int n(3);
+    Parameters<real> params;
+    params.sh_order	 = p;
+    params.upsample_freq = 2*p;
+
+    // Operators
+    OMats_t M(true /* readFromFile */, params);
+    Sh_t sht_gemm(p, M.mats_p_, -1, 4.0, GemmDFT);
+    Sh_t sht_fft (p, M.mats_p_, -1, 4.0, FFTDFT);
+    ASSERT(sht_fft.getDFTType()==FFTDFT, "FFT is not used");
+
+    // without an explicit type, the transform comes from the parameters
+    params.sht_dft = FFTDFT;
+    OMats_t M_fft(true /* readFromFile */, params);
+    Sh_t sht_default(p, M_fft.mats_p_);
+    ASSERT(sht_default.getDFTType()==FFTDFT, "Parameters::sht_dft is not used");
+
+    Sca_t x(n,p), shc(n,p), wrk(n,p), y_gemm(n,p), y_fft(n,p);
+    size_t len((p+1)*(p+1)-1);
+    fillRand(x);
+
+    real merr(0), err;
+    sht_gemm.forward(x, wrk, y_gemm);
+    sht_fft.forward (x, wrk, y_fft);
+    axpy(-1.0, y_gemm, y_fft, y_fft);
+    merr = std::max(merr, err=MaxAbs(y_fft));
+    COUT("  forward     (p="<<p<<") error="<<err);
+
+    sht_gemm.forward(x, wrk, shc);
+    shc.getDevice().Memset(shc.begin()+len,0, (shc.size()-len)*sizeof(real));
+
+    void (Sh_t::*backs[])(const Sca_t&, Sca_t&, Sca_t&) const = {
+        &Sh_t::backward, &Sh_t::backward_du, &Sh_t::backward_dv,
+        &Sh_t::backward_d2u, &Sh_t::backward_d2v, &Sh_t::backward_duv};
+    const char *names[] = {"backward    ", "backward_du ", "backward_dv ",
+                           "backward_d2u", "backward_d2v", "backward_duv"};
+
+    for (int ii=0; ii<6; ++ii){
+        (sht_gemm.*backs[ii])(shc, wrk, y_gemm);
+        (sht_fft.*backs[ii]) (shc, wrk, y_fft);
+        axpy(-1.0, y_gemm, y_fft, y_fft);
+        err = MaxAbs(y_fft)/std::max((real) 1.0, MaxAbs(y_gemm));
+        merr = std::max(merr, err);
+        COUT("  "<<names[ii]<<"(p="<<p<<") error="<<err);
+    }
+
+    ASSERT(merr<1e-12,"FFT and GEMM longitudinal transforms should match, error="<<merr);
+    return true;
+}
+
+/*
+ * Timing of the longitudinal step (dense DFT matrix vs real FFT) for
+ * the orders in the shape gallery. The Legendre matrices are only
+ * precomputed for a few orders, so the benchmark only uses the DFT
+ * matrices (which SHTMats generates).
+ */
+bool bench_dft(){
+    typedef SHTMats<real,DCPU> SMats_t;
+
+    int orders[] = {6, 8, 12, 16, 24, 32, 48};
+    int n_orders(sizeof(orders)/sizeof(int));
+    int n_surfs(200), n_rep(10);
+    real alpha(1.0), beta(0.0);
+
+    COUT("  DFT benchmark ("<<n_surfs<<" surfaces, "<<n_rep<<" repetitions, time in seconds)");
+    COUT("      p        gemm-fwd         fft-fwd       gemm-d2v        fft-d2v");
+    for (int io=0; io<n_orders; ++io){
+        int p(orders[io]), dft_size(2*p);
+        int howmany(n_surfs*(p+1));
+
+        std::vector<real> data(SMats_t::getDataLength(p));
+        SMats_t mats(the_cpu_dev, p, &data[0], true /* generateMats */);
+        RealFFT<real> fft(dft_size);
+
+        std::vector<real> x(howmany*dft_size), y(x.size()), z(x.size());
+        std::vector<real> w(omp_get_max_threads()*fft.work_size());
+        for (size_t ii=0; ii<x.size(); ++ii) x[ii] = drand48();
+
+        double tgf(-GETSECONDS());
+        for (int ir=0; ir<n_rep; ++ir)
+            the_cpu_dev.gemm("N", "N", &dft_size, &howmany, &dft_size,
+                &alpha, mats.dft_, &dft_size, &x[0], &dft_size, &beta,
+                &y[0], &dft_size);
+        tgf += GETSECONDS();
+
+        double tff(-GETSECONDS());
+        for (int ir=0; ir<n_rep; ++ir)
+            fft.forward(&x[0], howmany, &z[0], &w[0], w.size());
+        tff += GETSECONDS();
+
+        real err(0);
+        for (size_t ii=0; ii<y.size(); ++ii)
+            err = std::max(err, (real) fabs(y[ii]-z[ii]));
+        ASSERT(err<1e-12, "FFT and GEMM forward should match, error="<<err);
+
+        // one object, used by two threads at once with their own scratch
+        std::vector<real> z2(x.size());
+        #pragma omp parallel for num_threads(2)
+        for (int it=0; it<2; ++it){
+            std::vector<real> wt(fft.work_size());
+            int h0(it*howmany/2), h1((it+1)*howmany/2);
+            fft.forward(&x[h0*dft_size], h1-h0, &z2[h0*dft_size], &wt[0], wt.size());
+        }
+        ASSERT(z2==z, "Concurrent FFT calls should match the single call");
+
+        double tgb(-GETSECONDS());
+        for (int ir=0; ir<n_rep; ++ir)
+            the_cpu_dev.gemm("T", "N", &dft_size, &howmany, &dft_size,
+                &alpha, mats.dft_inv_d2_, &dft_size, &x[0], &dft_size, &beta,
+                &y[0], &dft_size);
+        tgb += GETSECONDS();
+
+        double tfb(-GETSECONDS());
+        for (int ir=0; ir<n_rep; ++ir)
+            fft.backward(&x[0], howmany, &z[0], 2, &w[0], w.size());
+        tfb += GETSECONDS();
+
+        COUT("  "<<std::setw(5)<<p
+            <<std::setw(16)<<tgf<<std::setw(16)<<tff
+            <<std::setw(16)<<tgb<<std::setw(16)<<tfb);
+    }
+
+    return true;
+}
+
 int main(int argc, char *argv[])
 {
     VES3D_INITIALIZE(&argc,&argv,NULL,NULL);
     ASSERT(test_resample(),"resample test failed");
     ASSERT(test_inverse(),"inverse test failed");
+    ASSERT(test_fft(6),"FFT test failed");
+    ASSERT(bench_dft(),"DFT benchmark failed");
     return 0;
     VES3D_FINALIZE();
 }
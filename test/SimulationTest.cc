@@ -137,6 +137,90 @@ int main(int argc, char **argv)
         ASSERT(maxerr<5e-7, "inconsistent checkpoints, error="<<maxerr);
     }
 
+    if (nproc==1){
+        /*
+         * Restart on a different number of processes: the initial
+         * state is written as a block checkpoint with one block per
+         * vesicle (as if written by n_surfs processes), so the restart
+         * has to redistribute the blocks.
+         */
+        typedef Sim_t::Evolve_t Evolve_t;
+        typedef Sim_t::VProp_t VProp_t;
+        typedef Sim_t::Sur_t Sur_t;
+        typedef Sim_t::Vec_t Vec_t;
+
+        Param_t params;
+        params.n_surfs               = 2;
+        params.sh_order              = 16;
+        params.shape_gallery_file    = "precomputed/shape_gallery_{{sh_order}}.txt";
+        params.vesicle_geometry_file = "precomputed/lattice_geometry_spec.txt";
+        params.expand_templates(&dict);
+
+        Sim_t sim1(params);
+        CHK(sim1.setup());
+        const Evolve_t &E1(*sim1.time_stepper());
+        const Vec_t &xref(E1.S_->getPosition());
+        int nves(xref.getNumSubs()), nprops(VProp_t::n_props);
+        size_t ves_sz(xref.getTheDim()*xref.getStride());
+
+        std::stringstream pre;
+        sim1.run_params()->pack(pre, Streamable::BIN);
+        std::vector<std::string> blocks(nves);
+        for (int k(0); k<nves; ++k){
+            Vec_t xk(1, params.sh_order);
+            xk.getDevice().Memcpy(xk.begin(), xref.begin() + k*ves_sz,
+                ves_sz * sizeof(real_t), Dev::MemcpyDeviceToDevice);
+            Sur_t Sk(params.sh_order, E1.mats_, &xk, params.filter_freq,
+                params.rep_filter_freq, params.rep_type, params.rep_exponent);
+
+            VProp_t pk;
+            for (int iP(0); iP<nprops; ++iP){
+                pk.getPropIdx(iP)->resize(1);
+                pk.getPropIdx(iP)->getDevice().Memcpy(pk.getPropIdx(iP)->begin(),
+                    E1.ves_props_->getPropIdx(iP)->begin() + k,
+                    sizeof(real_t), Dev::MemcpyDeviceToDevice);
+            }
+            pk.update();
+
+            std::stringstream blk;
+            blk<<std::scientific<<std::setprecision(16);
+            CHK(Evolve_t::packState(blk, Streamable::BIN, pk, Sk, "surface"));
+            blocks[k] = blk.str();
+        }
+
+        std::string fname("SimulationTest_c.chk");
+        {
+            std::ofstream fh(fname.c_str(), std::ios::binary | std::ios::out);
+            fh<<"BLOCKFILE\n"<<"version: "<<VERSION<<"\n"<<"nblocks: "<<nves<<"\n";
+            fh<<"count:";
+            for (int k(0); k<nves; ++k) fh<<" 1";
+            fh<<"\nsize:";
+            for (int k(0); k<nves; ++k) fh<<" "<<blocks[k].size();
+            fh<<"\nchecksum:";
+            for (int k(0); k<nves; ++k) fh<<" "<<DataIO::Checksum(blocks[k].data(), blocks[k].size());
+            fh<<"\npreamble: "<<pre.str().size()<<"\n"<<pre.str()<<"\n/BLOCKFILE\n";
+            for (int k(0); k<nves; ++k) fh<<blocks[k];
+        }
+
+        params.load_checkpoint = "test/"+fname;
+        Sim_t sim2(params);
+        CHK(sim2.setup());
+        const Evolve_t &E2(*sim2.time_stepper());
+        ASSERT(E2.S_->getPosition().getNumSubs()==nves, "Redistributed restart lost vesicles");
+
+        Vec_t err;
+        err.replicate(xref);
+        axpy((real_t) -1.0, xref, E2.S_->getPosition(), err);
+        real_t maxerr = MaxAbs(err);
+        for (int iP(0); iP<nprops; ++iP){
+            const VProp_t::container_type &p1(*E1.ves_props_->getPropIdx(iP)), &p2(*E2.ves_props_->getPropIdx(iP));
+            for (int k(0); k<nves; ++k)
+                maxerr = std::max(maxerr, (real_t) fabs(p1.begin()[k]-p2.begin()[k]));
+        }
+        ASSERT(maxerr<1e-12, "inconsistent state after restart from "<<nves<<" blocks, error="<<maxerr);
+        remove(fname.c_str());
+    }
+
     COUT(emph<<"** SimulationTest passed **"<<emph);
 
     VES3D_FINALIZE();
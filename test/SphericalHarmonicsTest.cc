@@ -0,0 +1,143 @@
+/**
+ * @file
+ * @author Rahimian, Abtin <arahimian@acm.org>
+ * @revision $Revision$
+ * @tags $Tags$
+ * @date $Date$
+ *
+ * @brief Workspace and thread-safety tests for SphericalHarmonics
+ */
+
+/*
+ * Copyright (c) 2014, Abtin Rahimian
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstdlib>
+#include <omp.h>
+#include "ves3d_common.h"
+#include "Logger.h"
+#include "SphericalHarmonics.h"
+
+/*
+ * Frames hand out buffers in stack order and return them on
+ * destruction; the high water mark records the most bytes in use.
+ */
+template<class Real>
+void workspace_test(){
+  typedef typename SHWorkspace<Real>::Frame Frame;
+  SHWorkspace<Real> ws;
+  pvfmm::Vector<Real>* inner=NULL;
+  { // nested frames
+    Frame outer(&ws);
+    outer.Get().ReInit(100);
+    {
+      Frame f(outer.Workspace());
+      inner=&f.Get();
+      inner->ReInit(200);
+    }
+    ASSERT(ws.HighWaterMark()>=300*sizeof(Real), "high water mark of the nested frames, got "<<ws.HighWaterMark());
+    ASSERT(ws.HighWaterMark()==ws.Bytes(), "both buffers were in use at once");
+    {
+      Frame f(outer.Workspace());
+      ASSERT(&f.Get()==inner, "a closed frame should hand its buffer to the next one");
+    }
+  }
+  size_t high_water=ws.HighWaterMark();
+  ASSERT(ws.Bytes()==high_water, "buffers should keep their capacity, got "<<ws.Bytes());
+  { // a frame after the outer one closed starts again at the bottom
+    Frame f(&ws);
+    f.Get().ReInit(50);
+  }
+  ASSERT(ws.Bytes()==high_water, "a smaller request should not reallocate, got "<<ws.Bytes());
+  ASSERT(ws.HighWaterMark()==high_water, "high water mark should not drop, got "<<ws.HighWaterMark());
+  ws.Clear();
+  ASSERT(ws.Bytes()==0, "Clear() should release the buffers");
+
+  // repeated transforms of one size do not grow the workspace
+  long p=8, N=3;
+  pvfmm::Vector<Real> X(N*2*p*(p+1)), S, Y;
+  for(long i=0;i<X.Dim();i++) X[i]=drand48();
+  SphericalHarmonics<Real>::Grid2SHC(X, p, p, S, &ws);
+  SphericalHarmonics<Real>::SHC2Grid(S, p, p, Y, NULL, NULL, &ws);
+  size_t bytes=ws.Bytes();
+  SphericalHarmonics<Real>::Grid2SHC(X, p, p, S, &ws);
+  SphericalHarmonics<Real>::SHC2Grid(S, p, p, Y, NULL, NULL, &ws);
+  ASSERT(ws.Bytes()==bytes, "workspace grew on a repeated transform ("<<bytes<<" -> "<<ws.Bytes()<<")");
+  ASSERT(ws.HighWaterMark()<=ws.Bytes(), "high water mark above the held bytes");
+  COUT("  workspace: "<<ws.Bytes()<<" bytes, high water mark "<<ws.HighWaterMark());
+}
+
+/*
+ * Two threads, each with its own workspace, transform at an order whose
+ * operators are not cached yet, so both race to build them. The results
+ * must match a serial evaluation.
+ */
+template<class Real>
+void concurrent_test(){
+  long p=14, N=4;
+  long Ngrid=2*p*(p+1);
+  pvfmm::Vector<Real> X(N*Ngrid);
+  for(long i=0;i<N;i++) for(long j=0;j<Ngrid;j++){
+    X[i*Ngrid+j]=std::cos((i+1)*0.1*j)+drand48()*1e-3;
+  }
+
+  int n_thrd=2;
+  std::vector<pvfmm::Vector<Real> > Y(n_thrd), Yt(n_thrd), Yp(n_thrd);
+  #pragma omp parallel num_threads(n_thrd)
+  {
+    int tid=omp_get_thread_num();
+    SHWorkspace<Real> ws;
+    pvfmm::Vector<Real> S;
+    SphericalHarmonics<Real>::Grid2SHC(X, p, p, S, &ws);
+    SphericalHarmonics<Real>::SHC2Grid(S, p, p, Y[tid], &Yt[tid], &Yp[tid], &ws);
+  }
+
+  pvfmm::Vector<Real> S, Y0, Yt0, Yp0;
+  SphericalHarmonics<Real>::Grid2SHC(X, p, p, S);
+  SphericalHarmonics<Real>::SHC2Grid(S, p, p, Y0, &Yt0, &Yp0);
+
+  Real err=0, scale=0;
+  for(int t=0;t<n_thrd;t++){
+    ASSERT(Y[t].Dim()==Y0.Dim(), "concurrent transform has the wrong size");
+    for(long i=0;i<Y0.Dim();i++){
+      err=std::max(err, std::fabs(Y[t][i]-Y0[i]));
+      err=std::max(err, std::fabs(Yt[t][i]-Yt0[i]));
+      err=std::max(err, std::fabs(Yp[t][i]-Yp0[i]));
+      scale=std::max(scale, std::fabs(Yt0[i]));
+    }
+  }
+  COUT("  concurrent transforms (p="<<p<<", "<<n_thrd<<" threads): max error="<<err/scale);
+  ASSERT(err<=1e-12*scale, "concurrent and serial transforms differ, error="<<err/scale);
+}
+
+int main(int argc, char** argv){
+  VES3D_INITIALIZE(&argc,&argv,NULL,NULL);
+
+  typedef double Real;
+  workspace_test<Real>();
+  concurrent_test<Real>();
+  COUT(emph<<" *** SphericalHarmonics test passed ***"<<emph);
+
+  VES3D_FINALIZE();
+  return 0;
+}
@@ -78,6 +78,14 @@ void test_geo_props(const ST &S){
     COUT("Volume = "<<vol);
     ASSERT( fabs(vol/5.24886489292959-1)<5e-8,"Expected volume for dumbell, "<<fabs(vol/5.24886489292959-1));
 
+    COUT("Computing area and volume in one pass");
+    Sca_t Area2(nVec, p, std::make_pair(1,1));
+    Sca_t Vol2(nVec, p, std::make_pair(1,1));
+    S.areaVolume(Area2, Vol2);
+    axpy((real) -1, Area, Area2, Area2);
+    axpy((real) -1, Vol, Vol2, Vol2);
+    ASSERT( MaxAbs(Area2)<1e-12*area && MaxAbs(Vol2)<1e-12*vol,"Fused area and volume");
+
     COUT("Computing centers");
     Vec_t Cntrs(nVec, 0, std::make_pair(1,1));
     S.getCenters(Cntrs);
@@ -185,7 +193,10 @@ void test_resample(const ST &S, const MT &mats){
     ASSERT(merr<5e-14,"bad resampling, "<<merr);
 
     //resample into initialized surface
+    size_t ver(S3->getPositionVersion());
+    ASSERT(ver!=S1->getPositionVersion(), "versions are unique among surfaces");
     axpy(2.0, S3->getPosition(), S3->getPositionModifiable());
+    ASSERT(S3->getPositionVersion()!=ver, "modifying the position renews the version");
     CHK(S.resample(p1, &S4));
     CHK(S3->resample(p1, &S4));
 
@@ -0,0 +1,118 @@
+#include <cmath>
+#include <vector>
+
+#include "SuspensionGenerator.h"
+#include "Logger.h"
+#include "TestTools.h"
+#include "ves3d_common.h"
+
+typedef double real;
+
+// unit sphere sampled on a latitude-longitude grid
+void Sphere(int p, std::vector<real> &shape)
+{
+    int nlat(p+1), nlon(2*p), stride(nlat*nlon);
+    shape.resize(DIM*stride);
+    for (int i(0); i<nlat; ++i)
+        for (int j(0); j<nlon; ++j){
+            real th(M_PI*(i+.5)/nlat), ph(2*M_PI*j/nlon);
+            shape[         i*nlon+j] = sin(th)*cos(ph);
+            shape[  stride+i*nlon+j] = sin(th)*sin(ph);
+            shape[2*stride+i*nlon+j] = cos(th);
+        }
+}
+
+void TestSuspension(int nves, real phi, real L, real min_sep)
+{
+    int p(8), stride((p+1)*2*p);
+    std::vector<real> shape, vol(1, 4*M_PI/3);
+    Sphere(p, shape);
+
+    SuspensionGenerator<real> gen(shape, stride, vol);
+    std::vector<real> geo;
+    testtools::AssertTrue(gen(nves, phi, L, min_sep, 1, geo)==ErrorEvent::Success,
+        "generating the suspension", "failed to place the vesicles");
+    testtools::AssertTrue(geo.size()==8*(size_t) nves, "number of vesicles", "bad size");
+
+    real box(gen.BoxSize()), scale(gen.Scale());
+    bool periodic(L>0);
+    testtools::AssertTrue(!periodic || fabs(box-L)<1e-12, "box size", "bad box");
+    testtools::AssertTrue(periodic || scale==1, "scale", "bad scale");
+
+    // all centers on rank 0
+    std::vector<real> all(geo);
+#ifdef HAS_MPI
+    int nproc, rank;
+    MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+    MPI_Comm_rank(VES3D_COMM_WORLD, &rank);
+    all.resize(nproc*geo.size());
+    MPI_Gather(&geo[0], geo.size(), MPI_DOUBLE, &all[0], geo.size(), MPI_DOUBLE,
+        0, VES3D_COMM_WORLD);
+    if (rank) return;
+#endif
+
+    size_t n(all.size()/8);
+    real rmin(1e10);
+    bool inside(true);
+    for (size_t i(0); i<n; ++i){
+        const real *ci(&all[8*i+2]);
+        inside &= (all[8*i]==0 && all[8*i+1]==scale);
+        for (int d(0); d<DIM; ++d)
+            inside &= (ci[d]>=0 && ci[d]<=box);
+
+        for (size_t j(0); j<i; ++j){
+            const real *cj(&all[8*j+2]);
+            real r2(0);
+            for (int d(0); d<DIM; ++d){
+                real dc(ci[d]-cj[d]);
+                if (periodic) dc -= box*floor(dc/box+.5);
+                r2 += dc*dc;
+            }
+            rmin = std::min(rmin, sqrt(r2));
+        }
+    }
+    testtools::AssertTrue(inside, "vesicles in the box", "bad center");
+    testtools::AssertTrue(rmin >= 2*scale+min_sep, "vesicle separation", "overlapping vesicles");
+    COUT("  "<<n<<" vesicles in a box of size "<<box<<" at scale "<<scale
+        <<" (closest centers "<<rmin<<")");
+}
+
+// the same seed gives the same suspension, seeds that differ only in
+// their high bits give different ones
+void TestSeeds()
+{
+    int p(8), stride((p+1)*2*p);
+    std::vector<real> shape, vol(1, 4*M_PI/3);
+    Sphere(p, shape);
+
+    int seeds[] = {1, 1, 1+(1<<16), 1+(1<<30)};
+    std::vector<real> geo[4];
+    for (int i(0); i<4; ++i){
+        SuspensionGenerator<real> gen(shape, stride, vol);
+        testtools::AssertTrue(gen(20, .1, -1, .1, seeds[i], geo[i])==ErrorEvent::Success,
+            "generating the suspension", "failed to place the vesicles");
+    }
+    testtools::AssertTrue(geo[0]==geo[1], "same seed, same suspension", "same seed, different suspension");
+    testtools::AssertTrue(geo[0]!=geo[2] && geo[0]!=geo[3] && geo[2]!=geo[3],
+        "high bits of the seed used", "seeds differing in the high bits give the same suspension");
+}
+
+int main(int argc, char** argv)
+{
+    VES3D_INITIALIZE(&argc,&argv,NULL,NULL);
+
+    COUT("\n ==============================\n"
+        <<"  SuspensionGenerator Test:"
+        <<"\n ==============================\n");
+
+    int nproc(1);
+#ifdef HAS_MPI
+    MPI_Comm_size(VES3D_COMM_WORLD, &nproc);
+#endif
+    TestSuspension(100, .2, -1, .1);
+    TestSuspension(100, .2, 10*cbrt(nproc), .05);
+    TestSeeds();
+
+    COUT(emph<<"** SuspensionGeneratorTest passed **"<<emph<<std::endl);
+    VES3D_FINALIZE();
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+'''converts text tables (e.g. vesicle geometry or properties) to table files'''
+
+from __future__ import absolute_import, division, print_function
+
+__author__    = 'Abtin Rahimian'
+__email__     = 'arahimian@acm.org'
+__status__    = 'prototype'
+__revision__  = '$Revision$'
+__date__      = '$Date$'
+__tags__      = '$Tags$'
+__copyright__ = 'Copyright (c) 2015, Abtin Rahimian'
+__license__   = '''
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without
+restriction, including without limitation the rights to use,
+copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following
+conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+'''
+
+import argparse as ap
+import struct
+
+def parse_args():
+    p = ap.ArgumentParser(description='Converts the text table of the vesicle geometry '
+                          'or properties to the binary table file read by ves3d '
+                          '(see DataIO::ReadRows).')
+    p.add_argument('-f', '--fields', help='number of fields per row (8 for the geometry)',
+                   required=True, type=int)
+    p.add_argument('-v', '--version', help='version written in the header', default='0')
+    p.add_argument('input', help='text table')
+    p.add_argument('output', help='table file')
+
+    return vars(p.parse_args())
+
+def load_table(fname):
+    '''all the numbers in the file, skipping # comments'''
+    data = list()
+    with open(fname, 'r') as fh:
+        for line in fh:
+            line = line.split('#')[0]
+            data.extend(float(x) for x in line.split())
+    return data
+
+def write_table(fname, data, fields, version):
+    if len(data) % fields:
+        raise ValueError('%d values do not make whole rows of %d fields' %
+                         (len(data), fields))
+
+    header = ('TABLEFILE\nversion: %s\nrows: %d\nfields: %d\n/TABLEFILE\n' %
+              (version, len(data)//fields, fields))
+    with open(fname, 'wb') as fh:
+        fh.write(header.encode('ascii'))
+        fh.write(struct.pack('=%dd' % len(data), *data))
+
+def main():
+    opts = parse_args()
+    data = load_table(opts['input'])
+    write_table(opts['output'], data, opts['fields'], opts['version'])
+    print('wrote %d rows of %d fields to %s' %
+          (len(data)//opts['fields'], opts['fields'], opts['output']))
+
+if __name__ == '__main__':
+    main()